@@ -0,0 +1,364 @@
+/**
+ * @file bench_pipeline.cpp
+ * @author Adrien Chevrier
+ *
+ * @brief Microbenchmarks of the frame pipeline and IPC primitives.
+ *
+ * This program uses Google Benchmark to measure the building blocks
+ * of the application, each reporting its time per operation and, when
+ * meaningful, its throughput [bytes/s]:
+ * - frame publish/consume through the frame pool and the frame bus,
+ *   the @c get_latest_frame() / @c free_frame() round trip of the
+ *   inference, and the results sent to the display;
+ * - MJPEG decoding variants;
+ * - resizing and color conversion;
+ * - the command handoff to the motors in @c write_abs_pos() ;
+ * - the waiting primitives of @c wait_utils.h .
+ *
+ * Usage:
+ * @code
+ * $ ./bin/bench_pipeline --benchmark_filter=Decode
+ * @endcode
+ *
+ * @see c_interface.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <benchmark/benchmark.h>
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <vector>
+
+#include "c_interface.h"
+
+/*******************************************************************************
+ * Helper functions
+ ******************************************************************************/
+
+/**
+ * @brief Builds a synthetic camera frame with some texture and noise,
+ * so that its JPEG encoding has a realistic size.
+ */
+static cv::Mat synthetic_frame(void)
+{
+    cv::Mat frame(FRAME_HEIGHT, FRAME_WIDTH, CV_8UC3);
+    for (int y = 0; y < frame.rows; y++) {
+        for (int x = 0; x < frame.cols; x++) {
+            frame.at<cv::Vec3b>(y, x) = cv::Vec3b(x & 0xFF, y & 0xFF, (x ^ y) & 0xFF);
+        }
+    }
+    cv::Mat noise(frame.size(), frame.type());
+    cv::randn(noise, cv::Scalar::all(0), cv::Scalar::all(12));
+    frame += noise;
+    cv::circle(frame, cv::Point(160, 120), 40, cv::Scalar(30, 200, 60), cv::FILLED);
+    return frame;
+}
+
+/// Synthetic frame shared by all benchmarks.
+static const cv::Mat& test_frame(void)
+{
+    static const cv::Mat frame = synthetic_frame();
+    return frame;
+}
+
+/// JPEG encoding of the synthetic frame, as captured in MJPEG mode.
+static const std::vector<uint8_t>& test_jpeg(void)
+{
+    static std::vector<uint8_t> jpeg;
+    if (jpeg.empty()) {
+        cv::imencode(".jpg", test_frame(), jpeg, { cv::IMWRITE_JPEG_QUALITY, 80 });
+    }
+    return jpeg;
+}
+
+static const int64_t frame_bytes = FRAME_WIDTH * FRAME_HEIGHT * 3;
+
+/*******************************************************************************
+ * Frame handoff
+ ******************************************************************************/
+
+/// Camera thread side: fill a pool buffer and publish it to N latest-only subscribers.
+static void BM_FramePublish(benchmark::State& state)
+{
+    const cv::Mat& frame = test_frame();
+    std::vector<frame_sub_t*> subs;
+    for (int i = 0; i < state.range(0); i++) {
+        subs.push_back(frame_bus_subscribe(&cam_bus, "bench", FRAME_BUS_LATEST, 0));
+    }
+
+    for ([[maybe_unused]] auto _ : state) {
+        frame_t* slot = frame_pool_acquire();
+        memcpy(slot->data, frame.data, frame_bytes);
+        slot->width = FRAME_WIDTH;
+        slot->height = FRAME_HEIGHT;
+        slot->size = frame_bytes;
+
+        frame_bus_publish(&cam_bus, slot);
+        frame_unref(slot);
+    }
+    state.SetBytesProcessed(state.iterations() * frame_bytes);
+
+    for (frame_sub_t* sub : subs) {
+        frame_bus_unsubscribe(&cam_bus, sub);
+    }
+}
+BENCHMARK(BM_FramePublish)->Arg(0)->Arg(1)->Arg(4);
+
+/// Subscriber side: receive and release a published frame, without copy.
+static void BM_FrameConsume(benchmark::State& state)
+{
+    frame_sub_t* sub = frame_bus_subscribe(&cam_bus, "bench", FRAME_BUS_LATEST, 0);
+    frame_t* slot = frame_pool_acquire();
+    for ([[maybe_unused]] auto _ : state) {
+        frame_bus_publish(&cam_bus, slot);
+        frame_t* frame = frame_sub_receive(&cam_bus, sub, 0);
+        benchmark::DoNotOptimize(frame->data);
+        frame_unref(frame);
+    }
+    state.SetBytesProcessed(state.iterations() * frame_bytes);
+    frame_unref(slot);
+    frame_bus_unsubscribe(&cam_bus, sub);
+}
+BENCHMARK(BM_FrameConsume);
+
+/// Inference side: get the latest frame through the rate governor and the motion gate, then release it.
+static void BM_GetLatestFrame(benchmark::State& state)
+{
+    frame_t* slot = frame_pool_acquire();
+    for ([[maybe_unused]] auto _ : state) {
+        frame_bus_publish(&cam_bus, slot);
+        size_t size;
+        uint8_t* data = get_latest_frame(&size);
+        benchmark::DoNotOptimize(data);
+        free_frame(data);
+    }
+    state.SetBytesProcessed(state.iterations() * frame_bytes);
+    frame_unref(slot);
+}
+BENCHMARK(BM_GetLatestFrame);
+
+/// Display path: publish a detection result and read it back, instead of an annotated frame.
+static void BM_OverlayPublish(benchmark::State& state)
+{
+    detection_t dets[TARGETING_MAX_DETECTIONS] = {};
+    track_t tracks[TRACKER_MAX_TRACKS] = {};
+    static overlay_t overlay;
+    uint64_t frame_id = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        overlay_publish(dets, 10, tracks, 10, ++frame_id, 0, false);
+        overlay_wait(&overlay, 0);
+        benchmark::DoNotOptimize(overlay.seq);
+    }
+}
+BENCHMARK(BM_OverlayPublish);
+
+/*******************************************************************************
+ * MJPEG decoding
+ ******************************************************************************/
+
+/// Full resolution color decoding, allocating the output.
+static void BM_DecodeColor(benchmark::State& state)
+{
+    const std::vector<uint8_t>& jpeg = test_jpeg();
+    for ([[maybe_unused]] auto _ : state) {
+        cv::Mat out = cv::imdecode(jpeg, cv::IMREAD_COLOR);
+        benchmark::DoNotOptimize(out.data);
+    }
+    state.SetBytesProcessed(state.iterations() * jpeg.size());
+}
+BENCHMARK(BM_DecodeColor);
+
+/// Full resolution color decoding into a reused output.
+static void BM_DecodeColorInPlace(benchmark::State& state)
+{
+    const std::vector<uint8_t>& jpeg = test_jpeg();
+    cv::Mat out(FRAME_HEIGHT, FRAME_WIDTH, CV_8UC3);
+    for ([[maybe_unused]] auto _ : state) {
+        cv::imdecode(jpeg, cv::IMREAD_COLOR, &out);
+        benchmark::DoNotOptimize(out.data);
+    }
+    state.SetBytesProcessed(state.iterations() * jpeg.size());
+}
+BENCHMARK(BM_DecodeColorInPlace);
+
+/// Half resolution color decoding, scaled by the JPEG decoder itself.
+static void BM_DecodeReducedColor2(benchmark::State& state)
+{
+    const std::vector<uint8_t>& jpeg = test_jpeg();
+    for ([[maybe_unused]] auto _ : state) {
+        cv::Mat out = cv::imdecode(jpeg, cv::IMREAD_REDUCED_COLOR_2);
+        benchmark::DoNotOptimize(out.data);
+    }
+    state.SetBytesProcessed(state.iterations() * jpeg.size());
+}
+BENCHMARK(BM_DecodeReducedColor2);
+
+/// Full resolution grayscale decoding (luma only).
+static void BM_DecodeGrayscale(benchmark::State& state)
+{
+    const std::vector<uint8_t>& jpeg = test_jpeg();
+    for ([[maybe_unused]] auto _ : state) {
+        cv::Mat out = cv::imdecode(jpeg, cv::IMREAD_GRAYSCALE);
+        benchmark::DoNotOptimize(out.data);
+    }
+    state.SetBytesProcessed(state.iterations() * jpeg.size());
+}
+BENCHMARK(BM_DecodeGrayscale);
+
+/*******************************************************************************
+ * Resizing and color conversion
+ ******************************************************************************/
+
+/// Resize to the model input size, with the given interpolation.
+static void BM_ResizeToModel(benchmark::State& state)
+{
+    const cv::Mat& frame = test_frame();
+    cv::Mat out;
+    int interpolation = static_cast<int>(state.range(0));
+    for ([[maybe_unused]] auto _ : state) {
+        cv::resize(frame, out, cv::Size(224, 168), 0, 0, interpolation);
+        benchmark::DoNotOptimize(out.data);
+    }
+    state.SetBytesProcessed(state.iterations() * frame_bytes);
+}
+BENCHMARK(BM_ResizeToModel)->Arg(cv::INTER_NEAREST)->Arg(cv::INTER_LINEAR)->Arg(cv::INTER_AREA);
+
+/// Resize to the display size, as done by the display task.
+static void BM_ResizeToDisplay(benchmark::State& state)
+{
+    const cv::Mat& frame = test_frame();
+    cv::Mat out;
+    int display_height = DISPLAY_WIDTH * FRAME_HEIGHT / FRAME_WIDTH;
+    for ([[maybe_unused]] auto _ : state) {
+        cv::resize(frame, out, cv::Size(DISPLAY_WIDTH, display_height), 0, 0, cv::INTER_LINEAR);
+        benchmark::DoNotOptimize(out.data);
+    }
+    state.SetBytesProcessed(state.iterations() * DISPLAY_WIDTH * display_height * 3);
+}
+BENCHMARK(BM_ResizeToDisplay);
+
+/// Color conversion, with the given OpenCV conversion code.
+static void BM_CvtColor(benchmark::State& state)
+{
+    const cv::Mat& frame = test_frame();
+    cv::Mat out;
+    int code = static_cast<int>(state.range(0));
+    for ([[maybe_unused]] auto _ : state) {
+        cv::cvtColor(frame, out, code);
+        benchmark::DoNotOptimize(out.data);
+    }
+    state.SetBytesProcessed(state.iterations() * frame_bytes);
+}
+BENCHMARK(BM_CvtColor)->Arg(cv::COLOR_BGR2RGB)->Arg(cv::COLOR_BGR2GRAY)->Arg(cv::COLOR_BGR2BGRA);
+
+/*******************************************************************************
+ * Command handoff to the motors
+ ******************************************************************************/
+
+static std::atomic<bool> motors_running;
+
+/// Minimal motor task: acknowledges each coordinate without moving.
+static void* fake_motor_task(void* arg)
+{
+    bool is_x = arg != nullptr;
+    while (motors_running.load()) {
+        sem_wait(is_x ? &data_x_ready_sem : &data_y_ready_sem);
+        sem_post(is_x ? &data_x_done_sem : &data_y_done_sem);
+    }
+    return nullptr;
+}
+
+/// Round trip of a target position between the inference and motor threads.
+static void BM_WriteAbsPos(benchmark::State& state)
+{
+    pthread_t x_thread, y_thread;
+    motors_running = true;
+    pthread_create(&x_thread, nullptr, fake_motor_task, (void*)1);
+    pthread_create(&y_thread, nullptr, fake_motor_task, nullptr);
+
+    d_px_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        write_abs_pos(i, i);
+        i = (i + 1) & 0xFF;
+    }
+
+    // Release the fake motors with a last coordinate.
+    motors_running = false;
+    write_abs_pos(0, 0);
+    pthread_join(x_thread, nullptr);
+    pthread_join(y_thread, nullptr);
+    state.SetBytesProcessed(state.iterations() * 2 * sizeof(d_px_t));
+}
+BENCHMARK(BM_WriteAbsPos)->UseRealTime();
+
+/*******************************************************************************
+ * Waiting primitives
+ ******************************************************************************/
+
+static bool never_exit(void)
+{
+    return false;
+}
+
+/// Interruptible wait of the given duration [us], checked every 1 ms.
+static void BM_WaitInterruptibleUs(benchmark::State& state)
+{
+    time_us_t duration = static_cast<time_us_t>(state.range(0));
+    for ([[maybe_unused]] auto _ : state) {
+        wait_interruptible_us(duration, 1000, never_exit);
+    }
+    state.counters["requested_us"] = duration;
+}
+BENCHMARK(BM_WaitInterruptibleUs)->Arg(100)->Arg(1000)->Arg(2857)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+/// Interruptible wait of 2 ms, checked at the given interval [ms].
+static void BM_WaitInterruptibleMs(benchmark::State& state)
+{
+    time_ms_t interval = static_cast<time_ms_t>(state.range(0));
+    for ([[maybe_unused]] auto _ : state) {
+        wait_interruptible_ms(2, interval, never_exit);
+    }
+}
+BENCHMARK(BM_WaitInterruptibleMs)->Arg(1)->Arg(2)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+/*******************************************************************************
+ * Entry point
+ ******************************************************************************/
+
+int main(int argc, char** argv)
+{
+    // The frame pipeline and logging are needed, but not the hardware.
+    log_init();
+    log_set_level(LOG_WARNING);
+    if (init_pipeline() == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    close_pipeline();
+    log_close();
+    return EXIT_SUCCESS;
+}
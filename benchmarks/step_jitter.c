@@ -0,0 +1,330 @@
+/**
+ * @file step_jitter.c
+ * @author Adrien Chevrier
+ *
+ * @brief Step timing jitter measurement, in the spirit of @c cyclictest .
+ *
+ * This program exercises the timing path of the stepper motors:
+ * - each step pause, as done by @c syspwm_stepper_sig() with
+ *   @c wait_interruptible_us() , comparing the requested and actual periods;
+ * - whole moves through @c syspwm_stepper_sig() , comparing the expected
+ *   and actual move durations.
+ *
+ * Both errors are printed as histograms, under a configurable CPU load
+ * and scheduling policy. By default the PWM files are simulated in a
+ * temporary directory, so no motor is moved. Use @c -r to drive the
+ * real PWM channel of the X-axis instead.
+ *
+ * Usage:
+ * @code
+ * $ ./bin/step_jitter -f 350 -s 100 -n 20 -l 4 -p 80 -c 3
+ * @endcode
+ *
+ * @see syspwm.h
+ * @see wait_utils.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "syspwm.h"
+#include "wait_utils.h"
+#include "setup.h"
+
+/// Run parameters, set from the command line.
+typedef struct {
+    frequency_hz_t freq;    ///< Step frequency [Hz].
+    step_t steps;           ///< Number of steps per move.
+    unsigned int moves;     ///< Number of moves.
+    unsigned int load;      ///< Number of CPU load threads.
+    int prio;               ///< SCHED_FIFO priority, 0 for SCHED_OTHER.
+    int cpu;                ///< CPU to pin the measuring thread to, -1 for none.
+    time_us_t step_bucket;  ///< Width of the step histogram buckets [us].
+    time_us_t move_bucket;  ///< Width of the move histogram buckets [us].
+    unsigned int buckets;   ///< Number of buckets per histogram.
+    bool real;              ///< Use the real PWM sysfs files.
+} params_t;
+
+/// Histogram of timing errors, with statistics.
+typedef struct {
+    time_us_t width;    ///< Bucket width [us].
+    unsigned int size;  ///< Number of buckets.
+    uint64_t* counts;   ///< Bucket counts.
+    uint64_t overflows; ///< Errors beyond the last bucket.
+    uint64_t samples;   ///< Number of samples.
+    int64_t min;        ///< Minimum error [us].
+    int64_t max;        ///< Maximum error [us].
+    int64_t sum;        ///< Sum of the errors [us].
+} histogram_t;
+
+static volatile sig_atomic_t stop_requested = 0;
+static volatile sig_atomic_t load_running = 1;
+
+static void on_signal(int signal)
+{
+    (void)signal;
+    stop_requested = 1;
+}
+
+static bool exit_requested(void)
+{
+    return stop_requested != 0;
+}
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void hist_init(histogram_t* h, time_us_t width, unsigned int size)
+{
+    memset(h, 0, sizeof(*h));
+    h->width = width ? width : 1;
+    h->size = size;
+    h->counts = calloc(size, sizeof(uint64_t));
+    h->min = INT64_MAX;
+    h->max = INT64_MIN;
+}
+
+static void hist_add(histogram_t* h, int64_t error)
+{
+    h->samples++;
+    h->sum += error;
+    if (error < h->min) h->min = error;
+    if (error > h->max) h->max = error;
+
+    // Early wake-ups are counted in the first bucket.
+    uint64_t idx = error < 0 ? 0 : (uint64_t)error / h->width;
+    if (idx < h->size) h->counts[idx]++;
+    else h->overflows++;
+}
+
+static void hist_print(const histogram_t* h, const char* name)
+{
+    printf("# Histogram: %s error [us], bucket width %u us\n", name, h->width);
+    for (unsigned int i = 0; i < h->size; i++) {
+        if (h->counts[i]) printf("%06u %06llu\n", i * h->width, (unsigned long long)h->counts[i]);
+    }
+    if (h->samples == 0) return;
+    printf("# Samples: %llu\n", (unsigned long long)h->samples);
+    printf("# Min/Avg/Max error: %lld / %lld / %lld us\n",
+           (long long)h->min, (long long)(h->sum / (int64_t)h->samples), (long long)h->max);
+    printf("# Histogram overflows: %llu\n", (unsigned long long)h->overflows);
+}
+
+/**
+ * @brief CPU load thread body: spins until told to stop.
+ */
+static void* load_task(void* arg)
+{
+    (void)arg;
+    volatile uint64_t x = 1;
+    while (load_running) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Creates a simulated PWM channel file tree in a temporary directory.
+ *
+ * @param[out] root Buffer receiving the directory name.
+ * @param[in] pwm The PWM channel to simulate.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE otherwise.
+ */
+static int sim_backend_create(char* root, const syspwm_t* pwm)
+{
+    strcpy(root, "/tmp/step_jitter.XXXXXX");
+    if (!mkdtemp(root)) {
+        perror("[Error] Could not create simulated PWM directory");
+        return EXIT_FAILURE;
+    }
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/pwmchip%u", root, pwm->chip_no);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/pwmchip%u/pwm%u", root, pwm->chip_no, pwm->channel_no);
+    mkdir(path, 0755);
+
+    const char* files[] = { "period", "duty_cycle", "enable" };
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        snprintf(path, sizeof(path), "%s/pwmchip%u/pwm%u/%s", root, pwm->chip_no, pwm->channel_no, files[i]);
+        FILE* f = fopen(path, "w");
+        if (!f) {
+            perror("[Error] Could not create simulated PWM file");
+            return EXIT_FAILURE;
+        }
+        fputs("0\n", f);
+        fclose(f);
+    }
+    return EXIT_SUCCESS;
+}
+
+static void sim_backend_remove(const char* root, const syspwm_t* pwm)
+{
+    char path[256];
+    const char* files[] = { "period", "duty_cycle", "enable" };
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        snprintf(path, sizeof(path), "%s/pwmchip%u/pwm%u/%s", root, pwm->chip_no, pwm->channel_no, files[i]);
+        unlink(path);
+    }
+    snprintf(path, sizeof(path), "%s/pwmchip%u/pwm%u", root, pwm->chip_no, pwm->channel_no);
+    rmdir(path);
+    snprintf(path, sizeof(path), "%s/pwmchip%u", root, pwm->chip_no);
+    rmdir(path);
+    rmdir(root);
+}
+
+static void usage(const char* prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -f <Hz>      step frequency (default %u)\n"
+           "  -s <steps>   steps per move (default 100)\n"
+           "  -n <moves>   number of moves (default 20)\n"
+           "  -l <n>       number of CPU load threads (default 0)\n"
+           "  -p <prio>    SCHED_FIFO priority of the measuring thread (default 0: SCHED_OTHER)\n"
+           "  -c <cpu>     pin the measuring thread to a CPU (default: none)\n"
+           "  -b <us>      step histogram bucket width (default 10)\n"
+           "  -m <us>      move histogram bucket width (default 1000)\n"
+           "  -H <n>       number of buckets per histogram (default 100)\n"
+           "  -r           drive the real PWM channel of the X-axis (moves the motor!)\n",
+           prog, PWM_FREQ);
+}
+
+int main(int argc, char* argv[])
+{
+    params_t p = { PWM_FREQ, 100, 20, 0, 0, -1, 10, 1000, 100, false };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:s:n:l:p:c:b:m:H:rh")) != -1) {
+        switch (opt) {
+        case 'f': p.freq = (frequency_hz_t)strtoul(optarg, NULL, 10); break;
+        case 's': p.steps = (step_t)strtoul(optarg, NULL, 10); break;
+        case 'n': p.moves = (unsigned int)strtoul(optarg, NULL, 10); break;
+        case 'l': p.load = (unsigned int)strtoul(optarg, NULL, 10); break;
+        case 'p': p.prio = atoi(optarg); break;
+        case 'c': p.cpu = atoi(optarg); break;
+        case 'b': p.step_bucket = (time_us_t)strtoul(optarg, NULL, 10); break;
+        case 'm': p.move_bucket = (time_us_t)strtoul(optarg, NULL, 10); break;
+        case 'H': p.buckets = (unsigned int)strtoul(optarg, NULL, 10); break;
+        case 'r': p.real = true; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (p.freq == 0 || p.buckets == 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    signal(SIGINT, on_signal);
+
+    // Select the PWM backend.
+    const syspwm_t* pwm = &PWM_STEP_X;
+    char sim_root[64] = "";
+    if (!p.real) {
+        if (sim_backend_create(sim_root, pwm) == EXIT_FAILURE) return EXIT_FAILURE;
+        syspwm_set_root(sim_root);
+    } else if (syspwm_check(pwm) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    // Scheduling of the measuring thread.
+    if (p.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(p.cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+            fprintf(stderr, "[Warning] Could not pin to CPU %d\n", p.cpu);
+        }
+    }
+    if (p.prio > 0) {
+        struct sched_param sp = { .sched_priority = p.prio };
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) != 0) {
+            fprintf(stderr, "[Warning] Could not set SCHED_FIFO priority %d (are you root?)\n", p.prio);
+        }
+    }
+
+    // CPU load.
+    pthread_t* load_threads = calloc(p.load ? p.load : 1, sizeof(pthread_t));
+    for (unsigned int i = 0; i < p.load; i++) {
+        pthread_create(&load_threads[i], NULL, load_task, NULL);
+    }
+
+    period_ns_t period_ns = 1000000000UL / p.freq;
+    time_us_t period_us = period_ns / 1000;
+
+    printf("# Step timing jitter: %s backend, %u Hz (%u us), %u steps x %u moves, "
+           "%u load threads, %s %d\n",
+           p.real ? "real" : "simulated", p.freq, period_us, p.steps, p.moves,
+           p.load, p.prio > 0 ? "SCHED_FIFO" : "SCHED_OTHER", p.prio);
+
+    histogram_t step_hist, move_hist;
+    hist_init(&step_hist, p.step_bucket, p.buckets);
+    hist_init(&move_hist, p.move_bucket, p.buckets);
+
+    // Step pauses, as timed in syspwm_stepper_sig().
+    for (unsigned int m = 0; m < p.moves && !exit_requested(); m++) {
+        for (step_t i = 0; i < p.steps && !exit_requested(); i++) {
+            int64_t t0 = now_us();
+            wait_interruptible_us(period_us, 1000, exit_requested);
+            hist_add(&step_hist, now_us() - t0 - (int64_t)period_us);
+        }
+    }
+
+    // Whole moves, including the PWM reconfiguration.
+    int64_t expected_us = (int64_t)p.steps * period_us;
+    for (unsigned int m = 0; m < p.moves && !exit_requested(); m++) {
+        int64_t t0 = now_us();
+        syspwm_stepper_sig(pwm, p.freq, p.steps);
+        hist_add(&move_hist, now_us() - t0 - expected_us);
+    }
+
+    load_running = 0;
+    for (unsigned int i = 0; i < p.load; i++) {
+        pthread_join(load_threads[i], NULL);
+    }
+    free(load_threads);
+
+    hist_print(&step_hist, "step period");
+    hist_print(&move_hist, "move duration");
+    free(step_hist.counts);
+    free(move_hist.counts);
+
+    if (!p.real) {
+        syspwm_set_root(NULL);
+        sim_backend_remove(sim_root, pwm);
+    }
+    return EXIT_SUCCESS;
+}
@@ -37,14 +37,33 @@
 #include <pthread.h>
 #include <sched.h>
 #include <iostream>
+#include <string>
 #include <cstring>
 
 #include "setup.h"
+#include "log_utils.h"
+#include "perf_counters.h"
 #include "ipc_elements.h"
 #include "ctrl_motors.h"
 #include "camera.h"
 #include "display_result.h"
 #include "stepper_demo.h"
+#include "shm_ipc.h"
+#include "targeting.h"
+#include "overlay.h"
+#include "corr_tracker.h"
+#include "motion_gate.h"
+#include "rate_governor.h"
+#include "calib.h"
+#include "calib_sweep.h"
+#include "servo.h"
+#include "mjpeg_stream.h"
+#include "dataset_collect.h"
+#include "flight_recorder.h"
+#include "telemetry_log.h"
+
+/// Maximum waiting time for a camera frame in @c get_latest_frame() [ms].
+#define FRAME_WAIT_MS 100
 
 #ifdef __cplusplus
 extern "C" {
@@ -64,16 +83,138 @@ extern "C" {
  */
 int init_board(void);
 
+/**
+ * @brief Initializes the frame pipeline, without the hardware.
+ *
+ * This function allocates the frame pool and initializes the IPC elements,
+ * the targeting and the frame gates, and subscribes the inference to the
+ * camera frames. It is called by @c init_board() , and can be called alone
+ * to run the pipeline without the board, as the benchmarks do.
+ *
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE otherwise.
+ */
+int init_pipeline(void);
+
+/**
+ * @brief Runs the inference in a separate process, linked by shared memory.
+ *
+ * The frame pool is then allocated in shared memory, and the threads
+ * linking the inference process to the motors are spawned instead of
+ * running the inference in this process.
+ *
+ * @param[in] enable @c true to run the inference in a separate process.
+ *
+ * @warning Must be called before @c init_board() .
+ *
+ * @see shm_ipc.h
+ */
+void set_shm_mode(bool enable);
+
 /**
  * @brief Spawns the necessary C/C++ threads for system operation.
  *
  * This function spawns all the required C/C++ threads that handle different tasks 
- * such as motor control and camera capture/display.
+ * such as motor control and camera capture, and the display, visual servoing,
+ * streaming, dataset collection, flight recorder and telemetry log threads if
+ * enabled with @c set_display() , @c set_servo() , @c set_stream_port() ,
+ * @c set_collect_dir() , @c set_flight_dir() and @c set_telemetry_dir() .
  *
  * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if one thread could not be created.
  */
 int spawn_threads(void);
 
+/**
+ * @brief Enables or disables the thread displaying the inference results.
+ *
+ * @param[in] enable @c true to display the camera frames with the detections drawn over them.
+ *
+ * @warning Must be called before @c spawn_threads() .
+ */
+void set_display(bool enable);
+
+/**
+ * @brief Checks if the inference results are displayed.
+ *
+ * @return @c true if the display thread is enabled, otherwise @c false.
+ */
+bool display_enabled(void);
+
+/**
+ * @brief Selects the screen output of the display thread.
+ *
+ * @param[in] output A @c display_output_t : @c 0 (automatic), @c 1 (DRM/KMS),
+ *                   @c 2 (framebuffer device) or @c 3 (X11 window).
+ *
+ * @warning Must be called before @c spawn_threads() .
+ */
+void set_display_output(uint8_t output);
+
+/**
+ * @brief Enables or disables the thread correcting the missed steps on the laser dot.
+ *
+ * @param[in] enable @c true to correct the motors on the camera frames.
+ *
+ * @warning Must be called before @c spawn_threads() .
+ *
+ * @see servo.h
+ */
+void set_servo(bool enable);
+
+/**
+ * @brief Enables or disables the thread streaming the camera frames in MJPEG over HTTP.
+ *
+ * @param[in] port The TCP port on the loopback interface, @c 0 to disable the streaming.
+ *
+ * @warning Must be called before @c spawn_threads() .
+ *
+ * @see mjpeg_stream.h
+ */
+void set_stream_port(uint16_t port);
+
+/**
+ * @brief Enables or disables the threads recording hard examples for the training dataset.
+ *
+ * @param[in] dir The dataset directory, created if missing, or @c nullptr
+ *            (or an empty string) to disable the collection.
+ *
+ * @warning Must be called before @c spawn_threads() .
+ *
+ * @see dataset_collect.h
+ */
+void set_collect_dir(const char* dir);
+
+/**
+ * @brief Enables or disables the flight recorder.
+ *
+ * @param[in] dir The directory of the dump files, created if missing, or
+ *            @c nullptr (or an empty string) to disable the recorder.
+ *
+ * @warning Must be called before @c spawn_threads() .
+ *
+ * @see flight_recorder.h
+ */
+void set_flight_dir(const char* dir);
+
+/**
+ * @brief Dumps the last seconds recorded by the flight recorder to a file.
+ *
+ * The file is written by the flight recorder thread, without waiting.
+ * Does nothing if the recorder is disabled.
+ */
+void dump_flight_recorder(void);
+
+/**
+ * @brief Enables or disables the binary telemetry log.
+ *
+ * @param[in] dir The directory of the log files, created if missing, or
+ *            @c nullptr (or an empty string) to disable the log.
+ *
+ * @warning Must be called before @c spawn_threads() .
+ *
+ * @see telemetry_log.h
+ */
+void set_telemetry_dir(const char* dir);
+
 /**
  * @brief Joins the spawned C/C++ threads.
  *
@@ -90,6 +231,13 @@ void join_threads(void);
  */
 void exit_clean(void);
 
+/**
+ * @brief Releases the frame pipeline initialized by @c init_pipeline() .
+ *
+ * It is called by @c exit_clean() .
+ */
+void close_pipeline(void);
+
 /*******************************************************************************
  * Signal Management
  ******************************************************************************/
@@ -111,52 +259,156 @@ void thread_exit_ready(void);
  */
 bool kill_requested(void);
 
-/*******************************************************************************
- * Camera/Display Operations
- ******************************************************************************/
+/**
+ * @brief Sets the minimum level of the messages logged by the C/C++ threads.
+ *
+ * @param[in] level The minimum level: 0 (debug), 1 (info), 2 (warning)
+ *                  or 3 (error).
+ *
+ * @see log_utils.h
+ */
+void set_log_level(uint8_t level);
+
+/**
+ * @brief Reads the hardware counters of the calling thread when entering a stage.
+ *
+ * Does nothing unless the environment variable @c EDGEAI_PERF is set to @c 1 .
+ *
+ * @param[in] stage The stage being entered, as a @c perf_stage_t value.
+ *
+ * @see perf_counters.h
+ */
+void perf_begin(uint8_t stage);
 
 /**
- * @brief Sends a frame to be displayed.
+ * @brief Reads the hardware counters of the calling thread when leaving a stage.
  *
- * This function takes a frame (raw pixel data) and stores it in the display buffer 
- * for later rendering by the thread in charge of displaying the result.
+ * Does nothing unless the environment variable @c EDGEAI_PERF is set to @c 1 .
  *
- * @param[in] data Pointer to the raw image data.
- * @param[in] width The width of the image frame.
- * @param[in] height The height of the image frame.
+ * @param[in] stage The stage being left, as a @c perf_stage_t value.
+ *
+ * @see perf_counters.h
  */
-void send_frame(uint8_t* data, int width, int height);
+void perf_end(uint8_t stage);
 
+/*******************************************************************************
+ * Camera/Display Operations
+ ******************************************************************************/
 
 /**
  * @brief Retrieves the latest captured frame from the camera.
  *
- * This function copies the most recent camera frame into a newly allocated buffer. 
- * The function also calculates the size of the frame and returns it through
- * the @c out_size parameter.
+ * This function waits for a camera frame newer than the previous one
+ * retrieved, and returns its pixel buffer without copying it: the frame
+ * is kept out of the frame pool until @c free_frame() is called.
+ * Frames captured while the caller was busy are dropped, only the most
+ * recent one is returned. The function also returns the size of the
+ * frame through the @c out_size parameter.
  *
  * @param[in,out] out_size Pointer to a variable that will hold the size of the frame.
  *
- * @return A pointer to the raw frame data. Can be @c nullptr .
+ * @return A pointer to the raw frame data. Can be @c nullptr if no frame
+ *         has been captured within @c FRAME_WAIT_MS .
  * 
- * @warning The caller is responsible for freeing the memory.
+ * @warning The caller is responsible for releasing the frame, and must
+ * not write to it.
  */
 uint8_t* get_latest_frame(size_t* out_size);
 
 /**
- * @brief Frees the memory allocated for a frame.
+ * @brief Releases a frame obtained with @c get_latest_frame() .
  *
- * This function frees the memory that was allocated for storing a captured 
- * image frame. It is important to call this function after the frame is no 
- * longer needed to avoid memory leaks.
+ * This function gives the frame buffer back to the frame pool once
+ * it is not used anymore. It is important to call this function after
+ * the frame is no longer needed, otherwise the pool gets exhausted
+ * and the camera drops frames.
  *
- * @param[in,out] ptr Pointer to the raw frame data to be freed.
+ * @param[in,out] ptr Pointer to the raw frame data to be released.
  *
  * @warning Must be called by any Python thread
- * copying frames from the camera thread buffer.
+ * reading frames from the camera thread.
  */
 void free_frame(uint8_t* ptr);
 
+/**
+ * @brief Gets the capture sequence number of a frame obtained with @c get_latest_frame() .
+ *
+ * @param[in] ptr Pointer to the raw frame data, not released yet.
+ * @return The capture sequence number, or 0 if @c ptr is not a frame of the pool.
+ */
+uint64_t get_frame_id(const uint8_t* ptr);
+
+/**
+ * @brief Gets the usage statistics of the frame pool.
+ *
+ * @param[out] stats The statistics: number of buffers, buffers in use
+ *             (current and peak), acquisitions and failed acquisitions.
+ */
+void get_frame_pool_stats(frame_pool_stats_t* stats);
+
+/*******************************************************************************
+ * Inference Process (shared memory mode)
+ ******************************************************************************/
+
+/**
+ * @brief Connects the inference process to the running application.
+ *
+ * Must only be called from the inference process, which must not
+ * call @c init_board() .
+ *
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the application
+ *         is not running in shared memory mode.
+ */
+int inference_connect(void);
+
+/**
+ * @brief Disconnects the inference process, releasing its leased frame.
+ */
+void inference_disconnect(void);
+
+/**
+ * @brief Checks if the application the inference process is connected to still runs.
+ *
+ * @return @c true if the application runs, otherwise @c false.
+ */
+bool inference_link_alive(void);
+
+/**
+ * @brief Checks if the motors already received the calibration reference.
+ *
+ * @return @c true if the motors are calibrated, otherwise @c false.
+ */
+bool inference_calibrated(void);
+
+/**
+ * @brief Waits for a new camera frame in the inference process.
+ *
+ * The frame is read in place in the shared frame pool, and kept out of
+ * the pool until the next call or @c inference_release_frame() .
+ *
+ * @param[out] info Description of the frame.
+ * @return A read-only pointer to the raw frame data, or @c nullptr if no
+ *         frame has been published within @c SHM_WAIT_MS .
+ */
+const uint8_t* inference_wait_frame(shm_frame_info_t* info);
+
+/**
+ * @brief Releases the frame obtained with @c inference_wait_frame() .
+ */
+void inference_release_frame(void);
+
+/**
+ * @brief Sends the detections of a frame from the inference process.
+ *
+ * @param[in] dets The detections.
+ * @param[in] n Number of detections, at most @c SHM_MAX_DETECTIONS .
+ * @param[in] frame_id Frame the detections come from.
+ * @param[in] flags @c SHM_DETECTIONS_CALIBRATION if the first detection
+ *            is the calibration reference, 0 otherwise.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if not connected.
+ */
+int inference_submit(const detection_t* dets, size_t n, uint64_t frame_id, uint32_t flags);
+
 /*******************************************************************************
  * Communication with stepper motors
  ******************************************************************************/
@@ -172,6 +424,133 @@ void free_frame(uint8_t* ptr);
  */
 void send_abs_pos(d_px_t x, d_px_t y);
 
+/**
+ * @brief Loads the calibration model mapping the pixels to the motor steps.
+ *
+ * Without calibration file, the model is linear (@c STEP_SIZE ).
+ *
+ * @param[in] path The calibration file.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the file cannot
+ *         be read or is invalid.
+ *
+ * @see calib.h
+ */
+int load_calibration(const char* path);
+
+/**
+ * @brief Calibrates the motors automatically with the laser dot.
+ *
+ * This function drives the mirrors through a grid covering the frame, fits
+ * the calibration model to the laser dots found in the camera frames, saves
+ * it, and sends the calibration reference to the motors. It blocks until
+ * the sweep is done, and must be called after @c spawn_threads() , instead
+ * of sending the reference with @c send_abs_pos() .
+ *
+ * @param[in] path The calibration file to write.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the motors are
+ *         left to calibrate manually.
+ *
+ * @see calib_sweep.h
+ */
+int auto_calibrate(const char* path);
+
+/**
+ * @brief Checks if the motors received their calibration reference.
+ *
+ * @return @c true if the motors are calibrated, otherwise @c false .
+ */
+bool motors_calibrated(void);
+
+/**
+ * @brief Submits the detections of a frame to the targeting thread.
+ *
+ * This function copies the detections and returns immediately: the
+ * targeting thread tracks the aliens and sends them to the motors, in
+ * the order minimizing the travel from the last position sent.
+ * Detections not handled yet are replaced by newer ones.
+ *
+ * @param[in] dets The detections.
+ * @param[in] n Number of detections, at most @c TARGETING_MAX_DETECTIONS .
+ * @param[in] frame_id Frame the detections come from, 0 if unknown.
+ *
+ * @warning The motors must have been calibrated with @c send_abs_pos() ,
+ * detections submitted before are ignored.
+ *
+ * @see targeting.h
+ */
+void submit_detections(const detection_t* dets, size_t n, uint64_t frame_id);
+
+/**
+ * @brief Sets the time the laser stays on each target.
+ *
+ * @param[in] ms The dwell time, from the arrival of the beam [ms].
+ */
+void set_dwell_time(uint32_t ms);
+
+/**
+ * @brief Enables or disables the velocity mode of the motors.
+ *
+ * In velocity mode, the motors continuously follow the position and
+ * velocity of the targets, changing their step rate on the fly, instead of
+ * moving from point to point.
+ *
+ * @param[in] enable @c true to follow the targets in velocity mode.
+ *
+ * @warning Must be called before @c spawn_threads() .
+ */
+void set_velocity_mode(bool enable);
+
+/**
+ * @brief Gets the statistics of the targeting thread.
+ *
+ * @param[out] stats The statistics: detection sets submitted and replaced
+ *             before being handled, targets sent and lost before being visited.
+ */
+void get_targeting_stats(targeting_stats_t* stats);
+
+/**
+ * @brief Enables or disables the motion gate of the inference.
+ *
+ * With the gate, the inference only runs on the frames where the scene
+ * changed, and at least every @c MOTION_KEEPALIVE_MS : the last detections
+ * are reused for the other frames.
+ *
+ * @param[in] enable @c true to skip the inference on a static scene.
+ *
+ * @see motion_gate.h
+ */
+void set_motion_gate(bool enable);
+
+/**
+ * @brief Gets the statistics of the motion gate.
+ *
+ * @param[out] stats The statistics: frames analyzed and changing the scene,
+ *             frames admitted to the inference or skipped.
+ */
+void get_motion_stats(motion_stats_t* stats);
+
+/**
+ * @brief Sets what the rate governor slows down when nothing is in view.
+ *
+ * After @c GOVERNOR_IDLE_AFTER_MS without detection, the inference runs at
+ * @c GOVERNOR_IDLE_HZ , and with @c GOVERNOR_CAMERA the camera frames are
+ * decoded and published at @c GOVERNOR_IDLE_CAMERA_FPS . The first detection
+ * switches back to full rate.
+ *
+ * @param[in] mode A @c governor_mode_t .
+ *
+ * @see rate_governor.h
+ */
+void set_governor(uint8_t mode);
+
+/**
+ * @brief Gets the statistics of the rate governor.
+ *
+ * @param[out] stats The statistics: current state, transitions, time spent
+ *             in each state, frames skipped.
+ */
+void get_governor_stats(governor_stats_t* stats);
+
 /**
  * @brief Sends positions to move the stepper motors in a circular pattern.
  *
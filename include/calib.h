@@ -0,0 +1,138 @@
+/**
+ * @file calib.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the calibration model mapping the pixels to the motor steps.
+ *
+ * The mirrors deflect the beam along a tangent, and the deflection of each
+ * mirror depends on the position of the other one: the step position
+ * aiming at a pixel is neither linear nor separable across the field. This
+ * file provides a calibration model stored as a lookup table of absolute
+ * (X, Y) step positions on a regular grid of nodes over the frame, queried
+ * in constant time by bilinear interpolation between the four nodes
+ * surrounding a pixel.
+ *
+ * Without a table, the model is linear: one step every @c STEP_SIZE pixels
+ * on each axis.
+ *
+ * The table is stored in a text file:
+ * @code
+ * # Comment lines start with '#'.
+ * grid <cols> <rows> <cell>
+ * <x-steps> <y-steps>
+ * ...
+ * @endcode
+ * with one line per node, row by row, the node (i, j) being at pixel
+ * (i * cell, j * cell).
+ *
+ * @see calib.c
+ * @see ctrl_motors.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CALIB_H
+#define CALIB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CALIB_DEFAULT_FILE "calibration.lut"    ///< Calibration file loaded by default.
+#define CALIB_MAX_NODES (321 * 241)             ///< Maximum number of nodes (one per pixel).
+#define CALIB_INVERSE_ITERATIONS 4              ///< Maximum number of Newton iterations of the inverse model.
+#define CALIB_INVERSE_TOLERANCE 0.01f           ///< Step error ending the Newton iterations [steps].
+
+/**
+ * @brief Sets the lookup table of the calibration model.
+ *
+ * @param[in] cols Number of nodes per row, at least 2.
+ * @param[in] rows Number of rows, at least 2.
+ * @param[in] cell Distance between two nodes [px].
+ * @param[in] sx X-step positions of the nodes, row by row.
+ * @param[in] sy Y-step positions of the nodes, row by row.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the grid is invalid.
+ */
+int calib_set_grid(int cols, int rows, float cell, const float* sx, const float* sy);
+
+/**
+ * @brief Loads the lookup table of the calibration model from a file.
+ *
+ * @param[in] path The calibration file.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the file cannot
+ *         be read or is invalid, the model being left unchanged.
+ */
+int calib_load(const char* path);
+
+/**
+ * @brief Saves the lookup table of the calibration model to a file.
+ *
+ * @param[in] path The calibration file.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if there is no table
+ *         or the file cannot be written.
+ */
+int calib_save(const char* path);
+
+/**
+ * @brief Removes the lookup table, going back to the linear model.
+ */
+void calib_clear(void);
+
+/**
+ * @brief Checks if a lookup table is loaded.
+ *
+ * @return @c true if the model uses a lookup table, @c false if it is linear.
+ */
+bool calib_loaded(void);
+
+/**
+ * @brief Converts a pixel to the absolute step positions aiming at it.
+ *
+ * Pixels outside the grid take the value of its nearest border.
+ *
+ * @param[in] x The X-position [px].
+ * @param[in] y The Y-position [px].
+ * @param[out] sx The X-step position [steps].
+ * @param[out] sy The Y-step position [steps].
+ */
+void calib_px_to_steps(float x, float y, float* sx, float* sy);
+
+/**
+ * @brief Converts absolute step positions to the pixel they aim at.
+ *
+ * With a lookup table, the pixel is found by Newton iterations on the
+ * interpolated table from an initial guess, which should be close, the
+ * pixels being kept within the grid.
+ *
+ * @param[in] sx The X-step position [steps].
+ * @param[in] sy The Y-step position [steps].
+ * @param[in,out] x The initial guess, then the X-position [px].
+ * @param[in,out] y The initial guess, then the Y-position [px].
+ */
+void calib_steps_to_px(float sx, float sy, float* x, float* y);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CALIB_H
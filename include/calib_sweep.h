@@ -0,0 +1,88 @@
+/**
+ * @file calib_sweep.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the automatic calibration of the motors.
+ *
+ * This file provides a calibration routine driving the mirrors through a
+ * grid of step positions covering the frame, and finding the laser dot in
+ * a camera frame captured at each position. The step positions are fitted
+ * to the pixels of the dots by least squares with a bivariate polynomial,
+ * then sampled into the lookup table of the calibration model.
+ *
+ * The routine runs instead of the manual reference, before the motors are
+ * calibrated:
+ * 1. the dot is found at the starting position, then after a small move of
+ *    each axis, which gives a first affine model;
+ * 2. the grid of pixels is visited in a serpentine order, the step position
+ *    of each pixel being predicted with the affine model of the dots found
+ *    so far, and its dot searched near the pixel, positions whose dot is not
+ *    found being skipped;
+ * 3. the mirrors go back to the starting position, whose dot is sent to the
+ *    motors as the calibration reference.
+ *
+ * @see calib_sweep.c
+ * @see calib.h
+ * @see laser_dot.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CALIB_SWEEP_H
+#define CALIB_SWEEP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CALIB_SWEEP_COLS 6              ///< Number of columns of the visited grid.
+#define CALIB_SWEEP_ROWS 4              ///< Number of rows of the visited grid.
+#define CALIB_SWEEP_MARGIN 24           ///< Distance of the visited grid to the frame edges [px].
+#define CALIB_SWEEP_PROBE_STEPS 10      ///< Move of each axis giving the first affine model [steps].
+#define CALIB_SWEEP_MAX_STEPS 1000      ///< Largest distance to the starting position [steps].
+#define CALIB_SWEEP_SEARCH 40           ///< Search radius of the dot around its expected position [px].
+#define CALIB_SWEEP_SETTLE_MS 50        ///< Waiting time after each move, for the mirrors to settle [ms].
+#define CALIB_SWEEP_FRAME_MS 500        ///< Maximum waiting time for a frame captured after a move [ms].
+#define CALIB_SWEEP_MIN_POINTS 10       ///< Minimum number of dots to fit.
+#define CALIB_SWEEP_MAX_RMS 1.5f        ///< Largest residual of the fit [steps].
+#define CALIB_SWEEP_CELL 10             ///< Distance between two nodes of the lookup table [px].
+
+/**
+ * @brief Calibrates the motors automatically with the laser dot.
+ *
+ * The camera must run, and the motors must not be calibrated yet. On
+ * success, the lookup table of the calibration model is replaced and saved,
+ * and the motors are calibrated. On failure, the calibration model is left
+ * unchanged and the mirrors go back to their starting position, so that
+ * the motors can still be calibrated manually.
+ *
+ * @param[in] path The calibration file to write. Can be @c NULL .
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE otherwise.
+ */
+int calib_sweep_run(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CALIB_SWEEP_H
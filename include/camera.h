@@ -37,23 +37,30 @@
 #include <iostream>
 
 #include "psig_utils.h"
+#include "log_utils.h"
+#include "perf_counters.h"
 #include "ipc_elements.h"
+#include "frame_pool.h"
+#include "frame_clock.h"
+#include "motion_gate.h"
+#include "rate_governor.h"
 
-// Constant definitions for frame width, height, and frame rate.
-#define FRAME_WIDTH 320     ///< Frame width [px].
-#define FRAME_HEIGHT 240    ///< Frame height [px].
+// Constant definition for the frame rate, the frame size being in frame_pool.h .
 #define FRAME_FPS 120       ///< Frame rate [FPS].
 
-// External variable holding the camera frame buffer.
-extern cv::Mat cam_buffer_0;    ///< Camera frame buffer, holds a single image.
+/// Size of a camera frame buffer [bytes].
+#define FRAME_BUFFER_SIZE (FRAME_WIDTH * FRAME_HEIGHT * 3)
 
 /**
  * @brief Camera task to capture an store frames from the camera.
  * 
  * This task initializes the camera
  * and continually captures frames from it.
- * Each time a valide frame is captured, it is copyied in a buffer,
- * effectively erasing the previous stored frame.
+ * Each frame is captured directly into a buffer of the frame pool,
+ * which is then published on @c cam_bus to all its subscribers.
+ * With an MJPEG camera, the compressed data of the frame is kept in the
+ * frame too, and decoded into its pixel buffer.
+ * When the pool is exhausted, the frame is skipped.
  * 
  * @param[in] arg A pointer to any necessary arguments for the camera task.
  * @return A pointer to a result of the task execution.
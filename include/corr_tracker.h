@@ -0,0 +1,139 @@
+/**
+ * @file corr_tracker.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the correlation tracker following the targets between detections.
+ *
+ * The camera captures frames faster than the detector produces boxes. This
+ * file provides a lightweight visual tracker running on every captured frame:
+ * each confirmed track is followed by normalized cross-correlation of a small
+ * patch of a downscaled grayscale frame, searched around its previous
+ * position.
+ *
+ * The patches are seeded again with every detection update, on the frame the
+ * detections come from when it is still in the history of the tracker: the
+ * patches are then followed through the frames captured since. The targeting
+ * thread is notified of each refreshed position, so that the motors follow
+ * the targets at camera rate rather than at inference rate.
+ *
+ * The correlation and the downscaling use NEON when available.
+ *
+ * @see corr_tracker.c
+ * @see targeting.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORR_TRACKER_H
+#define CORR_TRACKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tracker.h"
+
+#define CORR_SCALE 2            ///< Downscaling factor of the frames.
+#define CORR_PATCH 16           ///< Size of the correlated patches [downscaled px].
+#define CORR_RADIUS 6           ///< Search radius around the previous position [downscaled px].
+#define CORR_HISTORY 8          ///< Number of downscaled frames kept to seed the patches.
+#define CORR_MIN_SCORE 0.6f     ///< Correlation below which a target is lost until seeded again.
+#define CORR_WAIT_MS 100        ///< Maximum waiting time for a frame [ms].
+
+/**
+ * @brief Position of a target followed by correlation.
+ */
+typedef struct {
+    uint32_t id;            ///< Track identifier.
+    float x;                ///< X-position of the center [px].
+    float y;                ///< Y-position of the center [px].
+    uint64_t timestamp_ns;  ///< Capture time of the frame of the position [ns].
+    float score;            ///< Normalized cross-correlation of the last match, between -1 and 1.
+} corr_pos_t;
+
+/**
+ * @brief Statistics of the correlation tracker.
+ */
+typedef struct {
+    uint64_t frames;        ///< Number of frames processed.
+    uint64_t seeds;         ///< Number of patches seeded on the frame of their detection.
+    uint64_t late_seeds;    ///< Number of patches seeded on a newer frame, at the predicted position.
+    uint64_t lost;          ///< Number of targets lost by the correlation.
+} corr_stats_t;
+
+/**
+ * @brief Initializes the correlation tracker, without targets.
+ */
+void corr_tracker_init(void);
+
+/**
+ * @brief Destroys the correlation tracker.
+ */
+void corr_tracker_close(void);
+
+/**
+ * @brief Replaces the followed targets with updated tracks.
+ *
+ * The patches are seeded by the tracker thread on its next frame. Targets
+ * missing from @p tracks stop being followed.
+ *
+ * @param[in] tracks The tracks to follow.
+ * @param[in] n Number of tracks, truncated to @c TRACKER_MAX_TRACKS .
+ * @param[in] frame_id Frame the track states come from, 0 if unknown.
+ * @param[in] timestamp_ns Capture time of the frame (@c CLOCK_MONOTONIC ) [ns].
+ */
+void corr_tracker_seed(const track_t* tracks, size_t n, uint64_t frame_id, uint64_t timestamp_ns);
+
+/**
+ * @brief Reads the latest position of a followed target.
+ *
+ * @param[in] id The track identifier.
+ * @param[out] pos The position.
+ * @return @c true if the target is followed, @c false if it is unknown or lost.
+ */
+bool corr_tracker_lookup(uint32_t id, corr_pos_t* pos);
+
+/**
+ * @brief Reads the correlation tracker statistics.
+ *
+ * @param[out] stats The statistics.
+ */
+void corr_tracker_get_stats(corr_stats_t* stats);
+
+/**
+ * @brief Task following the targets on every camera frame.
+ *
+ * This task downscales each captured frame, seeds the patches of updated
+ * tracks, matches the patches around their previous positions, and notifies
+ * the targeting thread of the refreshed positions.
+ *
+ * @param[in] arg Unused.
+ * @return A pointer to a result of the task execution.
+ */
+void* corr_tracker_task(void* arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CORR_TRACKER_H
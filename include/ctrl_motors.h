@@ -42,6 +42,8 @@ extern "C" {
 #include <stdint.h>
 
 #include "psig_utils.h"
+#include "log_utils.h"
+#include "perf_counters.h"
 #include "gpio_utils.h"
 #include "syspwm.h"
 #include "ipc_elements.h"
@@ -51,6 +53,14 @@ extern "C" {
 /// Type definition for a displacement/position on a captured frame [px] (signed).
 typedef int16_t d_px_t;
 
+// Velocity mode parameters.
+#define VELOCITY_PERIOD_US 10000    ///< Control period of the velocity mode [us].
+#define VELOCITY_GAIN 5.0f          ///< Correction of the position error [1/s].
+#define VELOCITY_MAX_RATE PWM_FREQ  ///< Maximum step rate [Hz].
+#define VELOCITY_MIN_RATE 10        ///< Step rate below which an axis stops [Hz].
+#define VELOCITY_MAX_ACCEL 3000     ///< Maximum change of the step rate [Hz/s].
+#define VELOCITY_MAX_PREDICTION_MS 500  ///< Longest extrapolation of a target [ms].
+
 
 /**
  * @brief Enumeration to represent step direction.
@@ -63,6 +73,24 @@ typedef enum {
 } step_dir_t;
 
 
+/**
+ * @brief Enumeration to represent the motion mode of the motors.
+ */
+typedef enum {
+    MOTOR_MODE_POINT,   ///< Point-to-point moves at @c PWM_FREQ to each position received.
+    MOTOR_MODE_VELOCITY ///< Continuous step rate following a moving target.
+} motor_mode_t;
+
+/**
+ * @brief Target followed by an axis in velocity mode.
+ */
+typedef struct {
+    float pos;              ///< Position at @c timestamp_ns [px].
+    float vel;              ///< Velocity [px/s].
+    uint64_t timestamp_ns;  ///< Time of the position (@c CLOCK_MONOTONIC ) [ns].
+} axis_target_t;
+
+
 extern d_px_t x_px_buff;    ///< Buffer where the X-axis position is read by the X-motor [px].
 extern d_px_t y_px_buff;    ///< Buffer where the Y-axis position is read by the Y-motor [px].
 
@@ -78,10 +106,11 @@ extern d_px_t y_px_buff;    ///< Buffer where the Y-axis position is read by the
  * @param[in] freq Frequency at which the motor should operate [Hz].
  * @param[in] steps Number of steps to move the motor.
  * @param[in] dir Direction to move the motor, either @c STEP_P or @c STEP_M .
+ * @param[out] emitted Number of steps actually emitted, or @c NULL .
  *
  * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE otherwise.
  */
-int move_stepper_raw(const syspwm_t* pwm, gpiod_line *gpio_line, frequency_hz_t freq, step_t steps, step_dir_t dir);
+int move_stepper_raw(const syspwm_t* pwm, gpiod_line *gpio_line, frequency_hz_t freq, step_t steps, step_dir_t dir, step_t* emitted);
 
 /**
  * @brief Moves a stepper motor by a specified displacement in pixels.
@@ -99,15 +128,109 @@ int move_stepper_raw(const syspwm_t* pwm, gpiod_line *gpio_line, frequency_hz_t
  */
 int move_stepper(const syspwm_t* pwm, gpiod_line *gpio_line, frequency_hz_t freq, d_px_t d);
 
+/**
+ * @brief Moves a stepper motor by a signed number of steps.
+ *
+ * @param[in] pwm Pointer to the PWM channel used for motor step control.
+ * @param[in,out] gpio_line Pointer to the GPIO line controlling motor direction.
+ * @param[in] freq Frequency at which the motor should operate [Hz].
+ * @param[in] steps Number of steps, positive in the @c STEP_P direction.
+ * @param[out] emitted Signed number of steps actually emitted, or @c NULL .
+ *
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE otherwise.
+ */
+int move_stepper_steps(const syspwm_t* pwm, gpiod_line *gpio_line, frequency_hz_t freq, int32_t steps, int32_t* emitted);
+
+/**
+ * @brief Computes the duration of a move between two pixels.
+ *
+ * Both motors move at once, by the difference of the step positions
+ * aiming at both pixels given by the calibration model: the move lasts
+ * as long as the longest axis.
+ *
+ * @param[in] freq Frequency at which the motors operate [Hz].
+ * @param[in] x0 The starting X-position [px].
+ * @param[in] y0 The starting Y-position [px].
+ * @param[in] x1 The final X-position [px].
+ * @param[in] y1 The final Y-position [px].
+ *
+ * @return The expected duration of the move [us].
+ *
+ * @see calib.h
+ */
+time_us_t move_time_us(frequency_hz_t freq, d_px_t x0, d_px_t y0, d_px_t x1, d_px_t y1);
+
+/**
+ * @brief Sets the motion mode of the motors.
+ *
+ * @param[in] mode The motion mode.
+ *
+ * @warning Must be called before the motor tasks start.
+ */
+void motor_set_mode(motor_mode_t mode);
+
+/**
+ * @brief Gets the motion mode of the motors.
+ *
+ * @return The motion mode.
+ */
+motor_mode_t motor_get_mode(void);
+
+/**
+ * @brief Gets the absolute step positions counted by the motors in point mode.
+ *
+ * Each move advances the count by the steps actually emitted, which may
+ * exceed the steps planned.
+ *
+ * @param[out] x The X-step position [steps].
+ * @param[out] y The Y-step position [steps].
+ */
+void motor_get_steps(int32_t* x, int32_t* y);
+
+/**
+ * @brief Corrects the absolute step positions of the motors by missed steps.
+ *
+ * The correction applies before the next move of each motor, which then
+ * reaches the step position of its target again.
+ *
+ * @param[in] dx Steps the X-motor is ahead of its step position [steps].
+ * @param[in] dy Steps the Y-motor is ahead of its step position [steps].
+ */
+void motor_resync(int32_t dx, int32_t dy);
+
+/**
+ * @brief Sets the targets followed by the motors in velocity mode.
+ *
+ * Each axis extrapolates its target at constant velocity, and sets its
+ * step rate to the target velocity plus a correction of its position error,
+ * within the rate and acceleration limits of the motors.
+ *
+ * @param[in] x The target of the X-axis.
+ * @param[in] y The target of the Y-axis.
+ */
+void motor_follow(const axis_target_t* x, const axis_target_t* y);
+
+/**
+ * @brief Gets the positions of the motors estimated in velocity mode.
+ *
+ * The step positions integrate the step rates applied since the calibration,
+ * and are converted to pixels by the inverse of the calibration model.
+ *
+ * @param[out] x The X-position [px].
+ * @param[out] y The Y-position [px].
+ */
+void motor_estimate(float* x, float* y);
+
 /**
  * @brief Task to control the X-axis stepper motor.
  * 
- * This task waits for the motor to receive its calibration X-position,
- * then reads X-position from the corresponding buffer.
- * Each time a new position is recorded, the displacement is computed
- * with the previous position, and the motor moves according
- * to this displacement. The previous position is finally updated
- * with the last received one.
+ * This task waits for the motor to receive its calibration position,
+ * then reads the positions from the buffers.
+ * Each time a new position is recorded, the calibration model gives the
+ * absolute X-step position aiming at it, and the motor moves by the
+ * difference with its current step position.
+ * In velocity mode, the motor follows instead the target set with
+ * @c motor_follow() after the calibration.
  * 
  * @param[in] arg A pointer to any necessary arguments for the camera task.
  * @return A pointer to a result of the task execution.
@@ -117,12 +240,13 @@ void* stepper_x_task(void* arg);
 /**
  * @brief Task to control the Y-axis stepper motor.
  * 
- * This task waits for the motor to receive its calibration Y-position,
- * then reads Y-position from the corresponding buffer.
- * Each time a new position is recorded, the displacement is computed
- * with the previous position, and the motor moves according
- * to this displacement. The previous position is finally updated
- * with the last received one.
+ * This task waits for the motor to receive its calibration position,
+ * then reads the positions from the buffers.
+ * Each time a new position is recorded, the calibration model gives the
+ * absolute Y-step position aiming at it, and the motor moves by the
+ * difference with its current step position.
+ * In velocity mode, the motor follows instead the target set with
+ * @c motor_follow() after the calibration.
  * 
  * @param[in] arg A pointer to any necessary arguments for the camera task.
  * @return A pointer to a result of the task execution.
@@ -0,0 +1,130 @@
+/**
+ * @file dataset_collect.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the collection of hard examples for the training dataset.
+ *
+ * This file provides the recording of the camera frames the model struggles
+ * with, along with label files in the YOLO format, so that they can be
+ * reviewed and added to the dataset the model is trained on. A frame is
+ * recorded when its detection result contains:
+ * - a detection of low confidence, just above the inference threshold;
+ * - a confirmed track missed by the detector (flickering detection);
+ * - two overlapping detections of different classes (conflicting detections).
+ *
+ * The examples are written in a YOLO dataset layout:
+ * @c DIR/images/NAME.jpg and @c DIR/labels/NAME.txt , where @c NAME is the
+ * wall-clock time of the recording [ms] followed by its triggers. The labels
+ * hold the detections, and the predicted boxes of the missed tracks.
+ *
+ * Two threads share the work, away from the inference:
+ * - the collecting thread keeps a copy of the last camera frames, compressed
+ *   as delivered by the camera if possible, and checks every detection result;
+ * - the writing thread, of idle scheduling priority, encodes the frames not
+ *   compressed yet and writes the files.
+ *
+ * The recordings go through a bounded queue, dropped when full, and are
+ * limited to one every @c COLLECT_MIN_INTERVAL_MS .
+ *
+ * @see dataset_collect.cpp
+ * @see overlay.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATASET_COLLECT_H
+#define DATASET_COLLECT_H
+
+#include <cstdint>
+
+#include "psig_utils.h"
+#include "log_utils.h"
+#include "ipc_elements.h"
+#include "overlay.h"
+
+#define COLLECT_HISTORY 8               ///< Number of last camera frames kept.
+#define COLLECT_QUEUE_SIZE 4            ///< Maximum number of recordings waiting to be written.
+#define COLLECT_MIN_INTERVAL_MS 1000    ///< Minimum time between two recordings [ms].
+#define COLLECT_LOW_CONF 0.8f           ///< Confidence score below which a detection is uncertain.
+#define COLLECT_CONFLICT_IOU 0.45f      ///< Overlap above which detections of different classes conflict.
+#define COLLECT_JPEG_QUALITY 95         ///< Quality of the encoded frames not compressed by the camera (0-100).
+#define COLLECT_WAIT_MS 100             ///< Maximum waiting time before checking for termination [ms].
+#define COLLECT_NAME_SIZE 64            ///< Maximum size of a recording name [bytes].
+
+/**
+ * @brief Triggers of a recording, as a bit mask.
+ */
+typedef enum {
+    COLLECT_LOW_CONFIDENCE = 1 << 0,    ///< Detection of low confidence.
+    COLLECT_FLICKER = 1 << 1,           ///< Confirmed track missed by the detector.
+    COLLECT_CONFLICT = 1 << 2,          ///< Overlapping detections of different classes.
+} collect_trigger_t;
+
+/**
+ * @brief Statistics of the collection.
+ */
+typedef struct {
+    uint64_t triggered;     ///< Number of detection results meeting a trigger.
+    uint64_t limited;       ///< Number of triggered results skipped by the rate limit.
+    uint64_t missing;       ///< Number of triggered results whose frame was no longer kept.
+    uint64_t dropped;       ///< Number of recordings dropped by the full queue.
+    uint64_t recorded;      ///< Number of examples written.
+    uint64_t failed;        ///< Number of examples that could not be written.
+} collect_stats_t;
+
+/**
+ * @brief Prepares the collection in a dataset directory.
+ *
+ * Creates the directory, and its @c images and @c labels subdirectories.
+ *
+ * @param[in] dir The dataset directory.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the directories
+ *         could not be created.
+ */
+int collect_open(const char* dir);
+
+/**
+ * @brief Releases the recordings not written and the queue lock.
+ */
+void collect_close(void);
+
+/**
+ * @brief Reads the collection statistics.
+ *
+ * @param[out] stats The statistics.
+ */
+void collect_get_stats(collect_stats_t* stats);
+
+/**
+ * @brief Task keeping the last camera frames, and queuing those meeting a trigger.
+ *
+ * @param[in] arg Unused.
+ * @return A pointer to a result of the task execution.
+ */
+void* collect_task(void* arg);
+
+/**
+ * @brief Task writing the queued examples, at idle scheduling priority.
+ *
+ * @param[in] arg Unused.
+ * @return A pointer to a result of the task execution.
+ */
+void* collect_writer_task(void* arg);
+
+#endif // DATASET_COLLECT_H
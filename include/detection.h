@@ -0,0 +1,59 @@
+/**
+ * @file detection.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the object detections exchanged with the inference.
+ *
+ * This file defines the layout of a detection as produced by YOLOv8n, shared
+ * by the C/C++ threads, the Python bindings and the inference process.
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DETECTION_H
+#define DETECTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/// Class index of the aliens, the only class being targeted.
+#define DETECTION_CLASS_ALIEN 0
+
+/**
+ * @brief Bounding box detected in a camera frame.
+ *
+ * Coordinates are given in camera frame pixels.
+ */
+typedef struct {
+    float x1;       ///< Left edge [px].
+    float y1;       ///< Top edge [px].
+    float x2;       ///< Right edge [px].
+    float y2;       ///< Bottom edge [px].
+    float conf;     ///< Confidence score, between 0 and 1.
+    int32_t cls;    ///< Class index.
+} detection_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DETECTION_H
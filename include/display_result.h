@@ -6,11 +6,15 @@
  *        inference results.
  *
  * This file defines the necessary functions and data structures to display
- * YOLOv8n inference results on the screen. The display task waits for an
- * image to be placed in the buffer, resizes it using linear interpolation
- * for better visibility, and then displays the image on the screen.
+ * YOLOv8n inference results on the screen. The display task sleeps until the
+ * targeting publishes the result of a new frame, resizes the latest camera
+ * frame using linear interpolation for better visibility, draws the
+ * detections, the tracks and the beam target over it, and then displays the
+ * image on the screen, directly through DRM/KMS or the framebuffer device,
+ * or in a window of the X11 display server.
  *
  * @see display_result.cpp
+ * @see overlay.h
  * 
  * @version 0.1
  * @date 2025-07-15
@@ -41,22 +45,55 @@
 #include "psig_utils.h"
 #include "ipc_elements.h"
 #include "camera.h"
+#include "overlay.h"
+#include "scanout.h"
 
-/// Largest screen dimension, usually the width [px].
+/// Width of the X11 window, the largest screen dimension [px].
 #define DISPLAY_WIDTH 1280
 
-/// Buffer where to read the frame to display. Holds only one frame.
-extern cv::Mat disp_buffer_0;
+/// Maximum waiting time for a result before checking for termination [ms].
+#define DISPLAY_WAIT_MS 100
+
+/**
+ * @brief Screen output of the display task.
+ */
+typedef enum {
+    DISPLAY_OUTPUT_AUTO = 0,    ///< DRM, then framebuffer device if no DRM device, then X11.
+    DISPLAY_OUTPUT_DRM,         ///< DRM/KMS dumb buffers, without display server.
+    DISPLAY_OUTPUT_FBDEV,       ///< Framebuffer device, without display server.
+    DISPLAY_OUTPUT_X11,         ///< OpenCV window on the X11 display server.
+} display_output_t;
+
+/// Longest extrapolation of the tracks to a newer frame [ms].
+#define DISPLAY_MAX_PREDICT_MS 500
+
+/**
+ * @brief Draws a detection result over a resized camera frame.
+ *
+ * Draws the boxes of the detections with their class and confidence,
+ * the confirmed tracks with their identifier, extrapolated to the capture
+ * time of the frame, and a crosshair on the target of the motors.
+ *
+ * @param[in,out] image The image, resized from the frame.
+ * @param[in] frame The camera frame the image is resized from.
+ * @param[in] overlay The detection result.
+ */
+void display_draw_overlay(cv::Mat& image, const frame_t* frame, const overlay_t* overlay);
 
 /**
  * @brief Task to display YOLOv8n inference results.
  * 
- * This task waits for a result image to be placed in the buffer,
- * then reads the buffer to display the image on the screen. To improve visibility,
- * since the resolution is likely to be low, it first resizes the image
- * using linear interpolation.
+ * This task waits for a new detection result with @c overlay_wait() ,
+ * then displays the latest camera frame from @c cam_bus with the result
+ * drawn over it. To improve visibility, since the resolution is likely to
+ * be low, it first resizes the frame using linear interpolation.
+ *
+ * Without display server, the frame is resized once straight into a buffer
+ * scanned out by the display controller (see @c scanout.h ), letterboxed to
+ * the screen, and the buffers are page flipped. Otherwise, it is shown in
+ * an OpenCV window on the X11 display.
  * 
- * @param[in] arg A pointer to any necessary arguments for the camera task.
+ * @param[in] arg A pointer to the requested @c display_output_t , or @c nullptr for automatic.
  * @return A pointer to a result of the task execution.
  */
 void* display_task(void* arg);
@@ -0,0 +1,261 @@
+/**
+ * @file flight_recorder.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the recording of the last seconds before an incident.
+ *
+ * This file provides a flight recorder: the compressed camera frames and the
+ * telemetry of the application (detections, motor commands and steps) are
+ * recorded continuously in fixed-size rings in memory, then the last
+ * @c FLIGHT_DUMP_SECONDS before a trigger are written to a file in a single
+ * sequential write. Nothing is written to disk, encoded nor formatted until
+ * a trigger:
+ * - a call to @c flight_trigger() , e.g. from Python;
+ * - the @c SIGUSR1 signal, e.g. @c kill -USR1 $(pidof python3) ;
+ * - a fault, i.e. missed steps detected on the laser dot.
+ *
+ * The frames are recorded as compressed by the camera (MJPEG), without
+ * encoding: with a camera delivering raw frames, only the telemetry is
+ * recorded. Telemetry events are written by their threads without lock,
+ * and also appended to the telemetry log if open (see @c telemetry_log.h ).
+ *
+ * The dump file @c DIR/flight-TIME-REASON.bin , where @c TIME is the
+ * wall-clock time of the trigger [ms], holds in the native byte order:
+ * - a @c flight_dump_header_t ;
+ * - @c event_count @c flight_event_t , oldest first;
+ * - @c frame_count frames, oldest first, each made of a @c flight_frame_t
+ *   and its JPEG data, padded to a multiple of 8 bytes.
+ *
+ * @see flight_recorder.c
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "detection.h"
+
+#define FLIGHT_FRAME_RING_SIZE (8u << 20)   ///< Memory of the compressed frames [bytes].
+#define FLIGHT_MAX_FRAMES 1024              ///< Maximum number of frames kept.
+#define FLIGHT_EVENTS 8192                  ///< Number of telemetry events kept (power of 2).
+#define FLIGHT_DUMP_SECONDS 10              ///< Time recorded before a trigger [s].
+#define FLIGHT_COOLDOWN_MS 5000             ///< Time after a dump during which triggers are ignored [ms].
+#define FLIGHT_WAIT_MS 100                  ///< Maximum waiting time before checking for triggers [ms].
+#define FLIGHT_MAGIC "EAFLIGHT"             ///< Signature of the dump files (8 characters).
+#define FLIGHT_VERSION 2                    ///< Version of the dump file format.
+
+/**
+ * @brief Reason of a dump.
+ */
+typedef enum {
+    FLIGHT_TRIGGER_API = 1,         ///< Call to @c flight_trigger() .
+    FLIGHT_TRIGGER_SIGNAL,          ///< @c SIGUSR1 signal.
+    FLIGHT_TRIGGER_MISSED_STEPS,    ///< Missed steps detected on the laser dot.
+} flight_trigger_t;
+
+/**
+ * @brief Kind of telemetry event.
+ */
+typedef enum {
+    FLIGHT_EVENT_DETECTION = 1,     ///< Detection submitted to the targeting.
+    FLIGHT_EVENT_COMMAND,           ///< Position sent to the motors.
+    FLIGHT_EVENT_STEPS,             ///< Move of a motor in point mode.
+    FLIGHT_EVENT_RATE,              ///< Step rate change of a motor in velocity mode.
+    FLIGHT_EVENT_TRIGGER,           ///< Trigger of a dump.
+} flight_event_type_t;
+
+/**
+ * @brief Telemetry event, of one cache line.
+ */
+typedef struct {
+    uint64_t seq;               ///< Event number plus 1, 0 while being written (internal).
+    uint64_t timestamp_ns;      ///< Time of the event (@c CLOCK_MONOTONIC ) [ns].
+    uint32_t type;              ///< A @c flight_event_type_t .
+    uint32_t reserved;          ///< Unused, 0.
+    union {
+        struct {
+            uint64_t frame_id;  ///< Frame of the detection, 0 if unknown.
+            uint32_t index;     ///< Index of the detection in its frame.
+            uint32_t count;     ///< Number of detections of the frame, 0 for a frame without detection.
+            detection_t det;    ///< The detection, zeroed without detection.
+        } detection;
+        struct {
+            uint32_t velocity;  ///< 1 for a target followed in velocity mode, 0 for a position.
+            float x;            ///< X-position [px].
+            float y;            ///< Y-position [px].
+            float vx;           ///< X-velocity in velocity mode [px/s].
+            float vy;           ///< Y-velocity in velocity mode [px/s].
+        } command;
+        struct {
+            uint32_t axis;      ///< 0 for the X-axis, 1 for the Y-axis.
+            int32_t position;   ///< Step position after the move [steps].
+            int32_t moved;      ///< Steps planned by the move [steps].
+            int32_t slip;       ///< Missed steps corrected before the move [steps].
+            int32_t emitted;    ///< Steps actually emitted by the move [steps].
+        } steps;
+        struct {
+            uint32_t axis;      ///< 0 for the X-axis, 1 for the Y-axis.
+            float rate;         ///< New signed step rate [Hz].
+            float estimate;     ///< Estimated position [px].
+        } rate;
+        struct {
+            uint32_t reason;    ///< A @c flight_trigger_t .
+        } trigger;
+        uint8_t payload[40];    ///< Size of the event data.
+    } u;
+} flight_event_t;
+
+/**
+ * @brief Header of a frame in the dump file, followed by its JPEG data.
+ */
+typedef struct {
+    uint64_t frame_id;      ///< Capture sequence number.
+    uint64_t timestamp_ns;  ///< Capture time (@c CLOCK_MONOTONIC ) [ns].
+    uint32_t width;         ///< Frame width [px].
+    uint32_t height;        ///< Frame height [px].
+    uint32_t size;          ///< Size of the JPEG data [bytes], without padding.
+    uint32_t reserved;      ///< Unused, 0.
+} flight_frame_t;
+
+/**
+ * @brief Header of a dump file.
+ */
+typedef struct {
+    char magic[8];          ///< @c FLIGHT_MAGIC , not terminated.
+    uint32_t version;       ///< @c FLIGHT_VERSION .
+    uint32_t reason;        ///< A @c flight_trigger_t .
+    uint64_t trigger_ns;    ///< Time of the trigger (@c CLOCK_MONOTONIC ) [ns].
+    uint64_t realtime_ns;   ///< Wall-clock time of the trigger (@c CLOCK_REALTIME ) [ns].
+    uint64_t event_count;   ///< Number of events.
+    uint64_t frame_count;   ///< Number of frames.
+    uint64_t frame_bytes;   ///< Size of the frames, headers and padding included [bytes].
+} flight_dump_header_t;
+
+/**
+ * @brief Statistics of the flight recorder.
+ */
+typedef struct {
+    uint64_t frames;        ///< Number of frames recorded.
+    uint64_t raw_frames;    ///< Number of frames not recorded, without compressed data.
+    uint64_t events;        ///< Number of events recorded.
+    uint64_t dumps;         ///< Number of dump files written.
+    uint64_t ignored;       ///< Number of triggers ignored during the cooldown.
+    uint64_t failed;        ///< Number of dump files that could not be written.
+} flight_stats_t;
+
+/**
+ * @brief Allocates the rings, and starts recording the telemetry.
+ *
+ * @param[in] dir Directory of the dump files, created if missing.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the directory
+ *         could not be created or the memory allocated.
+ */
+int flight_open(const char* dir);
+
+/**
+ * @brief Stops recording, and frees the rings.
+ */
+void flight_close(void);
+
+/**
+ * @brief Requests a dump of the recording, written by the recording thread.
+ *
+ * Can be called from any thread.
+ *
+ * @param[in] reason A @c flight_trigger_t .
+ */
+void flight_trigger(flight_trigger_t reason);
+
+/**
+ * @brief Records the detections of a frame.
+ *
+ * Does nothing until @c flight_open() or @c telemetry_open() .
+ *
+ * @param[in] dets The detections.
+ * @param[in] n Number of detections.
+ * @param[in] frame_id Frame the detections come from, 0 if unknown.
+ */
+void flight_record_detections(const detection_t* dets, size_t n, uint64_t frame_id);
+
+/**
+ * @brief Records a position sent to the motors.
+ *
+ * Does nothing until @c flight_open() or @c telemetry_open() .
+ *
+ * @param[in] x The X-position [px].
+ * @param[in] y The Y-position [px].
+ * @param[in] vx The X-velocity [px/s], 0 for a position at rest.
+ * @param[in] vy The Y-velocity [px/s], 0 for a position at rest.
+ * @param[in] velocity @c true for a target followed in velocity mode.
+ */
+void flight_record_command(float x, float y, float vx, float vy, bool velocity);
+
+/**
+ * @brief Records a move of a motor in point mode.
+ *
+ * Does nothing until @c flight_open() or @c telemetry_open() .
+ *
+ * @param[in] axis 0 for the X-axis, 1 for the Y-axis.
+ * @param[in] position Step position after the move [steps].
+ * @param[in] moved Steps planned by the move [steps].
+ * @param[in] emitted Steps actually emitted by the move [steps].
+ * @param[in] slip Missed steps corrected before the move [steps].
+ */
+void flight_record_steps(uint32_t axis, int32_t position, int32_t moved, int32_t emitted, int32_t slip);
+
+/**
+ * @brief Records a step rate change of a motor in velocity mode.
+ *
+ * Does nothing until @c flight_open() or @c telemetry_open() .
+ *
+ * @param[in] axis 0 for the X-axis, 1 for the Y-axis.
+ * @param[in] rate The new signed step rate [Hz].
+ * @param[in] estimate The estimated position [px].
+ */
+void flight_record_rate(uint32_t axis, float rate, float estimate);
+
+/**
+ * @brief Reads the flight recorder statistics.
+ *
+ * @param[out] stats The statistics.
+ */
+void flight_get_stats(flight_stats_t* stats);
+
+/**
+ * @brief Task recording the compressed camera frames, and writing the dumps.
+ *
+ * @param[in] arg Unused.
+ * @return A pointer to a result of the task execution.
+ */
+void* flight_task(void* arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLIGHT_RECORDER_H
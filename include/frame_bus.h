@@ -0,0 +1,189 @@
+/**
+ * @file frame_bus.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the publish/subscribe frame bus.
+ *
+ * A frame bus hands reference counted frames from one publisher, such as the
+ * camera thread, to any number of subscribers (inference, display, recorder,
+ * streamer...). Each subscriber has its own policy:
+ * - @c FRAME_BUS_LATEST : only keeps the most recent frame;
+ * - @c FRAME_BUS_QUEUE : keeps up to a given number of frames, dropping the
+ *   oldest one when full;
+ * - @c FRAME_BUS_EVERY_NTH : only keeps the most recent of every Nth frame.
+ *
+ * Publishing never waits for a subscriber: a slow subscriber only drops its
+ * own frames, without holding back the publisher or the other subscribers.
+ * Frames are shared without copy, each subscriber holding its own references.
+ *
+ * @see frame_bus.c
+ * @see frame_pool.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_BUS_H
+#define FRAME_BUS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "frame_pool.h"
+
+#define FRAME_BUS_MAX_SUBSCRIBERS 8 ///< Maximum number of subscribers per bus.
+#define FRAME_BUS_MAX_DEPTH 8       ///< Maximum queue depth of a subscriber.
+#define FRAME_BUS_RESERVED 1        ///< Frames of the pool left to the publisher.
+
+// All the subscribers holding their frames must leave one to the camera,
+// which otherwise drops every frame: the bus refuses the subscriptions
+// beyond the pool, which must at least fit the deepest queue.
+#if FRAME_POOL_SIZE < FRAME_BUS_MAX_DEPTH + 1 + FRAME_BUS_RESERVED
+#error "FRAME_POOL_SIZE too small for FRAME_BUS_MAX_DEPTH"
+#endif
+
+/**
+ * @brief Enumeration to represent the delivery policy of a subscriber.
+ */
+typedef enum {
+    FRAME_BUS_LATEST,   ///< Keep only the most recent frame.
+    FRAME_BUS_QUEUE,    ///< Keep a bounded queue of frames, dropping the oldest.
+    FRAME_BUS_EVERY_NTH ///< Keep only the most recent of every Nth frame.
+} frame_bus_policy_t;
+
+/**
+ * @brief Subscriber of a frame bus, with its pending frames.
+ */
+typedef struct {
+    bool active;                            ///< The subscription is in use.
+    const char* name;                       ///< Name, for statistics.
+    frame_bus_policy_t policy;              ///< Delivery policy.
+    uint32_t depth;                         ///< Queue depth (1 unless @c FRAME_BUS_QUEUE ).
+    uint32_t nth;                           ///< Frame decimation (1 unless @c FRAME_BUS_EVERY_NTH ).
+    uint32_t counter;                       ///< Published frames counter, for decimation.
+    frame_t* queue[FRAME_BUS_MAX_DEPTH];    ///< Pending frames, oldest first from @c head .
+    uint32_t head;                          ///< Index of the oldest pending frame.
+    uint32_t count;                         ///< Number of pending frames.
+    uint32_t held;                          ///< Frames kept after being received, besides the one processed.
+    uint64_t delivered;                     ///< Number of frames received.
+    uint64_t dropped;                       ///< Number of frames dropped by the policy.
+    pthread_mutex_t mutex;                  ///< Protects the pending frames.
+    pthread_cond_t cond;                    ///< Signaled when a frame is pending.
+} frame_sub_t;
+
+/**
+ * @brief Frame bus, connecting one publisher to its subscribers.
+ */
+typedef struct {
+    frame_sub_t subs[FRAME_BUS_MAX_SUBSCRIBERS];    ///< Subscribers slots.
+    uint32_t committed;                             ///< Frames the subscribers can hold at once.
+    pthread_mutex_t mutex;                          ///< Protects subscriptions.
+    bool closed;                                    ///< Receivers stop waiting when set.
+} frame_bus_t;
+
+/**
+ * @brief Initializes a frame bus without subscribers.
+ *
+ * @param[out] bus The bus to initialize.
+ */
+void frame_bus_init(frame_bus_t* bus);
+
+/**
+ * @brief Wakes up all the subscribers waiting for a frame, for shutdown.
+ *
+ * @param[in,out] bus The bus to close.
+ */
+void frame_bus_close(frame_bus_t* bus);
+
+/**
+ * @brief Releases the pending frames and destroys the bus.
+ *
+ * @param[in,out] bus The bus to destroy.
+ */
+void frame_bus_destroy(frame_bus_t* bus);
+
+/**
+ * @brief Attaches a new subscriber to a bus.
+ *
+ * The subscriber can hold its pending frames and the one it processes:
+ * the subscription is refused if the subscribers could then hold more
+ * frames than the pool has, less @c FRAME_BUS_RESERVED .
+ *
+ * @param[in,out] bus The bus to subscribe to.
+ * @param[in] name Name of the subscriber, for statistics (string literal).
+ * @param[in] policy The delivery policy.
+ * @param[in] param Queue depth for @c FRAME_BUS_QUEUE (at most
+ *            @c FRAME_BUS_MAX_DEPTH ), N for @c FRAME_BUS_EVERY_NTH ,
+ *            ignored for @c FRAME_BUS_LATEST .
+ * @return The subscriber, or @c NULL if the bus has no free slot
+ *         or not enough frames left.
+ */
+frame_sub_t* frame_bus_subscribe(frame_bus_t* bus, const char* name, frame_bus_policy_t policy, uint32_t param);
+
+/**
+ * @brief Commits the frames a subscriber keeps after receiving them,
+ * besides the one it processes.
+ *
+ * @param[in,out] bus The bus the subscriber is attached to.
+ * @param[in,out] sub The subscriber.
+ * @param[in] frames Number of frames kept.
+ * @return @c true if the pool has enough frames left, otherwise @c false
+ *         and the subscriber keeps its previous commitment.
+ */
+bool frame_sub_hold(frame_bus_t* bus, frame_sub_t* sub, uint32_t frames);
+
+/**
+ * @brief Detaches a subscriber from its bus and releases its pending frames.
+ *
+ * @param[in,out] bus The bus the subscriber is attached to.
+ * @param[in,out] sub The subscriber. Can be @c NULL .
+ */
+void frame_bus_unsubscribe(frame_bus_t* bus, frame_sub_t* sub);
+
+/**
+ * @brief Publishes a frame to all the subscribers of a bus.
+ *
+ * Each subscriber keeping the frame takes its own reference: the caller
+ * keeps its reference and must release it.
+ *
+ * @param[in,out] bus The bus to publish on.
+ * @param[in] frame The frame to publish.
+ */
+void frame_bus_publish(frame_bus_t* bus, frame_t* frame);
+
+/**
+ * @brief Waits for the next pending frame of a subscriber.
+ *
+ * @param[in,out] bus The bus the subscriber is attached to.
+ * @param[in,out] sub The subscriber.
+ * @param[in] timeout_ms Maximum waiting time [ms], 0 to only poll.
+ * @return The oldest pending frame, whose reference is transferred
+ *         to the caller, or @c NULL on timeout or if the bus is closed.
+ */
+frame_t* frame_sub_receive(frame_bus_t* bus, frame_sub_t* sub, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_BUS_H
@@ -0,0 +1,76 @@
+/**
+ * @file frame_clock.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the capture times of the latest camera frames.
+ *
+ * Detections only carry the identifier of their frame, which may be back in
+ * the pool by the time they are submitted. This file provides a small ring
+ * recording the capture time of the latest frames, so that the age of the
+ * detections can still be known.
+ *
+ * The ring has a single writer (the camera thread) and lock-free readers.
+ *
+ * @see frame_clock.c
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_CLOCK_H
+#define FRAME_CLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define FRAME_CLOCK_SIZE 64     ///< Number of frames whose capture time is kept.
+
+/**
+ * @brief Records the capture time of a frame.
+ *
+ * @note Must only be called by the camera thread.
+ *
+ * @param[in] frame_id Capture sequence number, not 0.
+ * @param[in] timestamp_ns Capture time (@c CLOCK_MONOTONIC ) [ns].
+ */
+void frame_clock_record(uint64_t frame_id, uint64_t timestamp_ns);
+
+/**
+ * @brief Looks up the capture time of a recent frame.
+ *
+ * @param[in] frame_id Capture sequence number.
+ * @return The capture time (@c CLOCK_MONOTONIC ) [ns], or 0 if the frame
+ *         is unknown or older than the last @c FRAME_CLOCK_SIZE frames.
+ */
+uint64_t frame_clock_lookup(uint64_t frame_id);
+
+/**
+ * @brief Returns the current time.
+ *
+ * @return The current time (@c CLOCK_MONOTONIC ) [ns].
+ */
+uint64_t frame_clock_now(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_CLOCK_H
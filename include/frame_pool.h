@@ -0,0 +1,180 @@
+/**
+ * @file frame_pool.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the preallocated frame buffers pool.
+ *
+ * This file provides a fixed pool of frame buffers shared by the camera,
+ * inference and display threads. All buffers are allocated once, in a single
+ * cache-line-aligned block, when initializing the pool. Frames are handed
+ * between threads as reference counted handles: a buffer goes back to the
+ * pool when its last reference is released. The steady-state loops therefore
+ * never allocate memory for frames.
+ *
+ * The buffers can also be allocated in a POSIX shared memory object, so that
+ * another process can map them and read the frames without copy.
+ *
+ * Each frame also has a buffer for its compressed data, as delivered by the
+ * camera, so that the consumers that store or stream the frames can use it
+ * without encoding them again.
+ *
+ * @see frame_pool.c
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+
+// Each LATEST subscriber of the camera bus can hold 2 frames (pending and being
+// processed), and the shared memory publisher also holds its ring and the lease:
+// the bus refuses the subscriptions exceeding the pool, see frame_bus.h .
+#define FRAME_POOL_SIZE 24      ///< Number of frame buffers in the pool.
+#define FRAME_POOL_ALIGN 64     ///< Alignment of the frame buffers [bytes] (cache line).
+
+// Size of the camera frames, which the image processing buffers are sized from.
+#define FRAME_WIDTH 320         ///< Frame width [px].
+#define FRAME_HEIGHT 240        ///< Frame height [px].
+
+/**
+ * @brief Frame buffer of the pool, with its metadata.
+ *
+ * Metadata are written by the thread that acquired the frame,
+ * before sharing it with other threads.
+ */
+typedef struct {
+    uint8_t* data;          ///< Pixel data (BGR, 8 bits per channel).
+    size_t capacity;        ///< Size of the pixel buffer [bytes].
+    size_t size;            ///< Size of the pixel data [bytes].
+    uint8_t* jpeg;          ///< Compressed data (JPEG) as delivered by the camera, private to the process.
+    size_t jpeg_capacity;   ///< Size of the compressed data buffer [bytes].
+    size_t jpeg_size;       ///< Size of the compressed data [bytes], 0 if none.
+    int width;              ///< Frame width [px].
+    int height;             ///< Frame height [px].
+    uint64_t frame_id;      ///< Capture sequence number, 0 if not a camera frame.
+    uint64_t timestamp_ns;  ///< Capture time, stamped by the camera driver (@c CLOCK_MONOTONIC ) [ns].
+    uint32_t refcount;      ///< Number of references, 0 if the buffer is free.
+} frame_t;
+
+/**
+ * @brief Usage statistics of the pool.
+ */
+typedef struct {
+    uint32_t size;          ///< Number of frame buffers.
+    uint32_t in_use;        ///< Number of frame buffers currently referenced.
+    uint32_t peak_in_use;   ///< Maximum number of frame buffers referenced at once.
+    uint64_t acquired;      ///< Number of successful acquisitions.
+    uint64_t exhausted;     ///< Number of failed acquisitions (no free buffer).
+} frame_pool_stats_t;
+
+/**
+ * @brief Allocates the frame buffers of the pool.
+ *
+ * @param[in] buffer_size Size of each frame buffer [bytes].
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the memory
+ *         could not be allocated.
+ */
+int frame_pool_init(size_t buffer_size);
+
+/**
+ * @brief Allocates the frame buffers of the pool in a shared memory object.
+ *
+ * @param[in] buffer_size Size of each frame buffer [bytes].
+ * @param[in] shm_name Name of the POSIX shared memory object (string literal),
+ *            removed when closing the pool.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the shared memory
+ *         could not be created or mapped.
+ */
+int frame_pool_init_shared(size_t buffer_size, const char* shm_name);
+
+/**
+ * @brief Frees the frame buffers of the pool.
+ *
+ * @warning No frame must be referenced anymore.
+ */
+void frame_pool_close(void);
+
+/**
+ * @brief Acquires a free frame buffer.
+ *
+ * The returned frame has a single reference, owned by the caller,
+ * and its metadata are reset.
+ *
+ * @return A frame, or @c NULL if the pool is exhausted.
+ */
+frame_t* frame_pool_acquire(void);
+
+/**
+ * @brief Adds a reference to a frame.
+ *
+ * @param[in,out] frame The frame to reference.
+ */
+void frame_ref(frame_t* frame);
+
+/**
+ * @brief Releases a reference to a frame.
+ *
+ * The frame buffer goes back to the pool with its last reference.
+ *
+ * @param[in,out] frame The frame to release. Can be @c NULL .
+ */
+void frame_unref(frame_t* frame);
+
+/**
+ * @brief Finds the frame owning a pixel buffer.
+ *
+ * @param[in] data A pointer to the pixel data of a frame.
+ * @return The frame, or @c NULL if @p data does not belong to the pool.
+ */
+frame_t* frame_pool_find(const uint8_t* data);
+
+/**
+ * @brief Gets the offset of the pixel data of a frame in the pool memory.
+ *
+ * @param[in] frame A frame of the pool.
+ * @return The offset [bytes].
+ */
+size_t frame_pool_offset(const frame_t* frame);
+
+/**
+ * @brief Gets the size of the pool memory.
+ *
+ * @return The size of all the frame buffers [bytes].
+ */
+size_t frame_pool_bytes(void);
+
+/**
+ * @brief Gets the usage statistics of the pool.
+ *
+ * @param[out] stats The statistics.
+ */
+void frame_pool_get_stats(frame_pool_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_POOL_H
@@ -0,0 +1,65 @@
+/**
+ * @file gray_downscale.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the downscaling of the camera frames to grayscale.
+ *
+ * The correlation tracker and the motion gate both work on small grayscale
+ * copies of the camera frames: each output pixel averages a square block of
+ * BGR pixels, its luminance being approximated by (B + 2G + R) / 4.
+ *
+ * The factors 2 and 4 use NEON when available.
+ *
+ * @see gray_downscale.c
+ * @see corr_tracker.h
+ * @see motion_gate.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GRAY_DOWNSCALE_H
+#define GRAY_DOWNSCALE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+ * @brief Downscales a BGR frame into a grayscale frame, averaging blocks of
+ * @p scale x @p scale pixels.
+ *
+ * The output frame is (@p width / @p scale) x (@p height / @p scale) pixels,
+ * the last rows and columns not filling a block being dropped.
+ *
+ * @param[in] src The pixels of the frame (BGR, 8 bits per channel).
+ * @param[in] width The frame width [px].
+ * @param[in] height The frame height [px].
+ * @param[in] scale The downscaling factor, at least 1.
+ * @param[out] dst The pixels of the grayscale frame, row by row.
+ */
+void gray_downscale(const uint8_t* src, int width, int height, int scale, uint8_t* dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GRAY_DOWNSCALE_H
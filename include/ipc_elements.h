@@ -7,16 +7,11 @@
  *
  * This file contains the declaration of the functions for initializing, releasing,
  * and closing IPC mechanisms (mutexes and semaphores) used for inter-thread synchronization
- * and communication, such as managing buffers for camera, motors, and display tasks.
+ * and communication, such as the frame bus between the camera and the inference,
+ * display or tracking tasks, and the position handoff to the motors.
  *
  * @see ipc_elements.c
- *
- * @note Uncomment statements commented with two pairs of dashes // ... //
- * to run the thread that displays inference results on screen.
- * Also modify ipc_elements.h, ipc_elements.cpp and yolov8n_inference.py
- * accordingly.
- *
- * @todo provide an easy way to display the results or not.
+ * @see frame_bus.h
  *
  * @see display_result.h and display_result.cpp
  * @see ipc_elements.h and ipc_elements.cpp
@@ -53,15 +48,26 @@ extern "C" {
 #include <stdint.h>
 #include <semaphore.h>
 
+#include "frame_bus.h"
+
 /**
- * @brief Number of threads in this application.
+ * @brief Number of threads always running in this application.
  *
  * 1 thread for the camera              (C++)
- * 1 thread for running inferences      (Python)
+ * 1 thread for running inferences      (Python),
+ *   or 2 threads linking to the inference process in shared memory mode (C)
+ * 1 thread selecting the targets       (C)
+ * 1 thread following the targets       (C)
  * 2 threads to drive the motors        (C)
- * 1 thread to display inference result (C++)
+ *
+ * Optional threads, such as the display thread (C++), the visual servoing thread (C),
+ * the MJPEG streaming thread (C++), the 2 dataset collection threads (C++) or the
+ * flight recorder thread (C), are added to @c thread_number when spawned.
  */
-#define THREAD_NUMBER 4 //5// when displaying results.
+#define THREAD_NUMBER 6
+
+/// Number of threads to wait for before releasing the IPC resources.
+extern volatile uint8_t thread_number;
 
 /// Counter for the number of threads that are ready.
 extern volatile uint8_t thread_ready_num;
@@ -71,13 +77,14 @@ extern sem_t data_x_ready_sem;  ///< Semaphore for signaling when X coordinate d
 extern sem_t data_y_ready_sem;  ///< Semaphore for signaling when Y coordinate data is ready.
 extern sem_t data_x_done_sem;   ///< Semaphore for signaling when X coordinate data are consumed.
 extern sem_t data_y_done_sem;   ///< Semaphore for signaling when Y coordinate data are consumed.
-extern pthread_mutex_t cam_buffer_mutex;    ///< Mutex for controlling access to the camera buffer.
-extern pthread_mutex_t disp_buffer_mutex;   ///< Mutex for controlling access to the display buffer.
+
+// Frame buses
+extern frame_bus_t cam_bus;     ///< Bus publishing the captured camera frames.
 
 /**
- * @brief Initializes the IPC mechanisms (mutexes and semaphores).
+ * @brief Initializes the IPC mechanisms (frame buses and semaphores).
  * 
- * This function initializes the necessary mutexes and semaphores used for
+ * This function initializes the necessary frame buses and semaphores used for
  * thread synchronization and communication.
  */
 void ipc_init(void);
@@ -92,7 +99,7 @@ void ipc_release(void);
 /**
  * @brief Closes and cleans up the IPC resources.
  * 
- * This function destroys the initialized mutexes and semaphores, freeing any
+ * This function destroys the initialized frame buses and semaphores, freeing any
  * allocated resources. It is intended to be called when the system is shutting down.
  */
 void ipc_close(void);
@@ -0,0 +1,98 @@
+/**
+ * @file laser_dot.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the detection of the laser dot in the camera frames.
+ *
+ * The laser dot is the brightest red spot of the frame. Its center is often
+ * saturated to white by the camera, while its halo stays red: the dot is
+ * found as the centroid of the bright red pixels, whose red channel exceeds
+ * both other channels by a margin.
+ *
+ * Over a whole frame, the dot is searched in the block of pixels counting
+ * the most bright red pixels, so that a red object elsewhere in the frame
+ * does not shift the centroid. Around an expected position, such as the
+ * target of the motors, only a small region is searched.
+ *
+ * The threshold and the centroid use NEON when available.
+ *
+ * @see laser_dot.c
+ * @see calib_sweep.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LASER_DOT_H
+#define LASER_DOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "frame_pool.h"
+
+#define LASER_DOT_MIN_RED 160       ///< Minimum red channel of a dot pixel.
+#define LASER_DOT_MIN_EXCESS 50     ///< Minimum excess of the red channel over the green and blue ones.
+#define LASER_DOT_MIN_PIXELS 3      ///< Minimum number of pixels of a dot.
+#define LASER_DOT_BLOCK 16          ///< Size of the blocks searched over a whole frame [px].
+
+/**
+ * @brief Laser dot found in a frame.
+ */
+typedef struct {
+    float x;            ///< X-position of the centroid [px].
+    float y;            ///< Y-position of the centroid [px].
+    uint32_t pixels;    ///< Number of bright red pixels.
+} laser_dot_t;
+
+/**
+ * @brief Finds the laser dot in a region of a frame.
+ *
+ * @param[in] frame The frame (BGR).
+ * @param[in] x The left edge of the region [px], clipped to the frame.
+ * @param[in] y The top edge of the region [px], clipped to the frame.
+ * @param[in] w The width of the region [px].
+ * @param[in] h The height of the region [px].
+ * @param[out] dot The centroid of the bright red pixels of the region.
+ * @return @c true if the region holds at least @c LASER_DOT_MIN_PIXELS
+ *         bright red pixels, otherwise @c false .
+ */
+bool laser_dot_find_roi(const frame_t* frame, int x, int y, int w, int h, laser_dot_t* dot);
+
+/**
+ * @brief Finds the laser dot in a whole frame.
+ *
+ * The centroid is computed around the block of @c LASER_DOT_BLOCK pixels
+ * holding the most bright red pixels.
+ *
+ * @param[in] frame The frame (BGR).
+ * @param[out] dot The laser dot.
+ * @return @c true if a dot is found, otherwise @c false .
+ */
+bool laser_dot_find(const frame_t* frame, laser_dot_t* dot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LASER_DOT_H
@@ -0,0 +1,125 @@
+/**
+ * @file log_utils.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the asynchronous logging module.
+ *
+ * This file provides a logger meant to be called from time-critical threads,
+ * such as the stepper motors tasks. Instead of formatting and writing text
+ * with @c printf() , a log call only stores a compact binary record (level,
+ * timestamp, format string address, raw arguments and copies of the string
+ * arguments) into a lock-free ring
+ * owned by the calling thread. A background thread later formats the records
+ * and writes them to the standard output.
+ *
+ * @see log_utils.c
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOG_UTILS_H
+#define LOG_UTILS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define LOG_MAX_THREADS 16  ///< Maximum number of threads owning a log ring.
+#define LOG_RING_SIZE 256   ///< Number of records per thread ring (power of 2).
+#define LOG_MAX_ARGS 6      ///< Maximum number of arguments per record.
+#define LOG_STRING_SIZE 128 ///< Size of the copies of the string arguments per record [bytes].
+
+/**
+ * @brief Enumeration to represent log levels.
+ *
+ * Records with a level lower than the current level are discarded
+ * before being written to a ring.
+ */
+typedef enum {
+    LOG_DEBUG,      ///< Verbose messages, such as each received coordinate.
+    LOG_INFO,       ///< Regular messages (@c [Info] ).
+    LOG_WARNING,    ///< Unexpected but recoverable events (@c [Warning] ).
+    LOG_ERROR       ///< Failures (@c [Error] ).
+} log_level_t;
+
+/**
+ * @brief Starts the background thread in charge of writing the records.
+ *
+ * Until this function is called, or after @c log_close() , @c log_write()
+ * formats and prints messages synchronously.
+ *
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the thread
+ *         could not be created.
+ */
+int log_init(void);
+
+/**
+ * @brief Stops the background thread and writes the remaining records.
+ *
+ * The number of dropped records, if any, is printed as a warning.
+ */
+void log_close(void);
+
+/**
+ * @brief Sets the minimum level of the records to keep.
+ *
+ * @param[in] level The new minimum level.
+ */
+void log_set_level(log_level_t level);
+
+/**
+ * @brief Gets the minimum level of the records to keep.
+ *
+ * @return The current minimum level.
+ */
+log_level_t log_get_level(void);
+
+/**
+ * @brief Gets the number of records dropped because a ring was full.
+ *
+ * @return The total number of dropped records since startup.
+ */
+uint64_t log_dropped(void);
+
+/**
+ * @brief Logs a message without blocking the calling thread.
+ *
+ * The message is not formatted here: the address of @p fmt and up to
+ * @c LOG_MAX_ARGS arguments are copied into the ring of the calling thread,
+ * the @c %s arguments being copied into the record, within a total of
+ * @c LOG_STRING_SIZE bytes beyond which they are truncated.
+ * If the ring is full the record is dropped and counted.
+ * The level prefix and the trailing new line are added when formatting.
+ *
+ * @param[in] level The level of the message.
+ * @param[in] fmt A @c printf() format string, without trailing new line.
+ *
+ * @warning @p fmt must be a string literal, or at least outlive the call,
+ * since it is only read by the background thread.
+ */
+void log_write(log_level_t level, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOG_UTILS_H
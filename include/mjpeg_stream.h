@@ -0,0 +1,93 @@
+/**
+ * @file mjpeg_stream.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the MJPEG streaming of the camera frames over HTTP.
+ *
+ * This file provides a small HTTP server on the loopback interface, serving
+ * the camera frames as a @c multipart/x-mixed-replace MJPEG stream, viewed
+ * by a browser or a video player on the board, or remotely through an SSH
+ * tunnel. Each client selects its stream in the query string:
+ * - @c fps : frame rate, from 1 to @c FRAME_FPS (default @c STREAM_DEFAULT_FPS );
+ * - @c overlay : @c 1 to draw the detections over the frames.
+ *
+ * e.g. @c http://localhost:8080/stream?fps=30&overlay=1 .
+ *
+ * Without overlay, the compressed data delivered by the camera is forwarded
+ * untouched. With overlay, the frame is drawn and encoded once for all the
+ * clients that requested it. Nothing is encoded, nor even received from the
+ * camera, while no client is connected. A client still sending its last
+ * frame skips the newer ones, so that a slow client never holds back the
+ * server, let alone the camera or the inference.
+ *
+ * @see mjpeg_stream.cpp
+ * @see display_result.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MJPEG_STREAM_H
+#define MJPEG_STREAM_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+
+#include "psig_utils.h"
+#include "log_utils.h"
+#include "perf_counters.h"
+#include "ipc_elements.h"
+#include "camera.h"
+#include "overlay.h"
+#include "display_result.h"
+
+#define STREAM_DEFAULT_PORT 8080    ///< Default TCP port of the server.
+#define STREAM_MAX_CLIENTS 4        ///< Maximum number of clients at once.
+#define STREAM_DEFAULT_FPS 15       ///< Frame rate of a client without @c fps in its query [FPS].
+#define STREAM_JPEG_QUALITY 80      ///< Quality of the encoded frames with overlay (0-100).
+#define STREAM_REQUEST_SIZE 1024    ///< Maximum size of a request [bytes].
+#define STREAM_WAIT_MS 100          ///< Maximum waiting time without client before checking for termination [ms].
+#define STREAM_TICK_MS 5            ///< Period checking for new frames with clients [ms].
+
+/**
+ * @brief Statistics of the MJPEG streaming.
+ */
+typedef struct {
+    uint64_t clients;       ///< Number of clients served.
+    uint64_t forwarded;     ///< Number of frames sent as compressed by the camera.
+    uint64_t encoded;       ///< Number of frames encoded by the server.
+    uint64_t sent;          ///< Number of frames sent to the clients.
+    uint64_t skipped;       ///< Number of frames skipped by clients still sending the previous one.
+} stream_stats_t;
+
+/**
+ * @brief Reads the MJPEG streaming statistics.
+ *
+ * @param[out] stats The statistics.
+ */
+void stream_get_stats(stream_stats_t* stats);
+
+/**
+ * @brief Task serving the MJPEG streams.
+ *
+ * @param[in] arg A pointer to the TCP port ( @c uint16_t ).
+ * @return A pointer to a result of the task execution.
+ */
+void* stream_task(void* arg);
+
+#endif // MJPEG_STREAM_H
@@ -0,0 +1,158 @@
+/**
+ * @file motion_gate.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the motion gate skipping the inference on a static scene.
+ *
+ * Most of the time, the scene seen by the camera does not change, and running
+ * the detector on every frame only wastes the TPU, the CPU and power. This file
+ * provides a cheap change detector, run by the camera thread on every frame:
+ * - the frame is downscaled by @c MOTION_SCALE into a grayscale frame;
+ * - the sum of absolute differences (SAD) with a reference frame is computed
+ *   by tiles of @c MOTION_TILE x @c MOTION_TILE downscaled pixels, giving a
+ *   change map of the tiles whose mean difference exceeds @c MOTION_THRESHOLD ;
+ * - a frame changing at least @c MOTION_MIN_TILES tiles becomes the reference.
+ *
+ * The reference only follows the changes, so that a slow move adds up until it
+ * is detected. The consumer of the frames for the inference admits a frame if
+ * the scene changed since the last frame it admitted, or every
+ * @c MOTION_KEEPALIVE_MS ; for the frames skipped, the last detections are
+ * submitted again to the tracks, so that the tracks of static targets live on,
+ * without being recorded as detection results (see @c targeting_submit_reused() ).
+ *
+ * The downscaling and the SAD use NEON when available.
+ *
+ * @see motion_gate.c
+ * @see targeting.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "frame_pool.h"
+#include "detection.h"
+
+#define MOTION_SCALE 4              ///< Downscaling factor of the frames.
+#define MOTION_TILE 16              ///< Size of the tiles of the change map [downscaled px].
+#define MOTION_THRESHOLD 6          ///< Mean absolute difference above which a tile changed [gray levels].
+#define MOTION_MIN_TILES 1          ///< Number of changed tiles making a frame change.
+#define MOTION_KEEPALIVE_MS 1000    ///< Maximum time between two inferences [ms].
+
+/// Number of tiles of a camera frame.
+#define MOTION_MAX_TILES (((FRAME_WIDTH / MOTION_SCALE + MOTION_TILE - 1) / MOTION_TILE) * \
+                          ((FRAME_HEIGHT / MOTION_SCALE + MOTION_TILE - 1) / MOTION_TILE))
+
+/**
+ * @brief Change map of the last frame analyzed.
+ */
+typedef struct {
+    uint64_t frame_id;                  ///< Frame analyzed, 0 if none.
+    uint32_t cols;                      ///< Number of tile columns.
+    uint32_t rows;                      ///< Number of tile rows.
+    uint32_t changed;                   ///< Number of tiles changed.
+    uint8_t diff[MOTION_MAX_TILES];     ///< Mean absolute difference of each tile, row by row [gray levels].
+} motion_map_t;
+
+/**
+ * @brief Statistics of the motion gate.
+ */
+typedef struct {
+    uint64_t frames;        ///< Number of frames analyzed.
+    uint64_t changes;       ///< Number of frames changing the scene.
+    uint64_t admitted;      ///< Number of frames admitted to the inference on a change.
+    uint64_t keepalives;    ///< Number of frames admitted to the inference by the keep-alive.
+    uint64_t skipped;       ///< Number of frames skipped, whose last detections were reused.
+} motion_stats_t;
+
+/**
+ * @brief Initializes the motion gate, disabled.
+ */
+void motion_gate_init(void);
+
+/**
+ * @brief Releases the motion gate.
+ */
+void motion_gate_close(void);
+
+/**
+ * @brief Enables or disables the motion gate.
+ *
+ * Disabled, every frame is admitted to the inference. Can be called at any time.
+ *
+ * @param[in] enable @c true to skip the inference on a static scene.
+ */
+void motion_gate_enable(bool enable);
+
+/**
+ * @brief Analyzes a camera frame, before it is published.
+ *
+ * Called by the camera thread. Does nothing if the gate is disabled.
+ *
+ * @param[in] frame The frame.
+ */
+void motion_gate_update(const frame_t* frame);
+
+/**
+ * @brief Decides whether the inference runs on a frame.
+ *
+ * Called by the consumer of the frames for the inference. For a frame
+ * skipped, the last detections are submitted to the targeting for it.
+ *
+ * @param[in] frame The frame.
+ * @return @c true if the inference must run on the frame.
+ */
+bool motion_gate_admit(const frame_t* frame);
+
+/**
+ * @brief Keeps the detections of a frame, to be reused for the frames skipped.
+ *
+ * @param[in] dets The detections.
+ * @param[in] n Number of detections.
+ */
+void motion_gate_keep(const detection_t* dets, size_t n);
+
+/**
+ * @brief Reads the change map of the last frame analyzed.
+ *
+ * @param[out] map The change map.
+ */
+void motion_gate_get_map(motion_map_t* map);
+
+/**
+ * @brief Reads the motion gate statistics.
+ *
+ * @param[out] stats The statistics.
+ */
+void motion_gate_get_stats(motion_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MOTION_GATE_H
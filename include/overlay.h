@@ -0,0 +1,100 @@
+/**
+ * @file overlay.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the detection results drawn over the camera frames.
+ *
+ * The targeting publishes here the detections and the tracks of each
+ * processed frame. The viewers, such as the display thread, sleep until a
+ * new result is published, then draw it themselves over a camera frame, so
+ * that the inference never renders nor copies images.
+ *
+ * @see overlay.c
+ * @see display_result.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "detection.h"
+#include "tracker.h"
+#include "targeting.h"
+
+/**
+ * @brief Detection result of a frame.
+ */
+typedef struct {
+    uint64_t seq;                                   ///< Result number, 0 before the first result.
+    uint64_t frame_id;                              ///< Frame the detections come from, 0 if unknown.
+    uint64_t timestamp_ns;                          ///< Capture time of the frame (@c CLOCK_MONOTONIC ) [ns].
+    detection_t dets[TARGETING_MAX_DETECTIONS];     ///< Detections of the frame.
+    size_t det_count;                               ///< Number of detections.
+    track_t tracks[TRACKER_MAX_TRACKS];             ///< Tracks updated with the detections.
+    size_t track_count;                             ///< Number of tracks.
+    bool reused;                                    ///< Detections of a previous frame, the frame not being inferred.
+} overlay_t;
+
+/**
+ * @brief Initializes the overlay, without result.
+ */
+void overlay_init(void);
+
+/**
+ * @brief Releases the overlay lock and notification.
+ */
+void overlay_close(void);
+
+/**
+ * @brief Publishes the detection result of a frame, and wakes up the viewers.
+ *
+ * @param[in] dets The detections.
+ * @param[in] n Number of detections, truncated to @c TARGETING_MAX_DETECTIONS .
+ * @param[in] tracks The tracks updated with the detections.
+ * @param[in] m Number of tracks, truncated to @c TRACKER_MAX_TRACKS .
+ * @param[in] frame_id Frame the detections come from, 0 if unknown.
+ * @param[in] timestamp_ns Capture time of the frame (@c CLOCK_MONOTONIC ) [ns].
+ * @param[in] reused @c true if the detections come from a previous frame.
+ */
+void overlay_publish(const detection_t* dets, size_t n, const track_t* tracks, size_t m,
+                     uint64_t frame_id, uint64_t timestamp_ns, bool reused);
+
+/**
+ * @brief Waits for a result newer than the last one read.
+ *
+ * @param[in,out] overlay The last result read, replaced by the newer one.
+ * @param[in] timeout_ms Maximum waiting time [ms].
+ * @return @c true if a newer result was read, @c false on timeout.
+ */
+bool overlay_wait(overlay_t* overlay, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OVERLAY_H
@@ -0,0 +1,122 @@
+/**
+ * @file perf_counters.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for hardware performance counters sampling.
+ *
+ * This file provides an optional instrumentation of the pipeline stages
+ * (camera capture, inference, motor moves) with the GNU/Linux
+ * @c perf_event_open() interface. Each thread opens its own group of
+ * counters (cycles, instructions, L1D and last level cache misses, context
+ * switches) the first time it enters a stage. Counters are read when entering
+ * and leaving a stage, and the averaged per-frame deltas are logged
+ * periodically. This tells whether a stage is compute or memory bound.
+ * When the kernel multiplexes the groups on the PMU, the deltas are scaled
+ * by the time the group was enabled over the time it was counting. The
+ * counters of a thread are closed when it exits.
+ *
+ * Sampling is disabled unless the environment variable @c EDGEAI_PERF is
+ * set to @c 1 when calling @c perf_init() . When disabled, entering or
+ * leaving a stage costs a single branch.
+ *
+ * @see perf_counters.c
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PERF_REPORT_FRAMES 120  ///< Number of frames averaged in each report.
+
+/**
+ * @brief Enumeration of the sampled counters.
+ */
+typedef enum {
+    PERF_CYCLES,        ///< CPU cycles.
+    PERF_INSTRUCTIONS,  ///< Retired instructions.
+    PERF_L1D_MISSES,    ///< L1 data cache read misses.
+    PERF_LLC_MISSES,    ///< Last level cache read misses.
+    PERF_CTX_SWITCHES,  ///< Context switches.
+    PERF_COUNTER_NUMBER
+} perf_counter_t;
+
+/**
+ * @brief Enumeration of the instrumented pipeline stages.
+ *
+ * A stage must always be entered and left by the same thread.
+ */
+typedef enum {
+    PERF_STAGE_CAPTURE,     ///< Camera: frame grab and MJPEG decoding.
+    PERF_STAGE_PUBLISH,     ///< Camera: frame copy to the shared buffer.
+    PERF_STAGE_INFERENCE,   ///< Inference: model prediction on a frame.
+    PERF_STAGE_MOTOR_X,     ///< X-motor: one move.
+    PERF_STAGE_MOTOR_Y,     ///< Y-motor: one move.
+    PERF_STAGE_CORRELATION, ///< Correlation tracker: one frame.
+    PERF_STAGE_SERVO,       ///< Visual servoing: one frame.
+    PERF_STAGE_STREAM,      ///< MJPEG streaming: one frame encoding.
+    PERF_STAGE_MOTION,      ///< Camera: change detection of the motion gate.
+    PERF_STAGE_NUMBER
+} perf_stage_t;
+
+/**
+ * @brief Enables sampling if requested by the environment.
+ *
+ * Must be called before any thread enters a stage.
+ */
+void perf_init(void);
+
+/**
+ * @brief Checks if sampling is enabled.
+ *
+ * @return @c true if sampling is enabled, @c false otherwise.
+ */
+bool perf_enabled(void);
+
+/**
+ * @brief Reads the counters of the calling thread when entering a stage.
+ *
+ * Opens the counters of the calling thread on first call.
+ *
+ * @param[in] stage The stage being entered.
+ */
+void perf_stage_begin(perf_stage_t stage);
+
+/**
+ * @brief Reads the counters of the calling thread when leaving a stage.
+ *
+ * The deltas since @c perf_stage_begin() are accumulated, and their
+ * average per frame is logged every @c PERF_REPORT_FRAMES frames.
+ *
+ * @param[in] stage The stage being left.
+ */
+void perf_stage_end(perf_stage_t stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PERF_COUNTERS_H
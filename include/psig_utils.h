@@ -47,7 +47,7 @@ extern "C" {
  * This function installs the custom signal handler.
  * For instance, when the SIGINT signal is triggered, the @c on_signal handler will be called.
  *
- * @note Only SIGINT is installed for now.
+ * @note Only SIGINT and SIGUSR1 are installed for now.
  * @note Not sure if calling it one time for the whole application is enough.
  *
  * @todo Figure out if calling it only one time at the begining,
@@ -65,6 +65,15 @@ void psig_install_handler(void);
  */
 bool psig_kill_requested(void);
 
+/**
+ * @brief Checks if a dump has been requested with the SIGUSR1 signal, and clears the request.
+ *
+ * @return @c true if SIGUSR1 was received since the last call, otherwise @c false.
+ *
+ * @see flight_recorder.h
+ */
+bool psig_dump_requested(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,158 @@
+/**
+ * @file rate_governor.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the governor of the inference and camera rates.
+ *
+ * Running the detector and the camera at full rate while nothing is in view
+ * only heats the board and takes CPU time from the motor threads. This file
+ * provides a governor deciding from the recent detection history how often
+ * the inference runs, and optionally how often the camera frames are
+ * decoded and published:
+ * - @c GOVERNOR_TRACKING : a confirmed alien is tracked, everything runs at
+ *   full rate;
+ * - @c GOVERNOR_ACQUIRING : objects are detected, or were during the last
+ *   @c GOVERNOR_IDLE_AFTER_MS , but no alien is confirmed: full rate too, to
+ *   confirm the tracks as fast as possible;
+ * - @c GOVERNOR_IDLE : nothing detected for @c GOVERNOR_IDLE_AFTER_MS , the
+ *   inference runs at @c GOVERNOR_IDLE_HZ and the camera at
+ *   @c GOVERNOR_IDLE_CAMERA_FPS .
+ *
+ * The first detection in idle switches back to full rate. The state is
+ * updated with every detection result submitted to the targeting, and its
+ * transitions and the time spent in each state are counted.
+ *
+ * @see rate_governor.c
+ * @see targeting.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RATE_GOVERNOR_H
+#define RATE_GOVERNOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GOVERNOR_IDLE_AFTER_MS 3000     ///< Time without detection before idling [ms].
+#define GOVERNOR_IDLE_HZ 2              ///< Inference rate in idle [Hz].
+#define GOVERNOR_IDLE_CAMERA_FPS 10     ///< Camera frames published in idle, with the camera governed [FPS].
+
+/**
+ * @brief What the governor slows down.
+ */
+typedef enum {
+    GOVERNOR_OFF = 0,       ///< Nothing, everything runs at full rate.
+    GOVERNOR_INFERENCE,     ///< The inference.
+    GOVERNOR_CAMERA,        ///< The inference and the camera.
+} governor_mode_t;
+
+/**
+ * @brief State of the governor.
+ */
+typedef enum {
+    GOVERNOR_IDLE = 0,      ///< Nothing in view.
+    GOVERNOR_ACQUIRING,     ///< Objects in view, no alien confirmed.
+    GOVERNOR_TRACKING,      ///< Alien confirmed.
+    GOVERNOR_STATE_NUMBER
+} governor_state_t;
+
+/**
+ * @brief Statistics of the governor.
+ */
+typedef struct {
+    uint32_t state;                                 ///< Current @c governor_state_t .
+    uint32_t reserved;                              ///< Unused, 0.
+    uint64_t transitions;                           ///< Number of state changes.
+    uint64_t entered[GOVERNOR_STATE_NUMBER];        ///< Number of times each state was entered.
+    uint64_t time_ms[GOVERNOR_STATE_NUMBER];        ///< Time spent in each state [ms].
+    uint64_t skipped;                               ///< Number of frames not inferred in idle.
+    uint64_t camera_skipped;                        ///< Number of camera frames not published in idle.
+} governor_stats_t;
+
+/**
+ * @brief Initializes the governor, off and acquiring.
+ */
+void governor_init(void);
+
+/**
+ * @brief Releases the governor.
+ */
+void governor_close(void);
+
+/**
+ * @brief Sets what the governor slows down.
+ *
+ * Can be called at any time.
+ *
+ * @param[in] mode A @c governor_mode_t .
+ */
+void governor_set_mode(governor_mode_t mode);
+
+/**
+ * @brief Updates the state with a detection result.
+ *
+ * @param[in] detections Number of detections of the frame.
+ * @param[in] aliens Number of confirmed alien tracks after the frame.
+ */
+void governor_observe(size_t detections, size_t aliens);
+
+/**
+ * @brief Decides whether the inference runs on a frame.
+ *
+ * Called by the consumer of the frames for the inference.
+ *
+ * @return @c true if the inference must run on the frame.
+ */
+bool governor_admit(void);
+
+/**
+ * @brief Decides whether a camera frame is decoded and published.
+ *
+ * Called by the camera thread.
+ *
+ * @return @c true if the frame must be published.
+ */
+bool governor_camera_admit(void);
+
+/**
+ * @brief Gets the name of a state.
+ *
+ * @param[in] state A @c governor_state_t .
+ * @return The name, a string literal.
+ */
+const char* governor_state_name(governor_state_t state);
+
+/**
+ * @brief Reads the governor statistics.
+ *
+ * @param[out] stats The statistics.
+ */
+void governor_get_stats(governor_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RATE_GOVERNOR_H
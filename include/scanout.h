@@ -0,0 +1,146 @@
+/**
+ * @file scanout.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the direct output of images to the screen.
+ *
+ * This file provides a screen output without display server: the images
+ * are written in buffers mapped in memory and scanned out by the display
+ * controller, either through DRM/KMS dumb buffers, or through the legacy
+ * framebuffer device when no DRM driver is available.
+ *
+ * Two buffers are used when possible: the image is written in the back
+ * buffer while the front one is displayed, then the buffers are swapped
+ * (page flip or panning) at the next vertical blanking, without tearing.
+ *
+ * The buffers hold 32-bit pixels, in the BGRX byte order of OpenCV 4-channel
+ * images, so that an image can be resized directly into a buffer.
+ *
+ * @see scanout.c
+ * @see display_result.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANOUT_H
+#define SCANOUT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <drm/drm_mode.h>
+
+#define SCANOUT_DRM_DEVICE "/dev/dri/card0"     ///< DRM device of the display controller.
+#define SCANOUT_FB_DEVICE "/dev/fb0"            ///< Legacy framebuffer device.
+#define SCANOUT_BUFFERS 2                       ///< Number of buffers, for page flipping.
+#define SCANOUT_FLIP_TIMEOUT_MS 100             ///< Maximum waiting time for a page flip [ms].
+#define SCANOUT_MAX_OBJECTS 16                  ///< Maximum number of connectors, encoders and CRTCs.
+
+/**
+ * @brief Kind of screen output.
+ */
+typedef enum {
+    SCANOUT_NONE = 0,   ///< Not opened.
+    SCANOUT_DRM,        ///< DRM/KMS dumb buffers, swapped by page flips.
+    SCANOUT_FBDEV,      ///< Framebuffer device, swapped by panning if large enough.
+} scanout_kind_t;
+
+/**
+ * @brief Screen output.
+ */
+typedef struct {
+    scanout_kind_t kind;                ///< Kind of output.
+    int fd;                             ///< Device file descriptor.
+    uint32_t width;                     ///< Screen width [px].
+    uint32_t height;                    ///< Screen height [px].
+    uint32_t pitch;                     ///< Bytes per buffer line.
+    uint8_t* map[SCANOUT_BUFFERS];      ///< Mapped buffers.
+    size_t size;                        ///< Size of each buffer [bytes].
+    uint8_t buffers;                    ///< Number of buffers.
+    uint8_t back;                       ///< Buffer not displayed.
+    bool pending;                       ///< Page flip not completed yet.
+
+    // DRM output.
+    uint32_t crtc_id;                   ///< CRTC scanning out the buffers.
+    uint32_t connector_id;              ///< Connector of the screen.
+    uint32_t fb_id[SCANOUT_BUFFERS];    ///< Framebuffers of the dumb buffers.
+    uint32_t handle[SCANOUT_BUFFERS];   ///< Handles of the dumb buffers.
+    struct drm_mode_crtc saved_crtc;    ///< CRTC state before, restored on close.
+
+    // Framebuffer device output.
+    uint8_t* fb_base;                   ///< Mapped framebuffer memory.
+    size_t fb_len;                      ///< Length of the mapped memory [bytes].
+    int tty_fd;                         ///< Console switched to graphics mode, -1 if none.
+} scanout_t;
+
+/**
+ * @brief Opens the screen output of a DRM device.
+ *
+ * Takes the first connected screen in its preferred mode, and displays a
+ * black buffer on it.
+ *
+ * @param[out] scanout The screen output.
+ * @param[in] device The DRM device, e.g. @c SCANOUT_DRM_DEVICE .
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the device is missing,
+ *         has no screen connected, or is already driven by a display server.
+ */
+int scanout_open_drm(scanout_t* scanout, const char* device);
+
+/**
+ * @brief Opens the screen output of a framebuffer device.
+ *
+ * @param[out] scanout The screen output.
+ * @param[in] device The framebuffer device, e.g. @c SCANOUT_FB_DEVICE .
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the device is missing
+ *         or its pixels are not 32-bit BGRX.
+ */
+int scanout_open_fbdev(scanout_t* scanout, const char* device);
+
+/**
+ * @brief Waits until the back buffer can be written.
+ *
+ * @param[in,out] scanout The screen output.
+ * @return The back buffer, of @c height lines of @c pitch bytes.
+ */
+uint8_t* scanout_begin(scanout_t* scanout);
+
+/**
+ * @brief Displays the back buffer at the next vertical blanking.
+ *
+ * @param[in,out] scanout The screen output.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the buffers could not be swapped.
+ */
+int scanout_flip(scanout_t* scanout);
+
+/**
+ * @brief Closes the screen output, and restores the previous display.
+ *
+ * @param[in,out] scanout The screen output.
+ */
+void scanout_close(scanout_t* scanout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCANOUT_H
@@ -0,0 +1,124 @@
+/**
+ * @file scheduler.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the order in which the targets are visited by the laser.
+ *
+ * With several targets in view, the visit order decides how far the mirrors
+ * travel. This file provides a scheduler planning the order minimizing the
+ * total travel time from the current mirror position: nearest neighbor
+ * first, then improved with 2-opt for small sets of targets. Both axes move
+ * at once, so that the travel time between two targets is the duration of
+ * the move on the longest axis, given by the motor model.
+ *
+ * Targets are visited by rounds: each target is visited once, then a new
+ * round starts. When the targets are updated, only the targets not visited
+ * yet in the round are planned again, from the current mirror position.
+ *
+ * @see scheduler.c
+ * @see targeting.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ctrl_motors.h"
+
+#define SCHEDULER_MAX_TARGETS 32    ///< Maximum number of targets.
+#define SCHEDULER_2OPT_MAX 10       ///< Maximum number of targets improved with 2-opt.
+
+/**
+ * @brief Target to visit.
+ */
+typedef struct {
+    uint32_t id;    ///< Target identifier, such as a track identifier.
+    d_px_t x;       ///< X-position [px].
+    d_px_t y;       ///< Y-position [px].
+} sched_target_t;
+
+/**
+ * @brief Visit plan of the targets of the current round.
+ */
+typedef struct {
+    sched_target_t plan[SCHEDULER_MAX_TARGETS];     ///< Targets left to visit, in order.
+    size_t count;                                   ///< Number of targets left to visit.
+    uint32_t visited[SCHEDULER_MAX_TARGETS];        ///< Targets already visited in the round.
+    size_t visited_count;                           ///< Number of targets already visited.
+    uint32_t last_id;                               ///< Last visited target, 0 if none.
+    uint32_t deferred_id;                           ///< Target visited last in the round, 0 if none.
+} scheduler_t;
+
+/**
+ * @brief Initializes a scheduler without targets.
+ *
+ * @param[out] sched The scheduler.
+ */
+void scheduler_init(scheduler_t* sched);
+
+/**
+ * @brief Plans the visit of the targets not visited yet in the round.
+ *
+ * Targets that disappeared are removed from the plan. Once all the targets
+ * have been visited, a new round starts, in which the last visited target
+ * comes last.
+ *
+ * @param[in,out] sched The scheduler.
+ * @param[in] targets The current targets, with distinct non-zero identifiers.
+ * @param[in] n Number of targets, truncated to @c SCHEDULER_MAX_TARGETS .
+ * @param[in] x The X-position of the mirrors when the visit starts [px].
+ * @param[in] y The Y-position of the mirrors when the visit starts [px].
+ * @return The number of planned targets removed because they disappeared.
+ */
+size_t scheduler_update(scheduler_t* sched, const sched_target_t* targets, size_t n, d_px_t x, d_px_t y);
+
+/**
+ * @brief Takes the next target of the plan, and marks it as visited.
+ *
+ * @param[in,out] sched The scheduler.
+ * @param[out] target The next target.
+ * @return @c true if a target is left to visit, otherwise @c false.
+ */
+bool scheduler_next(scheduler_t* sched, sched_target_t* target);
+
+/**
+ * @brief Computes the travel time of the mirrors between two positions.
+ *
+ * @param[in] x0 The starting X-position [px].
+ * @param[in] y0 The starting Y-position [px].
+ * @param[in] x1 The final X-position [px].
+ * @param[in] y1 The final Y-position [px].
+ * @return The travel time [us], both axes moving at once.
+ */
+time_us_t scheduler_travel_us(d_px_t x0, d_px_t y0, d_px_t x1, d_px_t y1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCHEDULER_H
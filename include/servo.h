@@ -0,0 +1,87 @@
+/**
+ * @file servo.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the visual servoing of the motors on the laser dot.
+ *
+ * Stepper motors miss steps, and the position of the beam then drifts from
+ * the absolute step positions counted by the motors. This file provides a
+ * closed loop on the camera frames: once the mirrors are at rest on their
+ * target, the laser dot is searched in a small region around the target,
+ * and the step positions aiming at the dot and at the target are compared.
+ * A difference of at least @c SERVO_DEADBAND_STEPS is corrected: the step
+ * positions of the motors are shifted by the missed steps, and the motors
+ * move back onto the target.
+ *
+ * The loop only runs in point-to-point mode.
+ *
+ * @see servo.c
+ * @see laser_dot.h
+ * @see stepper_demo.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVO_H
+#define SERVO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SERVO_SEARCH 24             ///< Search radius of the dot around the target [px].
+#define SERVO_SETTLE_MS 30          ///< Time for the mirrors to settle after a move [ms].
+#define SERVO_DEADBAND_STEPS 1.0f   ///< Smallest corrected error [steps].
+#define SERVO_MAX_STEPS 20          ///< Largest corrected error, beyond which the dot is not trusted [steps].
+#define SERVO_WAIT_MS 100           ///< Maximum waiting time for a frame [ms].
+
+/**
+ * @brief Statistics of the visual servoing.
+ */
+typedef struct {
+    uint64_t frames;        ///< Number of frames exposed with the mirrors at rest.
+    uint64_t found;         ///< Number of frames where the dot was found.
+    uint64_t corrections;   ///< Number of corrections sent to the motors.
+    uint64_t steps;         ///< Number of missed steps corrected, on both axes.
+} servo_stats_t;
+
+/**
+ * @brief Reads the visual servoing statistics.
+ *
+ * @param[out] stats The statistics.
+ */
+void servo_get_stats(servo_stats_t* stats);
+
+/**
+ * @brief Task correcting the missed steps of the motors on every camera frame.
+ *
+ * @param[in] arg Unused.
+ * @return A pointer to a result of the task execution.
+ */
+void* servo_task(void* arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SERVO_H
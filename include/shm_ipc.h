@@ -0,0 +1,256 @@
+/**
+ * @file shm_ipc.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the shared memory link with a separate inference process.
+ *
+ * In shared memory mode, the inference runs in its own process, so that the
+ * Python interpreter does not share its address space with the motor threads,
+ * and can crash or be restarted without stopping them.
+ *
+ * Three POSIX shared memory objects are used:
+ * - @c SHM_POOL_NAME : the frame pool buffers, written by the camera thread
+ *   and mapped read-only by the inference process;
+ * - @c SHM_FRAMES_NAME : a ring describing the latest published frames,
+ *   mapped read-only by the inference process;
+ * - @c SHM_DETECTIONS_NAME : a ring of detections written back by the
+ *   inference process, along with the frame it is currently reading.
+ *
+ * Frames are never copied: the inference process reads them in the pool.
+ * While it reads a frame, it holds a lease on it, which prevents the frame
+ * from going back to the pool. Ring entries are protected by sequence
+ * counters, and waiters sleep on futexes on the ring counters.
+ *
+ * The producer side (this application) runs two threads: one publishing
+ * camera frames, one forwarding detections to the motors. The client side
+ * functions are meant to be called by the inference process.
+ *
+ * @see shm_ipc.c
+ * @see frame_pool.h
+ * @see yolov8n_inference.py
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHM_IPC_H
+#define SHM_IPC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "detection.h"
+
+// Shared memory object names.
+#define SHM_POOL_NAME "/edgeai_pool"                ///< Frame pool buffers.
+#define SHM_FRAMES_NAME "/edgeai_frames"            ///< Published frames ring.
+#define SHM_DETECTIONS_NAME "/edgeai_detections"    ///< Detections ring.
+
+#define SHM_MAGIC 0x45444741            ///< Marks initialized segments ("EDGA").
+#define SHM_VERSION 1                   ///< Layout version of the segments.
+#define SHM_FRAME_RING_SIZE 4           ///< Number of published frames kept in the ring.
+#define SHM_DETECTION_RING_SIZE 8       ///< Number of detection batches kept in the ring.
+#define SHM_MAX_DETECTIONS 32           ///< Maximum number of detections per batch.
+#define SHM_WAIT_MS 100                 ///< Maximum waiting time before checking for termination [ms].
+
+/// Detection batch flag: the first detection is the calibration reference.
+#define SHM_DETECTIONS_CALIBRATION 0x1
+
+/**
+ * @brief Published frame, as seen by the inference process.
+ */
+typedef struct {
+    uint64_t frame_id;      ///< Capture sequence number.
+    uint64_t timestamp_ns;  ///< Capture time (@c CLOCK_MONOTONIC ) [ns].
+    uint64_t size;          ///< Size of the pixel data [bytes].
+    int32_t width;          ///< Frame width [px].
+    int32_t height;         ///< Frame height [px].
+} shm_frame_info_t;
+
+/**
+ * @brief Entry of the published frames ring.
+ */
+typedef struct {
+    uint32_t gen;           ///< Sequence counter, odd while the entry is written.
+    uint32_t reserved;      ///< Padding.
+    uint64_t offset;        ///< Offset of the pixel data in the pool [bytes].
+    shm_frame_info_t info;  ///< Frame description.
+} shm_frame_entry_t;
+
+/**
+ * @brief Layout of the published frames segment.
+ */
+typedef struct {
+    uint32_t magic;         ///< @c SHM_MAGIC once initialized.
+    uint32_t version;       ///< @c SHM_VERSION .
+    uint64_t pool_bytes;    ///< Size of the frame pool segment [bytes].
+    uint32_t alive;         ///< 1 while the producer runs.
+    uint32_t seq;           ///< Number of published frames (futex word).
+    shm_frame_entry_t entries[SHM_FRAME_RING_SIZE]; ///< Latest frames, at @c seq-1 modulo the size.
+} shm_frame_ring_t;
+
+/**
+ * @brief Entry of the detections ring.
+ */
+typedef struct {
+    uint32_t gen;           ///< Sequence counter, odd while the entry is written.
+    uint32_t flags;         ///< @c SHM_DETECTIONS_ flags.
+    uint64_t frame_id;      ///< Frame the detections come from.
+    uint32_t count;         ///< Number of detections.
+    uint32_t reserved;      ///< Padding.
+    detection_t dets[SHM_MAX_DETECTIONS];   ///< Detections.
+} shm_detection_entry_t;
+
+/**
+ * @brief Layout of the detections segment.
+ */
+typedef struct {
+    uint32_t magic;         ///< @c SHM_MAGIC once initialized.
+    uint32_t version;       ///< @c SHM_VERSION .
+    uint64_t lease;         ///< Frame being read by the inference process, 0 if none.
+    uint32_t seq;           ///< Number of detection batches written (futex word).
+    int32_t client_pid;     ///< Process ID of the inference process, 0 if none.
+    uint32_t calibrated;    ///< 1 once the motors received the calibration reference.
+    uint32_t reserved;      ///< Padding.
+    shm_detection_entry_t entries[SHM_DETECTION_RING_SIZE]; ///< Latest batches.
+} shm_detection_ring_t;
+
+/*******************************************************************************
+ * Producer side
+ ******************************************************************************/
+
+/**
+ * @brief Creates the frames and detections segments.
+ *
+ * The frame pool must have been initialized with @c frame_pool_init_shared()
+ * and @c SHM_POOL_NAME .
+ *
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE otherwise.
+ */
+int shm_ipc_init(void);
+
+/**
+ * @brief Unmaps and removes the frames and detections segments.
+ */
+void shm_ipc_close(void);
+
+/**
+ * @brief Sets the calibration state seen by the inference process.
+ *
+ * While set, the inference process does not ask for the calibration
+ * reference, and calibration batches are ignored.
+ *
+ * @param[in] calibrated @c true if the motors are calibrated, or being
+ *            calibrated automatically.
+ */
+void shm_ipc_set_calibrated(bool calibrated);
+
+/**
+ * @brief Task publishing the camera frames to the inference process.
+ *
+ * This task subscribes to the latest camera frames and describes them in
+ * the frames ring. It keeps the frames of the ring, and the frame leased by
+ * the inference process, out of the pool.
+ *
+ * @param[in] arg Unused.
+ * @return A pointer to a result of the task execution.
+ */
+void* shm_publish_task(void* arg);
+
+/**
+ * @brief Task forwarding the detections of the inference process to the motors.
+ *
+ * A calibration batch sends the center of its first detection to the motors,
+ * the other batches are submitted to the targeting thread.
+ *
+ * @param[in] arg Unused.
+ * @return A pointer to a result of the task execution.
+ */
+void* shm_detections_task(void* arg);
+
+/*******************************************************************************
+ * Client side (inference process)
+ ******************************************************************************/
+
+/**
+ * @brief Maps the segments created by the producer.
+ *
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the producer
+ *         is not running.
+ */
+int shm_client_connect(void);
+
+/**
+ * @brief Unmaps the segments, releasing the leased frame.
+ */
+void shm_client_disconnect(void);
+
+/**
+ * @brief Checks if the producer is still running.
+ *
+ * @return @c true if connected to a running producer, otherwise @c false.
+ */
+bool shm_client_alive(void);
+
+/**
+ * @brief Checks if the motors already received the calibration reference.
+ *
+ * A restarted inference process must not calibrate the motors again.
+ *
+ * @return @c true if the motors are calibrated, otherwise @c false.
+ */
+bool shm_client_calibrated(void);
+
+/**
+ * @brief Waits for a frame newer than the previous one, and leases it.
+ *
+ * The previously leased frame is released.
+ *
+ * @param[out] info Description of the frame.
+ * @return A read-only pointer to the pixel data, valid until the next call
+ *         or @c shm_client_release_frame() , or @c NULL if no frame has been
+ *         published within @c SHM_WAIT_MS or if the producer stopped.
+ */
+const uint8_t* shm_client_wait_frame(shm_frame_info_t* info);
+
+/**
+ * @brief Releases the leased frame.
+ */
+void shm_client_release_frame(void);
+
+/**
+ * @brief Writes a batch of detections into the detections ring.
+ *
+ * @param[in] dets The detections.
+ * @param[in] n Number of detections, truncated to @c SHM_MAX_DETECTIONS .
+ * @param[in] frame_id Frame the detections come from.
+ * @param[in] flags @c SHM_DETECTIONS_ flags.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if not connected.
+ */
+int shm_client_submit(const detection_t* dets, size_t n, uint64_t frame_id, uint32_t flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SHM_IPC_H
@@ -37,10 +37,12 @@ extern "C" {
 #endif
 
 #include <math.h>
+#include <stdbool.h>
 
 #include "ctrl_motors.h"
 #include "ipc_elements.h"
 #include "wait_utils.h"
+#include "frame_clock.h"
 
 /**
  * @brief Writes the absolute target position on the image in X and Y coordinates.
@@ -48,12 +50,50 @@ extern "C" {
  * This function sends the target absolute position (X,Y) on the image
  * via two buffers, one for each coordinate, then waits until
  * the two motors read those buffers.
+ * The first position sent calibrates the motors. In velocity mode, the
+ * following positions are followed at rest without waiting.
+ *
+ * @note Thread-safe: concurrent writers are serialized.
  *
  * @param[in] x The target X absolute position [px].
  * @param[in] y The target Y absolute position [px].
  */
 void write_abs_pos(d_px_t x, d_px_t y);
 
+/**
+ * @brief Corrects the motors by the steps they missed while aiming at a position.
+ *
+ * The absolute step positions of the motors are shifted by the missed steps,
+ * then the same position is sent again, so that the motors move back onto it.
+ *
+ * @note Thread-safe: serialized with @c write_abs_pos() .
+ *
+ * @param[in] x The X absolute position the motors aim at [px].
+ * @param[in] y The Y absolute position the motors aim at [px].
+ * @param[in] dx Steps the X-motor is ahead of its step position [steps].
+ * @param[in] dy Steps the Y-motor is ahead of its step position [steps].
+ * @return @c true if corrected, @c false if another position was sent
+ *         meanwhile, or in velocity mode.
+ */
+bool resync_abs_pos(d_px_t x, d_px_t y, int32_t dx, int32_t dy);
+
+/**
+ * @brief Reads the last absolute target position sent to the motors.
+ *
+ * In velocity mode, the position is the one estimated from the steps
+ * generated, reached now.
+ *
+ * @param[out] x The last target X absolute position [px]. Can be @c NULL
+ *             with @p y to only check the calibration.
+ * @param[out] y The last target Y absolute position [px].
+ * @param[out] arrival_ns Time the motors are expected to reach this position
+ *             (@c CLOCK_MONOTONIC ) [ns], according to @c move_time_us() .
+ *             Can be @c NULL .
+ * @return @c true if the motors are calibrated, otherwise @c false
+ *         and the position is left untouched.
+ */
+bool read_abs_pos(d_px_t* x, d_px_t* y, uint64_t* arrival_ns);
+
 /**
  * @brief Sends positions to move the stepper motors in a circular pattern.
  *
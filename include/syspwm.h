@@ -49,11 +49,15 @@ extern "C" {
 #include <stdbool.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <time.h>
 #include <sys/stat.h>
 
 #include "wait_utils.h"
 #include "psig_utils.h"
 
+/// Directory where the kernel exposes the PWM chips.
+#define SYSPWM_DEFAULT_ROOT "/sys/class/pwm"
+
 // Type definitions for PWM configuration
 typedef uint32_t period_ns_t;       ///< Type for PWM period [ns].
 typedef uint32_t frequency_hz_t;    ///< Type for PWM frequency [Hz].
@@ -98,6 +102,21 @@ typedef struct {
 extern const syspwm_t SYSPWM_3; ///< PWM3
 extern const syspwm_t SYSPWM_4; ///< PWM4
 
+/**
+ * @brief Change the directory where PWM chips are looked for.
+ * 
+ * By default, PWM chips are accessed through @c SYSPWM_DEFAULT_ROOT .
+ * Pointing to another directory holding the same file tree
+ * (@c pwmchip<N>/pwm<M>/period , @c duty_cycle and @c enable ) allows
+ * running the motor control code against a simulated PWM backend,
+ * for instance in benchmarks.
+ * 
+ * @param[in] root The new directory, or @c NULL to restore the default one.
+ *
+ * @warning The string must remain valid while PWM functions are in use.
+ */
+void syspwm_set_root(const char* root);
+
 /**
  * @brief Check the status of a PWM pin.
  * 
@@ -141,12 +160,33 @@ int syspwm_enable(const syspwm_t* pwm, syspwm_state_t enable);
  * This function sends a PWM signal at given frequency and step count.
  * A step is a small part of the PWM signal that has the duration of one period.
  * This type of signal is typically used to drive stepper motors.
+ *
+ * The signal runs freely between its start and its stop: the steps emitted
+ * are estimated from the time it ran, which exceeds the planned duration
+ * whenever the thread is woken up late.
  * 
  * @param[in] pwm A pointer to a @c syspwm_t structure representing the PWM pin.
  * @param[in] freq The frequency of the PWM signal [Hz].
  * @param[in] steps The number of steps to generate.
+ * @return The number of steps emitted, 0 if the frequency is zero.
+ */
+step_t syspwm_stepper_sig(const syspwm_t* pwm, frequency_hz_t freq, step_t steps);
+
+/**
+ * @brief Change the frequency of a running stepper PWM signal.
+ *
+ * This function changes the frequency of the PWM signal, keeping a 50% duty
+ * cycle, without disabling the pin in between: a signal already running
+ * keeps generating steps. As sysfs rejects a duty cycle longer than the
+ * period, the duty cycle is written first when the period gets shorter,
+ * and last when it gets longer.
+ *
+ * @param[in] pwm A pointer to a @c syspwm_t structure representing the PWM pin.
+ * @param[in] old_freq The current frequency [Hz], 0 if the pin is disabled.
+ * @param[in] freq The new frequency [Hz], 0 to disable the pin.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if sysfs is not accessible.
  */
-void syspwm_stepper_sig(const syspwm_t* pwm, frequency_hz_t freq, step_t steps);
+int syspwm_set_freq(const syspwm_t* pwm, frequency_hz_t old_freq, frequency_hz_t freq);
 
 #ifdef __cplusplus
 }
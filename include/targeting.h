@@ -0,0 +1,153 @@
+/**
+ * @file targeting.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the selection of the targets among the detections.
+ *
+ * The inference submits all the detections of a frame at once, and returns
+ * immediately: the detections update the tracks of the objects, read by the
+ * targeting thread. Tracks not read yet when newer detections arrive are
+ * simply updated again, so the motors always aim at the latest positions.
+ *
+ * The targeting thread knows the last position sent to the motors: it visits
+ * the confirmed alien tracks in the order minimizing the travel of the
+ * mirrors, planned by the scheduler, and plans the targets not visited yet
+ * again as soon as the tracks are updated. The beam can stay on each target
+ * for a dwell time.
+ *
+ * Targets are led: the position sent is the one predicted from the track
+ * velocity at the time the beam arrives, i.e. after the age of the frame,
+ * the end of the current move and the duration of the new move.
+ *
+ * @see targeting.c
+ * @see tracker.h
+ * @see scheduler.h
+ * @see corr_tracker.h
+ * @see stepper_demo.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TARGETING_H
+#define TARGETING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "detection.h"
+
+#define TARGETING_MAX_DETECTIONS 32     ///< Maximum number of detections per set.
+#define TARGETING_WAIT_MS 100           ///< Maximum waiting time before checking for termination [ms].
+#define TARGETING_MAX_LEAD_MS 500       ///< Longest extrapolation of a track ahead of its frame [ms].
+#define TARGETING_DEFAULT_DWELL_MS 0    ///< Default time spent on each target [ms].
+
+/**
+ * @brief Statistics of the targeting.
+ */
+typedef struct {
+    uint64_t submitted;     ///< Number of detection sets submitted.
+    uint64_t replaced;      ///< Number of sets submitted before the previous one was read.
+    uint64_t targets;       ///< Number of positions sent to the motors.
+    uint64_t abandoned;     ///< Number of planned targets lost before being visited.
+} targeting_stats_t;
+
+/**
+ * @brief Initializes the mailbox of the targeting thread, without tracks.
+ */
+void targeting_init(void);
+
+/**
+ * @brief Destroys the mailbox of the targeting thread.
+ */
+void targeting_close(void);
+
+/**
+ * @brief Submits the detections of a frame, without waiting for the motors.
+ *
+ * The detections update the tracks. Frames without detection must also be
+ * submitted, so that lost objects stop being targeted.
+ *
+ * @param[in] dets The detections.
+ * @param[in] n Number of detections, truncated to @c TARGETING_MAX_DETECTIONS .
+ * @param[in] frame_id Frame the detections come from, 0 if unknown.
+ */
+void targeting_submit(const detection_t* dets, size_t n, uint64_t frame_id);
+
+/**
+ * @brief Submits the detections of a previous frame again, for a frame not inferred.
+ *
+ * The detections only update the tracks: unlike @c targeting_submit() , they
+ * are neither recorded as detection results nor seen by the rate governor.
+ *
+ * @param[in] dets The detections.
+ * @param[in] n Number of detections, truncated to @c TARGETING_MAX_DETECTIONS .
+ * @param[in] frame_id Frame the detections are reused for.
+ *
+ * @see motion_gate.h
+ */
+void targeting_submit_reused(const detection_t* dets, size_t n, uint64_t frame_id);
+
+/**
+ * @brief Notifies the targeting thread that the positions followed by correlation were refreshed.
+ *
+ * The targets are then aimed again at their latest positions, without
+ * waiting for the next detections.
+ *
+ * @see corr_tracker.h
+ */
+void targeting_refresh(void);
+
+/**
+ * @brief Sets the time spent on each target.
+ *
+ * @param[in] ms The dwell time, from the arrival of the beam [ms].
+ */
+void targeting_set_dwell_ms(uint32_t ms);
+
+/**
+ * @brief Reads the targeting statistics.
+ *
+ * @param[out] stats The statistics.
+ */
+void targeting_get_stats(targeting_stats_t* stats);
+
+/**
+ * @brief Task sending the submitted aliens to the motors.
+ *
+ * This task waits for an update of the tracks or of their positions
+ * followed by correlation, then sends the predicted center of each
+ * confirmed alien track at beam arrival to the motors, in the order
+ * planned by the scheduler. In velocity mode, the motors follow the
+ * position and velocity of each target instead.
+ * Nothing is sent until the motors are calibrated.
+ *
+ * @param[in] arg Unused.
+ * @return A pointer to a result of the task execution.
+ */
+void* targeting_task(void* arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TARGETING_H
@@ -0,0 +1,143 @@
+/**
+ * @file telemetry_log.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the binary telemetry log of a whole session.
+ *
+ * This file provides an append-only log of the telemetry events of the flight
+ * recorder (see @c flight_recorder.h ): every detection with its frame,
+ * position sent to the motors, motor move with its planned and emitted steps,
+ * and step rate change, each with its timestamp. The events are copied as
+ * fixed-size records in a memory-mapped file by the threads producing them,
+ * without lock, formatting nor system call: the kernel writes the pages back
+ * to the disk.
+ *
+ * The log rotates by size: once @c TELEMETRY_FILE_SIZE bytes of records are
+ * written, a thread opens the next file, and closes the previous one, cut to
+ * its records. Only the last @c TELEMETRY_MAX_FILES files are kept.
+ *
+ * A log file @c DIR/telemetry-TIME.bin , where @c TIME is the wall-clock time
+ * of its opening [ms], holds in the native byte order:
+ * - a @c telemetry_header_t ;
+ * - the @c flight_event_t records, oldest first, up to the first record whose
+ *   @c seq is 0 if @c record_count is 0 (file not closed).
+ *
+ * The tool @c telemetry_reader.py converts the log files to CSV or columnar files.
+ *
+ * @see telemetry_log.c
+ * @see flight_recorder.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TELEMETRY_LOG_H
+#define TELEMETRY_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "flight_recorder.h"
+
+#define TELEMETRY_FILE_SIZE (64u << 20)     ///< Size of the records of a file before rotation [bytes].
+#define TELEMETRY_HEADROOM 16384            ///< Records mapped past the rotation size, while the next file opens.
+#define TELEMETRY_MAX_FILES 16              ///< Number of log files kept, the oldest being deleted.
+#define TELEMETRY_WAIT_MS 100               ///< Time between two checks of the file size [ms].
+#define TELEMETRY_MAGIC "EATELEMT"          ///< Signature of the log files (8 characters).
+#define TELEMETRY_VERSION 1                 ///< Version of the log file format.
+
+/**
+ * @brief Header of a log file, of one cache line.
+ */
+typedef struct {
+    char magic[8];          ///< @c TELEMETRY_MAGIC , not terminated.
+    uint32_t version;       ///< @c TELEMETRY_VERSION .
+    uint32_t record_size;   ///< Size of a record, @c sizeof(flight_event_t) [bytes].
+    uint64_t file_index;    ///< Number of the file in the session, from 0.
+    uint64_t start_ns;      ///< Opening time of the file (@c CLOCK_MONOTONIC ) [ns].
+    uint64_t realtime_ns;   ///< Wall-clock time at @c start_ns (@c CLOCK_REALTIME ) [ns].
+    uint64_t record_count;  ///< Number of records, 0 until the file is closed.
+    uint8_t reserved[16];   ///< Unused, 0.
+} telemetry_header_t;
+
+/**
+ * @brief Statistics of the telemetry log.
+ */
+typedef struct {
+    uint64_t records;       ///< Number of records written.
+    uint64_t dropped;       ///< Number of records dropped, the file being full.
+    uint64_t files;         ///< Number of files opened.
+    uint64_t failed;        ///< Number of files that could not be opened or closed.
+} telemetry_stats_t;
+
+/**
+ * @brief Opens the first log file, and starts logging the telemetry events.
+ *
+ * @param[in] dir Directory of the log files, created if missing.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE if the directory or
+ *         the file could not be created.
+ */
+int telemetry_open(const char* dir);
+
+/**
+ * @brief Stops logging, and closes the log file.
+ */
+void telemetry_close(void);
+
+/**
+ * @brief Checks whether the telemetry events are logged.
+ *
+ * @return @c true between @c telemetry_open() and @c telemetry_close() .
+ */
+bool telemetry_is_open(void);
+
+/**
+ * @brief Appends a telemetry event to the log file.
+ *
+ * Can be called from any thread, without lock. Does nothing until
+ * @c telemetry_open() .
+ *
+ * @param[in] event The event, with its @c seq set.
+ */
+void telemetry_append(const flight_event_t* event);
+
+/**
+ * @brief Reads the telemetry log statistics.
+ *
+ * @param[out] stats The statistics.
+ */
+void telemetry_get_stats(telemetry_stats_t* stats);
+
+/**
+ * @brief Task rotating the log files.
+ *
+ * @param[in] arg Unused.
+ * @return A pointer to a result of the task execution.
+ */
+void* telemetry_task(void* arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_LOG_H
@@ -0,0 +1,135 @@
+/**
+ * @file tracker.h
+ * @author Adrien Chevrier
+ *
+ * @brief Header file for the multi-object tracker between the detector and the motors.
+ *
+ * This file provides a SORT-like tracker: each tracked object is described
+ * by a constant velocity Kalman filter on its center, and the detections of
+ * each frame are assigned to the predicted tracks by maximizing the overlap
+ * of their boxes (Hungarian algorithm).
+ *
+ * A detection matching no track starts a new one, which is confirmed after
+ * @c TRACKER_MIN_HITS consecutive matches. A track coasts on its prediction
+ * while it is not detected, and is removed after @c TRACKER_MAX_MISSES
+ * frames without detection.
+ *
+ * The motors then follow smoothed positions, and keep moving through brief
+ * detection dropouts.
+ *
+ * @see tracker.cpp
+ * @see targeting.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACKER_H
+#define TRACKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "detection.h"
+
+#define TRACKER_MAX_TRACKS 32       ///< Maximum number of tracks.
+#define TRACKER_MIN_HITS 3          ///< Consecutive detections confirming a track.
+#define TRACKER_MAX_MISSES 5        ///< Consecutive frames without detection removing a track.
+#define TRACKER_MIN_IOU 0.3f        ///< Minimum overlap between a detection and a predicted track.
+#define TRACKER_MEAS_NOISE 3.0f     ///< Standard deviation of the detected centers [px].
+#define TRACKER_ACCEL_NOISE 100.0f  ///< Standard deviation of the objects acceleration [px/s^2].
+#define TRACKER_DEFAULT_DT 0.066f   ///< Time between frames of unknown capture time [s].
+
+/**
+ * @brief Kalman filter on one axis of a track center.
+ */
+typedef struct {
+    float pos;      ///< Position [px].
+    float vel;      ///< Velocity [px/s].
+    float p00;      ///< Position variance [px^2].
+    float p01;      ///< Position and velocity covariance [px^2/s].
+    float p11;      ///< Velocity variance [px^2/s^2].
+} tracker_axis_t;
+
+/**
+ * @brief Tracked object.
+ */
+typedef struct {
+    uint32_t id;        ///< Track identifier, unique for the tracker lifetime.
+    int32_t cls;        ///< Class index of the last detection.
+    float conf;         ///< Confidence score of the last detection.
+    float w;            ///< Width of the last detected box [px].
+    float h;            ///< Height of the last detected box [px].
+    uint32_t hits;      ///< Consecutive frames with a detection.
+    uint32_t misses;    ///< Consecutive frames without detection.
+    uint8_t confirmed;  ///< 1 once detected @c TRACKER_MIN_HITS times in a row.
+    tracker_axis_t x;   ///< Filter on the X-axis center.
+    tracker_axis_t y;   ///< Filter on the Y-axis center.
+} track_t;
+
+/**
+ * @brief Set of tracks updated with the detections of each frame.
+ */
+typedef struct {
+    track_t tracks[TRACKER_MAX_TRACKS]; ///< Active tracks.
+    size_t count;                       ///< Number of active tracks.
+    uint32_t next_id;                   ///< Identifier of the next track.
+    uint64_t last_ns;                   ///< Capture time of the last frame [ns], 0 if none.
+} tracker_t;
+
+/**
+ * @brief Initializes a tracker without tracks.
+ *
+ * @param[out] tracker The tracker.
+ */
+void tracker_init(tracker_t* tracker);
+
+/**
+ * @brief Updates the tracks with the detections of a new frame.
+ *
+ * The tracks are predicted at the capture time of the frame, matched with
+ * the detections of the same class, and corrected. Frames without any
+ * detection must also be submitted, so that lost tracks get removed.
+ *
+ * @param[in,out] tracker The tracker.
+ * @param[in] dets The detections.
+ * @param[in] n Number of detections.
+ * @param[in] timestamp_ns Capture time of the frame (@c CLOCK_MONOTONIC ) [ns],
+ *            or 0 if unknown.
+ */
+void tracker_update(tracker_t* tracker, const detection_t* dets, size_t n, uint64_t timestamp_ns);
+
+/**
+ * @brief Copies the confirmed tracks.
+ *
+ * @param[in] tracker The tracker.
+ * @param[out] tracks The confirmed tracks, at most @c max .
+ * @param[in] max Size of @p tracks .
+ * @return The number of tracks copied.
+ */
+size_t tracker_confirmed(const tracker_t* tracker, track_t* tracks, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACKER_H
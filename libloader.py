@@ -10,12 +10,21 @@ frames, and communicate with stepper motors.
 Typical usage includes:
     - Initializing the board and system resources.
     - Spawning and joining C/C++ worker threads.
-    - Sending/receiving camera frames for processing or display.
-    - Sending position commands to stepper motors.
+    - Receiving camera frames for processing.
+    - Sending position commands and detections to stepper motors.
+    - Linking a separate inference process to the application (shared memory mode).
+
+The ``edgeai`` object exposes these functions with Python types. It is the
+native module ``edgeai_native`` (``pymodule/edgeai_native.cpp``) when it has
+been built, which avoids the ctypes marshalling and releases the GIL in
+blocking calls, or otherwise an equivalent wrapper of the ctypes bindings.
+Frames are returned as objects viewed without copy by ``numpy.asarray()``,
+and detections are passed as a single ``float32`` array of shape (N, 6).
 
 References:
     - c_interface.h
     - c_interface.cpp
+    - pymodule/edgeai_native.cpp
 
 Author:
     Adrien Chevrier
@@ -42,6 +51,8 @@ License:
 """
 
 import ctypes
+import sys
+import numpy as np
 
 clib = ctypes.CDLL("./lib/libc_interface.so")
 
@@ -59,13 +70,30 @@ Returns:
 clib.init_board.argtypes = []
 clib.init_board.restype = ctypes.c_int
 
+"""Runs the inference in a separate process, linked by shared memory.
+
+C signature:
+    void set_shm_mode(bool enable);
+
+Args:
+    enable (bool): ``True`` to run the inference in a separate process.
+
+Warning:
+    Must be called before ``init_board()``.
+"""
+clib.set_shm_mode.argtypes = [ctypes.c_bool]
+clib.set_shm_mode.restype = None
+
 """Spawns the necessary C/C++ threads for system operation.
 
 C signature:
     int spawn_threads(void);
 
 Creates all required worker threads for tasks such as motor control
-and camera capture/display.
+and camera capture, and the display, visual servoing, streaming, dataset
+collection, flight recorder and telemetry log threads if enabled with ``set_display()``,
+``set_servo()``, ``set_stream_port()``, ``set_collect_dir()``, ``set_flight_dir()``
+and ``set_telemetry_dir()``.
 
 Returns:
     int: ``0`` on success, non-zero if any thread creation fails.
@@ -73,6 +101,127 @@ Returns:
 clib.spawn_threads.argtypes = []
 clib.spawn_threads.restype = ctypes.c_int
 
+"""Enables or disables the thread displaying the inference results.
+
+C signature:
+    void set_display(bool enable);
+
+Args:
+    enable (bool): ``True`` to display the camera frames with the detections drawn over them.
+
+Warning:
+    Must be called before ``spawn_threads()``.
+"""
+clib.set_display.argtypes = [ctypes.c_bool]
+clib.set_display.restype = None
+
+"""Checks if the inference results are displayed.
+
+C signature:
+    bool display_enabled(void);
+
+Returns:
+    bool: ``True`` if the display thread is enabled, otherwise ``False``.
+"""
+clib.display_enabled.argtypes = []
+clib.display_enabled.restype = ctypes.c_bool
+
+"""Selects the screen output of the display thread.
+
+C signature:
+    void set_display_output(uint8_t output);
+
+Args:
+    output (int): ``0`` (automatic), ``1`` (DRM/KMS), ``2`` (framebuffer device)
+        or ``3`` (X11 window).
+"""
+clib.set_display_output.argtypes = [ctypes.c_uint8]
+clib.set_display_output.restype = None
+
+"""Enables or disables the thread correcting the missed steps on the laser dot.
+
+C signature:
+    void set_servo(bool enable);
+
+Args:
+    enable (bool): ``True`` to correct the motors on the camera frames.
+
+Warning:
+    Must be called before ``spawn_threads()``.
+"""
+clib.set_servo.argtypes = [ctypes.c_bool]
+clib.set_servo.restype = None
+
+"""Enables or disables the thread streaming the camera frames in MJPEG over HTTP.
+
+C signature:
+    void set_stream_port(uint16_t port);
+
+Args:
+    port (int): The TCP port on the loopback interface, ``0`` to disable the streaming.
+
+Warning:
+    Must be called before ``spawn_threads()``.
+"""
+clib.set_stream_port.argtypes = [ctypes.c_uint16]
+clib.set_stream_port.restype = None
+
+"""Enables or disables the threads recording hard examples for the training dataset.
+
+C signature:
+    void set_collect_dir(const char* dir);
+
+Args:
+    dir (bytes): The dataset directory, created if missing, or ``None`` to disable
+        the collection.
+
+Warning:
+    Must be called before ``spawn_threads()``.
+"""
+clib.set_collect_dir.argtypes = [ctypes.c_char_p]
+clib.set_collect_dir.restype = None
+
+"""Enables or disables the flight recorder.
+
+C signature:
+    void set_flight_dir(const char* dir);
+
+Args:
+    dir (bytes): The directory of the dump files, created if missing, or ``None``
+        to disable the recorder.
+
+Warning:
+    Must be called before ``spawn_threads()``.
+"""
+clib.set_flight_dir.argtypes = [ctypes.c_char_p]
+clib.set_flight_dir.restype = None
+
+"""Dumps the last seconds recorded by the flight recorder to a file.
+
+C signature:
+    void dump_flight_recorder(void);
+
+The file is written by the flight recorder thread, without waiting.
+Does nothing if the recorder is disabled.
+"""
+clib.dump_flight_recorder.argtypes = []
+clib.dump_flight_recorder.restype = None
+
+"""Enables or disables the binary telemetry log.
+
+C signature:
+    void set_telemetry_dir(const char* dir);
+
+Args:
+    dir (bytes): The directory of the log files, created if missing, or ``None``
+        to disable the log.
+
+Warning:
+    Must be called before ``spawn_threads()``.
+"""
+clib.set_telemetry_dir.argtypes = [ctypes.c_char_p]
+clib.set_telemetry_dir.restype = None
+
 """Joins all spawned C/C++ threads.
 
 C signature:
@@ -117,19 +266,43 @@ Returns:
 clib.kill_requested.argtypes = []
 clib.kill_requested.restype = ctypes.c_bool
 
-"""Sends a raw image frame to the display buffer.
+"""Sets the minimum level of the messages logged by the C/C++ threads.
+
+C signature:
+    void set_log_level(uint8_t level);
+
+Args:
+    level (int): ``0`` (debug), ``1`` (info), ``2`` (warning) or ``3`` (error).
+"""
+clib.set_log_level.argtypes = [ctypes.c_uint8]
+clib.set_log_level.restype = None
+
+"""Reads the hardware counters of the calling thread when entering a stage.
+
+C signature:
+    void perf_begin(uint8_t stage);
+
+Does nothing unless the environment variable ``EDGEAI_PERF`` is set to ``1``.
+
+Args:
+    stage (int): The stage being entered, e.g. ``PERF_STAGE_INFERENCE``.
+"""
+clib.perf_begin.argtypes = [ctypes.c_uint8]
+clib.perf_begin.restype = None
+
+"""Reads the hardware counters of the calling thread when leaving a stage.
 
 C signature:
-    void send_frame(uint8_t* data, int width, int height);
+    void perf_end(uint8_t stage);
 
 Args:
-    data (ctypes.POINTER(ctypes.c_ubyte)): Pointer to the raw image data.
-    width (int): Frame width in pixels.
-    height (int): Frame height in pixels.
+    stage (int): The stage being left, e.g. ``PERF_STAGE_INFERENCE``.
 """
-clib.send_frame.argtypes = [ctypes.POINTER(ctypes.c_ubyte),
-                               ctypes.c_int, ctypes.c_int]
-clib.send_frame.restype = None
+clib.perf_end.argtypes = [ctypes.c_uint8]
+clib.perf_end.restype = None
+
+# Pipeline stages instrumented from Python (see perf_counters.h).
+PERF_STAGE_INFERENCE = 2
 
 """Retrieves the latest captured camera frame.
 
@@ -139,16 +312,22 @@ C signature:
 Args:
     out_size (ctypes.POINTER(ctypes.c_size_t)): Pointer to store frame size.
 
+Waits for a frame newer than the previously retrieved one, frames
+captured in between are dropped.
+
 Returns:
-    ctypes.POINTER(ctypes.c_ubyte): Pointer to a newly allocated frame buffer.
+    ctypes.POINTER(ctypes.c_ubyte): Pointer to the frame buffer, taken from
+    the frame pool without copy, or a null pointer if no frame has been
+    captured within 100 ms.
 
 Warning:
-    The caller must free the returned buffer with ``free_frame()``.
+    The caller must release the returned buffer with ``free_frame()``,
+    and must not write to it.
 """
 clib.get_latest_frame.argtypes = [ctypes.POINTER(ctypes.c_size_t)]
 clib.get_latest_frame.restype = ctypes.POINTER(ctypes.c_ubyte)
 
-"""Frees memory allocated for a captured frame.
+"""Releases a captured frame back to the frame pool.
 
 C signature:
     void free_frame(uint8_t* ptr);
@@ -158,11 +337,162 @@ Args:
         from ``get_latest_frame()``.
 
 Warning:
-    Must be called by any Python thread copying frames from the camera thread buffer.
+    Must be called by any Python thread reading frames from the camera thread,
+    once the frame is no longer used.
 """
 clib.free_frame.argtypes = [ctypes.POINTER(ctypes.c_ubyte)]
 clib.free_frame.restype = None
 
+"""Gets the capture sequence number of a frame obtained with ``get_latest_frame()``.
+
+C signature:
+    uint64_t get_frame_id(const uint8_t* ptr);
+
+Args:
+    ptr (ctypes.POINTER(ctypes.c_ubyte)): Pointer to frame data, not released yet.
+
+Returns:
+    int: The capture sequence number, or ``0`` if not a frame of the pool.
+"""
+clib.get_frame_id.argtypes = [ctypes.POINTER(ctypes.c_ubyte)]
+clib.get_frame_id.restype = ctypes.c_uint64
+
+class FramePoolStats(ctypes.Structure):
+    """Usage statistics of the frame pool (``frame_pool_stats_t``)."""
+    _fields_ = [("size", ctypes.c_uint32),
+                ("in_use", ctypes.c_uint32),
+                ("peak_in_use", ctypes.c_uint32),
+                ("acquired", ctypes.c_uint64),
+                ("exhausted", ctypes.c_uint64)]
+
+"""Gets the usage statistics of the frame pool.
+
+C signature:
+    void get_frame_pool_stats(frame_pool_stats_t* stats);
+
+Args:
+    stats (ctypes.POINTER(FramePoolStats)): Structure to fill.
+"""
+clib.get_frame_pool_stats.argtypes = [ctypes.POINTER(FramePoolStats)]
+clib.get_frame_pool_stats.restype = None
+
+class ShmFrameInfo(ctypes.Structure):
+    """Description of a frame published to the inference process (``shm_frame_info_t``)."""
+    _fields_ = [("frame_id", ctypes.c_uint64),
+                ("timestamp_ns", ctypes.c_uint64),
+                ("size", ctypes.c_uint64),
+                ("width", ctypes.c_int32),
+                ("height", ctypes.c_int32)]
+
+class Detection(ctypes.Structure):
+    """Bounding box detected in a camera frame (``detection_t``)."""
+    _fields_ = [("x1", ctypes.c_float),
+                ("y1", ctypes.c_float),
+                ("x2", ctypes.c_float),
+                ("y2", ctypes.c_float),
+                ("conf", ctypes.c_float),
+                ("cls", ctypes.c_int32)]
+
+# Maximum number of detections per batch (see shm_ipc.h).
+SHM_MAX_DETECTIONS = 32
+
+# Detection batch flag: the first detection is the calibration reference.
+SHM_DETECTIONS_CALIBRATION = 0x1
+
+"""Connects the inference process to the running application.
+
+C signature:
+    int inference_connect(void);
+
+Returns:
+    int: ``0`` on success, non-zero if the application is not running in
+    shared memory mode.
+
+Warning:
+    Must only be called from the inference process, which must not call
+    ``init_board()``.
+"""
+clib.inference_connect.argtypes = []
+clib.inference_connect.restype = ctypes.c_int
+
+"""Disconnects the inference process, releasing its leased frame.
+
+C signature:
+    void inference_disconnect(void);
+"""
+clib.inference_disconnect.argtypes = []
+clib.inference_disconnect.restype = None
+
+"""Checks if the application the inference process is connected to still runs.
+
+C signature:
+    bool inference_link_alive(void);
+
+Returns:
+    bool: ``True`` if the application runs, otherwise ``False``.
+"""
+clib.inference_link_alive.argtypes = []
+clib.inference_link_alive.restype = ctypes.c_bool
+
+"""Checks if the motors already received the calibration reference.
+
+C signature:
+    bool inference_calibrated(void);
+
+Returns:
+    bool: ``True`` if the motors are calibrated, so that a restarted inference
+    process must not ask for calibration again.
+"""
+clib.inference_calibrated.argtypes = []
+clib.inference_calibrated.restype = ctypes.c_bool
+
+"""Waits for a new camera frame in the inference process.
+
+C signature:
+    const uint8_t* inference_wait_frame(shm_frame_info_t* info);
+
+Args:
+    info (ctypes.POINTER(ShmFrameInfo)): Description of the frame.
+
+Returns:
+    ctypes.POINTER(ctypes.c_ubyte): Read-only pointer to the frame, read in
+    place in the shared frame pool, or a null pointer if no frame has been
+    published within 100 ms.
+
+Warning:
+    The frame is only valid until the next call or ``inference_release_frame()``,
+    and must not be written to.
+"""
+clib.inference_wait_frame.argtypes = [ctypes.POINTER(ShmFrameInfo)]
+clib.inference_wait_frame.restype = ctypes.POINTER(ctypes.c_ubyte)
+
+"""Releases the frame obtained with ``inference_wait_frame()``.
+
+C signature:
+    void inference_release_frame(void);
+"""
+clib.inference_release_frame.argtypes = []
+clib.inference_release_frame.restype = None
+
+"""Sends the detections of a frame from the inference process.
+
+C signature:
+    int inference_submit(const detection_t* dets, size_t n, uint64_t frame_id, uint32_t flags);
+
+Args:
+    dets (ctypes.POINTER(Detection)): The detections.
+    n (int): Number of detections, at most ``SHM_MAX_DETECTIONS``.
+    frame_id (int): Frame the detections come from.
+    flags (int): ``SHM_DETECTIONS_CALIBRATION`` if the first detection is the
+        calibration reference, ``0`` otherwise.
+
+Returns:
+    int: ``0`` on success, non-zero if not connected.
+"""
+clib.inference_submit.argtypes = [ctypes.POINTER(Detection), ctypes.c_size_t,
+                                  ctypes.c_uint64, ctypes.c_uint32]
+clib.inference_submit.restype = ctypes.c_int
+
 """Sends an absolute position to the motor control system.
 
 C signature:
@@ -175,6 +505,185 @@ Args:
 clib.send_abs_pos.argtypes = [ctypes.c_int16, ctypes.c_int16]
 clib.send_abs_pos.restype = None
 
+"""Loads the calibration model mapping the pixels to the motor steps.
+
+C signature:
+    int load_calibration(const char* path);
+
+Without calibration file, the model is linear (``STEP_SIZE``).
+
+Args:
+    path (bytes): The calibration file.
+
+Returns:
+    int: ``0`` on success, non-zero if the file cannot be read or is invalid.
+"""
+clib.load_calibration.argtypes = [ctypes.c_char_p]
+clib.load_calibration.restype = ctypes.c_int
+
+"""Calibrates the motors automatically with the laser dot.
+
+C signature:
+    int auto_calibrate(const char* path);
+
+Drives the mirrors through a grid covering the frame, fits the calibration
+model to the laser dots, saves it and calibrates the motors. Must be called
+after ``spawn_threads()``, instead of ``send_abs_pos()``.
+
+Args:
+    path (bytes): The calibration file to write.
+
+Returns:
+    int: ``0`` on success, non-zero if the motors are left to calibrate manually.
+"""
+clib.auto_calibrate.argtypes = [ctypes.c_char_p]
+clib.auto_calibrate.restype = ctypes.c_int
+
+"""Checks if the motors received their calibration reference.
+
+C signature:
+    bool motors_calibrated(void);
+
+Returns:
+    bool: ``True`` if the motors are calibrated, otherwise ``False``.
+"""
+clib.motors_calibrated.argtypes = []
+clib.motors_calibrated.restype = ctypes.c_bool
+
+# Maximum number of detections per set (see targeting.h).
+TARGETING_MAX_DETECTIONS = 32
+
+"""Submits the detections of a frame to the targeting thread.
+
+C signature:
+    void submit_detections(const detection_t* dets, size_t n, uint64_t frame_id);
+
+Copies the detections and returns immediately: the targeting thread sends
+the tracked aliens to the motors, in the order minimizing the travel of the
+mirrors, and replaces the detections not handled yet by newer ones.
+
+Args:
+    dets (ctypes.POINTER(Detection)): The detections.
+    n (int): Number of detections, at most ``TARGETING_MAX_DETECTIONS``.
+    frame_id (int): Frame the detections come from, ``0`` if unknown.
+
+Warning:
+    The motors must have been calibrated with ``send_abs_pos()``,
+    detections submitted before are ignored.
+"""
+clib.submit_detections.argtypes = [ctypes.POINTER(Detection), ctypes.c_size_t, ctypes.c_uint64]
+clib.submit_detections.restype = None
+
+"""Sets the time the laser stays on each target.
+
+C signature:
+    void set_dwell_time(uint32_t ms);
+
+Args:
+    ms (int): The dwell time, from the arrival of the beam [ms].
+"""
+clib.set_dwell_time.argtypes = [ctypes.c_uint32]
+clib.set_dwell_time.restype = None
+
+"""Enables or disables the velocity mode of the motors.
+
+C signature:
+    void set_velocity_mode(bool enable);
+
+Args:
+    enable (bool): ``True`` to follow the targets continuously, changing
+        the step rate on the fly, instead of moving from point to point.
+
+Warning:
+    Must be called before ``spawn_threads()``.
+"""
+clib.set_velocity_mode.argtypes = [ctypes.c_bool]
+clib.set_velocity_mode.restype = None
+
+class TargetingStats(ctypes.Structure):
+    """Statistics of the targeting thread (``targeting_stats_t``)."""
+    _fields_ = [("submitted", ctypes.c_uint64),
+                ("replaced", ctypes.c_uint64),
+                ("targets", ctypes.c_uint64),
+                ("abandoned", ctypes.c_uint64)]
+
+"""Gets the statistics of the targeting thread.
+
+C signature:
+    void get_targeting_stats(targeting_stats_t* stats);
+
+Args:
+    stats (ctypes.POINTER(TargetingStats)): Structure to fill.
+"""
+clib.get_targeting_stats.argtypes = [ctypes.POINTER(TargetingStats)]
+clib.get_targeting_stats.restype = None
+
+"""Enables or disables the motion gate of the inference.
+
+C signature:
+    void set_motion_gate(bool enable);
+
+Args:
+    enable (bool): ``True`` to run the inference only when the scene changes,
+        and on a periodic keep-alive, reusing the last detections otherwise.
+"""
+clib.set_motion_gate.argtypes = [ctypes.c_bool]
+clib.set_motion_gate.restype = None
+
+class MotionStats(ctypes.Structure):
+    """Statistics of the motion gate (``motion_stats_t``)."""
+    _fields_ = [("frames", ctypes.c_uint64),
+                ("changes", ctypes.c_uint64),
+                ("admitted", ctypes.c_uint64),
+                ("keepalives", ctypes.c_uint64),
+                ("skipped", ctypes.c_uint64)]
+
+"""Gets the statistics of the motion gate.
+
+C signature:
+    void get_motion_stats(motion_stats_t* stats);
+
+Args:
+    stats (ctypes.POINTER(MotionStats)): Structure to fill.
+"""
+clib.get_motion_stats.argtypes = [ctypes.POINTER(MotionStats)]
+clib.get_motion_stats.restype = None
+
+"""Sets what the rate governor slows down when nothing is in view.
+
+C signature:
+    void set_governor(uint8_t mode);
+
+Args:
+    mode (int): ``0`` (off), ``1`` (inference) or ``2`` (inference and camera).
+"""
+clib.set_governor.argtypes = [ctypes.c_uint8]
+clib.set_governor.restype = None
+
+# Names of the governor states, in the order of governor_state_t.
+GOVERNOR_STATES = ["idle", "acquiring", "tracking"]
+
+class GovernorStats(ctypes.Structure):
+    """Statistics of the rate governor (``governor_stats_t``)."""
+    _fields_ = [("state", ctypes.c_uint32),
+                ("reserved", ctypes.c_uint32),
+                ("transitions", ctypes.c_uint64),
+                ("entered", ctypes.c_uint64 * 3),
+                ("time_ms", ctypes.c_uint64 * 3),
+                ("skipped", ctypes.c_uint64),
+                ("camera_skipped", ctypes.c_uint64)]
+
+"""Gets the statistics of the rate governor.
+
+C signature:
+    void get_governor_stats(governor_stats_t* stats);
+
+Args:
+    stats (ctypes.POINTER(GovernorStats)): Structure to fill.
+"""
+clib.get_governor_stats.argtypes = [ctypes.POINTER(GovernorStats)]
+clib.get_governor_stats.restype = None
+
 """Sends circular motion commands to the motor control system.
 
 C signature:
@@ -188,5 +697,129 @@ Args:
 clib.circle_demo.argtypes = [ctypes.c_int16, ctypes.c_ubyte, ctypes.c_uint32]
 clib.circle_demo.restype = None
 
+class _CtypesFrame:
+    """Camera frame returned by the ctypes wrapper, like ``edgeai_native.Frame``."""
+
+    def __init__(self, ptr, width, height, frame_id, timestamp_ns, release):
+        self._ptr = ptr
+        self._release = release
+        self.width = width
+        self.height = height
+        self.frame_id = frame_id
+        self.timestamp_ns = timestamp_ns
+
+    def __array__(self, dtype=None, copy=None):
+        frame = np.ctypeslib.as_array(self._ptr, shape=(self.height, self.width, 3))
+        frame.flags.writeable = False
+        return frame
+
+    def release(self):
+        """Gives the frame back. Arrays viewing it must not be used anymore."""
+        if self._ptr is not None:
+            self._release(self._ptr)
+            self._ptr = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.release()
+
+def _detections(dets, max_dets):
+    """Converts an array of shape (N, 6) into a ctypes array of ``Detection``."""
+    rows = np.asarray(dets, dtype=np.float32).reshape(-1, 6)[:max_dets]
+    return (Detection * len(rows))(*[Detection(*row[:5], int(row[5])) for row in rows])
+
+class _CtypesBackend:
+    """Wrapper of the ctypes bindings with the API of the native module ``edgeai_native``."""
+
+    PERF_STAGE_INFERENCE = PERF_STAGE_INFERENCE
+    SHM_MAX_DETECTIONS = SHM_MAX_DETECTIONS
+    SHM_DETECTIONS_CALIBRATION = SHM_DETECTIONS_CALIBRATION
+    TARGETING_MAX_DETECTIONS = TARGETING_MAX_DETECTIONS
+
+    def __getattr__(self, name):
+        # Functions with the same signature in both bindings.
+        return getattr(clib, name)
+
+    def get_latest_frame(self):
+        size = ctypes.c_size_t()
+        ptr = clib.get_latest_frame(ctypes.byref(size))
+        if not ptr:
+            return None
+        return _CtypesFrame(ptr, FRAME_WIDTH, FRAME_HEIGHT, clib.get_frame_id(ptr), 0, clib.free_frame)
+
+    def get_frame_pool_stats(self):
+        stats = FramePoolStats()
+        clib.get_frame_pool_stats(ctypes.byref(stats))
+        return {name: getattr(stats, name) for name, _ in FramePoolStats._fields_}
+
+    def inference_wait_frame(self):
+        info = ShmFrameInfo()
+        ptr = clib.inference_wait_frame(ctypes.byref(info))
+        if not ptr:
+            return None
+        return _CtypesFrame(ptr, info.width, info.height, info.frame_id, info.timestamp_ns,
+                            lambda _: clib.inference_release_frame())
+
+    def inference_submit(self, dets, frame_id, flags=0):
+        array = _detections(dets, SHM_MAX_DETECTIONS)
+        return clib.inference_submit(array, len(array), frame_id, flags)
+
+    def load_calibration(self, path):
+        return clib.load_calibration(path.encode())
+
+    def auto_calibrate(self, path):
+        return clib.auto_calibrate(path.encode())
+
+    def set_collect_dir(self, path):
+        clib.set_collect_dir(path.encode() if path is not None else None)
+
+    def set_flight_dir(self, path):
+        clib.set_flight_dir(path.encode() if path is not None else None)
+
+    def set_telemetry_dir(self, path):
+        clib.set_telemetry_dir(path.encode() if path is not None else None)
+
+    def submit_detections(self, dets, frame_id=0):
+        array = _detections(dets, TARGETING_MAX_DETECTIONS)
+        clib.submit_detections(array, len(array), frame_id)
+
+    def get_targeting_stats(self):
+        stats = TargetingStats()
+        clib.get_targeting_stats(ctypes.byref(stats))
+        return {name: getattr(stats, name) for name, _ in TargetingStats._fields_}
+
+    def get_motion_stats(self):
+        stats = MotionStats()
+        clib.get_motion_stats(ctypes.byref(stats))
+        return {name: getattr(stats, name) for name, _ in MotionStats._fields_}
+
+    def get_governor_stats(self):
+        stats = GovernorStats()
+        clib.get_governor_stats(ctypes.byref(stats))
+        return {"state": GOVERNOR_STATES[stats.state],
+                "transitions": stats.transitions,
+                "entered": tuple(stats.entered),
+                "time_ms": tuple(stats.time_ms),
+                "skipped": stats.skipped,
+                "camera_skipped": stats.camera_skipped}
+
+# Camera frame size (see camera.h), for the ctypes wrapper.
+FRAME_WIDTH = 320
+FRAME_HEIGHT = 240
+
+# Native bindings when built, ctypes bindings otherwise.
+try:
+    sys.path.insert(0, "./lib")
+    import edgeai_native as edgeai
+except ImportError:
+    print("[Warning] Native module edgeai_native not found, using ctypes bindings")
+    edgeai = _CtypesBackend()
+finally:
+    sys.path.pop(0)
+
 # Export for external use.
-__all__ = ["clib"]
+__all__ = ["clib", "edgeai", "FramePoolStats", "PERF_STAGE_INFERENCE", "ShmFrameInfo", "Detection",
+           "SHM_MAX_DETECTIONS", "SHM_DETECTIONS_CALIBRATION", "TargetingStats", "TARGETING_MAX_DETECTIONS",
+           "MotionStats", "GovernorStats", "GOVERNOR_STATES"]
@@ -4,7 +4,8 @@ Main entry point for the Python–C/C++ integrated application.
 
 This script initializes the hardware and system resources via the C interface,
 spawns the C/C++ threads for core functionality (motor control, camera, etc.),
-and starts the Python-based YOLOv8n inference thread.
+and starts the Python-based YOLOv8n inference thread. With ``--shm``, the
+inference runs instead in a separate process (``python3 yolov8n_inference.py``).
 
 References:
     - yolov8n_inference.py
@@ -34,35 +35,101 @@ License:
     along with this program.  If not, see <https://www.gnu.org/licenses/>.
 """
 
-from libloader import clib
+from libloader import edgeai
+import argparse
+import os
 import threading
 import yolov8n_inference as yolov8n
 
 EXIT_SUCCESS = 0
 EXIT_FAILURE = 1
 
+# Screen outputs of the display thread, in the order of display_output_t.
+DISPLAY_OUTPUTS = ["auto", "drm", "fb", "x11"]
+
+# What the rate governor slows down, in the order of governor_mode_t.
+GOVERNOR_MODES = ["off", "inference", "camera"]
+
 def main():
     
+    # Command line options.
+    parser = argparse.ArgumentParser(description="Edge AI alien tracking")
+    parser.add_argument("--display", nargs="?", const="auto", choices=DISPLAY_OUTPUTS,
+                        help="display the inference results on screen, directly or in an X11 window (default: auto)")
+    parser.add_argument("--shm", action="store_true",
+                        help="run the inference in a separate process (python3 yolov8n_inference.py)")
+    parser.add_argument("--dwell", type=int, default=0, metavar="MS",
+                        help="time the laser stays on each target [ms]")
+    parser.add_argument("--velocity", action="store_true",
+                        help="follow the targets with continuous step rates instead of point-to-point moves")
+    parser.add_argument("--motion-gate", action="store_true",
+                        help="run the inference only when the scene changes, reusing the last detections otherwise")
+    parser.add_argument("--governor", nargs="?", const="inference", default="off", choices=GOVERNOR_MODES,
+                        help="slow the inference, or also the camera, down when nothing is in view (default: off)")
+    parser.add_argument("--servo", action="store_true",
+                        help="correct the missed steps of the motors on the laser dot")
+    parser.add_argument("--stream", type=int, nargs="?", const=8080, default=0, metavar="PORT",
+                        help="stream the camera frames in MJPEG on http://localhost:PORT/stream (default port: 8080)")
+    parser.add_argument("--collect", metavar="DIR",
+                        help="record the frames with uncertain detections and their YOLO labels in DIR for training")
+    parser.add_argument("--flight", metavar="DIR",
+                        help="keep the last seconds of frames and telemetry in memory, dumped to DIR on SIGUSR1 or missed steps")
+    parser.add_argument("--telemetry", metavar="DIR",
+                        help="log the telemetry in binary files rotated in DIR (read with telemetry_reader.py)")
+    parser.add_argument("--calib", default="calibration.lut", metavar="FILE",
+                        help="calibration file mapping the pixels to the motor steps (default: %(default)s)")
+    parser.add_argument("--auto-calib", action="store_true",
+                        help="calibrate the motors with the laser dot, and write the calibration file")
+    args = parser.parse_args()
+    
     # Hardware and IPC initialization.
-    if clib.init_board() != EXIT_SUCCESS:
+    edgeai.set_shm_mode(args.shm)
+    if edgeai.init_board() != EXIT_SUCCESS:
         print("[Error] Abort main program")
         return EXIT_FAILURE
     
-    # Spawm C/C++ threads: camera, motors, and optionally display.
-    if clib.spawn_threads() != EXIT_SUCCESS:
+    # Calibration model of the motors, linear without file.
+    if os.path.exists(args.calib):
+        if edgeai.load_calibration(args.calib) != EXIT_SUCCESS:
+            print("[Error] Abort main program")
+            return EXIT_FAILURE
+    else:
+        print(f"[Info] No calibration file {args.calib}, using the linear model")
+    
+    # Spawm C/C++ threads: camera, motors, and optionally display, servoing, streaming, collection, flight recorder and telemetry log.
+    edgeai.set_display(args.display is not None)
+    if args.display is not None:
+        edgeai.set_display_output(DISPLAY_OUTPUTS.index(args.display))
+    edgeai.set_dwell_time(max(args.dwell, 0))
+    edgeai.set_velocity_mode(args.velocity)
+    edgeai.set_motion_gate(args.motion_gate)
+    edgeai.set_governor(GOVERNOR_MODES.index(args.governor))
+    edgeai.set_servo(args.servo)
+    edgeai.set_stream_port(args.stream)
+    edgeai.set_collect_dir(args.collect)
+    edgeai.set_flight_dir(args.flight)
+    edgeai.set_telemetry_dir(args.telemetry)
+    if edgeai.spawn_threads() != EXIT_SUCCESS:
         print("[Error] Abort main program")
         return EXIT_FAILURE
     
-    # Spawn YOLOv8n inference Python thread.
-    inference_thread = threading.Thread(target=yolov8n.task)
-    inference_thread.start()
+    # Automatic calibration with the laser dot, manual reference otherwise.
+    if args.auto_calib and edgeai.auto_calibrate(args.calib) != EXIT_SUCCESS:
+        print("[Warning] Automatic calibration failed, falling back to the manual reference")
+    
+    # Spawn YOLOv8n inference Python thread, unless it runs in its own process.
+    inference_thread = None
+    if not args.shm:
+        inference_thread = threading.Thread(target=yolov8n.task)
+        inference_thread.start()
     
     # Wait for all threads to terminate.
-    clib.join_threads()
-    inference_thread.join()
+    edgeai.join_threads()
+    if inference_thread:
+        inference_thread.join()
     
     # Release resources and hardware.
-    clib.exit_clean()
+    edgeai.exit_clean()
     return EXIT_SUCCESS
 
 if __name__ == "__main__":
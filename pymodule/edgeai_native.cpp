@@ -0,0 +1,717 @@
+/**
+ * @file edgeai_native.cpp
+ * @author Adrien Chevrier
+ *
+ * @brief Native Python module exposing the C interface without ctypes.
+ *
+ * This file implements the @c edgeai_native extension module with the
+ * CPython C API. It exposes the functions of @c c_interface.h with Python
+ * types, so that each call costs a plain C function call instead of the
+ * ctypes argument marshalling:
+ * - blocking calls (waiting for a frame, sending a position to the motors,
+ *   joining the threads...) release the GIL while they wait;
+ * - camera frames are returned as @c Frame objects implementing the buffer
+ *   protocol, viewed by numpy without copy (@c numpy.asarray(frame) );
+ * - detections are passed as a single @c float32 array of shape (N, 6),
+ *   each row being x1, y1, x2, y2, confidence and class index.
+ *
+ * A frame goes back to the frame pool when @c Frame.release() is called,
+ * or when the object is destroyed, once no buffer views it anymore.
+ *
+ * @see c_interface.h
+ * @see libloader.py
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <structmember.h>
+
+#include "c_interface.h"
+
+/// Number of values describing a detection in the input arrays.
+#define DETECTION_FIELDS 6
+
+/*******************************************************************************
+ * Frame type
+ ******************************************************************************/
+
+/**
+ * @brief Origin of a frame, which tells how to release it.
+ */
+enum frame_kind_t {
+    FRAME_KIND_POOL,    ///< Frame of the pool, from @c get_latest_frame() .
+    FRAME_KIND_SHM      ///< Frame leased in shared memory, from @c inference_wait_frame() .
+};
+
+/**
+ * @brief Python object holding a camera frame, exported as a read-only buffer.
+ */
+typedef struct {
+    PyObject_HEAD
+    uint8_t* data;                  ///< Pixel data, @c nullptr once released.
+    Py_ssize_t shape[3];            ///< Height, width and channels.
+    Py_ssize_t strides[3];          ///< Strides of the dimensions [bytes].
+    unsigned long long frame_id;    ///< Capture sequence number.
+    unsigned long long timestamp_ns;///< Capture time (@c CLOCK_MONOTONIC ) [ns].
+    int width;                      ///< Frame width [px].
+    int height;                     ///< Frame height [px].
+    frame_kind_t kind;              ///< Origin of the frame.
+    uint64_t lease;                 ///< Lease number, for shared memory frames.
+    int exports;                    ///< Number of buffers viewing the frame.
+    bool release_requested;         ///< Release once no buffer views the frame.
+} FrameObject;
+
+// Number of the current shared memory lease: a new frame ends the previous lease.
+static uint64_t shm_lease = 0;
+
+/**
+ * @brief Gives the frame back, if not done yet.
+ */
+static void frame_do_release(FrameObject* self)
+{
+    if (!self->data) return;
+    if (self->kind == FRAME_KIND_POOL) {
+        free_frame(self->data);
+    } else if (self->lease == shm_lease) {
+        inference_release_frame();
+    }
+    self->data = nullptr;
+}
+
+static void Frame_dealloc(FrameObject* self)
+{
+    frame_do_release(self);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static int Frame_getbuffer(FrameObject* self, Py_buffer* view, int flags)
+{
+    if (!self->data || self->release_requested) {
+        PyErr_SetString(PyExc_BufferError, "frame already released");
+        return -1;
+    }
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "frames are read-only");
+        return -1;
+    }
+
+    view->obj = (PyObject*)self;
+    Py_INCREF(self);
+    view->buf = self->data;
+    view->len = self->shape[0] * self->shape[1] * self->shape[2];
+    view->readonly = 1;
+    view->itemsize = 1;
+    view->format = (flags & PyBUF_FORMAT) ? (char*)"B" : nullptr;
+    view->ndim = 3;
+    view->shape = (flags & PyBUF_ND) ? self->shape : nullptr;
+    view->strides = (flags & PyBUF_STRIDES) ? self->strides : nullptr;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+    self->exports++;
+    return 0;
+}
+
+static void Frame_releasebuffer(FrameObject* self, Py_buffer* view)
+{
+    self->exports--;
+    if (self->exports == 0 && self->release_requested) {
+        frame_do_release(self);
+    }
+}
+
+static PyObject* Frame_release(FrameObject* self, PyObject* Py_UNUSED(args))
+{
+    self->release_requested = true;
+    if (self->exports == 0) {
+        frame_do_release(self);
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject* Frame_enter(FrameObject* self, PyObject* Py_UNUSED(args))
+{
+    Py_INCREF(self);
+    return (PyObject*)self;
+}
+
+static PyObject* Frame_exit(FrameObject* self, PyObject* Py_UNUSED(args))
+{
+    return Frame_release(self, nullptr);
+}
+
+static PyBufferProcs Frame_as_buffer = {
+    (getbufferproc)Frame_getbuffer,
+    (releasebufferproc)Frame_releasebuffer
+};
+
+static PyMethodDef Frame_methods[] = {
+    {"release", (PyCFunction)Frame_release, METH_NOARGS,
+     "Gives the frame back, once no array views it anymore."},
+    {"__enter__", (PyCFunction)Frame_enter, METH_NOARGS, nullptr},
+    {"__exit__", (PyCFunction)Frame_exit, METH_VARARGS, nullptr},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static PyMemberDef Frame_members[] = {
+    {"frame_id", T_ULONGLONG, offsetof(FrameObject, frame_id), READONLY, "Capture sequence number."},
+    {"timestamp_ns", T_ULONGLONG, offsetof(FrameObject, timestamp_ns), READONLY, "Capture time [ns]."},
+    {"width", T_INT, offsetof(FrameObject, width), READONLY, "Frame width [px]."},
+    {"height", T_INT, offsetof(FrameObject, height), READONLY, "Frame height [px]."},
+    {nullptr, 0, 0, 0, nullptr}
+};
+
+static PyTypeObject FrameType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+};
+
+/**
+ * @brief Wraps a frame into a new @c Frame object.
+ *
+ * @return The object, or @c nullptr with an exception set.
+ */
+static PyObject* frame_new(uint8_t* data, int width, int height, uint64_t frame_id,
+                           uint64_t timestamp_ns, frame_kind_t kind)
+{
+    FrameObject* self = PyObject_New(FrameObject, &FrameType);
+    if (!self) return nullptr;
+
+    self->data = data;
+    self->width = width;
+    self->height = height;
+    self->shape[0] = height;
+    self->shape[1] = width;
+    self->shape[2] = 3;
+    self->strides[0] = (Py_ssize_t)width * 3;
+    self->strides[1] = 3;
+    self->strides[2] = 1;
+    self->frame_id = frame_id;
+    self->timestamp_ns = timestamp_ns;
+    self->kind = kind;
+    self->lease = shm_lease;
+    self->exports = 0;
+    self->release_requested = false;
+    return (PyObject*)self;
+}
+
+/*******************************************************************************
+ * Board and Thread Management
+ ******************************************************************************/
+
+static PyObject* py_init_board(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    return PyLong_FromLong(init_board());
+}
+
+static PyObject* py_spawn_threads(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    return PyLong_FromLong(spawn_threads());
+}
+
+static PyObject* py_join_threads(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    Py_BEGIN_ALLOW_THREADS
+    join_threads();
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_exit_clean(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    exit_clean();
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_set_display(PyObject* self, PyObject* arg)
+{
+    int enable = PyObject_IsTrue(arg);
+    if (enable < 0) return nullptr;
+    set_display(enable);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_display_enabled(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    return PyBool_FromLong(display_enabled());
+}
+
+static PyObject* py_set_display_output(PyObject* self, PyObject* arg)
+{
+    long output = PyLong_AsLong(arg);
+    if (output == -1 && PyErr_Occurred()) return nullptr;
+    set_display_output((uint8_t)output);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_set_servo(PyObject* self, PyObject* arg)
+{
+    int enable = PyObject_IsTrue(arg);
+    if (enable < 0) return nullptr;
+    set_servo(enable);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_set_stream_port(PyObject* self, PyObject* arg)
+{
+    long port = PyLong_AsLong(arg);
+    if (port == -1 && PyErr_Occurred()) return nullptr;
+    if (port < 0 || port > 65535) {
+        PyErr_SetString(PyExc_ValueError, "expected a TCP port between 0 and 65535");
+        return nullptr;
+    }
+    set_stream_port((uint16_t)port);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_set_collect_dir(PyObject* self, PyObject* args)
+{
+    const char* dir = nullptr;
+    if (!PyArg_ParseTuple(args, "z", &dir)) return nullptr;
+    set_collect_dir(dir);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_set_flight_dir(PyObject* self, PyObject* args)
+{
+    const char* dir = nullptr;
+    if (!PyArg_ParseTuple(args, "z", &dir)) return nullptr;
+    set_flight_dir(dir);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_dump_flight_recorder(PyObject* self, PyObject* args)
+{
+    dump_flight_recorder();
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_set_telemetry_dir(PyObject* self, PyObject* args)
+{
+    const char* dir = nullptr;
+    if (!PyArg_ParseTuple(args, "z", &dir)) return nullptr;
+    set_telemetry_dir(dir);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_set_shm_mode(PyObject* self, PyObject* arg)
+{
+    int enable = PyObject_IsTrue(arg);
+    if (enable < 0) return nullptr;
+    set_shm_mode(enable);
+    Py_RETURN_NONE;
+}
+
+/*******************************************************************************
+ * Signal Management
+ ******************************************************************************/
+
+static PyObject* py_thread_exit_ready(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    thread_exit_ready();
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_kill_requested(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    return PyBool_FromLong(kill_requested());
+}
+
+static PyObject* py_set_log_level(PyObject* self, PyObject* arg)
+{
+    long level = PyLong_AsLong(arg);
+    if (level == -1 && PyErr_Occurred()) return nullptr;
+    set_log_level((uint8_t)level);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_perf_begin(PyObject* self, PyObject* arg)
+{
+    long stage = PyLong_AsLong(arg);
+    if (stage == -1 && PyErr_Occurred()) return nullptr;
+    perf_begin((uint8_t)stage);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_perf_end(PyObject* self, PyObject* arg)
+{
+    long stage = PyLong_AsLong(arg);
+    if (stage == -1 && PyErr_Occurred()) return nullptr;
+    perf_end((uint8_t)stage);
+    Py_RETURN_NONE;
+}
+
+/*******************************************************************************
+ * Camera/Display Operations
+ ******************************************************************************/
+
+static PyObject* py_get_latest_frame(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    size_t size = 0;
+    uint8_t* data;
+
+    Py_BEGIN_ALLOW_THREADS
+    data = get_latest_frame(&size);
+    Py_END_ALLOW_THREADS
+
+    if (!data) Py_RETURN_NONE;
+
+    const frame_t* frame = frame_pool_find(data);
+    PyObject* obj = frame_new(data, frame->width, frame->height, frame->frame_id,
+                              frame->timestamp_ns, FRAME_KIND_POOL);
+    if (!obj) free_frame(data);
+    return obj;
+}
+
+static PyObject* py_get_frame_pool_stats(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    frame_pool_stats_t stats;
+    get_frame_pool_stats(&stats);
+    return Py_BuildValue("{s:I,s:I,s:I,s:K,s:K}",
+                         "size", stats.size,
+                         "in_use", stats.in_use,
+                         "peak_in_use", stats.peak_in_use,
+                         "acquired", (unsigned long long)stats.acquired,
+                         "exhausted", (unsigned long long)stats.exhausted);
+}
+
+/*******************************************************************************
+ * Inference Process (shared memory mode)
+ ******************************************************************************/
+
+/**
+ * @brief Converts an array of shape (N, 6) into detections.
+ *
+ * @param[in] obj Object supporting the buffer protocol, with @c float32 items.
+ * @param[out] dets The detections, at most @c max_dets .
+ * @param[in] max_dets Size of @p dets .
+ * @return The number of detections, or -1 with an exception set.
+ */
+static Py_ssize_t detections_from_array(PyObject* obj, detection_t* dets, Py_ssize_t max_dets)
+{
+    Py_buffer view;
+    if (PyObject_GetBuffer(obj, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) return -1;
+
+    bool valid = view.itemsize == sizeof(float) && view.format && strcmp(view.format, "f") == 0 &&
+                 ((view.ndim == 2 && view.shape[1] == DETECTION_FIELDS) || view.len == 0);
+    if (!valid) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, "expected a contiguous float32 array of shape (N, 6)");
+        return -1;
+    }
+
+    Py_ssize_t n = view.len / (Py_ssize_t)(DETECTION_FIELDS * sizeof(float));
+    if (n > max_dets) n = max_dets;
+    const float* rows = (const float*)view.buf;
+    for (Py_ssize_t i = 0; i < n; i++) {
+        const float* row = rows + i * DETECTION_FIELDS;
+        dets[i].x1 = row[0];
+        dets[i].y1 = row[1];
+        dets[i].x2 = row[2];
+        dets[i].y2 = row[3];
+        dets[i].conf = row[4];
+        dets[i].cls = (int32_t)row[5];
+    }
+
+    PyBuffer_Release(&view);
+    return n;
+}
+
+static PyObject* py_inference_connect(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    return PyLong_FromLong(inference_connect());
+}
+
+static PyObject* py_inference_disconnect(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    shm_lease++;
+    inference_disconnect();
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_inference_link_alive(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    return PyBool_FromLong(inference_link_alive());
+}
+
+static PyObject* py_inference_calibrated(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    return PyBool_FromLong(inference_calibrated());
+}
+
+static PyObject* py_inference_wait_frame(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    shm_frame_info_t info;
+    const uint8_t* data;
+
+    // The previous frame lease ends here.
+    shm_lease++;
+    Py_BEGIN_ALLOW_THREADS
+    data = inference_wait_frame(&info);
+    Py_END_ALLOW_THREADS
+
+    if (!data) Py_RETURN_NONE;
+    return frame_new((uint8_t*)data, info.width, info.height, info.frame_id,
+                     info.timestamp_ns, FRAME_KIND_SHM);
+}
+
+static PyObject* py_inference_release_frame(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    inference_release_frame();
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_inference_submit(PyObject* self, PyObject* args)
+{
+    PyObject* array;
+    unsigned long long frame_id;
+    unsigned int flags = 0;
+    if (!PyArg_ParseTuple(args, "OK|I", &array, &frame_id, &flags)) return nullptr;
+
+    detection_t dets[SHM_MAX_DETECTIONS];
+    Py_ssize_t n = detections_from_array(array, dets, SHM_MAX_DETECTIONS);
+    if (n < 0) return nullptr;
+    return PyLong_FromLong(inference_submit(dets, (size_t)n, frame_id, flags));
+}
+
+/*******************************************************************************
+ * Communication with stepper motors
+ ******************************************************************************/
+
+static PyObject* py_send_abs_pos(PyObject* self, PyObject* args)
+{
+    int x, y;
+    if (!PyArg_ParseTuple(args, "ii", &x, &y)) return nullptr;
+
+    Py_BEGIN_ALLOW_THREADS
+    send_abs_pos((d_px_t)x, (d_px_t)y);
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_load_calibration(PyObject* self, PyObject* args)
+{
+    const char* path;
+    if (!PyArg_ParseTuple(args, "s", &path)) return nullptr;
+    return PyLong_FromLong(load_calibration(path));
+}
+
+static PyObject* py_auto_calibrate(PyObject* self, PyObject* args)
+{
+    const char* path;
+    if (!PyArg_ParseTuple(args, "s", &path)) return nullptr;
+
+    int exit_code;
+    Py_BEGIN_ALLOW_THREADS
+    exit_code = auto_calibrate(path);
+    Py_END_ALLOW_THREADS
+    return PyLong_FromLong(exit_code);
+}
+
+static PyObject* py_motors_calibrated(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    return PyBool_FromLong(motors_calibrated());
+}
+
+static PyObject* py_submit_detections(PyObject* self, PyObject* args)
+{
+    PyObject* array;
+    unsigned long long frame_id = 0;
+    if (!PyArg_ParseTuple(args, "O|K", &array, &frame_id)) return nullptr;
+
+    detection_t dets[TARGETING_MAX_DETECTIONS];
+    Py_ssize_t n = detections_from_array(array, dets, TARGETING_MAX_DETECTIONS);
+    if (n < 0) return nullptr;
+    submit_detections(dets, (size_t)n, frame_id);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_set_dwell_time(PyObject* self, PyObject* args)
+{
+    unsigned int ms;
+    if (!PyArg_ParseTuple(args, "I", &ms)) return nullptr;
+    set_dwell_time((uint32_t)ms);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_set_velocity_mode(PyObject* self, PyObject* arg)
+{
+    int enable = PyObject_IsTrue(arg);
+    if (enable < 0) return nullptr;
+    set_velocity_mode(enable);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_get_targeting_stats(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    targeting_stats_t stats;
+    get_targeting_stats(&stats);
+    return Py_BuildValue("{s:K,s:K,s:K,s:K}",
+                         "submitted", (unsigned long long)stats.submitted,
+                         "replaced", (unsigned long long)stats.replaced,
+                         "targets", (unsigned long long)stats.targets,
+                         "abandoned", (unsigned long long)stats.abandoned);
+}
+
+static PyObject* py_set_motion_gate(PyObject* self, PyObject* arg)
+{
+    int enable = PyObject_IsTrue(arg);
+    if (enable < 0) return nullptr;
+    set_motion_gate(enable);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_get_motion_stats(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    motion_stats_t stats;
+    get_motion_stats(&stats);
+    return Py_BuildValue("{s:K,s:K,s:K,s:K,s:K}",
+                         "frames", (unsigned long long)stats.frames,
+                         "changes", (unsigned long long)stats.changes,
+                         "admitted", (unsigned long long)stats.admitted,
+                         "keepalives", (unsigned long long)stats.keepalives,
+                         "skipped", (unsigned long long)stats.skipped);
+}
+
+static PyObject* py_set_governor(PyObject* self, PyObject* arg)
+{
+    long mode = PyLong_AsLong(arg);
+    if (mode == -1 && PyErr_Occurred()) return nullptr;
+    set_governor((uint8_t)mode);
+    Py_RETURN_NONE;
+}
+
+static PyObject* py_get_governor_stats(PyObject* self, PyObject* Py_UNUSED(args))
+{
+    governor_stats_t stats;
+    get_governor_stats(&stats);
+    return Py_BuildValue("{s:s,s:K,s:(KKK),s:(KKK),s:K,s:K}",
+                         "state", governor_state_name((governor_state_t)stats.state),
+                         "transitions", (unsigned long long)stats.transitions,
+                         "entered", (unsigned long long)stats.entered[GOVERNOR_IDLE],
+                         (unsigned long long)stats.entered[GOVERNOR_ACQUIRING],
+                         (unsigned long long)stats.entered[GOVERNOR_TRACKING],
+                         "time_ms", (unsigned long long)stats.time_ms[GOVERNOR_IDLE],
+                         (unsigned long long)stats.time_ms[GOVERNOR_ACQUIRING],
+                         (unsigned long long)stats.time_ms[GOVERNOR_TRACKING],
+                         "skipped", (unsigned long long)stats.skipped,
+                         "camera_skipped", (unsigned long long)stats.camera_skipped);
+}
+
+static PyObject* py_circle_demo(PyObject* self, PyObject* args)
+{
+    int r;
+    unsigned int n_pts, delay;
+    if (!PyArg_ParseTuple(args, "iII", &r, &n_pts, &delay)) return nullptr;
+
+    Py_BEGIN_ALLOW_THREADS
+    circle_demo((d_px_t)r, (uint8_t)n_pts, (time_us_t)delay);
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+/*******************************************************************************
+ * Module definition
+ ******************************************************************************/
+
+static PyMethodDef module_methods[] = {
+    {"init_board", py_init_board, METH_NOARGS, "Initializes the hardware and system setup."},
+    {"spawn_threads", py_spawn_threads, METH_NOARGS, "Spawns the C/C++ threads."},
+    {"join_threads", py_join_threads, METH_NOARGS, "Joins the C/C++ threads, without holding the GIL."},
+    {"exit_clean", py_exit_clean, METH_NOARGS, "Cleans up the system before exit."},
+    {"set_display", py_set_display, METH_O, "Enables the display thread, before spawn_threads()."},
+    {"display_enabled", py_display_enabled, METH_NOARGS, "Checks if the display thread is enabled."},
+    {"set_display_output", py_set_display_output, METH_O, "Selects the screen output, before spawn_threads()."},
+    {"set_servo", py_set_servo, METH_O, "Enables the visual servoing thread, before spawn_threads()."},
+    {"set_stream_port", py_set_stream_port, METH_O, "Enables the MJPEG streaming thread on a port, before spawn_threads()."},
+    {"set_collect_dir", py_set_collect_dir, METH_VARARGS, "Enables the recording of hard examples in a dataset directory, before spawn_threads()."},
+    {"set_flight_dir", py_set_flight_dir, METH_VARARGS, "Enables the flight recorder, dumping to a directory, before spawn_threads()."},
+    {"dump_flight_recorder", py_dump_flight_recorder, METH_NOARGS, "Dumps the last seconds recorded by the flight recorder to a file."},
+    {"set_telemetry_dir", py_set_telemetry_dir, METH_VARARGS, "Enables the binary telemetry log in a directory, before spawn_threads()."},
+    {"set_shm_mode", py_set_shm_mode, METH_O, "Runs the inference in a separate process, before init_board()."},
+    {"thread_exit_ready", py_thread_exit_ready, METH_NOARGS, "Marks the calling thread as ready to exit."},
+    {"kill_requested", py_kill_requested, METH_NOARGS, "Checks if a termination signal has been received."},
+    {"set_log_level", py_set_log_level, METH_O, "Sets the minimum level of the logged messages."},
+    {"perf_begin", py_perf_begin, METH_O, "Reads the hardware counters when entering a stage."},
+    {"perf_end", py_perf_end, METH_O, "Reads the hardware counters when leaving a stage."},
+    {"get_latest_frame", py_get_latest_frame, METH_NOARGS,
+     "Waits for a new camera frame without holding the GIL, returns a Frame or None."},
+    {"get_frame_pool_stats", py_get_frame_pool_stats, METH_NOARGS, "Gets the usage statistics of the frame pool."},
+    {"inference_connect", py_inference_connect, METH_NOARGS, "Connects the inference process to the application."},
+    {"inference_disconnect", py_inference_disconnect, METH_NOARGS, "Disconnects the inference process."},
+    {"inference_link_alive", py_inference_link_alive, METH_NOARGS, "Checks if the application still runs."},
+    {"inference_calibrated", py_inference_calibrated, METH_NOARGS, "Checks if the motors are calibrated."},
+    {"inference_wait_frame", py_inference_wait_frame, METH_NOARGS,
+     "Waits for a new frame in shared memory without holding the GIL, returns a Frame or None."},
+    {"inference_release_frame", py_inference_release_frame, METH_NOARGS, "Releases the leased frame."},
+    {"inference_submit", py_inference_submit, METH_VARARGS,
+     "Sends a float32 array of detections of shape (N, 6), its frame number and flags."},
+    {"send_abs_pos", py_send_abs_pos, METH_VARARGS, "Sends an absolute position to the motors."},
+    {"load_calibration", py_load_calibration, METH_VARARGS, "Loads the calibration file mapping the pixels to the motor steps."},
+    {"auto_calibrate", py_auto_calibrate, METH_VARARGS,
+     "Calibrates the motors with the laser dot without holding the GIL, and saves the calibration file."},
+    {"motors_calibrated", py_motors_calibrated, METH_NOARGS, "Checks if the motors received their calibration reference."},
+    {"submit_detections", py_submit_detections, METH_VARARGS,
+     "Submits a float32 array of detections of shape (N, 6) and its frame number to the targeting thread."},
+    {"set_dwell_time", py_set_dwell_time, METH_VARARGS, "Sets the time the laser stays on each target [ms]."},
+    {"set_velocity_mode", py_set_velocity_mode, METH_O, "Follows the targets in velocity mode, before spawn_threads()."},
+    {"get_targeting_stats", py_get_targeting_stats, METH_NOARGS, "Gets the statistics of the targeting thread."},
+    {"set_motion_gate", py_set_motion_gate, METH_O, "Skips the inference on the frames where the scene is static."},
+    {"get_motion_stats", py_get_motion_stats, METH_NOARGS, "Gets the statistics of the motion gate."},
+    {"set_governor", py_set_governor, METH_O, "Slows the inference, and optionally the camera, down when nothing is in view."},
+    {"get_governor_stats", py_get_governor_stats, METH_NOARGS, "Gets the statistics of the rate governor."},
+    {"circle_demo", py_circle_demo, METH_VARARGS, "Moves the motors in a circular pattern."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static struct PyModuleDef module_def = {
+    PyModuleDef_HEAD_INIT,
+    "edgeai_native",
+    "Native bindings of the C interface.",
+    -1,
+    module_methods
+};
+
+PyMODINIT_FUNC PyInit_edgeai_native(void)
+{
+    FrameType.tp_name = "edgeai_native.Frame";
+    FrameType.tp_doc = "Camera frame, viewed without copy through the buffer protocol.";
+    FrameType.tp_basicsize = sizeof(FrameObject);
+    FrameType.tp_flags = Py_TPFLAGS_DEFAULT;
+    FrameType.tp_dealloc = (destructor)Frame_dealloc;
+    FrameType.tp_as_buffer = &Frame_as_buffer;
+    FrameType.tp_methods = Frame_methods;
+    FrameType.tp_members = Frame_members;
+    if (PyType_Ready(&FrameType) < 0) return nullptr;
+
+    PyObject* module = PyModule_Create(&module_def);
+    if (!module) return nullptr;
+
+    Py_INCREF(&FrameType);
+    if (PyModule_AddObject(module, "Frame", (PyObject*)&FrameType) < 0) {
+        Py_DECREF(&FrameType);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    PyModule_AddIntConstant(module, "PERF_STAGE_INFERENCE", PERF_STAGE_INFERENCE);
+    PyModule_AddIntConstant(module, "SHM_MAX_DETECTIONS", SHM_MAX_DETECTIONS);
+    PyModule_AddIntConstant(module, "SHM_DETECTIONS_CALIBRATION", SHM_DETECTIONS_CALIBRATION);
+    PyModule_AddIntConstant(module, "TARGETING_MAX_DETECTIONS", TARGETING_MAX_DETECTIONS);
+    return module;
+}
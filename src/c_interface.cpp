@@ -5,16 +5,8 @@
  * @brief Implementation file for the header @c c_interface.h .
  *
  * @see c_interface.h
- *
- * @note Uncomment statements commented with two pairs of dashes // ... //
- * to run the thread that displays inference results on screen.
- * Also modify ipc_elements.h, ipc_elements.c and yolov8n_inference.py
- * accordingly.
- *
- * @todo provide an easy way to display the results or not.
- *
  * @see display_result.h and display_result.cpp
- * @see ipc_elements.h and ipc_elements.cpp
+ * @see ipc_elements.h and ipc_elements.c
  * @see yolov8n_inference.py
  * 
  * @version 0.1
@@ -40,9 +32,44 @@
 
 // Declare thread strcutures.
 static pthread_t camera_thread;
-//static pthread_t display_thread;//
+static pthread_t display_thread;
 static pthread_t stepper_x_thread;
 static pthread_t stepper_y_thread;
+static pthread_t targeting_thread;
+static pthread_t corr_thread;
+static pthread_t servo_thread;
+static pthread_t stream_thread;
+static pthread_t collect_thread;
+static pthread_t collect_writer_thread;
+static pthread_t flight_thread;
+static pthread_t telemetry_thread;
+static pthread_t shm_publish_thread;
+static pthread_t shm_detections_thread;
+
+// Display thread enabled.
+static bool display_on = false;
+static display_output_t display_output = DISPLAY_OUTPUT_AUTO;
+
+// Visual servoing thread enabled.
+static bool servo_on = false;
+
+// MJPEG streaming thread port, 0 if disabled.
+static uint16_t stream_port = 0;
+
+// Dataset directory of the hard examples, empty if the collection is disabled.
+static std::string collect_dir;
+
+// Directory of the flight recorder dumps, empty if the recorder is disabled.
+static std::string flight_dir;
+
+// Directory of the telemetry log files, empty if the log is disabled.
+static std::string telemetry_dir;
+
+// Inference running in a separate process.
+static bool shm_on = false;
+
+// Subscription of the inference thread to the camera frames.
+static frame_sub_t* inference_sub = nullptr;
 
 /*******************************************************************************
  * Board and Thread Management
@@ -50,6 +77,12 @@ static pthread_t stepper_y_thread;
 
 int init_board(void)
 {
+    if (log_init() == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    perf_init();
+
     if (gpio_setup() == EXIT_FAILURE) {
         return EXIT_FAILURE;
     }
@@ -58,11 +91,46 @@ int init_board(void)
         return EXIT_FAILURE;
     }
 
+	return init_pipeline();
+}
+
+int init_pipeline(void)
+{
+	if (shm_on) {
+		// The inference process reads the frames directly in the pool.
+		if (frame_pool_init_shared(FRAME_BUFFER_SIZE, SHM_POOL_NAME) == EXIT_FAILURE) {
+			return EXIT_FAILURE;
+		}
+	} else if (frame_pool_init(FRAME_BUFFER_SIZE) == EXIT_FAILURE) {
+		return EXIT_FAILURE;
+	}
+
 	ipc_init();
+	overlay_init();
+	targeting_init();
+	corr_tracker_init();
+	motion_gate_init();
+	governor_init();
+
+	if (shm_on) {
+		return shm_ipc_init();
+	}
+
+	// Inference only needs the most recent frame.
+	inference_sub = frame_bus_subscribe(&cam_bus, "inference", FRAME_BUS_LATEST, 0);
+	if (!inference_sub) {
+		std::cerr << "[Error] Could not subscribe to the camera bus" << std::endl;
+		return EXIT_FAILURE;
+	}
 
 	return EXIT_SUCCESS;
 }
 
+void set_shm_mode(bool enable)
+{
+	shm_on = enable;
+}
+
 int spawn_threads(void)
 {
 
@@ -81,26 +149,203 @@ int spawn_threads(void)
 		return EXIT_FAILURE;
 	}
 
-	//if (pthread_create(&display_thread, nullptr, display_task, nullptr) != 0) {//
-	//	std::cerr << "[Error] Could not create task for display" << std::endl;	 //
-	//	return EXIT_FAILURE;													 //
-	//}																			 //
+	if (pthread_create(&targeting_thread, nullptr, targeting_task, nullptr) != 0) {
+		std::cerr << "[Error] Could not create task for targeting" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (pthread_create(&corr_thread, nullptr, corr_tracker_task, nullptr) != 0) {
+		std::cerr << "[Error] Could not create task for correlation tracking" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (display_on) {
+		if (pthread_create(&display_thread, nullptr, display_task, &display_output) != 0) {
+			std::cerr << "[Error] Could not create task for display" << std::endl;
+			return EXIT_FAILURE;
+		}
+		thread_number++;
+	}
+
+	if (servo_on) {
+		if (pthread_create(&servo_thread, nullptr, servo_task, nullptr) != 0) {
+			std::cerr << "[Error] Could not create task for visual servoing" << std::endl;
+			return EXIT_FAILURE;
+		}
+		thread_number++;
+	}
+
+	if (stream_port != 0) {
+		if (pthread_create(&stream_thread, nullptr, stream_task, &stream_port) != 0) {
+			std::cerr << "[Error] Could not create task for MJPEG streaming" << std::endl;
+			return EXIT_FAILURE;
+		}
+		thread_number++;
+	}
+
+	if (!collect_dir.empty()) {
+		if (collect_open(collect_dir.c_str()) == EXIT_FAILURE) {
+			std::cerr << "[Error] Could not open the dataset directory " << collect_dir << std::endl;
+			return EXIT_FAILURE;
+		}
+		if (pthread_create(&collect_thread, nullptr, collect_task, nullptr) != 0) {
+			std::cerr << "[Error] Could not create task for dataset collection" << std::endl;
+			return EXIT_FAILURE;
+		}
+		if (pthread_create(&collect_writer_thread, nullptr, collect_writer_task, nullptr) != 0) {
+			std::cerr << "[Error] Could not create task for dataset writing" << std::endl;
+			return EXIT_FAILURE;
+		}
+		thread_number += 2;
+	}
+
+	if (!flight_dir.empty()) {
+		if (flight_open(flight_dir.c_str()) == EXIT_FAILURE) {
+			std::cerr << "[Error] Could not open the flight recorder in " << flight_dir << std::endl;
+			return EXIT_FAILURE;
+		}
+		if (pthread_create(&flight_thread, nullptr, flight_task, nullptr) != 0) {
+			std::cerr << "[Error] Could not create task for the flight recorder" << std::endl;
+			return EXIT_FAILURE;
+		}
+		thread_number++;
+	}
+
+	if (!telemetry_dir.empty()) {
+		if (telemetry_open(telemetry_dir.c_str()) == EXIT_FAILURE) {
+			std::cerr << "[Error] Could not open the telemetry log in " << telemetry_dir << std::endl;
+			return EXIT_FAILURE;
+		}
+		if (pthread_create(&telemetry_thread, nullptr, telemetry_task, nullptr) != 0) {
+			std::cerr << "[Error] Could not create task for the telemetry log" << std::endl;
+			return EXIT_FAILURE;
+		}
+		thread_number++;
+	}
+
+	// Both link threads replace the Python inference thread.
+	if (shm_on) {
+		if (pthread_create(&shm_publish_thread, nullptr, shm_publish_task, nullptr) != 0) {
+			std::cerr << "[Error] Could not create task for shared memory publishing" << std::endl;
+			return EXIT_FAILURE;
+		}
+		if (pthread_create(&shm_detections_thread, nullptr, shm_detections_task, nullptr) != 0) {
+			std::cerr << "[Error] Could not create task for shared memory detections" << std::endl;
+			return EXIT_FAILURE;
+		}
+		thread_number++;
+	}
 
 	return EXIT_SUCCESS;
 }
 
+void set_display(bool enable)
+{
+	display_on = enable;
+}
+
+bool display_enabled(void)
+{
+	return display_on;
+}
+
+void set_display_output(uint8_t output)
+{
+	display_output = (display_output_t)output;
+}
+
+void set_servo(bool enable)
+{
+	servo_on = enable;
+}
+
+void set_stream_port(uint16_t port)
+{
+	stream_port = port;
+}
+
+void set_collect_dir(const char* dir)
+{
+	collect_dir = dir ? dir : "";
+}
+
+void set_flight_dir(const char* dir)
+{
+	flight_dir = dir ? dir : "";
+}
+
+void dump_flight_recorder(void)
+{
+	flight_trigger(FLIGHT_TRIGGER_API);
+}
+
+void set_telemetry_dir(const char* dir)
+{
+	telemetry_dir = dir ? dir : "";
+}
+
 void join_threads(void)
 {
 	pthread_join(camera_thread, nullptr);
-	//pthread_join(display_thread, nullptr);//
+	if (display_on) {
+		pthread_join(display_thread, nullptr);
+	}
+	if (shm_on) {
+		pthread_join(shm_publish_thread, nullptr);
+		pthread_join(shm_detections_thread, nullptr);
+	}
+	if (servo_on) {
+		pthread_join(servo_thread, nullptr);
+	}
+	if (stream_port != 0) {
+		pthread_join(stream_thread, nullptr);
+	}
+	if (!collect_dir.empty()) {
+		pthread_join(collect_thread, nullptr);
+		pthread_join(collect_writer_thread, nullptr);
+	}
+	if (!flight_dir.empty()) {
+		pthread_join(flight_thread, nullptr);
+	}
+	if (!telemetry_dir.empty()) {
+		pthread_join(telemetry_thread, nullptr);
+	}
+	pthread_join(corr_thread, nullptr);
+	pthread_join(targeting_thread, nullptr);
 	pthread_join(stepper_x_thread, nullptr);
 	pthread_join(stepper_y_thread, nullptr);
 }
 
 void exit_clean(void)
 {
-	ipc_close();
+	if (shm_on) {
+		shm_ipc_close();
+	}
+	if (!collect_dir.empty()) {
+		collect_close();
+	}
+	if (!flight_dir.empty()) {
+		flight_close();
+	}
+	if (!telemetry_dir.empty()) {
+		telemetry_close();
+	}
 	gpio_close();
+	close_pipeline();
+	log_close();
+}
+
+void close_pipeline(void)
+{
+	frame_bus_unsubscribe(&cam_bus, inference_sub);
+	inference_sub = nullptr;
+	corr_tracker_close();
+	motion_gate_close();
+	governor_close();
+	targeting_close();
+	overlay_close();
+	ipc_close();
+	frame_pool_close();
 }
 
 /*******************************************************************************
@@ -117,40 +362,100 @@ bool kill_requested(void)
 	return psig_kill_requested();
 }
 
+void set_log_level(uint8_t level)
+{
+	log_set_level((log_level_t)level);
+}
+
+void perf_begin(uint8_t stage)
+{
+	perf_stage_begin((perf_stage_t)stage);
+}
+
+void perf_end(uint8_t stage)
+{
+	perf_stage_end((perf_stage_t)stage);
+}
+
 /*******************************************************************************
  * Camera/Display Operations
  ******************************************************************************/
 
-void send_frame(uint8_t* data, int width, int height)
+uint8_t* get_latest_frame(size_t* out_size)
 {
-	// Create a Mat object from the raw data and store it in the display buffer.
-	// Does nothing if it failed to lock the mutex.
-    if (pthread_mutex_trylock(&disp_buffer_mutex) == 0) {
-		disp_buffer_0 = cv::Mat(height, width, CV_8UC3, data).clone(); 
-		pthread_mutex_unlock(&disp_buffer_mutex);
+	// Wait for a new frame, whose reference is handed to the caller.
+	frame_t* frame = frame_sub_receive(&cam_bus, inference_sub, FRAME_WAIT_MS);
+
+	// No new frame captured, a frame dropped in idle, or a static scene
+	// whose last detections are reused.
+	if (frame && (!governor_admit() || !motion_gate_admit(frame))) {
+		frame_unref(frame);
+		frame = nullptr;
+	}
+	if (!frame) {
+		*out_size = 0;
+		return nullptr;
 	}
+
+	// Return data and size.
+    *out_size = frame->size;
+    return frame->data;
 }
 
-uint8_t* get_latest_frame(size_t* out_size)
+void free_frame(uint8_t* ptr)
 {
-	// Wait until a frame is available.
-    pthread_mutex_lock(&cam_buffer_mutex);
-    size_t data_size = cam_buffer_0.total() * cam_buffer_0.elemSize();
-    uint8_t* buffer = (uint8_t*)malloc(data_size);
+	// Release the reference taken by get_latest_frame().
+    frame_unref(frame_pool_find(ptr));
+}
 
-	// Copy the data from the camera buffer to the new buffer.
-    memcpy(buffer, cam_buffer_0.data, data_size);
+uint64_t get_frame_id(const uint8_t* ptr)
+{
+	const frame_t* frame = frame_pool_find(ptr);
+	return frame ? frame->frame_id : 0;
+}
 
-    pthread_mutex_unlock(&cam_buffer_mutex);
+void get_frame_pool_stats(frame_pool_stats_t* stats)
+{
+	frame_pool_get_stats(stats);
+}
 
-	// Return data and size.
-    *out_size = data_size;
-    return buffer;
+/*******************************************************************************
+ * Inference Process (shared memory mode)
+ ******************************************************************************/
+
+int inference_connect(void)
+{
+	return shm_client_connect();
 }
 
-void free_frame(uint8_t* ptr)
+void inference_disconnect(void)
+{
+	shm_client_disconnect();
+}
+
+bool inference_link_alive(void)
+{
+	return shm_client_alive();
+}
+
+bool inference_calibrated(void)
+{
+	return shm_client_calibrated();
+}
+
+const uint8_t* inference_wait_frame(shm_frame_info_t* info)
 {
-    free(ptr);
+	return shm_client_wait_frame(info);
+}
+
+void inference_release_frame(void)
+{
+	shm_client_release_frame();
+}
+
+int inference_submit(const detection_t* dets, size_t n, uint64_t frame_id, uint32_t flags)
+{
+	return shm_client_submit(dets, n, frame_id, flags);
 }
 
 /*******************************************************************************
@@ -162,6 +467,73 @@ void send_abs_pos(d_px_t x, d_px_t y)
 	write_abs_pos(x, y);
 }
 
+int load_calibration(const char* path)
+{
+	return calib_load(path);
+}
+
+int auto_calibrate(const char* path)
+{
+	// The inference process must not send a reference during the sweep.
+	if (shm_on) {
+		shm_ipc_set_calibrated(true);
+	}
+	int exit_code = calib_sweep_run(path);
+	if (shm_on) {
+		shm_ipc_set_calibrated(motors_calibrated());
+	}
+	return exit_code;
+}
+
+bool motors_calibrated(void)
+{
+	return read_abs_pos(nullptr, nullptr, nullptr);
+}
+
+void submit_detections(const detection_t* dets, size_t n, uint64_t frame_id)
+{
+	targeting_submit(dets, n, frame_id);
+}
+
+void set_velocity_mode(bool enable)
+{
+	motor_set_mode(enable ? MOTOR_MODE_VELOCITY : MOTOR_MODE_POINT);
+}
+
+void set_dwell_time(uint32_t ms)
+{
+	targeting_set_dwell_ms(ms);
+}
+
+void get_targeting_stats(targeting_stats_t* stats)
+{
+	targeting_get_stats(stats);
+}
+
+void set_motion_gate(bool enable)
+{
+	motion_gate_enable(enable);
+}
+
+void get_motion_stats(motion_stats_t* stats)
+{
+	motion_gate_get_stats(stats);
+}
+
+void set_governor(uint8_t mode)
+{
+	if (mode > GOVERNOR_CAMERA) {
+		log_write(LOG_WARNING, "Invalid governor mode %d", mode);
+		return;
+	}
+	governor_set_mode((governor_mode_t)mode);
+}
+
+void get_governor_stats(governor_stats_t* stats)
+{
+	governor_get_stats(stats);
+}
+
 void circle_demo(d_px_t r, uint8_t n_pts, time_us_t delay)
 {
 	circle(r, n_pts, delay);
@@ -0,0 +1,267 @@
+/**
+ * @file calib.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c calib.h .
+ *
+ * @see calib.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "calib.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "setup.h"
+#include "log_utils.h"
+
+/**
+ * @brief Lookup table of the calibration model.
+ */
+typedef struct {
+    int cols;
+    int rows;
+    float cell;
+    float* sx;
+    float* sy;
+} calib_grid_t;
+
+// Current table, empty for the linear model, and its lock.
+static pthread_mutex_t grid_mutex = PTHREAD_MUTEX_INITIALIZER;
+static calib_grid_t grid = { 0, 0, 0.0f, NULL, NULL };
+
+/**
+ * @brief Replaces the current table, and frees the previous one.
+ */
+static void swap_grid(calib_grid_t* g)
+{
+    pthread_mutex_lock(&grid_mutex);
+    calib_grid_t old = grid;
+    grid = *g;
+    pthread_mutex_unlock(&grid_mutex);
+
+    free(old.sx);
+    free(old.sy);
+}
+
+int calib_set_grid(int cols, int rows, float cell, const float* sx, const float* sy)
+{
+    if (cols < 2 || rows < 2 || (long)cols * rows > CALIB_MAX_NODES || cell <= 0.0f) {
+        log_write(LOG_WARNING, "Invalid calibration grid %dx%d, cell %.1f px", cols, rows, cell);
+        return EXIT_FAILURE;
+    }
+
+    size_t n = (size_t)cols * rows;
+    calib_grid_t g = { cols, rows, cell, malloc(n * sizeof(float)), malloc(n * sizeof(float)) };
+    if (!g.sx || !g.sy) {
+        free(g.sx);
+        free(g.sy);
+        log_write(LOG_WARNING, "Could not allocate the calibration grid");
+        return EXIT_FAILURE;
+    }
+    memcpy(g.sx, sx, n * sizeof(float));
+    memcpy(g.sy, sy, n * sizeof(float));
+    swap_grid(&g);
+
+    log_write(LOG_INFO, "Calibration grid %dx%d, cell %.1f px", cols, rows, cell);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Reads the next line of a file which is not a comment.
+ *
+ * @return @c true if a line was read, @c false at the end of the file.
+ */
+static bool next_line(FILE* f, char* line, size_t size)
+{
+    while (fgets(line, (int)size, f)) {
+        if (line[0] != '#' && line[0] != '\n') return true;
+    }
+    return false;
+}
+
+int calib_load(const char* path)
+{
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        log_write(LOG_WARNING, "Could not open calibration file %s", path);
+        return EXIT_FAILURE;
+    }
+
+    char line[128];
+    int cols = 0, rows = 0;
+    float cell = 0.0f;
+    if (!next_line(f, line, sizeof(line)) || sscanf(line, "grid %d %d %f", &cols, &rows, &cell) != 3 ||
+        cols < 2 || rows < 2 || (long)cols * rows > CALIB_MAX_NODES) {
+        log_write(LOG_WARNING, "Invalid calibration file header in %s", path);
+        fclose(f);
+        return EXIT_FAILURE;
+    }
+
+    size_t n = (size_t)cols * rows;
+    float* sx = malloc(n * sizeof(float));
+    float* sy = malloc(n * sizeof(float));
+    size_t read = 0;
+    while (sx && sy && read < n && next_line(f, line, sizeof(line))) {
+        if (sscanf(line, "%f %f", &sx[read], &sy[read]) != 2) break;
+        read++;
+    }
+    fclose(f);
+
+    int exit_code = EXIT_FAILURE;
+    if (read == n) {
+        exit_code = calib_set_grid(cols, rows, cell, sx, sy);
+    } else {
+        log_write(LOG_WARNING, "Calibration file %s has %zu nodes out of %zu", path, read, n);
+    }
+    free(sx);
+    free(sy);
+    return exit_code;
+}
+
+int calib_save(const char* path)
+{
+    pthread_mutex_lock(&grid_mutex);
+    if (!grid.sx) {
+        pthread_mutex_unlock(&grid_mutex);
+        log_write(LOG_WARNING, "No calibration grid to save");
+        return EXIT_FAILURE;
+    }
+
+    FILE* f = fopen(path, "w");
+    if (f) {
+        fprintf(f, "# Calibration: absolute step positions aiming at each node of the grid.\n");
+        fprintf(f, "grid %d %d %g\n", grid.cols, grid.rows, grid.cell);
+        for (size_t i = 0; i < (size_t)grid.cols * grid.rows; i++) {
+            fprintf(f, "%.2f %.2f\n", grid.sx[i], grid.sy[i]);
+        }
+    }
+    pthread_mutex_unlock(&grid_mutex);
+
+    if (!f || fclose(f) != 0) {
+        log_write(LOG_WARNING, "Could not write calibration file %s", path);
+        return EXIT_FAILURE;
+    }
+    log_write(LOG_INFO, "Saved calibration file %s", path);
+    return EXIT_SUCCESS;
+}
+
+void calib_clear(void)
+{
+    calib_grid_t g = { 0, 0, 0.0f, NULL, NULL };
+    swap_grid(&g);
+}
+
+bool calib_loaded(void)
+{
+    pthread_mutex_lock(&grid_mutex);
+    bool loaded = grid.sx != NULL;
+    pthread_mutex_unlock(&grid_mutex);
+    return loaded;
+}
+
+/**
+ * @brief Interpolates the current table at a pixel, with @c grid_mutex held.
+ */
+static void grid_eval(float x, float y, float* sx, float* sy)
+{
+    // Cell of the pixel, clamped to the grid.
+    float gx = x / grid.cell;
+    float gy = y / grid.cell;
+    if (gx < 0.0f) gx = 0.0f;
+    if (gy < 0.0f) gy = 0.0f;
+    if (gx > grid.cols - 1) gx = (float)(grid.cols - 1);
+    if (gy > grid.rows - 1) gy = (float)(grid.rows - 1);
+    int i = (int)gx;
+    int j = (int)gy;
+    if (i > grid.cols - 2) i = grid.cols - 2;
+    if (j > grid.rows - 2) j = grid.rows - 2;
+    float fx = gx - i;
+    float fy = gy - j;
+
+    // Bilinear interpolation between the four nodes of the cell.
+    size_t k = (size_t)j * grid.cols + i;
+    size_t c = (size_t)grid.cols;
+    *sx = (1.0f - fy) * ((1.0f - fx) * grid.sx[k] + fx * grid.sx[k + 1]) +
+          fy * ((1.0f - fx) * grid.sx[k + c] + fx * grid.sx[k + c + 1]);
+    *sy = (1.0f - fy) * ((1.0f - fx) * grid.sy[k] + fx * grid.sy[k + 1]) +
+          fy * ((1.0f - fx) * grid.sy[k + c] + fx * grid.sy[k + c + 1]);
+}
+
+void calib_px_to_steps(float x, float y, float* sx, float* sy)
+{
+    pthread_mutex_lock(&grid_mutex);
+
+    // Linear model.
+    if (!grid.sx) {
+        pthread_mutex_unlock(&grid_mutex);
+        *sx = x / STEP_SIZE;
+        *sy = y / STEP_SIZE;
+        return;
+    }
+
+    grid_eval(x, y, sx, sy);
+    pthread_mutex_unlock(&grid_mutex);
+}
+
+void calib_steps_to_px(float sx, float sy, float* x, float* y)
+{
+    pthread_mutex_lock(&grid_mutex);
+
+    // Linear model.
+    if (!grid.sx) {
+        pthread_mutex_unlock(&grid_mutex);
+        *x = sx * STEP_SIZE;
+        *y = sy * STEP_SIZE;
+        return;
+    }
+
+    // Newton iterations within the grid, where the model is not flat, with the
+    // Jacobian by finite differences of one pixel towards the inside.
+    float max_x = (grid.cols - 1) * grid.cell;
+    float max_y = (grid.rows - 1) * grid.cell;
+    for (int i = 0; i < CALIB_INVERSE_ITERATIONS; i++) {
+        *x = fminf(fmaxf(*x, 0.0f), max_x);
+        *y = fminf(fmaxf(*y, 0.0f), max_y);
+        float hx = *x + 1.0f <= max_x ? 1.0f : -1.0f;
+        float hy = *y + 1.0f <= max_y ? 1.0f : -1.0f;
+
+        float ax, ay, bx, by, cx, cy;
+        grid_eval(*x, *y, &ax, &ay);
+        float ex = sx - ax;
+        float ey = sy - ay;
+        if (fabsf(ex) < CALIB_INVERSE_TOLERANCE && fabsf(ey) < CALIB_INVERSE_TOLERANCE) break;
+        grid_eval(*x + hx, *y, &bx, &by);
+        grid_eval(*x, *y + hy, &cx, &cy);
+        float j11 = (bx - ax) / hx, j12 = (cx - ax) / hy;
+        float j21 = (by - ay) / hx, j22 = (cy - ay) / hy;
+        float det = j11 * j22 - j12 * j21;
+
+        // Degenerate table.
+        if (fabsf(det) < 1e-6f) break;
+        *x += (j22 * ex - j12 * ey) / det;
+        *y += (j11 * ey - j21 * ex) / det;
+    }
+
+    pthread_mutex_unlock(&grid_mutex);
+}
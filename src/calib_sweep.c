@@ -0,0 +1,405 @@
+/**
+ * @file calib_sweep.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c calib_sweep.h .
+ *
+ * @see calib_sweep.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "calib_sweep.h"
+
+#include <math.h>
+
+#include "psig_utils.h"
+#include "log_utils.h"
+#include "ipc_elements.h"
+#include "wait_utils.h"
+#include "frame_clock.h"
+#include "setup.h"
+#include "ctrl_motors.h"
+#include "stepper_demo.h"
+#include "laser_dot.h"
+#include "calib.h"
+
+// Maximum number of dots: the grid, the starting position and both probes.
+#define MAX_POINTS (CALIB_SWEEP_COLS * CALIB_SWEEP_ROWS + 3)
+
+// Number of terms of the fitted polynomials.
+#define TERMS_AFFINE 3
+#define TERMS_QUADRATIC 6
+#define TERMS_CUBIC 10
+
+/**
+ * @brief Dot found at a step position.
+ */
+typedef struct {
+    float px;   ///< X-position of the dot [px].
+    float py;   ///< Y-position of the dot [px].
+    float sx;   ///< X-step position [steps].
+    float sy;   ///< Y-step position [steps].
+} sample_t;
+
+/**
+ * @brief Step positions as polynomials of the pixel.
+ *
+ * The pixels are normalized to [-1, 1] over the frame for conditioning.
+ */
+typedef struct {
+    int terms;
+    float half_w;
+    float half_h;
+    double cx[TERMS_CUBIC];
+    double cy[TERMS_CUBIC];
+} fit_t;
+
+/*******************************************************************************
+ * Model fitting
+ ******************************************************************************/
+
+/**
+ * @brief Computes the monomials of a normalized pixel, by increasing degree.
+ */
+static void poly_terms(const fit_t* fit, float x, float y, double* t)
+{
+    double u = (x - fit->half_w) / fit->half_w;
+    double v = (y - fit->half_h) / fit->half_h;
+    double all[TERMS_CUBIC] = { 1.0, u, v, u * u, u * v, v * v, u * u * u, u * u * v, u * v * v, v * v * v };
+    for (int k = 0; k < fit->terms; k++) t[k] = all[k];
+}
+
+/**
+ * @brief Evaluates the fitted step positions of a pixel.
+ */
+static void fit_eval(const fit_t* fit, float x, float y, float* sx, float* sy)
+{
+    double t[TERMS_CUBIC];
+    poly_terms(fit, x, y, t);
+    double ax = 0.0, ay = 0.0;
+    for (int k = 0; k < fit->terms; k++) {
+        ax += fit->cx[k] * t[k];
+        ay += fit->cy[k] * t[k];
+    }
+    *sx = (float)ax;
+    *sy = (float)ay;
+}
+
+/**
+ * @brief Fits the step positions of the samples by least squares.
+ *
+ * The normal equations are solved by Gaussian elimination with partial
+ * pivoting, for both axes at once.
+ *
+ * @return @c true on success, @c false if the samples do not determine the
+ *         polynomials, such as dots not moving with the mirrors.
+ */
+static bool fit_solve(fit_t* fit, const sample_t* samples, size_t n)
+{
+    const int k = fit->terms;
+    if (n < (size_t)k) return false;
+
+    // Normal equations, both right-hand sides in the last two columns.
+    double m[TERMS_CUBIC][TERMS_CUBIC + 2] = { { 0.0 } };
+    for (size_t s = 0; s < n; s++) {
+        double t[TERMS_CUBIC];
+        poly_terms(fit, samples[s].px, samples[s].py, t);
+        for (int i = 0; i < k; i++) {
+            for (int j = 0; j < k; j++) m[i][j] += t[i] * t[j];
+            m[i][k] += t[i] * samples[s].sx;
+            m[i][k + 1] += t[i] * samples[s].sy;
+        }
+    }
+
+    // Forward elimination.
+    for (int c = 0; c < k; c++) {
+        int pivot = c;
+        for (int r = c + 1; r < k; r++) {
+            if (fabs(m[r][c]) > fabs(m[pivot][c])) pivot = r;
+        }
+        if (fabs(m[pivot][c]) < 1e-9 * n) return false;
+        if (pivot != c) {
+            for (int j = 0; j < k + 2; j++) {
+                double tmp = m[c][j];
+                m[c][j] = m[pivot][j];
+                m[pivot][j] = tmp;
+            }
+        }
+        for (int r = c + 1; r < k; r++) {
+            double f = m[r][c] / m[c][c];
+            for (int j = c; j < k + 2; j++) m[r][j] -= f * m[c][j];
+        }
+    }
+
+    // Back substitution.
+    for (int i = k - 1; i >= 0; i--) {
+        double ax = m[i][k], ay = m[i][k + 1];
+        for (int j = i + 1; j < k; j++) {
+            ax -= m[i][j] * fit->cx[j];
+            ay -= m[i][j] * fit->cy[j];
+        }
+        fit->cx[i] = ax / m[i][i];
+        fit->cy[i] = ay / m[i][i];
+    }
+    return true;
+}
+
+/**
+ * @brief Computes the root mean square residual of a fit [steps].
+ */
+static float fit_rms(const fit_t* fit, const sample_t* samples, size_t n)
+{
+    double sum = 0.0;
+    for (size_t s = 0; s < n; s++) {
+        float sx, sy;
+        fit_eval(fit, samples[s].px, samples[s].py, &sx, &sy);
+        sum += (sx - samples[s].sx) * (sx - samples[s].sx) + (sy - samples[s].sy) * (sy - samples[s].sy);
+    }
+    return n ? (float)sqrt(sum / n) : 0.0f;
+}
+
+/*******************************************************************************
+ * Motors and camera
+ ******************************************************************************/
+
+/**
+ * @brief Moves both motors to a step position, one axis after the other.
+ *
+ * @param[in,out] x The current X-step position, updated.
+ * @param[in,out] y The current Y-step position, updated.
+ * @param[in] tx The X-step position to reach.
+ * @param[in] ty The Y-step position to reach.
+ */
+static void move_to(int32_t* x, int32_t* y, int32_t tx, int32_t ty)
+{
+    if (tx != *x) move_stepper_steps(&PWM_STEP_X, dir_x_line, PWM_FREQ, tx - *x, NULL);
+    if (ty != *y) move_stepper_steps(&PWM_STEP_Y, dir_y_line, PWM_FREQ, ty - *y, NULL);
+    *x = tx;
+    *y = ty;
+}
+
+/**
+ * @brief Finds the laser dot in the first frame captured once the mirrors settled.
+ *
+ * @param[in,out] sub The subscription to the camera frames.
+ * @param[in] near The expected position of the dot, searched within
+ *            @c CALIB_SWEEP_SEARCH pixels, or @c NULL to search the whole frame.
+ * @param[out] dot The laser dot.
+ * @param[out] width The frame width [px]. Can be @c NULL .
+ * @param[out] height The frame height [px]. Can be @c NULL .
+ * @return @c true if the dot is found, otherwise @c false .
+ */
+static bool capture_dot(frame_sub_t* sub, const laser_dot_t* near, laser_dot_t* dot, int* width, int* height)
+{
+    if (wait_interruptible_ms(CALIB_SWEEP_SETTLE_MS, 1, psig_kill_requested)) return false;
+    uint64_t settled_ns = frame_clock_now();
+    uint64_t deadline_ns = settled_ns + CALIB_SWEEP_FRAME_MS * 1000000ULL;
+
+    // Skip the frames exposed while the mirrors were moving.
+    while (!psig_kill_requested() && frame_clock_now() < deadline_ns) {
+        frame_t* frame = frame_sub_receive(&cam_bus, sub, CALIB_SWEEP_FRAME_MS);
+        if (!frame) continue;
+        if (frame->timestamp_ns < settled_ns) {
+            frame_unref(frame);
+            continue;
+        }
+        bool found = near ? laser_dot_find_roi(frame, (int)near->x - CALIB_SWEEP_SEARCH,
+                                                (int)near->y - CALIB_SWEEP_SEARCH,
+                                                2 * CALIB_SWEEP_SEARCH + 1, 2 * CALIB_SWEEP_SEARCH + 1, dot)
+                          : laser_dot_find(frame, dot);
+        if (width) *width = frame->width;
+        if (height) *height = frame->height;
+        frame_unref(frame);
+        return found;
+    }
+    return false;
+}
+
+/**
+ * @brief Adds the dot found near its expected position to the samples.
+ *
+ * @return @c true if the dot is found, otherwise @c false .
+ */
+static bool add_sample(frame_sub_t* sub, const laser_dot_t* near, int32_t x, int32_t y, sample_t* samples, size_t* n)
+{
+    laser_dot_t dot;
+    if (!capture_dot(sub, near, &dot, NULL, NULL)) {
+        log_write(LOG_DEBUG, "No laser dot at steps (%d, %d)", x, y);
+        return false;
+    }
+    samples[*n] = (sample_t){ dot.x, dot.y, (float)x, (float)y };
+    (*n)++;
+    log_write(LOG_DEBUG, "Laser dot at (%.1f, %.1f) px for steps (%d, %d)", dot.x, dot.y, x, y);
+    return true;
+}
+
+/*******************************************************************************
+ * Calibration sweep
+ ******************************************************************************/
+
+/**
+ * @brief Visits the grid and fits the samples.
+ *
+ * The step positions are relative to the starting position.
+ *
+ * @param[in,out] sub The subscription to the camera frames.
+ * @param[in,out] x The current X-step position.
+ * @param[in,out] y The current Y-step position.
+ * @param[out] fit The fitted model.
+ * @param[out] dot0 The dot at the starting position.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE otherwise.
+ */
+static int sweep(frame_sub_t* sub, int32_t* x, int32_t* y, fit_t* fit, laser_dot_t* dot0)
+{
+    sample_t samples[MAX_POINTS];
+    size_t n = 0;
+
+    // Starting position, which also gives the frame size.
+    int width = 0, height = 0;
+    if (!capture_dot(sub, NULL, dot0, &width, &height)) {
+        log_write(LOG_WARNING, "Laser dot not found at the starting position");
+        return EXIT_FAILURE;
+    }
+    samples[n++] = (sample_t){ dot0->x, dot0->y, 0.0f, 0.0f };
+    fit->half_w = width / 2.0f;
+    fit->half_h = height / 2.0f;
+
+    // Probe each axis near the starting dot, in the other direction if the dot leaves the frame.
+    const int32_t probes[2][2] = { { CALIB_SWEEP_PROBE_STEPS, 0 }, { 0, CALIB_SWEEP_PROBE_STEPS } };
+    for (int p = 0; p < 2; p++) {
+        move_to(x, y, probes[p][0], probes[p][1]);
+        if (!add_sample(sub, dot0, *x, *y, samples, &n)) {
+            move_to(x, y, -probes[p][0], -probes[p][1]);
+            if (!add_sample(sub, dot0, *x, *y, samples, &n)) {
+                log_write(LOG_WARNING, "Laser dot lost while probing the %c-axis", p == 0 ? 'X' : 'Y');
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // Visit the grid in a serpentine order, aiming with the affine model of the dots so far.
+    fit_t affine = *fit;
+    affine.terms = TERMS_AFFINE;
+    const float gx = (width - 2.0f * CALIB_SWEEP_MARGIN) / (CALIB_SWEEP_COLS - 1);
+    const float gy = (height - 2.0f * CALIB_SWEEP_MARGIN) / (CALIB_SWEEP_ROWS - 1);
+    for (int j = 0; j < CALIB_SWEEP_ROWS && !psig_kill_requested(); j++) {
+        for (int c = 0; c < CALIB_SWEEP_COLS && !psig_kill_requested(); c++) {
+            int i = (j % 2 == 0) ? c : CALIB_SWEEP_COLS - 1 - c;
+            if (!fit_solve(&affine, samples, n)) {
+                log_write(LOG_WARNING, "Laser dot does not follow the mirrors");
+                return EXIT_FAILURE;
+            }
+            laser_dot_t aim = { CALIB_SWEEP_MARGIN + i * gx, CALIB_SWEEP_MARGIN + j * gy, 0 };
+            float sx, sy;
+            fit_eval(&affine, aim.x, aim.y, &sx, &sy);
+            if (fabsf(sx) > CALIB_SWEEP_MAX_STEPS || fabsf(sy) > CALIB_SWEEP_MAX_STEPS) {
+                log_write(LOG_WARNING, "Skipping calibration point (%d, %d), out of reach", i, j);
+                continue;
+            }
+            move_to(x, y, (int32_t)lroundf(sx), (int32_t)lroundf(sy));
+            add_sample(sub, &aim, *x, *y, samples, &n);
+        }
+    }
+    if (psig_kill_requested()) return EXIT_FAILURE;
+
+    // Model of the dots, cubic when the grid is well covered.
+    if (n < CALIB_SWEEP_MIN_POINTS) {
+        log_write(LOG_WARNING, "Only %zu laser dots found, %d needed", n, CALIB_SWEEP_MIN_POINTS);
+        return EXIT_FAILURE;
+    }
+    fit->terms = n >= 2 * TERMS_CUBIC ? TERMS_CUBIC : TERMS_QUADRATIC;
+    if (!fit_solve(fit, samples, n)) {
+        log_write(LOG_WARNING, "Could not fit the calibration model");
+        return EXIT_FAILURE;
+    }
+    float rms = fit_rms(fit, samples, n);
+    log_write(LOG_INFO, "Fitted %zu laser dots, residual %.2f steps", n, rms);
+    if (rms > CALIB_SWEEP_MAX_RMS) {
+        log_write(LOG_WARNING, "Calibration residual above %.2f steps, rejected", CALIB_SWEEP_MAX_RMS);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int calib_sweep_run(const char* path)
+{
+    // The mirrors belong to the motor tasks once calibrated.
+    if (read_abs_pos(NULL, NULL, NULL)) {
+        log_write(LOG_WARNING, "Motors already calibrated, no calibration sweep");
+        return EXIT_FAILURE;
+    }
+
+    frame_sub_t* sub = frame_bus_subscribe(&cam_bus, "calibration", FRAME_BUS_LATEST, 0);
+    if (!sub) {
+        log_write(LOG_ERROR, "Could not subscribe to the camera bus");
+        return EXIT_FAILURE;
+    }
+
+    log_write(LOG_INFO, "Start calibration sweep");
+    uint64_t start_ns = frame_clock_now();
+    int32_t x = 0, y = 0;
+    fit_t fit = { 0 };
+    laser_dot_t dot0;
+    int exit_code = sweep(sub, &x, &y, &fit, &dot0);
+
+    // Back to the starting position, for the reference or a manual calibration.
+    move_to(&x, &y, 0, 0);
+    laser_dot_t dot;
+    if (exit_code == EXIT_SUCCESS && !capture_dot(sub, &dot0, &dot, NULL, NULL)) {
+        log_write(LOG_WARNING, "Laser dot lost back at the starting position");
+        exit_code = EXIT_FAILURE;
+    }
+    frame_bus_unsubscribe(&cam_bus, sub);
+    if (exit_code != EXIT_SUCCESS) {
+        log_write(LOG_WARNING, "Calibration sweep failed");
+        return EXIT_FAILURE;
+    }
+    if (fabsf(dot.x - dot0.x) > 2 * STEP_SIZE || fabsf(dot.y - dot0.y) > 2 * STEP_SIZE) {
+        log_write(LOG_WARNING, "Laser dot moved by (%.1f, %.1f) px during the sweep, steps were missed",
+                  dot.x - dot0.x, dot.y - dot0.y);
+    }
+
+    // Sample the model into the lookup table.
+    int cols = (int)(2.0f * fit.half_w) / CALIB_SWEEP_CELL + 1;
+    int rows = (int)(2.0f * fit.half_h) / CALIB_SWEEP_CELL + 1;
+    float* sx = malloc(sizeof(float) * (size_t)cols * rows);
+    float* sy = malloc(sizeof(float) * (size_t)cols * rows);
+    if (sx && sy) {
+        for (int j = 0; j < rows; j++) {
+            for (int i = 0; i < cols; i++) {
+                size_t k = (size_t)j * cols + i;
+                fit_eval(&fit, (float)(i * CALIB_SWEEP_CELL), (float)(j * CALIB_SWEEP_CELL), &sx[k], &sy[k]);
+            }
+        }
+        exit_code = calib_set_grid(cols, rows, CALIB_SWEEP_CELL, sx, sy);
+    } else {
+        exit_code = EXIT_FAILURE;
+    }
+    free(sx);
+    free(sy);
+    if (exit_code != EXIT_SUCCESS) return EXIT_FAILURE;
+    if (path) calib_save(path);
+
+    // The dot at the starting position is the calibration reference.
+    write_abs_pos((d_px_t)lroundf(dot.x), (d_px_t)lroundf(dot.y));
+    log_write(LOG_INFO, "Calibration sweep done in %.1f s",
+              (double)(frame_clock_now() - start_ns) / 1e9);
+    return EXIT_SUCCESS;
+}
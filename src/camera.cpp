@@ -27,9 +27,34 @@
 
 #include "camera.h"
 
+#include <cstring>
 
-// Buffer initialization. This buffer holds a single frame.
-cv::Mat cam_buffer_0(FRAME_HEIGHT, FRAME_WIDTH, CV_8UC3);
+// Capture sequence number.
+static uint64_t frame_counter = 0;
+
+/**
+ * @brief Gets the capture time of the frame just read.
+ *
+ * The V4L2 driver stamps its buffers with @c CLOCK_MONOTONIC when the frame
+ * starts arriving, before the dequeue and decoding latency. Without a valid
+ * stamp, the frame is assumed one period older than the start of the read,
+ * the driver queue holding a single buffer.
+ *
+ * @param[in] cap The camera.
+ * @param[in] read_ns Time the read started (@c CLOCK_MONOTONIC ) [ns].
+ * @param[in] period_ns Frame period [ns].
+ * @return The capture time (@c CLOCK_MONOTONIC ) [ns].
+ */
+static uint64_t capture_time_ns(cv::VideoCapture& cap, uint64_t read_ns, uint64_t period_ns)
+{
+    double ms = cap.get(cv::CAP_PROP_POS_MSEC);
+    if (ms > 0.0) {
+        // A stamp from another clock is in the future, or far in the past.
+        uint64_t stamp_ns = static_cast<uint64_t>(ms * 1e6);
+        if (stamp_ns <= frame_clock_now() && stamp_ns + 1000000000ULL >= read_ns) return stamp_ns;
+    }
+    return read_ns > period_ns ? read_ns - period_ns : 0;
+}
 
 
 void* camera_task(void* arg)
@@ -55,6 +80,8 @@ void* camera_task(void* arg)
     cap.set(cv::CAP_PROP_FRAME_WIDTH, FRAME_WIDTH);
     cap.set(cv::CAP_PROP_FRAME_HEIGHT, FRAME_HEIGHT);
     cap.set(cv::CAP_PROP_FPS, FRAME_FPS);
+    // A single driver buffer, so that a frame read is never several frames old.
+    cap.set(cv::CAP_PROP_BUFFERSIZE, 1);
 
     // Retrieve and log the actual camera parameters for verification.
     int set_h = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_WIDTH));
@@ -77,30 +104,90 @@ void* camera_task(void* arg)
     printf("[Info] Camera capture Height: %d\n", set_w);
     printf("[Info] Camera capture FPS: %.2f\n", set_fps);
 
-    cv::Mat frame;
+    // Keep the MJPEG data of the camera, and decode it ourselves,
+    // so that the compressed frames are available to the consumers.
+    bool keep_jpeg = strcmp(set_fourcc, "MJPG") == 0 && cap.set(cv::CAP_PROP_CONVERT_RGB, 0);
+    printf("[Info] Camera compressed frames: %s\n", keep_jpeg ? "kept" : "not available");
+    cv::Mat jpeg;
+    uint64_t period_ns = static_cast<uint64_t>(1e9 / (set_fps > 0.0 ? set_fps : FRAME_FPS));
 
     // Capture loop that continues until a termination signal is received.
     while (!psig_kill_requested()) {
 
-        // Capture a frame from the camera.
-        cap >> frame;
+        // In idle, the governor drops most frames before they are decoded.
+        if (!governor_camera_admit()) {
+            cap.grab();
+            continue;
+        }
+
+        // Get a buffer from the pool, or drop the frame if there is none left.
+        frame_t* slot = frame_pool_acquire();
+        if (!slot) {
+            cap.grab();
+            continue;
+        }
+
+        // Capture a frame from the camera directly into the pool buffer,
+        // keeping a copy of its compressed data if any.
+        cv::Mat frame(FRAME_HEIGHT, FRAME_WIDTH, CV_8UC3, slot->data);
+        perf_stage_begin(PERF_STAGE_CAPTURE);
+        uint64_t read_ns = frame_clock_now();
+        if (keep_jpeg) {
+            cap >> jpeg;
+            size_t jpeg_size = jpeg.total() * jpeg.elemSize();
+            if (!jpeg.empty() && jpeg_size <= slot->jpeg_capacity) {
+                memcpy(slot->jpeg, jpeg.data, jpeg_size);
+                slot->jpeg_size = jpeg_size;
+                cv::imdecode(jpeg, cv::IMREAD_COLOR, &frame);
+            } else {
+                frame = cv::Mat();
+            }
+        } else {
+            cap >> frame;
+        }
+        uint64_t capture_ns = capture_time_ns(cap, read_ns, period_ns);
+        perf_stage_end(PERF_STAGE_CAPTURE);
 
         // Check if the frame is empty and continue if so.
         if (frame.empty()) {
-            printf("[Warning] Empty image captured\n");
+            log_write(LOG_WARNING, "Empty image captured");
+            frame_unref(slot);
             continue;
         }
 
-        // Try to lock the mutex before writing to the shared camera buffer.
-        if (pthread_mutex_trylock(&cam_buffer_mutex) == 0) {
-            cam_buffer_0 = frame.clone();
-            pthread_mutex_unlock(&cam_buffer_mutex);
+        // OpenCV reallocates the frame if the camera does not deliver the expected format.
+        if (frame.data != slot->data) {
+            log_write(LOG_WARNING, "Unexpected frame format %dx%d", frame.cols, frame.rows);
+            frame_unref(slot);
+            continue;
         }
 
-        // If lock failed, just continue to capture.
-
+        slot->width = frame.cols;
+        slot->height = frame.rows;
+        slot->size = frame.total() * frame.elemSize();
+        slot->frame_id = ++frame_counter;
+        slot->timestamp_ns = capture_ns;
+        frame_clock_record(slot->frame_id, slot->timestamp_ns);
+
+        // Detect the changes of the scene before the inference gets the frame.
+        motion_gate_update(slot);
+
+        // Hand the frame to all the subscribers, then release the capture reference.
+        perf_stage_begin(PERF_STAGE_PUBLISH);
+        frame_bus_publish(&cam_bus, slot);
+        perf_stage_end(PERF_STAGE_PUBLISH);
+        frame_unref(slot);
     }
 
+    // Wake up the subscribers still waiting for a frame.
+    frame_bus_close(&cam_bus);
+
+    frame_pool_stats_t stats;
+    frame_pool_get_stats(&stats);
+    log_write(LOG_INFO, "Frame pool: %u/%u buffers at peak, %llu acquired, %llu exhausted",
+              stats.peak_in_use, stats.size,
+              (unsigned long long)stats.acquired, (unsigned long long)stats.exhausted);
+
     // Indicate the camera task is complete and release resources.
     thread_ready_num++;
     printf("[Info] Stopping camera task\n");
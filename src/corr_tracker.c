@@ -0,0 +1,504 @@
+/**
+ * @file corr_tracker.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c corr_tracker.h .
+ *
+ * @see corr_tracker.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "corr_tracker.h"
+
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "psig_utils.h"
+#include "log_utils.h"
+#include "ipc_elements.h"
+#include "perf_counters.h"
+#include "targeting.h"
+#include "gray_downscale.h"
+
+// Number of pixels of a patch.
+#define PATCH_PIXELS (CORR_PATCH * CORR_PATCH)
+
+// Longest prediction of a track from its state [s].
+#define MAX_PREDICTION_S 0.5f
+
+/**
+ * @brief Downscaled grayscale frame.
+ */
+typedef struct {
+    uint64_t frame_id;
+    uint64_t timestamp_ns;
+    int width;
+    int height;
+    uint8_t px[(FRAME_WIDTH / CORR_SCALE) * (FRAME_HEIGHT / CORR_SCALE)];
+} small_frame_t;
+
+/**
+ * @brief Target followed by correlation.
+ */
+typedef struct {
+    corr_pos_t pos;                 ///< Latest position.
+    float vx;                       ///< X-velocity of the track [px/s].
+    float vy;                       ///< Y-velocity of the track [px/s].
+    uint8_t patch[PATCH_PIXELS];    ///< Patch seeded on the detection.
+    uint32_t patch_sum;             ///< Sum of the patch pixels.
+    uint64_t patch_sq;              ///< Sum of the squared patch pixels.
+} target_t;
+
+// History of the downscaled frames, only used by the tracker thread.
+static small_frame_t history[CORR_HISTORY];
+static uint64_t history_count = 0;
+
+// Followed targets, only used by the tracker thread.
+static target_t targets[TRACKER_MAX_TRACKS];
+static size_t target_count = 0;
+
+// Mailbox: latest tracks to seed.
+static pthread_mutex_t seed_mutex;
+static track_t seed_tracks[TRACKER_MAX_TRACKS];
+static size_t seed_count = 0;
+static uint64_t seed_frame_id = 0;
+static uint64_t seed_ns = 0;
+static bool seed_pending = false;
+
+// Positions published to the targeting thread.
+static pthread_mutex_t pos_mutex;
+static corr_pos_t published[TRACKER_MAX_TRACKS];
+static size_t published_count = 0;
+
+// Statistics, updated with atomic built-ins.
+static uint64_t frames = 0;
+static uint64_t seeds = 0;
+static uint64_t late_seeds = 0;
+static uint64_t lost = 0;
+
+/*******************************************************************************
+ * Image processing
+ ******************************************************************************/
+
+#if defined(__ARM_NEON)
+/**
+ * @brief Adds the lanes of a vector.
+ */
+static inline uint32_t hsum_u32(uint32x4_t v)
+{
+    uint32x2_t s = vadd_u32(vget_low_u32(v), vget_high_u32(v));
+    return vget_lane_u32(vpadd_u32(s, s), 0);
+}
+#endif
+
+/**
+ * @brief Computes the sums of a window of the frame and of its product with a patch.
+ *
+ * @param[in] img Top-left pixel of the window.
+ * @param[in] stride Width of the frame [px].
+ * @param[in] patch The patch.
+ * @param[out] si Sum of the window pixels.
+ * @param[out] sii Sum of the squared window pixels.
+ * @param[out] sit Sum of the products of the window and patch pixels.
+ */
+static void window_sums(const uint8_t* img, int stride, const uint8_t* patch,
+                        uint32_t* si, uint32_t* sii, uint32_t* sit)
+{
+#if defined(__ARM_NEON) && CORR_PATCH == 16
+    uint16x8_t acc_i = vdupq_n_u16(0);
+    uint32x4_t acc_ii = vdupq_n_u32(0);
+    uint32x4_t acc_it = vdupq_n_u32(0);
+    for (int r = 0; r < CORR_PATCH; r++) {
+        uint8x16_t i = vld1q_u8(img + (size_t)r * stride);
+        uint8x16_t t = vld1q_u8(patch + r * CORR_PATCH);
+        acc_i = vpadalq_u8(acc_i, i);
+        acc_ii = vpadalq_u16(acc_ii, vmull_u8(vget_low_u8(i), vget_low_u8(i)));
+        acc_ii = vpadalq_u16(acc_ii, vmull_u8(vget_high_u8(i), vget_high_u8(i)));
+        acc_it = vpadalq_u16(acc_it, vmull_u8(vget_low_u8(i), vget_low_u8(t)));
+        acc_it = vpadalq_u16(acc_it, vmull_u8(vget_high_u8(i), vget_high_u8(t)));
+    }
+    *si = hsum_u32(vpaddlq_u16(acc_i));
+    *sii = hsum_u32(acc_ii);
+    *sit = hsum_u32(acc_it);
+#else
+    uint32_t s = 0, ss = 0, st = 0;
+    for (int r = 0; r < CORR_PATCH; r++) {
+        const uint8_t* row = img + (size_t)r * stride;
+        const uint8_t* prow = patch + r * CORR_PATCH;
+        for (int c = 0; c < CORR_PATCH; c++) {
+            s += row[c];
+            ss += (uint32_t)row[c] * row[c];
+            st += (uint32_t)row[c] * prow[c];
+        }
+    }
+    *si = s;
+    *sii = ss;
+    *sit = st;
+#endif
+}
+
+/**
+ * @brief Computes the normalized cross-correlation of a patch at a window of the frame.
+ *
+ * @return The correlation, between -1 and 1, 0 if the window or the patch is uniform.
+ */
+static float ncc(const small_frame_t* f, int wx, int wy, const target_t* t)
+{
+    uint32_t si, sii, sit;
+    window_sums(f->px + (size_t)wy * f->width + wx, f->width, t->patch, &si, &sii, &sit);
+
+    const double n = PATCH_PIXELS;
+    double num = n * sit - (double)si * t->patch_sum;
+    double var_i = n * sii - (double)si * si;
+    double var_t = n * (double)t->patch_sq - (double)t->patch_sum * t->patch_sum;
+    if (var_i <= 0.0 || var_t <= 0.0) return 0.0f;
+    return (float)(num / sqrt(var_i * var_t));
+}
+
+/**
+ * @brief Converts a center to the top-left corner of its patch, within the frame.
+ */
+static void patch_corner(const small_frame_t* f, float x, float y, int* wx, int* wy)
+{
+    int cx = (int)lroundf(x / CORR_SCALE) - CORR_PATCH / 2;
+    int cy = (int)lroundf(y / CORR_SCALE) - CORR_PATCH / 2;
+    *wx = cx < 0 ? 0 : (cx > f->width - CORR_PATCH ? f->width - CORR_PATCH : cx);
+    *wy = cy < 0 ? 0 : (cy > f->height - CORR_PATCH ? f->height - CORR_PATCH : cy);
+}
+
+/*******************************************************************************
+ * Tracking
+ ******************************************************************************/
+
+/**
+ * @brief Seeds the patch of a target on a frame.
+ *
+ * @return @c true if the patch has texture to correlate, otherwise @c false.
+ */
+static bool seed_patch(target_t* t, const small_frame_t* f, float x, float y)
+{
+    int wx, wy;
+    patch_corner(f, x, y, &wx, &wy);
+
+    t->patch_sum = 0;
+    t->patch_sq = 0;
+    for (int r = 0; r < CORR_PATCH; r++) {
+        const uint8_t* row = f->px + (size_t)(wy + r) * f->width + wx;
+        memcpy(t->patch + r * CORR_PATCH, row, CORR_PATCH);
+        for (int c = 0; c < CORR_PATCH; c++) {
+            t->patch_sum += row[c];
+            t->patch_sq += (uint32_t)row[c] * row[c];
+        }
+    }
+
+    t->pos.x = (float)(CORR_SCALE * (wx + CORR_PATCH / 2));
+    t->pos.y = (float)(CORR_SCALE * (wy + CORR_PATCH / 2));
+    t->pos.timestamp_ns = f->timestamp_ns;
+    t->pos.score = 1.0f;
+    return (uint64_t)PATCH_PIXELS * t->patch_sq > (uint64_t)t->patch_sum * t->patch_sum;
+}
+
+/**
+ * @brief Refines a peak of correlation to a fraction of pixel, with a parabola.
+ */
+static float subpixel(float before, float peak, float after)
+{
+    float curvature = before - 2.0f * peak + after;
+    if (curvature >= 0.0f) return 0.0f;
+    float offset = 0.5f * (before - after) / curvature;
+    return offset < -0.5f ? -0.5f : (offset > 0.5f ? 0.5f : offset);
+}
+
+/**
+ * @brief Matches the patch of a target around its predicted position on a frame.
+ *
+ * @return @c true if the target is found, @c false if the correlation is too low.
+ */
+static bool match(target_t* t, const small_frame_t* f)
+{
+    // Search around the position predicted with the velocity of the track.
+    float dt = f->timestamp_ns > t->pos.timestamp_ns ? (float)((f->timestamp_ns - t->pos.timestamp_ns) / 1e9) : 0.0f;
+    if (dt > MAX_PREDICTION_S) dt = MAX_PREDICTION_S;
+    int wx, wy;
+    patch_corner(f, t->pos.x + t->vx * dt, t->pos.y + t->vy * dt, &wx, &wy);
+
+    enum { SIDE = 2 * CORR_RADIUS + 1 };
+    float score[SIDE][SIDE];
+    int best_dx = 0, best_dy = 0;
+    float best = -2.0f;
+    for (int dy = -CORR_RADIUS; dy <= CORR_RADIUS; dy++) {
+        for (int dx = -CORR_RADIUS; dx <= CORR_RADIUS; dx++) {
+            int x = wx + dx;
+            int y = wy + dy;
+            float s = -2.0f;
+            if (x >= 0 && y >= 0 && x <= f->width - CORR_PATCH && y <= f->height - CORR_PATCH) {
+                s = ncc(f, x, y, t);
+            }
+            score[dy + CORR_RADIUS][dx + CORR_RADIUS] = s;
+            if (s > best) {
+                best = s;
+                best_dx = dx;
+                best_dy = dy;
+            }
+        }
+    }
+
+    t->pos.score = best;
+    if (best < CORR_MIN_SCORE) return false;
+
+    // Refine the peak on each axis when both neighbors were searched.
+    int i = best_dy + CORR_RADIUS;
+    int j = best_dx + CORR_RADIUS;
+    float ox = 0.0f, oy = 0.0f;
+    if (j > 0 && j < SIDE - 1 && score[i][j - 1] > -2.0f && score[i][j + 1] > -2.0f) {
+        ox = subpixel(score[i][j - 1], best, score[i][j + 1]);
+    }
+    if (i > 0 && i < SIDE - 1 && score[i - 1][j] > -2.0f && score[i + 1][j] > -2.0f) {
+        oy = subpixel(score[i - 1][j], best, score[i + 1][j]);
+    }
+
+    t->pos.x = CORR_SCALE * (wx + best_dx + ox + CORR_PATCH / 2);
+    t->pos.y = CORR_SCALE * (wy + best_dy + oy + CORR_PATCH / 2);
+    t->pos.timestamp_ns = f->timestamp_ns;
+    return true;
+}
+
+/**
+ * @brief Gets a frame of the history from its sequence number.
+ */
+static small_frame_t* history_at(uint64_t seq)
+{
+    return &history[seq % CORR_HISTORY];
+}
+
+/**
+ * @brief Seeds the patches of the tracks of the mailbox, if any.
+ *
+ * @param[in] cur The current frame, last of the history.
+ * @return @c true if the targets were seeded, @c false if no tracks were pending.
+ */
+static bool seed_targets(const small_frame_t* cur)
+{
+    track_t tracks[TRACKER_MAX_TRACKS];
+    size_t n;
+    uint64_t frame_id, state_ns;
+
+    pthread_mutex_lock(&seed_mutex);
+    bool taken = seed_pending;
+    n = seed_count;
+    frame_id = seed_frame_id;
+    state_ns = seed_ns;
+    if (taken) memcpy(tracks, seed_tracks, n * sizeof(track_t));
+    seed_pending = false;
+    pthread_mutex_unlock(&seed_mutex);
+    if (!taken) return false;
+
+    // Look for the frame of the detections in the history.
+    uint64_t oldest = history_count > CORR_HISTORY ? history_count - CORR_HISTORY : 0;
+    uint64_t seq = history_count;
+    for (uint64_t s = history_count; frame_id != 0 && s-- > oldest;) {
+        if (history_at(s)->frame_id == frame_id) {
+            seq = s;
+            break;
+        }
+    }
+
+    target_count = 0;
+    for (size_t i = 0; i < n; i++) {
+        target_t* t = &targets[target_count];
+        const track_t* track = &tracks[i];
+        t->pos.id = track->id;
+        t->vx = track->x.vel;
+        t->vy = track->y.vel;
+
+        if (seq < history_count) {
+            // Seed on the frame of the detections, then follow the frames captured since.
+            if (!seed_patch(t, history_at(seq), track->x.pos, track->y.pos)) continue;
+            bool found = true;
+            for (uint64_t s = seq + 1; s < history_count && found; s++) found = match(t, history_at(s));
+            __atomic_add_fetch(&seeds, 1, __ATOMIC_RELAXED);
+            if (!found) {
+                __atomic_add_fetch(&lost, 1, __ATOMIC_RELAXED);
+                continue;
+            }
+        } else {
+            // The frame is gone: seed on the current frame, at the predicted position.
+            float dt = cur->timestamp_ns > state_ns ? (float)((cur->timestamp_ns - state_ns) / 1e9) : 0.0f;
+            if (dt > MAX_PREDICTION_S) dt = MAX_PREDICTION_S;
+            if (!seed_patch(t, cur, track->x.pos + t->vx * dt, track->y.pos + t->vy * dt)) continue;
+            __atomic_add_fetch(&late_seeds, 1, __ATOMIC_RELAXED);
+        }
+        target_count++;
+    }
+    return true;
+}
+
+/**
+ * @brief Matches the followed targets on the current frame, and drops the lost ones.
+ */
+static void match_targets(const small_frame_t* cur)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < target_count; i++) {
+        if (match(&targets[i], cur)) {
+            if (kept != i) targets[kept] = targets[i];
+            kept++;
+        } else {
+            __atomic_add_fetch(&lost, 1, __ATOMIC_RELAXED);
+        }
+    }
+    target_count = kept;
+}
+
+/**
+ * @brief Publishes the positions of the followed targets.
+ */
+static void publish_positions(void)
+{
+    pthread_mutex_lock(&pos_mutex);
+    for (size_t i = 0; i < target_count; i++) published[i] = targets[i].pos;
+    published_count = target_count;
+    pthread_mutex_unlock(&pos_mutex);
+}
+
+/**
+ * @brief Follows the targets on a camera frame.
+ */
+static void process_frame(const frame_t* frame)
+{
+    static bool warned = false;
+    if (frame->width > FRAME_WIDTH || frame->height > FRAME_HEIGHT) {
+        if (!warned) log_write(LOG_WARNING, "Frames of %dx%d px too large to track", frame->width, frame->height);
+        warned = true;
+        return;
+    }
+
+    small_frame_t* cur = history_at(history_count);
+    cur->frame_id = frame->frame_id;
+    cur->timestamp_ns = frame->timestamp_ns;
+    cur->width = frame->width / CORR_SCALE;
+    cur->height = frame->height / CORR_SCALE;
+    gray_downscale(frame->data, frame->width, frame->height, CORR_SCALE, cur->px);
+    history_count++;
+
+    // Seeded targets already followed the frames up to the current one.
+    if (!seed_targets(cur)) match_targets(cur);
+
+    publish_positions();
+    if (target_count > 0) targeting_refresh();
+    __atomic_add_fetch(&frames, 1, __ATOMIC_RELAXED);
+}
+
+/*******************************************************************************
+ * Interface
+ ******************************************************************************/
+
+void corr_tracker_init(void)
+{
+    pthread_mutex_init(&seed_mutex, NULL);
+    pthread_mutex_init(&pos_mutex, NULL);
+}
+
+void corr_tracker_close(void)
+{
+    pthread_mutex_destroy(&seed_mutex);
+    pthread_mutex_destroy(&pos_mutex);
+}
+
+void corr_tracker_seed(const track_t* tracks, size_t n, uint64_t frame_id, uint64_t timestamp_ns)
+{
+    if (n > TRACKER_MAX_TRACKS) n = TRACKER_MAX_TRACKS;
+
+    pthread_mutex_lock(&seed_mutex);
+    memcpy(seed_tracks, tracks, n * sizeof(track_t));
+    seed_count = n;
+    seed_frame_id = frame_id;
+    seed_ns = timestamp_ns;
+    seed_pending = true;
+    pthread_mutex_unlock(&seed_mutex);
+}
+
+bool corr_tracker_lookup(uint32_t id, corr_pos_t* pos)
+{
+    bool found = false;
+    pthread_mutex_lock(&pos_mutex);
+    for (size_t i = 0; i < published_count; i++) {
+        if (published[i].id == id) {
+            *pos = published[i];
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pos_mutex);
+    return found;
+}
+
+void corr_tracker_get_stats(corr_stats_t* stats)
+{
+    stats->frames = __atomic_load_n(&frames, __ATOMIC_RELAXED);
+    stats->seeds = __atomic_load_n(&seeds, __ATOMIC_RELAXED);
+    stats->late_seeds = __atomic_load_n(&late_seeds, __ATOMIC_RELAXED);
+    stats->lost = __atomic_load_n(&lost, __ATOMIC_RELAXED);
+}
+
+void* corr_tracker_task(void* arg)
+{
+    log_write(LOG_INFO, "Start correlation tracker task");
+
+    // Install signal handler for system signals.
+    psig_install_handler();
+
+    // Every frame is needed, but a late frame is useless: keep the latest one.
+    frame_sub_t* sub = frame_bus_subscribe(&cam_bus, "correlation", FRAME_BUS_LATEST, 0);
+    if (!sub) {
+        log_write(LOG_ERROR, "Could not subscribe to the camera bus");
+        thread_ready_num++;
+        pthread_exit(NULL);
+    }
+
+    // Tracking loop that continues until a termination signal is received.
+    while (!psig_kill_requested()) {
+        frame_t* frame = frame_sub_receive(&cam_bus, sub, CORR_WAIT_MS);
+        if (!frame) continue;
+
+        perf_stage_begin(PERF_STAGE_CORRELATION);
+        process_frame(frame);
+        perf_stage_end(PERF_STAGE_CORRELATION);
+        frame_unref(frame);
+    }
+
+    frame_bus_unsubscribe(&cam_bus, sub);
+
+    corr_stats_t stats;
+    corr_tracker_get_stats(&stats);
+    log_write(LOG_INFO, "Correlation: %llu frames, %llu seeds, %llu late seeds, %llu lost",
+              (unsigned long long)stats.frames, (unsigned long long)stats.seeds,
+              (unsigned long long)stats.late_seeds, (unsigned long long)stats.lost);
+
+    // Indicate the task is complete.
+    thread_ready_num++;
+    log_write(LOG_INFO, "Stopping correlation tracker task");
+    pthread_exit(EXIT_SUCCESS);
+}
@@ -27,6 +27,13 @@
 
 #include "ctrl_motors.h"
 
+#include <math.h>
+#include <pthread.h>
+
+#include "frame_clock.h"
+#include "calib.h"
+#include "flight_recorder.h"
+
 // Coordinates buffers to read.
 d_px_t x_px_buff;
 d_px_t y_px_buff;
@@ -35,12 +42,32 @@ d_px_t y_px_buff;
 static d_px_t x0_px = 0;
 static d_px_t y0_px = 0;
 
-int move_stepper_raw(const syspwm_t* pwm, gpiod_line *gpio_line, frequency_hz_t freq, step_t steps, step_dir_t dir)
+// Absolute step positions, in the calibration model, written by the motor
+// tasks and read with atomic built-ins.
+static int32_t x_steps = 0;
+static int32_t y_steps = 0;
+
+// Missed steps measured since the last move, updated with atomic built-ins.
+static int32_t x_slip = 0;
+static int32_t y_slip = 0;
+
+// Motion mode, set before the motor tasks start.
+static motor_mode_t motor_mode = MOTOR_MODE_POINT;
+
+// Targets followed in velocity mode, and step positions estimated from the step rates.
+static pthread_mutex_t follow_mutex = PTHREAD_MUTEX_INITIALIZER;
+static axis_target_t x_target;
+static axis_target_t y_target;
+static float x_est_steps = 0.0f;
+static float y_est_steps = 0.0f;
+
+int move_stepper_raw(const syspwm_t* pwm, gpiod_line *gpio_line, frequency_hz_t freq, step_t steps, step_dir_t dir, step_t* emitted)
 {
     // Write on GPIO for direction.
     int exit_code = gpio_write(gpio_line, dir);
     // Generate PWM signal for steps.
-    syspwm_stepper_sig(pwm, freq, steps);
+    step_t count = syspwm_stepper_sig(pwm, freq, steps);
+    if (emitted) *emitted = count;
     return exit_code;
 }
 
@@ -58,34 +85,208 @@ int move_stepper(const syspwm_t* pwm, gpiod_line *gpio_line, frequency_hz_t freq
 
     // Convert pixel displacement to a number of steps.
     step_t steps = (step_t) (d / STEP_SIZE);
-    return move_stepper_raw(pwm, gpio_line, freq, steps, dir);
+    return move_stepper_raw(pwm, gpio_line, freq, steps, dir, NULL);
+}
+
+int move_stepper_steps(const syspwm_t* pwm, gpiod_line *gpio_line, frequency_hz_t freq, int32_t steps, int32_t* emitted)
+{
+    step_dir_t dir = steps < 0 ? STEP_M : STEP_P;
+    step_t count = 0;
+    int exit_code = move_stepper_raw(pwm, gpio_line, freq, (step_t)abs(steps), dir, &count);
+    if (emitted) *emitted = steps < 0 ? -(int32_t)count : (int32_t)count;
+    return exit_code;
+}
+
+time_us_t move_time_us(frequency_hz_t freq, d_px_t x0, d_px_t y0, d_px_t x1, d_px_t y1)
+{
+    // Avoid division by zero.
+    if (freq == 0) return 0;
+
+    // Same rounding of the step positions as the motor tasks.
+    float sx0, sy0, sx1, sy1;
+    calib_px_to_steps(x0, y0, &sx0, &sy0);
+    calib_px_to_steps(x1, y1, &sx1, &sy1);
+    long dx = labs(lroundf(sx1) - lroundf(sx0));
+    long dy = labs(lroundf(sy1) - lroundf(sy0));
+    return (time_us_t) ((uint64_t)(dx > dy ? dx : dy) * 1000000UL / freq);
+}
+
+void motor_set_mode(motor_mode_t mode)
+{
+    motor_mode = mode;
+}
+
+motor_mode_t motor_get_mode(void)
+{
+    return motor_mode;
+}
+
+void motor_get_steps(int32_t* x, int32_t* y)
+{
+    *x = __atomic_load_n(&x_steps, __ATOMIC_RELAXED);
+    *y = __atomic_load_n(&y_steps, __ATOMIC_RELAXED);
+}
+
+void motor_resync(int32_t dx, int32_t dy)
+{
+    __atomic_add_fetch(&x_slip, dx, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&y_slip, dy, __ATOMIC_RELAXED);
+}
+
+void motor_follow(const axis_target_t* x, const axis_target_t* y)
+{
+    pthread_mutex_lock(&follow_mutex);
+    x_target = *x;
+    y_target = *y;
+    pthread_mutex_unlock(&follow_mutex);
+    flight_record_command(x->pos, y->pos, x->vel, y->vel, true);
+}
+
+void motor_estimate(float* x, float* y)
+{
+    // The targets are close to the motors, and start the inverse model.
+    pthread_mutex_lock(&follow_mutex);
+    float sx = x_est_steps;
+    float sy = y_est_steps;
+    *x = x_target.pos;
+    *y = y_target.pos;
+    pthread_mutex_unlock(&follow_mutex);
+    calib_steps_to_px(sx, sy, x, y);
+}
+
+/**
+ * @brief Computes the step positions aiming at the targets extrapolated to a time.
+ *
+ * @param[in] x The target of the X-axis.
+ * @param[in] y The target of the Y-axis.
+ * @param[in] at_ns The time of the extrapolation (@c CLOCK_MONOTONIC ) [ns].
+ * @param[out] s The X- and Y-step positions [steps].
+ */
+static void target_steps(const axis_target_t* x, const axis_target_t* y, uint64_t at_ns, float s[2])
+{
+    const axis_target_t* t[2] = { x, y };
+    float pos[2];
+    for (int i = 0; i < 2; i++) {
+        float lead_s = at_ns > t[i]->timestamp_ns ? (float)((at_ns - t[i]->timestamp_ns) / 1e9) : 0.0f;
+        if (lead_s > VELOCITY_MAX_PREDICTION_MS / 1000.0f) lead_s = VELOCITY_MAX_PREDICTION_MS / 1000.0f;
+        pos[i] = t[i]->pos + t[i]->vel * lead_s;
+    }
+    calib_px_to_steps(pos[0], pos[1], &s[0], &s[1]);
+}
+
+/**
+ * @brief Follows the target of an axis until a termination signal is received.
+ *
+ * Every @c VELOCITY_PERIOD_US , the steps generated since the previous period
+ * are integrated into the estimated step position, and the PWM frequency is
+ * changed on the fly to the new step rate. The targets of both axes are
+ * converted to step positions by the calibration model, which couples the
+ * axes. The direction only changes once the axis is stopped.
+ *
+ * @param[in] axis 0 for the X-axis, 1 for the Y-axis.
+ * @param[in] pwm Pointer to the PWM channel used for motor step control.
+ * @param[in,out] gpio_line Pointer to the GPIO line controlling motor direction.
+ * @param[out] est The estimated step position of the axis, protected by @c follow_mutex .
+ */
+static void follow_axis(uint32_t axis, const syspwm_t* pwm, gpiod_line* gpio_line, float* est)
+{
+    // Signed step rate [Hz], positive in the STEP_P direction.
+    float rate = 0.0f;
+    uint64_t last_ns = frame_clock_now();
+
+    while (!psig_kill_requested()) {
+        wait_interruptible_us(VELOCITY_PERIOD_US, 1000, psig_kill_requested);
+        uint64_t now_ns = frame_clock_now();
+        float dt = (float)((now_ns - last_ns) / 1e9);
+        last_ns = now_ns;
+
+        // Integrate the steps generated during the period.
+        pthread_mutex_lock(&follow_mutex);
+        *est += rate * dt;
+        float pos = *est;
+        axis_target_t tx = x_target;
+        axis_target_t ty = y_target;
+        pthread_mutex_unlock(&follow_mutex);
+
+        // Step positions aiming at the targets now and one period later.
+        float s0[2], s1[2];
+        target_steps(&tx, &ty, now_ns, s0);
+        target_steps(&tx, &ty, now_ns + VELOCITY_PERIOD_US * 1000ULL, s1);
+        float error = s0[axis] - pos;
+
+        // Velocity feedforward plus position feedback, within the motor limits.
+        float wanted = (s1[axis] - s0[axis]) * (1e6f / VELOCITY_PERIOD_US) + VELOCITY_GAIN * error;
+        if (wanted > VELOCITY_MAX_RATE) wanted = VELOCITY_MAX_RATE;
+        if (wanted < -VELOCITY_MAX_RATE) wanted = -VELOCITY_MAX_RATE;
+        float max_change = VELOCITY_MAX_ACCEL * dt;
+        float next = wanted;
+        if (next > rate + max_change) next = rate + max_change;
+        if (next < rate - max_change) next = rate - max_change;
+        if (fabsf(next) < VELOCITY_MIN_RATE || (rate != 0.0f && (next > 0.0f) != (rate > 0.0f))) next = 0.0f;
+
+        // Update the signal without stopping it.
+        frequency_hz_t old_freq = (frequency_hz_t)fabsf(rate);
+        frequency_hz_t freq = (frequency_hz_t)fabsf(next);
+        if (old_freq == 0 && freq > 0) gpio_write(gpio_line, (gpiod_value_t)(next > 0.0f ? STEP_P : STEP_M));
+        if (freq != old_freq) syspwm_set_freq(pwm, old_freq, freq);
+        rate = freq == 0 ? 0.0f : (next > 0.0f ? (float)freq : -(float)freq);
+        if (freq != old_freq) {
+            float ex, ey;
+            motor_estimate(&ex, &ey);
+            flight_record_rate(axis, rate, axis == 0 ? ex : ey);
+        }
+    }
 }
 
 void* stepper_x_task(void* arg)
 {
-    printf("[Info] Start x-stepper motor task\n");
+    log_write(LOG_INFO, "Start x-stepper motor task");
 
     // Install signal handler for system signals.
     psig_install_handler();
 
     // Wait for calibration.
-    printf("[Info] x-stepper waiting for cal...\n");
+    log_write(LOG_INFO, "x-stepper waiting for cal...");
     sem_wait(&data_x_ready_sem);
-    // Calibrate initial X-position.
+    // Calibrate initial X-position, and the step position aiming at it.
     x0_px = x_px_buff;
+    float sx, sy;
+    calib_px_to_steps(x_px_buff, y_px_buff, &sx, &sy);
+    __atomic_store_n(&x_steps, (int32_t)lroundf(sx), __ATOMIC_RELAXED);
     sem_post(&data_x_done_sem);
-    printf("[Info] Set x-stepper ref to x=%d\n", x0_px);
+    log_write(LOG_INFO, "Set x-stepper ref to x=%d", x0_px);
+
+    // Follow the targets from the reference in velocity mode.
+    if (motor_mode == MOTOR_MODE_VELOCITY) {
+        pthread_mutex_lock(&follow_mutex);
+        x_est_steps = (float)x_steps;
+        x_target = (axis_target_t){ x0_px, 0.0f, frame_clock_now() };
+        pthread_mutex_unlock(&follow_mutex);
+        follow_axis(0, &PWM_STEP_X, dir_x_line, &x_est_steps);
+    }
 
     // Reading loop that continues until a termination signal is received.
     while (!psig_kill_requested()) {
         // Wait for a new X-position.
         sem_wait(&data_x_ready_sem);
-        // Read X-position. 
+        // Read the position, both coordinates setting the step position.
         d_px_t x_px = x_px_buff;
+        d_px_t y_px = y_px_buff;
         sem_post(&data_x_done_sem);
-        printf("[Info] Received x=%d\n", x_px);
-        // Move the motor.
-        move_stepper(&PWM_STEP_X, dir_x_line, PWM_FREQ, x_px-x0_px);
+        log_write(LOG_INFO, "Received x=%d", x_px);
+        // Move the motor to the step position aiming at the new position,
+        // from its step position corrected by the missed steps.
+        calib_px_to_steps(x_px, y_px, &sx, &sy);
+        int32_t target = (int32_t)lroundf(sx);
+        int32_t slip = __atomic_exchange_n(&x_slip, 0, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&x_steps, slip, __ATOMIC_RELAXED);
+        perf_stage_begin(PERF_STAGE_MOTOR_X);
+        int32_t emitted = 0;
+        move_stepper_steps(&PWM_STEP_X, dir_x_line, PWM_FREQ, target - x_steps, &emitted);
+        perf_stage_end(PERF_STAGE_MOTOR_X);
+        flight_record_steps(0, target, target - x_steps, emitted, slip);
+        // The free-running signal may emit more steps than planned.
+        __atomic_add_fetch(&x_steps, emitted, __ATOMIC_RELAXED);
         // Update previous position.
         x0_px = x_px;
     }
@@ -93,35 +294,59 @@ void* stepper_x_task(void* arg)
     // Indicate the X-motor task is complete and release resources.
     syspwm_enable(&PWM_STEP_X, SYSPWM_DISABLE);
     thread_ready_num++;
-    printf("[Info] Stopping x-stepper motor task\n");
+    log_write(LOG_INFO, "Stopping x-stepper motor task");
     pthread_exit(EXIT_SUCCESS);
 }
 
 void* stepper_y_task(void* arg)
 {
-    printf("[Info] Start y-stepper motor task\n");
+    log_write(LOG_INFO, "Start y-stepper motor task");
 
     // Install signal handler for system signals
     psig_install_handler();
 
     // Wait for calibration.
-    printf("[Info] y-stepper waiting for cal...\n");
+    log_write(LOG_INFO, "y-stepper waiting for cal...");
     sem_wait(&data_y_ready_sem);
-    // Calibrate initial Y-position.
+    // Calibrate initial Y-position, and the step position aiming at it.
     y0_px = y_px_buff;
+    float sx, sy;
+    calib_px_to_steps(x_px_buff, y_px_buff, &sx, &sy);
+    __atomic_store_n(&y_steps, (int32_t)lroundf(sy), __ATOMIC_RELAXED);
     sem_post(&data_y_done_sem);
-    printf("[Info] Set y-stepper ref to y=%d\n", y0_px);
+    log_write(LOG_INFO, "Set y-stepper ref to y=%d", y0_px);
+
+    // Follow the targets from the reference in velocity mode.
+    if (motor_mode == MOTOR_MODE_VELOCITY) {
+        pthread_mutex_lock(&follow_mutex);
+        y_est_steps = (float)y_steps;
+        y_target = (axis_target_t){ y0_px, 0.0f, frame_clock_now() };
+        pthread_mutex_unlock(&follow_mutex);
+        follow_axis(1, &PWM_STEP_Y, dir_y_line, &y_est_steps);
+    }
     
     // Reading loop that continues until a termination signal is received.
     while (!psig_kill_requested()) {
         // Wait for a new Y-position.
         sem_wait(&data_y_ready_sem);
-        // Read Y-position.
+        // Read the position, both coordinates setting the step position.
+        d_px_t x_px = x_px_buff;
         d_px_t y_px = y_px_buff;
         sem_post(&data_y_done_sem);
-        printf("[Info] Received y=%d\n", y_px);
-        // Move the motor.
-        move_stepper(&PWM_STEP_Y, dir_y_line, PWM_FREQ, y_px-y0_px);
+        log_write(LOG_INFO, "Received y=%d", y_px);
+        // Move the motor to the step position aiming at the new position,
+        // from its step position corrected by the missed steps.
+        calib_px_to_steps(x_px, y_px, &sx, &sy);
+        int32_t target = (int32_t)lroundf(sy);
+        int32_t slip = __atomic_exchange_n(&y_slip, 0, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&y_steps, slip, __ATOMIC_RELAXED);
+        perf_stage_begin(PERF_STAGE_MOTOR_Y);
+        int32_t emitted = 0;
+        move_stepper_steps(&PWM_STEP_Y, dir_y_line, PWM_FREQ, target - y_steps, &emitted);
+        perf_stage_end(PERF_STAGE_MOTOR_Y);
+        flight_record_steps(1, target, target - y_steps, emitted, slip);
+        // The free-running signal may emit more steps than planned.
+        __atomic_add_fetch(&y_steps, emitted, __ATOMIC_RELAXED);
         // Update previous position.
         y0_px = y_px;
     }
@@ -129,6 +354,6 @@ void* stepper_y_task(void* arg)
     // Indicate the Y-motor task is complete and release resources.
     syspwm_enable(&PWM_STEP_Y, SYSPWM_DISABLE);
     thread_ready_num++;
-    printf("[Info] Stopping y-stepper motor task\n");
+    log_write(LOG_INFO, "Stopping y-stepper motor task");
     pthread_exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,475 @@
+/**
+ * @file dataset_collect.cpp
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c dataset_collect.h .
+ *
+ * @see dataset_collect.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "dataset_collect.h"
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "frame_clock.h"
+
+/**
+ * @brief Camera frame kept until its detection result.
+ */
+typedef struct {
+    uint64_t frame_id;          ///< Capture sequence number, 0 if the slot is free.
+    int width;                  ///< Frame width [px].
+    int height;                 ///< Frame height [px].
+    bool compressed;            ///< @c true if @c data holds the JPEG of the camera, @c false for BGR pixels.
+    std::vector<uint8_t> data;  ///< Frame data.
+} kept_frame_t;
+
+/**
+ * @brief Example waiting to be written.
+ */
+typedef struct {
+    kept_frame_t frame;             ///< The frame.
+    char name[COLLECT_NAME_SIZE];   ///< Name of the files.
+    std::string labels;             ///< Content of the label file.
+} recording_t;
+
+// Dataset directory.
+static char dataset_dir[PATH_MAX];
+
+// Last camera frames, only used by the collecting thread.
+static kept_frame_t history[COLLECT_HISTORY];
+static uint64_t history_count = 0;
+
+// Recordings waiting to be written, oldest first from queue_head.
+// Frame buffers are swapped in and out rather than copied.
+static pthread_mutex_t queue_mutex;
+static pthread_cond_t queue_cond;
+static recording_t queue[COLLECT_QUEUE_SIZE];
+static size_t queue_head = 0;
+static size_t queue_count = 0;
+
+// Statistics, updated with atomic built-ins.
+static uint64_t triggered = 0;
+static uint64_t limited = 0;
+static uint64_t missing = 0;
+static uint64_t dropped = 0;
+static uint64_t recorded = 0;
+static uint64_t failed = 0;
+
+int collect_open(const char* dir)
+{
+    snprintf(dataset_dir, sizeof(dataset_dir), "%s", dir);
+
+    const char* subdirs[] = { "", "/images", "/labels" };
+    for (const char* subdir : subdirs) {
+        char path[PATH_MAX + 8];
+        snprintf(path, sizeof(path), "%s%s", dataset_dir, subdir);
+        if (mkdir(path, 0755) < 0 && errno != EEXIST) {
+            log_write(LOG_ERROR, "Could not create %s%s: %s", dataset_dir, subdir, strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&queue_mutex, nullptr);
+    pthread_cond_init(&queue_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    return EXIT_SUCCESS;
+}
+
+void collect_close(void)
+{
+    for (int i = 0; i < COLLECT_HISTORY; i++) {
+        std::vector<uint8_t>().swap(history[i].data);
+    }
+    for (int i = 0; i < COLLECT_QUEUE_SIZE; i++) {
+        std::vector<uint8_t>().swap(queue[i].frame.data);
+        std::string().swap(queue[i].labels);
+    }
+    queue_count = 0;
+    pthread_mutex_destroy(&queue_mutex);
+    pthread_cond_destroy(&queue_cond);
+}
+
+void collect_get_stats(collect_stats_t* stats)
+{
+    stats->triggered = __atomic_load_n(&triggered, __ATOMIC_RELAXED);
+    stats->limited = __atomic_load_n(&limited, __ATOMIC_RELAXED);
+    stats->missing = __atomic_load_n(&missing, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+    stats->recorded = __atomic_load_n(&recorded, __ATOMIC_RELAXED);
+    stats->failed = __atomic_load_n(&failed, __ATOMIC_RELAXED);
+}
+
+/****************************************************************************
+ * Triggers
+ ****************************************************************************/
+
+/**
+ * @brief Computes the overlap of two detections.
+ *
+ * @return The intersection over union of their boxes, between 0 and 1.
+ */
+static float det_iou(const detection_t* a, const detection_t* b)
+{
+    float x1 = std::max(a->x1, b->x1);
+    float y1 = std::max(a->y1, b->y1);
+    float x2 = std::min(a->x2, b->x2);
+    float y2 = std::min(a->y2, b->y2);
+    if (x2 <= x1 || y2 <= y1) return 0.0f;
+
+    float inter = (x2 - x1) * (y2 - y1);
+    float area = (a->x2 - a->x1) * (a->y2 - a->y1) + (b->x2 - b->x1) * (b->y2 - b->y1) - inter;
+    return area > 0.0f ? inter / area : 0.0f;
+}
+
+/**
+ * @brief Checks a detection result against the triggers.
+ *
+ * @return The triggers met, as a mask of @c collect_trigger_t , 0 if none.
+ */
+static uint32_t find_triggers(const overlay_t* overlay)
+{
+    uint32_t triggers = 0;
+
+    for (size_t i = 0; i < overlay->det_count; i++) {
+        const detection_t* det = &overlay->dets[i];
+        if (det->conf < COLLECT_LOW_CONF) triggers |= COLLECT_LOW_CONFIDENCE;
+        for (size_t j = i + 1; j < overlay->det_count; j++) {
+            const detection_t* other = &overlay->dets[j];
+            if (det->cls != other->cls && det_iou(det, other) >= COLLECT_CONFLICT_IOU) triggers |= COLLECT_CONFLICT;
+        }
+    }
+
+    // Only the first frame missed, the next ones are the same example.
+    for (size_t i = 0; i < overlay->track_count; i++) {
+        const track_t* track = &overlay->tracks[i];
+        if (track->confirmed && track->misses == 1) triggers |= COLLECT_FLICKER;
+    }
+
+    return triggers;
+}
+
+/**
+ * @brief Appends a box to the labels, in the YOLO format.
+ *
+ * The box is clipped to the frame, and given by its center and size,
+ * relative to the frame size.
+ */
+static void append_label(std::string& labels, int32_t cls, float x1, float y1, float x2, float y2,
+                         int width, int height)
+{
+    x1 = std::max(x1, 0.0f);
+    y1 = std::max(y1, 0.0f);
+    x2 = std::min(x2, (float)width);
+    y2 = std::min(y2, (float)height);
+    if (x2 <= x1 || y2 <= y1) return;
+
+    char line[80];
+    snprintf(line, sizeof(line), "%d %.6f %.6f %.6f %.6f\n", (int)cls,
+             (x1 + x2) / 2.0f / width, (y1 + y2) / 2.0f / height, (x2 - x1) / width, (y2 - y1) / height);
+    labels += line;
+}
+
+/**
+ * @brief Writes the labels of a detection result: the detections, and the missed tracks.
+ */
+static void make_labels(const overlay_t* overlay, int width, int height, std::string& labels)
+{
+    labels.clear();
+    for (size_t i = 0; i < overlay->det_count; i++) {
+        const detection_t* det = &overlay->dets[i];
+        append_label(labels, det->cls, det->x1, det->y1, det->x2, det->y2, width, height);
+    }
+    for (size_t i = 0; i < overlay->track_count; i++) {
+        const track_t* track = &overlay->tracks[i];
+        if (!track->confirmed || track->misses == 0) continue;
+        append_label(labels, track->cls, track->x.pos - track->w / 2.0f, track->y.pos - track->h / 2.0f,
+                     track->x.pos + track->w / 2.0f, track->y.pos + track->h / 2.0f, width, height);
+    }
+}
+
+/**
+ * @brief Names a recording after the wall-clock time and its triggers.
+ */
+static void make_name(uint32_t triggers, char* name, size_t size)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    unsigned long long ms = (unsigned long long)now.tv_sec * 1000ULL + (unsigned long long)now.tv_nsec / 1000000ULL;
+
+    int len = snprintf(name, size, "%llu%s%s%s", ms,
+                       (triggers & COLLECT_LOW_CONFIDENCE) ? "_lowconf" : "",
+                       (triggers & COLLECT_FLICKER) ? "_flicker" : "",
+                       (triggers & COLLECT_CONFLICT) ? "_conflict" : "");
+    if (len < 0) name[0] = '\0';
+}
+
+/****************************************************************************
+ * Collecting thread
+ ****************************************************************************/
+
+/**
+ * @brief Copies a camera frame in the history, compressed if the camera delivered it so.
+ */
+static void keep_frame(const frame_t* frame)
+{
+    kept_frame_t* kept = &history[history_count++ % COLLECT_HISTORY];
+    kept->frame_id = frame->frame_id;
+    kept->width = frame->width;
+    kept->height = frame->height;
+    kept->compressed = frame->jpeg_size > 0;
+    if (kept->compressed) kept->data.assign(frame->jpeg, frame->jpeg + frame->jpeg_size);
+    else kept->data.assign(frame->data, frame->data + frame->size);
+}
+
+/**
+ * @brief Finds a frame of the history from its capture sequence number.
+ *
+ * @return The frame, or @c NULL if it is no longer kept.
+ */
+static kept_frame_t* find_frame(uint64_t frame_id)
+{
+    if (frame_id == 0) return nullptr;
+    for (int i = 0; i < COLLECT_HISTORY; i++) {
+        if (history[i].frame_id == frame_id) return &history[i];
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Queues the frame of a detection result meeting a trigger, within the rate limit.
+ *
+ * @param[in] overlay The detection result.
+ * @param[in,out] last_ns Time of the last recording [ns], 0 if none.
+ */
+static void check_result(const overlay_t* overlay, uint64_t* last_ns)
+{
+    // Only the results of an inference tell what the model struggles with.
+    if (overlay->reused) return;
+
+    uint32_t triggers = find_triggers(overlay);
+    if (!triggers) return;
+    __atomic_add_fetch(&triggered, 1, __ATOMIC_RELAXED);
+
+    uint64_t now_ns = frame_clock_now();
+    if (*last_ns != 0 && now_ns - *last_ns < COLLECT_MIN_INTERVAL_MS * 1000000ULL) {
+        __atomic_add_fetch(&limited, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    kept_frame_t* kept = find_frame(overlay->frame_id);
+    if (!kept) {
+        __atomic_add_fetch(&missing, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    // Prepare the labels outside of the lock.
+    static std::string labels;
+    make_labels(overlay, kept->width, kept->height, labels);
+
+    pthread_mutex_lock(&queue_mutex);
+    if (queue_count == COLLECT_QUEUE_SIZE) {
+        pthread_mutex_unlock(&queue_mutex);
+        __atomic_add_fetch(&dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    recording_t* rec = &queue[(queue_head + queue_count) % COLLECT_QUEUE_SIZE];
+    std::swap(rec->frame, *kept);
+    rec->labels.swap(labels);
+    make_name(triggers, rec->name, sizeof(rec->name));
+    queue_count++;
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_mutex);
+
+    // The history slot got the buffer of a recording already written.
+    kept->frame_id = 0;
+    *last_ns = now_ns;
+}
+
+void* collect_task(void* arg)
+{
+    log_write(LOG_INFO, "Start dataset collection task");
+
+    // Install signal handler for system signals.
+    psig_install_handler();
+
+    frame_sub_t* sub = frame_bus_subscribe(&cam_bus, "collect", FRAME_BUS_LATEST, 0);
+    if (!sub) {
+        log_write(LOG_ERROR, "Could not subscribe to the camera bus");
+        thread_ready_num++;
+        pthread_exit(nullptr);
+    }
+
+    static overlay_t overlay;
+    uint64_t last_ns = 0;
+
+    // Collecting loop that continues until a termination signal is received.
+    while (!psig_kill_requested()) {
+        frame_t* frame = frame_sub_receive(&cam_bus, sub, COLLECT_WAIT_MS);
+        if (frame) {
+            keep_frame(frame);
+            frame_unref(frame);
+        }
+
+        // The result of a frame always comes after the frame itself.
+        if (overlay_wait(&overlay, 0)) check_result(&overlay, &last_ns);
+    }
+
+    frame_bus_unsubscribe(&cam_bus, sub);
+
+    // Indicate the task is complete.
+    thread_ready_num++;
+    log_write(LOG_INFO, "Stopping dataset collection task");
+    pthread_exit(EXIT_SUCCESS);
+}
+
+/****************************************************************************
+ * Writing thread
+ ****************************************************************************/
+
+/**
+ * @brief Waits for the oldest recording waiting to be written.
+ *
+ * @param[in,out] rec The recording, swapped with the one of the queue.
+ * @return @c true if a recording was taken, @c false after @c COLLECT_WAIT_MS .
+ */
+static bool queue_take(recording_t* rec)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_nsec += (long)COLLECT_WAIT_MS * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&queue_mutex);
+    while (queue_count == 0) {
+        if (pthread_cond_timedwait(&queue_cond, &queue_mutex, &deadline) != 0) break;
+    }
+    bool taken = queue_count > 0;
+    if (taken) {
+        recording_t* head = &queue[queue_head];
+        std::swap(rec->frame, head->frame);
+        rec->labels.swap(head->labels);
+        memcpy(rec->name, head->name, sizeof(rec->name));
+        queue_head = (queue_head + 1) % COLLECT_QUEUE_SIZE;
+        queue_count--;
+    }
+    pthread_mutex_unlock(&queue_mutex);
+    return taken;
+}
+
+/**
+ * @brief Writes data to a new file.
+ *
+ * @return @c true on success, @c false with @c errno set otherwise.
+ */
+static bool write_file(const char* path, const void* data, size_t len)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    bool ok = fwrite(data, 1, len, file) == len;
+    return fclose(file) == 0 && ok;
+}
+
+/**
+ * @brief Writes the image and the label file of a recording.
+ *
+ * @param[in] rec The recording.
+ * @param[in,out] jpeg Buffer of the frames to encode.
+ */
+static void write_example(const recording_t* rec, std::vector<uint8_t>& jpeg)
+{
+    const std::vector<uint8_t>* image = &rec->frame.data;
+    if (!rec->frame.compressed) {
+        cv::Mat pixels(rec->frame.height, rec->frame.width, CV_8UC3, (void*)rec->frame.data.data());
+        cv::imencode(".jpg", pixels, jpeg, {cv::IMWRITE_JPEG_QUALITY, COLLECT_JPEG_QUALITY});
+        image = &jpeg;
+    }
+
+    // The label file comes last, so that labels never go without their image.
+    char path[PATH_MAX + COLLECT_NAME_SIZE + 16];
+    snprintf(path, sizeof(path), "%s/images/%s.jpg", dataset_dir, rec->name);
+    bool ok = write_file(path, image->data(), image->size());
+    if (ok) {
+        snprintf(path, sizeof(path), "%s/labels/%s.txt", dataset_dir, rec->name);
+        ok = write_file(path, rec->labels.data(), rec->labels.size());
+    }
+
+    if (ok) {
+        __atomic_add_fetch(&recorded, 1, __ATOMIC_RELAXED);
+        log_write(LOG_DEBUG, "Hard example recorded");
+    } else {
+        __atomic_add_fetch(&failed, 1, __ATOMIC_RELAXED);
+        log_write(LOG_WARNING, "Could not write a hard example: %s", strerror(errno));
+    }
+}
+
+void* collect_writer_task(void* arg)
+{
+    log_write(LOG_INFO, "Start dataset writing task");
+
+    // Install signal handler for system signals.
+    psig_install_handler();
+
+    // Encoding and writing only use the time left by the other threads.
+    struct sched_param param = {};
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0) {
+        log_write(LOG_WARNING, "Could not set the idle priority");
+    }
+
+    recording_t rec = {};
+    std::vector<uint8_t> jpeg;
+
+    // Writing loop that continues until a termination signal is received,
+    // then until the queue is empty.
+    while (true) {
+        if (queue_take(&rec)) write_example(&rec, jpeg);
+        else if (psig_kill_requested()) break;
+    }
+
+    collect_stats_t stats;
+    collect_get_stats(&stats);
+    log_write(LOG_INFO, "Dataset: %llu triggered, %llu recorded, %llu failed, %llu limited, %llu missing, %llu dropped",
+              (unsigned long long)stats.triggered, (unsigned long long)stats.recorded,
+              (unsigned long long)stats.failed, (unsigned long long)stats.limited,
+              (unsigned long long)stats.missing, (unsigned long long)stats.dropped);
+
+    // Indicate the task is complete.
+    thread_ready_num++;
+    log_write(LOG_INFO, "Stopping dataset writing task");
+    pthread_exit(EXIT_SUCCESS);
+}
@@ -27,44 +27,206 @@
 
 #include "display_result.h"
 
-// Result buffer initialization. Holds only one frame.
-cv::Mat disp_buffer_0(FRAME_HEIGHT, FRAME_WIDTH, CV_8UC3);
+#include <unistd.h>
 
-void* display_task(void* arg)
+#include "stepper_demo.h"
+
+/// Color of the boxes of each class (BGR).
+static const cv::Scalar ALIEN_COLOR(0, 0, 255);
+static const cv::Scalar OTHER_COLOR(0, 200, 0);
+static const cv::Scalar TRACK_COLOR(255, 200, 0);
+static const cv::Scalar TARGET_COLOR(255, 255, 255);
+
+/**
+ * @brief Writes a label above a point, on a filled background.
+ */
+static void draw_label(cv::Mat& image, const char* text, cv::Point at, const cv::Scalar& color)
 {
-    printf("[Info] Start display task\n");
+    int baseline = 0;
+    cv::Size size = cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, 0.5, 1, &baseline);
+    at.y = std::max(at.y, size.height + baseline);
+    cv::rectangle(image, cv::Point(at.x, at.y - size.height - baseline), cv::Point(at.x + size.width, at.y),
+                  color, cv::FILLED);
+    cv::putText(image, text, cv::Point(at.x, at.y - baseline), cv::FONT_HERSHEY_SIMPLEX, 0.5,
+                cv::Scalar(0, 0, 0), 1, cv::LINE_AA);
+}
+
+void display_draw_overlay(cv::Mat& image, const frame_t* frame, const overlay_t* overlay)
+{
+    float sx = (float)image.cols / frame->width;
+    float sy = (float)image.rows / frame->height;
+    char text[32];
+
+    // Detected boxes, with their class and confidence.
+    for (size_t i = 0; i < overlay->det_count; i++) {
+        const detection_t* det = &overlay->dets[i];
+        bool alien = det->cls == DETECTION_CLASS_ALIEN;
+        const cv::Scalar& color = alien ? ALIEN_COLOR : OTHER_COLOR;
+        cv::Point p1(cvRound(det->x1 * sx), cvRound(det->y1 * sy));
+        cv::Point p2(cvRound(det->x2 * sx), cvRound(det->y2 * sy));
+        cv::rectangle(image, p1, p2, color, 2);
+        if (alien) snprintf(text, sizeof(text), "alien %.2f", det->conf);
+        else snprintf(text, sizeof(text), "class %d %.2f", (int)det->cls, det->conf);
+        draw_label(image, text, p1, color);
+    }
+
+    // Confirmed tracks, moved to where they are on this frame.
+    float dt = 0.0f;
+    if (frame->timestamp_ns > overlay->timestamp_ns) {
+        dt = std::min((frame->timestamp_ns - overlay->timestamp_ns) / 1e9f, DISPLAY_MAX_PREDICT_MS / 1e3f);
+    }
+    for (size_t i = 0; i < overlay->track_count; i++) {
+        const track_t* track = &overlay->tracks[i];
+        if (!track->confirmed) continue;
+        cv::Point center(cvRound((track->x.pos + track->x.vel * dt) * sx),
+                         cvRound((track->y.pos + track->y.vel * dt) * sy));
+        cv::circle(image, center, 4, TRACK_COLOR, cv::FILLED);
+        snprintf(text, sizeof(text), "#%u", (unsigned)track->id);
+        draw_label(image, text, cv::Point(center.x + 6, center.y - 6), TRACK_COLOR);
+    }
 
-    // Compute display height.
-    int display_height = DISPLAY_WIDTH * FRAME_HEIGHT / FRAME_WIDTH;
+    // Target of the beam, once the motors have a reference.
+    d_px_t x, y;
+    if (read_abs_pos(&x, &y, nullptr)) {
+        cv::Point target(cvRound(x * sx), cvRound(y * sy));
+        cv::drawMarker(image, target, TARGET_COLOR, cv::MARKER_CROSS, 20, 2);
+    }
+}
 
-    // Import user's GUI settings.
-    setenv("DISPLAY", ":0", 1);
-    setenv("XAUTHORITY", "/home/orangepi/.Xauthority", 1);
+/**
+ * @brief Opens the direct screen output requested, if any.
+ *
+ * In automatic mode, the framebuffer device is only used without DRM
+ * device, since a display server may own the DRM device otherwise.
+ */
+static bool open_scanout(display_output_t output, scanout_t* scanout)
+{
+    if (output == DISPLAY_OUTPUT_AUTO || output == DISPLAY_OUTPUT_DRM) {
+        if (scanout_open_drm(scanout, SCANOUT_DRM_DEVICE) == EXIT_SUCCESS) return true;
+    }
+    if (output == DISPLAY_OUTPUT_FBDEV || (output == DISPLAY_OUTPUT_AUTO && access(SCANOUT_DRM_DEVICE, F_OK) != 0)) {
+        if (scanout_open_fbdev(scanout, SCANOUT_FB_DEVICE) == EXIT_SUCCESS) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Largest region of the screen with the aspect ratio of the frames, centered.
+ */
+static cv::Rect fit_frame(int screen_width, int screen_height)
+{
+    int width = screen_width;
+    int height = screen_width * FRAME_HEIGHT / FRAME_WIDTH;
+    if (height > screen_height) {
+        height = screen_height;
+        width = screen_height * FRAME_WIDTH / FRAME_HEIGHT;
+    }
+    return cv::Rect((screen_width - width) / 2, (screen_height - height) / 2, width, height);
+}
+
+/**
+ * @brief Scales a frame straight into the back buffer of the screen, draws the result, and flips.
+ */
+static void show_scanout(scanout_t* scanout, const cv::Rect& view, cv::Mat& bgrx,
+                         const frame_t* frame, const overlay_t* overlay)
+{
+    // Convert at the camera resolution, so that the only pass at the screen
+    // resolution is the resize writing into the mapped buffer.
+    cv::Mat image(frame->height, frame->width, CV_8UC3, frame->data);
+    cv::cvtColor(image, bgrx, cv::COLOR_BGR2BGRA);
+
+    cv::Mat screen(scanout->height, scanout->width, CV_8UC4, scanout_begin(scanout), scanout->pitch);
+    cv::Mat region = screen(view);
+    cv::resize(bgrx, region, region.size(), 0, 0, cv::INTER_LINEAR);
+    display_draw_overlay(region, frame, overlay);
+    scanout_flip(scanout);
+}
+
+void* display_task(void* arg)
+{
+    printf("[Info] Start display task\n");
+    display_output_t output = arg ? *(const display_output_t*)arg : DISPLAY_OUTPUT_AUTO;
 
     // Install signal handler for system signals
     psig_install_handler();
-    cv::Mat frame;
 
-    // Reading loop that read results until a termination signal is received.
+    // Only the latest frame is worth displaying.
+    frame_sub_t* sub = frame_bus_subscribe(&cam_bus, "display", FRAME_BUS_LATEST, 0);
+    if (!sub) {
+        fprintf(stderr, "[Error] Could not subscribe to the camera bus\n");
+        fprintf(stderr, "[Error] Abort display task\n");
+        thread_ready_num++;
+        pthread_exit(nullptr);
+    }
+
+    // Direct screen output, otherwise a window of the display server.
+    scanout_t scanout;
+    bool direct = open_scanout(output, &scanout);
+    if (!direct && output != DISPLAY_OUTPUT_AUTO && output != DISPLAY_OUTPUT_X11) {
+        fprintf(stderr, "[Error] Could not open the screen output\n");
+        fprintf(stderr, "[Error] Abort display task\n");
+        frame_bus_unsubscribe(&cam_bus, sub);
+        thread_ready_num++;
+        pthread_exit(nullptr);
+    }
+
+    cv::Rect view;
+    cv::Mat bgrx(FRAME_HEIGHT, FRAME_WIDTH, CV_8UC4);
+    cv::Mat resized_frame;
+    if (direct) {
+        view = fit_frame(scanout.width, scanout.height);
+    } else {
+        // Import user's GUI settings.
+        setenv("DISPLAY", ":0", 1);
+        setenv("XAUTHORITY", "/home/orangepi/.Xauthority", 1);
+
+        // Compute display height.
+        int display_height = DISPLAY_WIDTH * FRAME_HEIGHT / FRAME_WIDTH;
+        resized_frame.create(display_height, DISPLAY_WIDTH, CV_8UC3);
+    }
+
+    // Reading loop that waits for results until a termination signal is received.
+    static overlay_t overlay;
+    frame_t* latest = nullptr;
     while (!psig_kill_requested()) {
-        // Wait for a result image to be available.
-        pthread_mutex_lock(&disp_buffer_mutex);
-        frame = disp_buffer_0.clone();
-        pthread_mutex_unlock(&disp_buffer_mutex);
-
-        // If the image is not empty, copy it, resize it, and display it.
-        if (!frame.empty()) {
-            cv::Mat resized_frame;
-            cv::resize(frame, resized_frame, cv::Size(DISPLAY_WIDTH, display_height), 0, 0, cv::INTER_LINEAR);
-            cv::imshow("YOLOv8n result", resized_frame);
-            cv::waitKey(1);
+        // Wait for a new result, keeping the window responsive meanwhile.
+        if (!overlay_wait(&overlay, DISPLAY_WAIT_MS)) {
+            if (!direct) cv::waitKey(1);
+            continue;
         }
+
+        // Draw it over the latest frame, or the last one kept if none is newer.
+        frame_t* frame = frame_sub_receive(&cam_bus, sub, 0);
+        if (frame) {
+            if (latest) frame_unref(latest);
+            latest = frame;
+        }
+        if (!latest) continue;
+
+        if (direct) {
+            show_scanout(&scanout, view, bgrx, latest, &overlay);
+            continue;
+        }
+
+        // Resize the frame in the reused buffer, and draw on this copy only:
+        // the frame itself is shared with the other subscribers.
+        cv::Mat image(latest->height, latest->width, CV_8UC3, latest->data);
+        cv::resize(image, resized_frame, resized_frame.size(), 0, 0, cv::INTER_LINEAR);
+        display_draw_overlay(resized_frame, latest, &overlay);
+        cv::imshow("YOLOv8n result", resized_frame);
+        cv::waitKey(1);
     }
 
     // Indicate the task is complete and release resources.
-    cv::destroyAllWindows();
+    if (latest) frame_unref(latest);
+    if (direct) {
+        scanout_close(&scanout);
+    } else {
+        cv::destroyAllWindows();
+    }
+    frame_bus_unsubscribe(&cam_bus, sub);
     thread_ready_num++;
     printf("[Info] Stopping display task\n");
     pthread_exit(EXIT_SUCCESS);
 
-}
\ No newline at end of file
+}
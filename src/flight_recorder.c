@@ -0,0 +1,485 @@
+/**
+ * @file flight_recorder.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c flight_recorder.h .
+ *
+ * @see flight_recorder.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "flight_recorder.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "psig_utils.h"
+#include "log_utils.h"
+#include "ipc_elements.h"
+#include "frame_clock.h"
+#include "telemetry_log.h"
+
+_Static_assert(sizeof(flight_event_t) == 64, "a telemetry event must fill a cache line");
+_Static_assert((FLIGHT_EVENTS & (FLIGHT_EVENTS - 1)) == 0, "the number of events must be a power of 2");
+
+// Alignment of the frames in the ring and in the dump files [bytes].
+#define FRAME_ALIGN 8
+
+// Maximum number of contiguous parts of the ring in a dump, a wrap making 2.
+#define MAX_SPANS 4
+
+/**
+ * @brief Frame kept in the ring.
+ */
+typedef struct {
+    size_t offset;          ///< Offset of its @c flight_frame_t in the ring [bytes].
+    size_t len;             ///< Size of the header, the data and the padding [bytes].
+    uint64_t timestamp_ns;  ///< Capture time [ns].
+} ring_frame_t;
+
+// Directory of the dump files.
+static char dump_dir[PATH_MAX];
+
+// Recording enabled, read with atomic built-ins.
+static bool enabled = false;
+
+// Telemetry events, written without lock by any thread.
+static flight_event_t events[FLIGHT_EVENTS] __attribute__((aligned(64)));
+static uint64_t event_head = 0;
+
+// Copy of the events being dumped, only used by the recording thread.
+static flight_event_t dump_events[FLIGHT_EVENTS];
+
+// Compressed frames, only used by the recording thread, oldest first from frames_head.
+static uint8_t* ring = NULL;
+static size_t ring_pos = 0;
+static ring_frame_t frames[FLIGHT_MAX_FRAMES];
+static size_t frames_head = 0;
+static size_t frames_count = 0;
+
+// First trigger not handled yet, 0 if none.
+static uint32_t pending_reason = 0;
+static uint64_t pending_ns = 0;
+
+// Statistics, updated with atomic built-ins.
+static uint64_t frames_recorded = 0;
+static uint64_t raw_frames = 0;
+static uint64_t dumps = 0;
+static uint64_t ignored = 0;
+static uint64_t failed = 0;
+
+int flight_open(const char* dir)
+{
+    snprintf(dump_dir, sizeof(dump_dir), "%s", dir);
+    if (mkdir(dump_dir, 0755) < 0 && errno != EEXIST) {
+        log_write(LOG_ERROR, "Could not create %s: %s", dump_dir, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    ring = malloc(FLIGHT_FRAME_RING_SIZE);
+    if (!ring) {
+        log_write(LOG_ERROR, "Could not allocate the flight recorder");
+        return EXIT_FAILURE;
+    }
+    ring_pos = 0;
+    frames_head = 0;
+    frames_count = 0;
+
+    __atomic_store_n(&enabled, true, __ATOMIC_RELEASE);
+    return EXIT_SUCCESS;
+}
+
+void flight_close(void)
+{
+    __atomic_store_n(&enabled, false, __ATOMIC_RELEASE);
+    free(ring);
+    ring = NULL;
+}
+
+void flight_get_stats(flight_stats_t* stats)
+{
+    stats->frames = __atomic_load_n(&frames_recorded, __ATOMIC_RELAXED);
+    stats->raw_frames = __atomic_load_n(&raw_frames, __ATOMIC_RELAXED);
+    stats->events = __atomic_load_n(&event_head, __ATOMIC_RELAXED);
+    stats->dumps = __atomic_load_n(&dumps, __ATOMIC_RELAXED);
+    stats->ignored = __atomic_load_n(&ignored, __ATOMIC_RELAXED);
+    stats->failed = __atomic_load_n(&failed, __ATOMIC_RELAXED);
+}
+
+/****************************************************************************
+ * Telemetry
+ ****************************************************************************/
+
+/**
+ * @brief Checks whether the events are recorded, in the ring or in the telemetry log.
+ */
+static bool recording(void)
+{
+    return __atomic_load_n(&enabled, __ATOMIC_ACQUIRE) || telemetry_is_open();
+}
+
+/**
+ * @brief Writes an event in the telemetry log, and in the next slot of the ring.
+ *
+ * The slot is invalidated while being written, so that a dump running
+ * at the same time skips it rather than reading a torn event.
+ */
+static void put_event(flight_event_t* event)
+{
+    uint64_t idx = __atomic_fetch_add(&event_head, 1, __ATOMIC_RELAXED);
+    event->seq = idx + 1;
+    telemetry_append(event);
+    if (!__atomic_load_n(&enabled, __ATOMIC_ACQUIRE)) return;
+
+    flight_event_t* slot = &events[idx & (FLIGHT_EVENTS - 1)];
+
+    __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->timestamp_ns = event->timestamp_ns;
+    slot->type = event->type;
+    slot->reserved = 0;
+    memcpy(&slot->u, &event->u, sizeof(slot->u));
+    __atomic_store_n(&slot->seq, idx + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Prepares an event of a given type, at the current time.
+ */
+static void init_event(flight_event_t* event, flight_event_type_t type)
+{
+    memset(event, 0, sizeof(*event));
+    event->timestamp_ns = frame_clock_now();
+    event->type = type;
+}
+
+void flight_record_detections(const detection_t* dets, size_t n, uint64_t frame_id)
+{
+    if (!recording()) return;
+
+    flight_event_t event;
+    init_event(&event, FLIGHT_EVENT_DETECTION);
+    event.u.detection.frame_id = frame_id;
+    event.u.detection.count = (uint32_t)n;
+
+    // A frame without detection is recorded too, losing a target is an event.
+    if (n == 0) put_event(&event);
+    for (size_t i = 0; i < n; i++) {
+        event.u.detection.index = (uint32_t)i;
+        event.u.detection.det = dets[i];
+        put_event(&event);
+    }
+}
+
+void flight_record_command(float x, float y, float vx, float vy, bool velocity)
+{
+    if (!recording()) return;
+
+    flight_event_t event;
+    init_event(&event, FLIGHT_EVENT_COMMAND);
+    event.u.command.velocity = velocity ? 1 : 0;
+    event.u.command.x = x;
+    event.u.command.y = y;
+    event.u.command.vx = vx;
+    event.u.command.vy = vy;
+    put_event(&event);
+}
+
+void flight_record_steps(uint32_t axis, int32_t position, int32_t moved, int32_t emitted, int32_t slip)
+{
+    if (!recording()) return;
+
+    flight_event_t event;
+    init_event(&event, FLIGHT_EVENT_STEPS);
+    event.u.steps.axis = axis;
+    event.u.steps.position = position;
+    event.u.steps.moved = moved;
+    event.u.steps.slip = slip;
+    event.u.steps.emitted = emitted;
+    put_event(&event);
+}
+
+void flight_record_rate(uint32_t axis, float rate, float estimate)
+{
+    if (!recording()) return;
+
+    flight_event_t event;
+    init_event(&event, FLIGHT_EVENT_RATE);
+    event.u.rate.axis = axis;
+    event.u.rate.rate = rate;
+    event.u.rate.estimate = estimate;
+    put_event(&event);
+}
+
+void flight_trigger(flight_trigger_t reason)
+{
+    if (!recording()) return;
+
+    flight_event_t event;
+    init_event(&event, FLIGHT_EVENT_TRIGGER);
+    event.u.trigger.reason = reason;
+    put_event(&event);
+    if (!__atomic_load_n(&enabled, __ATOMIC_ACQUIRE)) return;
+
+    // Triggers coming before the dump share it.
+    uint32_t none = 0;
+    if (__atomic_compare_exchange_n(&pending_reason, &none, (uint32_t)reason, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&pending_ns, event.timestamp_ns, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief Copies the valid events since a given time, oldest first.
+ *
+ * @param[in] from_ns Time of the oldest event to copy [ns].
+ * @return The number of events copied in @c dump_events .
+ */
+static size_t snapshot_events(uint64_t from_ns)
+{
+    uint64_t head = __atomic_load_n(&event_head, __ATOMIC_ACQUIRE);
+    uint64_t first = head > FLIGHT_EVENTS ? head - FLIGHT_EVENTS : 0;
+    size_t count = 0;
+
+    for (uint64_t idx = first; idx < head; idx++) {
+        const flight_event_t* slot = &events[idx & (FLIGHT_EVENTS - 1)];
+        uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq != idx + 1) continue;
+
+        // Skip the events overwritten while being copied.
+        flight_event_t* copy = &dump_events[count];
+        memcpy(copy, slot, sizeof(*copy));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq) continue;
+
+        copy->seq = seq;
+        if (copy->timestamp_ns >= from_ns) count++;
+    }
+    return count;
+}
+
+/****************************************************************************
+ * Frames
+ ****************************************************************************/
+
+/**
+ * @brief Drops the oldest frame of the ring.
+ */
+static void drop_oldest(void)
+{
+    frames_head = (frames_head + 1) % FLIGHT_MAX_FRAMES;
+    frames_count--;
+}
+
+/**
+ * @brief Copies the compressed data of a camera frame in the ring, over the oldest frames.
+ */
+static void keep_frame(const frame_t* frame)
+{
+    size_t padded = (frame->jpeg_size + FRAME_ALIGN - 1) & ~(size_t)(FRAME_ALIGN - 1);
+    size_t len = sizeof(flight_frame_t) + padded;
+    if (frame->jpeg_size == 0 || len > FLIGHT_FRAME_RING_SIZE / 4) {
+        __atomic_add_fetch(&raw_frames, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    // A frame is never split: the end of the ring is left unused, and the
+    // frames kept there become the oldest ones.
+    if (ring_pos + len > FLIGHT_FRAME_RING_SIZE) {
+        while (frames_count > 0 && frames[frames_head].offset >= ring_pos) drop_oldest();
+        ring_pos = 0;
+    }
+
+    // Drop the frames overwritten, the oldest ones being just ahead.
+    while (frames_count > 0) {
+        const ring_frame_t* oldest = &frames[frames_head];
+        bool overlap = oldest->offset < ring_pos + len && ring_pos < oldest->offset + oldest->len;
+        if (!overlap && frames_count < FLIGHT_MAX_FRAMES) break;
+        drop_oldest();
+    }
+
+    flight_frame_t header = {
+        .frame_id = frame->frame_id,
+        .timestamp_ns = frame->timestamp_ns,
+        .width = (uint32_t)frame->width,
+        .height = (uint32_t)frame->height,
+        .size = (uint32_t)frame->jpeg_size,
+        .reserved = 0,
+    };
+    uint8_t* dst = ring + ring_pos;
+    memcpy(dst, &header, sizeof(header));
+    memcpy(dst + sizeof(header), frame->jpeg, frame->jpeg_size);
+    memset(dst + sizeof(header) + frame->jpeg_size, 0, padded - frame->jpeg_size);
+
+    ring_frame_t* kept = &frames[(frames_head + frames_count) % FLIGHT_MAX_FRAMES];
+    kept->offset = ring_pos;
+    kept->len = len;
+    kept->timestamp_ns = frame->timestamp_ns;
+    frames_count++;
+    ring_pos += len;
+
+    __atomic_add_fetch(&frames_recorded, 1, __ATOMIC_RELAXED);
+}
+
+/****************************************************************************
+ * Dumps
+ ****************************************************************************/
+
+/**
+ * @brief Gets the name of a trigger, for the dump files.
+ */
+static const char* trigger_name(uint32_t reason)
+{
+    switch (reason) {
+    case FLIGHT_TRIGGER_API: return "api";
+    case FLIGHT_TRIGGER_SIGNAL: return "signal";
+    case FLIGHT_TRIGGER_MISSED_STEPS: return "missed-steps";
+    default: return "unknown";
+    }
+}
+
+/**
+ * @brief Writes the recording before a trigger to a new file, in a single write.
+ *
+ * @param[in] reason A @c flight_trigger_t .
+ * @param[in] trigger_ns Time of the trigger [ns].
+ */
+static void dump(uint32_t reason, uint64_t trigger_ns)
+{
+    uint64_t window_ns = (uint64_t)FLIGHT_DUMP_SECONDS * 1000000000ULL;
+    uint64_t from_ns = trigger_ns > window_ns ? trigger_ns - window_ns : 0;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t realtime_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+    realtime_ns -= frame_clock_now() - trigger_ns;
+
+    flight_dump_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FLIGHT_MAGIC, sizeof(header.magic));
+    header.version = FLIGHT_VERSION;
+    header.reason = reason;
+    header.trigger_ns = trigger_ns;
+    header.realtime_ns = realtime_ns;
+    header.event_count = snapshot_events(from_ns);
+
+    struct iovec iov[MAX_SPANS + 2];
+    iov[0] = (struct iovec){ &header, sizeof(header) };
+    iov[1] = (struct iovec){ dump_events, header.event_count * sizeof(flight_event_t) };
+    int iovcnt = 2;
+
+    // The frames since the start of the window, by contiguous parts of the ring.
+    for (size_t i = 0; i < frames_count; i++) {
+        const ring_frame_t* kept = &frames[(frames_head + i) % FLIGHT_MAX_FRAMES];
+        if (kept->timestamp_ns < from_ns) continue;
+
+        struct iovec* last = &iov[iovcnt - 1];
+        if (iovcnt > 2 && (uint8_t*)last->iov_base + last->iov_len == ring + kept->offset) {
+            last->iov_len += kept->len;
+        } else if (iovcnt < MAX_SPANS + 2) {
+            iov[iovcnt++] = (struct iovec){ ring + kept->offset, kept->len };
+        } else {
+            break;
+        }
+        header.frame_count++;
+        header.frame_bytes += kept->len;
+    }
+
+    char path[PATH_MAX + 64];
+    snprintf(path, sizeof(path), "%s/flight-%llu-%s.bin", dump_dir,
+             (unsigned long long)(realtime_ns / 1000000ULL), trigger_name(reason));
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) total += iov[i].iov_len;
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    bool ok = fd >= 0 && writev(fd, iov, iovcnt) == (ssize_t)total;
+    if (fd >= 0 && close(fd) < 0) ok = false;
+
+    if (ok) {
+        __atomic_add_fetch(&dumps, 1, __ATOMIC_RELAXED);
+        log_write(LOG_INFO, "Flight recorder dumped to %s: %llu events, %llu frames", path,
+                  (unsigned long long)header.event_count, (unsigned long long)header.frame_count);
+    } else {
+        __atomic_add_fetch(&failed, 1, __ATOMIC_RELAXED);
+        log_write(LOG_ERROR, "Could not write %s: %s", path, strerror(errno));
+    }
+}
+
+void* flight_task(void* arg)
+{
+    log_write(LOG_INFO, "Start flight recorder task");
+
+    // Install signal handler for system signals.
+    psig_install_handler();
+
+    frame_sub_t* sub = frame_bus_subscribe(&cam_bus, "flight", FRAME_BUS_LATEST, 0);
+    if (!sub) {
+        log_write(LOG_ERROR, "Could not subscribe to the camera bus");
+        thread_ready_num++;
+        pthread_exit(NULL);
+    }
+
+    bool dumped = false;
+    uint64_t last_dump_ns = 0;
+
+    // Recording loop that continues until a termination signal is received.
+    while (!psig_kill_requested()) {
+        frame_t* frame = frame_sub_receive(&cam_bus, sub, FLIGHT_WAIT_MS);
+        if (frame) {
+            keep_frame(frame);
+            frame_unref(frame);
+        }
+
+        if (psig_dump_requested()) flight_trigger(FLIGHT_TRIGGER_SIGNAL);
+        uint32_t reason = __atomic_exchange_n(&pending_reason, 0, __ATOMIC_ACQ_REL);
+        if (reason == 0) continue;
+
+        // A fault repeating itself is already in the last dump.
+        uint64_t trigger_ns = __atomic_load_n(&pending_ns, __ATOMIC_ACQUIRE);
+        if (dumped && trigger_ns < last_dump_ns + FLIGHT_COOLDOWN_MS * 1000000ULL) {
+            __atomic_add_fetch(&ignored, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        dump(reason, trigger_ns);
+        dumped = true;
+        last_dump_ns = trigger_ns;
+    }
+
+    frame_bus_unsubscribe(&cam_bus, sub);
+
+    flight_stats_t stats;
+    flight_get_stats(&stats);
+    log_write(LOG_INFO, "Flight recorder: %llu frames, %llu raw, %llu events, %llu dumps, %llu ignored, %llu failed",
+              (unsigned long long)stats.frames, (unsigned long long)stats.raw_frames,
+              (unsigned long long)stats.events, (unsigned long long)stats.dumps,
+              (unsigned long long)stats.ignored, (unsigned long long)stats.failed);
+
+    // Indicate the task is complete.
+    thread_ready_num++;
+    log_write(LOG_INFO, "Stopping flight recorder task");
+    pthread_exit(EXIT_SUCCESS);
+}
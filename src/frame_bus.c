@@ -0,0 +1,230 @@
+/**
+ * @file frame_bus.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c frame_bus.h .
+ *
+ * The publisher only holds the lock of each subscriber for the few
+ * instructions needed to update its pending frames, never while
+ * the subscriber processes a frame.
+ *
+ * @see frame_bus.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "frame_bus.h"
+
+#include <string.h>
+#include <time.h>
+
+/*******************************************************************************
+ * Helper functions
+ ******************************************************************************/
+
+/**
+ * @brief Releases all the pending frames of a subscriber.
+ *
+ * @warning The subscriber mutex must be locked.
+ */
+static void sub_clear(frame_sub_t* sub)
+{
+    while (sub->count > 0) {
+        frame_unref(sub->queue[sub->head]);
+        sub->head = (sub->head + 1) % FRAME_BUS_MAX_DEPTH;
+        sub->count--;
+    }
+}
+
+/**
+ * @brief Appends a frame to the pending frames of a subscriber,
+ * dropping the oldest one if the subscriber is full.
+ *
+ * @warning The subscriber mutex must be locked.
+ */
+static void sub_push(frame_sub_t* sub, frame_t* frame)
+{
+    if (sub->count == sub->depth) {
+        frame_unref(sub->queue[sub->head]);
+        sub->head = (sub->head + 1) % FRAME_BUS_MAX_DEPTH;
+        sub->count--;
+        sub->dropped++;
+    }
+    frame_ref(frame);
+    sub->queue[(sub->head + sub->count) % FRAME_BUS_MAX_DEPTH] = frame;
+    sub->count++;
+}
+
+/**
+ * @brief Gives the number of frames a subscriber can hold at once.
+ */
+static inline uint32_t sub_cost(const frame_sub_t* sub)
+{
+    return sub->depth + 1 + sub->held;
+}
+
+/*******************************************************************************
+ * API functions
+ ******************************************************************************/
+
+void frame_bus_init(frame_bus_t* bus)
+{
+    memset(bus, 0, sizeof(*bus));
+    pthread_mutex_init(&bus->mutex, NULL);
+
+    // Subscribers wait on the monotonic clock.
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    for (int i = 0; i < FRAME_BUS_MAX_SUBSCRIBERS; i++) {
+        pthread_mutex_init(&bus->subs[i].mutex, NULL);
+        pthread_cond_init(&bus->subs[i].cond, &attr);
+    }
+    pthread_condattr_destroy(&attr);
+}
+
+void frame_bus_close(frame_bus_t* bus)
+{
+    __atomic_store_n(&bus->closed, true, __ATOMIC_RELEASE);
+    for (int i = 0; i < FRAME_BUS_MAX_SUBSCRIBERS; i++) {
+        pthread_mutex_lock(&bus->subs[i].mutex);
+        pthread_cond_broadcast(&bus->subs[i].cond);
+        pthread_mutex_unlock(&bus->subs[i].mutex);
+    }
+}
+
+void frame_bus_destroy(frame_bus_t* bus)
+{
+    for (int i = 0; i < FRAME_BUS_MAX_SUBSCRIBERS; i++) {
+        frame_sub_t* sub = &bus->subs[i];
+        pthread_mutex_lock(&sub->mutex);
+        sub_clear(sub);
+        sub->active = false;
+        pthread_mutex_unlock(&sub->mutex);
+        pthread_cond_destroy(&sub->cond);
+        pthread_mutex_destroy(&sub->mutex);
+    }
+    pthread_mutex_destroy(&bus->mutex);
+}
+
+frame_sub_t* frame_bus_subscribe(frame_bus_t* bus, const char* name, frame_bus_policy_t policy, uint32_t param)
+{
+    frame_sub_t* found = NULL;
+    uint32_t depth = 1;
+    if (policy == FRAME_BUS_QUEUE) {
+        depth = param == 0 ? 1 : (param > FRAME_BUS_MAX_DEPTH ? FRAME_BUS_MAX_DEPTH : param);
+    }
+
+    pthread_mutex_lock(&bus->mutex);
+
+    // The pending frames and the one processed must fit in the pool.
+    if (bus->committed + depth + 1 + FRAME_BUS_RESERVED > FRAME_POOL_SIZE) {
+        pthread_mutex_unlock(&bus->mutex);
+        return NULL;
+    }
+
+    for (int i = 0; i < FRAME_BUS_MAX_SUBSCRIBERS && !found; i++) {
+        frame_sub_t* sub = &bus->subs[i];
+        pthread_mutex_lock(&sub->mutex);
+        if (!sub->active) {
+            sub->name = name;
+            sub->policy = policy;
+            sub->depth = depth;
+            sub->nth = policy == FRAME_BUS_EVERY_NTH && param > 0 ? param : 1;
+            sub->held = 0;
+            sub->counter = 0;
+            sub->head = 0;
+            sub->count = 0;
+            sub->delivered = 0;
+            sub->dropped = 0;
+            sub->active = true;
+            bus->committed += sub_cost(sub);
+            found = sub;
+        }
+        pthread_mutex_unlock(&sub->mutex);
+    }
+    pthread_mutex_unlock(&bus->mutex);
+    return found;
+}
+
+bool frame_sub_hold(frame_bus_t* bus, frame_sub_t* sub, uint32_t frames)
+{
+    pthread_mutex_lock(&bus->mutex);
+    uint32_t committed = bus->committed - sub->held + frames;
+    bool fits = committed + FRAME_BUS_RESERVED <= FRAME_POOL_SIZE;
+    if (fits) {
+        bus->committed = committed;
+        sub->held = frames;
+    }
+    pthread_mutex_unlock(&bus->mutex);
+    return fits;
+}
+
+void frame_bus_unsubscribe(frame_bus_t* bus, frame_sub_t* sub)
+{
+    if (!sub) return;
+    pthread_mutex_lock(&bus->mutex);
+    pthread_mutex_lock(&sub->mutex);
+    sub_clear(sub);
+    if (sub->active) bus->committed -= sub_cost(sub);
+    sub->active = false;
+    pthread_mutex_unlock(&sub->mutex);
+    pthread_mutex_unlock(&bus->mutex);
+}
+
+void frame_bus_publish(frame_bus_t* bus, frame_t* frame)
+{
+    for (int i = 0; i < FRAME_BUS_MAX_SUBSCRIBERS; i++) {
+        frame_sub_t* sub = &bus->subs[i];
+        if (!__atomic_load_n(&sub->active, __ATOMIC_ACQUIRE)) continue;
+
+        pthread_mutex_lock(&sub->mutex);
+        if (sub->active && (sub->counter++ % sub->nth) == 0) {
+            sub_push(sub, frame);
+            pthread_cond_signal(&sub->cond);
+        }
+        pthread_mutex_unlock(&sub->mutex);
+    }
+}
+
+frame_t* frame_sub_receive(frame_bus_t* bus, frame_sub_t* sub, uint32_t timeout_ms)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    frame_t* frame = NULL;
+    pthread_mutex_lock(&sub->mutex);
+    while (sub->count == 0 && timeout_ms > 0 && !__atomic_load_n(&bus->closed, __ATOMIC_ACQUIRE)) {
+        if (pthread_cond_timedwait(&sub->cond, &sub->mutex, &deadline) != 0) break;
+    }
+    if (sub->count > 0) {
+        frame = sub->queue[sub->head];
+        sub->head = (sub->head + 1) % FRAME_BUS_MAX_DEPTH;
+        sub->count--;
+        sub->delivered++;
+    }
+    pthread_mutex_unlock(&sub->mutex);
+    return frame;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file frame_clock.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c frame_clock.h .
+ *
+ * @see frame_clock.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "frame_clock.h"
+
+#include <time.h>
+
+/**
+ * @brief Capture time of a frame.
+ */
+typedef struct {
+    uint64_t frame_id;      // 0 while the entry is written.
+    uint64_t timestamp_ns;
+} frame_clock_entry_t;
+
+static frame_clock_entry_t entries[FRAME_CLOCK_SIZE];
+
+void frame_clock_record(uint64_t frame_id, uint64_t timestamp_ns)
+{
+    frame_clock_entry_t* e = &entries[frame_id % FRAME_CLOCK_SIZE];
+
+    // Invalidate the entry while the time is written.
+    __atomic_store_n(&e->frame_id, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&e->timestamp_ns, timestamp_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->frame_id, frame_id, __ATOMIC_RELEASE);
+}
+
+uint64_t frame_clock_lookup(uint64_t frame_id)
+{
+    if (frame_id == 0) return 0;
+
+    frame_clock_entry_t* e = &entries[frame_id % FRAME_CLOCK_SIZE];
+
+    // Read the time, then check the entry still describes the frame.
+    if (__atomic_load_n(&e->frame_id, __ATOMIC_ACQUIRE) != frame_id) return 0;
+    uint64_t timestamp_ns = __atomic_load_n(&e->timestamp_ns, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&e->frame_id, __ATOMIC_RELAXED) != frame_id) return 0;
+
+    return timestamp_ns;
+}
+
+uint64_t frame_clock_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
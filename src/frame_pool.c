@@ -0,0 +1,219 @@
+/**
+ * @file frame_pool.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c frame_pool.h .
+ *
+ * @see frame_pool.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "frame_pool.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static frame_t frames[FRAME_POOL_SIZE];
+static uint8_t* pool_memory = NULL;
+static size_t pool_stride = 0;
+
+// Compressed data of the frames, always private to the process.
+static uint8_t* jpeg_memory = NULL;
+
+// Name of the shared memory object holding the buffers, NULL if private.
+static const char* pool_shm_name = NULL;
+
+// Statistics, updated with atomic built-ins.
+static uint32_t in_use = 0;
+static uint32_t peak_in_use = 0;
+static uint64_t acquired = 0;
+static uint64_t exhausted = 0;
+
+/**
+ * @brief Allocates the compressed buffers, touches the pool memory and
+ *        assigns the buffers to the frames.
+ *
+ * A compressed frame is never larger than its pixels, so that both
+ * buffers have the same size.
+ */
+static int pool_setup(size_t buffer_size)
+{
+    jpeg_memory = aligned_alloc(FRAME_POOL_ALIGN, pool_stride * FRAME_POOL_SIZE);
+    if (!jpeg_memory) {
+        perror("[Error] Could not allocate the compressed frame buffers");
+        return EXIT_FAILURE;
+    }
+
+    // Touch the memory now rather than on the first frames.
+    memset(pool_memory, 0, pool_stride * FRAME_POOL_SIZE);
+    memset(jpeg_memory, 0, pool_stride * FRAME_POOL_SIZE);
+
+    for (int i = 0; i < FRAME_POOL_SIZE; i++) {
+        memset(&frames[i], 0, sizeof(frame_t));
+        frames[i].data = pool_memory + i * pool_stride;
+        frames[i].capacity = buffer_size;
+        frames[i].jpeg = jpeg_memory + i * pool_stride;
+        frames[i].jpeg_capacity = buffer_size;
+    }
+    return EXIT_SUCCESS;
+}
+
+int frame_pool_init(size_t buffer_size)
+{
+    if (pool_memory) return EXIT_SUCCESS;
+
+    // Round each buffer up to a whole number of cache lines.
+    pool_stride = (buffer_size + FRAME_POOL_ALIGN - 1) & ~(size_t)(FRAME_POOL_ALIGN - 1);
+    pool_memory = aligned_alloc(FRAME_POOL_ALIGN, pool_stride * FRAME_POOL_SIZE);
+    if (!pool_memory) {
+        perror("[Error] Could not allocate the frame pool");
+        return EXIT_FAILURE;
+    }
+
+    if (pool_setup(buffer_size) == EXIT_FAILURE) {
+        free(pool_memory);
+        pool_memory = NULL;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int frame_pool_init_shared(size_t buffer_size, const char* shm_name)
+{
+    if (pool_memory) return EXIT_SUCCESS;
+
+    pool_stride = (buffer_size + FRAME_POOL_ALIGN - 1) & ~(size_t)(FRAME_POOL_ALIGN - 1);
+    size_t bytes = pool_stride * FRAME_POOL_SIZE;
+
+    int fd = shm_open(shm_name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        perror("[Error] Could not create the frame pool shared memory");
+        return EXIT_FAILURE;
+    }
+    if (ftruncate(fd, (off_t)bytes) < 0) {
+        perror("[Error] Could not size the frame pool shared memory");
+        close(fd);
+        shm_unlink(shm_name);
+        return EXIT_FAILURE;
+    }
+
+    // Mappings are page aligned, hence cache line aligned.
+    void* memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        perror("[Error] Could not map the frame pool shared memory");
+        shm_unlink(shm_name);
+        return EXIT_FAILURE;
+    }
+
+    pool_memory = memory;
+    pool_shm_name = shm_name;
+    if (pool_setup(buffer_size) == EXIT_FAILURE) {
+        frame_pool_close();
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+void frame_pool_close(void)
+{
+    if (pool_shm_name) {
+        munmap(pool_memory, pool_stride * FRAME_POOL_SIZE);
+        shm_unlink(pool_shm_name);
+        pool_shm_name = NULL;
+    } else {
+        free(pool_memory);
+    }
+    pool_memory = NULL;
+    free(jpeg_memory);
+    jpeg_memory = NULL;
+}
+
+frame_t* frame_pool_acquire(void)
+{
+    for (int i = 0; i < FRAME_POOL_SIZE; i++) {
+        uint32_t expected = 0;
+        if (__atomic_load_n(&frames[i].refcount, __ATOMIC_RELAXED) == 0 &&
+            __atomic_compare_exchange_n(&frames[i].refcount, &expected, 1, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            frame_t* frame = &frames[i];
+            frame->size = 0;
+            frame->jpeg_size = 0;
+            frame->width = 0;
+            frame->height = 0;
+            frame->frame_id = 0;
+            frame->timestamp_ns = 0;
+
+            uint32_t used = __atomic_add_fetch(&in_use, 1, __ATOMIC_RELAXED);
+            uint32_t peak = __atomic_load_n(&peak_in_use, __ATOMIC_RELAXED);
+            while (used > peak &&
+                   !__atomic_compare_exchange_n(&peak_in_use, &peak, used, true,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+            __atomic_add_fetch(&acquired, 1, __ATOMIC_RELAXED);
+            return frame;
+        }
+    }
+    __atomic_add_fetch(&exhausted, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+void frame_ref(frame_t* frame)
+{
+    __atomic_add_fetch(&frame->refcount, 1, __ATOMIC_RELAXED);
+}
+
+void frame_unref(frame_t* frame)
+{
+    if (!frame) return;
+    if (__atomic_sub_fetch(&frame->refcount, 1, __ATOMIC_RELEASE) == 0) {
+        __atomic_sub_fetch(&in_use, 1, __ATOMIC_RELAXED);
+    }
+}
+
+frame_t* frame_pool_find(const uint8_t* data)
+{
+    if (!pool_memory || data < pool_memory) return NULL;
+    size_t idx = (size_t)(data - pool_memory) / pool_stride;
+    if (idx >= FRAME_POOL_SIZE || frames[idx].data != data) return NULL;
+    return &frames[idx];
+}
+
+size_t frame_pool_offset(const frame_t* frame)
+{
+    return (size_t)(frame->data - pool_memory);
+}
+
+size_t frame_pool_bytes(void)
+{
+    return pool_stride * FRAME_POOL_SIZE;
+}
+
+void frame_pool_get_stats(frame_pool_stats_t* stats)
+{
+    stats->size = FRAME_POOL_SIZE;
+    stats->in_use = __atomic_load_n(&in_use, __ATOMIC_RELAXED);
+    stats->peak_in_use = __atomic_load_n(&peak_in_use, __ATOMIC_RELAXED);
+    stats->acquired = __atomic_load_n(&acquired, __ATOMIC_RELAXED);
+    stats->exhausted = __atomic_load_n(&exhausted, __ATOMIC_RELAXED);
+}
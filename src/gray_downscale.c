@@ -0,0 +1,124 @@
+/**
+ * @file gray_downscale.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c gray_downscale.h .
+ *
+ * @see gray_downscale.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gray_downscale.h"
+
+#include <string.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+
+/**
+ * @brief Adds the weighted channels (B + 2G + R) of 16 BGR pixels.
+ */
+static inline void add_luma(uint8x16x3_t p, uint16x8_t* lo, uint16x8_t* hi)
+{
+    *lo = vaddq_u16(*lo, vaddq_u16(vaddl_u8(vget_low_u8(p.val[0]), vget_low_u8(p.val[2])),
+                                   vshll_n_u8(vget_low_u8(p.val[1]), 1)));
+    *hi = vaddq_u16(*hi, vaddq_u16(vaddl_u8(vget_high_u8(p.val[0]), vget_high_u8(p.val[2])),
+                                   vshll_n_u8(vget_high_u8(p.val[1]), 1)));
+}
+
+/**
+ * @brief Downscales the pixels of a row of 2x2 blocks, 8 output pixels at once.
+ *
+ * @return The number of output pixels written.
+ */
+static int downscale_2(const uint8_t* rows, size_t stride, int dw, uint8_t* out)
+{
+    int x = 0;
+    // 16 pixels of both rows give 8 output pixels.
+    for (; x + 8 <= dw; x += 8) {
+        uint16x8_t lo = vdupq_n_u16(0);
+        uint16x8_t hi = vdupq_n_u16(0);
+        add_luma(vld3q_u8(rows + (size_t)x * 6), &lo, &hi);
+        add_luma(vld3q_u8(rows + stride + (size_t)x * 6), &lo, &hi);
+        uint16x8_t sum = vcombine_u16(vpadd_u16(vget_low_u16(lo), vget_high_u16(lo)),
+                                      vpadd_u16(vget_low_u16(hi), vget_high_u16(hi)));
+        vst1_u8(out + x, vshrn_n_u16(sum, 4));
+    }
+    return x;
+}
+
+/**
+ * @brief Downscales the pixels of a row of 4x4 blocks, 4 output pixels at once.
+ *
+ * @return The number of output pixels written.
+ */
+static int downscale_4(const uint8_t* rows, size_t stride, int dw, uint8_t* out)
+{
+    int x = 0;
+    // 16 pixels of the 4 rows give 4 output pixels.
+    for (; x + 4 <= dw; x += 4) {
+        uint16x8_t lo = vdupq_n_u16(0);
+        uint16x8_t hi = vdupq_n_u16(0);
+        for (int r = 0; r < 4; r++) {
+            add_luma(vld3q_u8(rows + (size_t)r * stride + (size_t)x * 12), &lo, &hi);
+        }
+        uint16x4_t pairs_lo = vpadd_u16(vget_low_u16(lo), vget_high_u16(lo));
+        uint16x4_t pairs_hi = vpadd_u16(vget_low_u16(hi), vget_high_u16(hi));
+        uint16x4_t sum = vpadd_u16(pairs_lo, pairs_hi);
+        uint8_t px[8];
+        vst1_u8(px, vshrn_n_u16(vcombine_u16(sum, sum), 6));
+        memcpy(out + x, px, 4);
+    }
+    return x;
+}
+#endif
+
+void gray_downscale(const uint8_t* src, int width, int height, int scale, uint8_t* dst)
+{
+    const int dw = width / scale;
+    const int dh = height / scale;
+    const size_t stride = (size_t)width * 3;
+    const uint32_t weight = (uint32_t)(scale * scale * 4);
+
+    for (int y = 0; y < dh; y++) {
+        const uint8_t* rows = src + (size_t)(scale * y) * stride;
+        uint8_t* out = dst + (size_t)y * dw;
+        int x = 0;
+
+#if defined(__ARM_NEON)
+        if (scale == 2) {
+            x = downscale_2(rows, stride, dw, out);
+        } else if (scale == 4) {
+            x = downscale_4(rows, stride, dw, out);
+        }
+#endif
+
+        for (; x < dw; x++) {
+            uint32_t sum = 0;
+            for (int r = 0; r < scale; r++) {
+                const uint8_t* p = rows + (size_t)r * stride + (size_t)x * scale * 3;
+                for (int c = 0; c < scale; c++, p += 3) {
+                    sum += p[0] + 2 * p[1] + p[2];
+                }
+            }
+            out[x] = (uint8_t)(sum / weight);
+        }
+    }
+}
@@ -6,13 +6,6 @@
  *
  * @see ipc_elements.h
  *
- * @note Uncomment statements commented with two pairs of dashes // ... //
- * to run the thread that displays inference results on screen.
- * Also modify ipc_elements.h, c_interface.cpp and yolov8n_inference.py
- * accordingly.
- *
- * @todo provide an easy way to display the results or not.
- *
  * @see display_result.h and display_result.cpp
  * @see ipc_elements.h and ipc_elements.cpp
  * @see yolov8n_inference.py
@@ -42,18 +35,21 @@
 // Counter for the number of threads that are ready.
 volatile uint8_t thread_ready_num = 0;
 
+// Number of threads to wait for.
+volatile uint8_t thread_number = THREAD_NUMBER;
+
 // Mutexes and semaphores.
 sem_t data_x_ready_sem;
 sem_t data_y_ready_sem;
 sem_t data_x_done_sem;
 sem_t data_y_done_sem;
-pthread_mutex_t cam_buffer_mutex;
-pthread_mutex_t disp_buffer_mutex;
+
+// Frame buses.
+frame_bus_t cam_bus;
 
 void ipc_init(void)
 {
-    pthread_mutex_init(&cam_buffer_mutex, NULL);
-    //pthread_mutex_init(&disp_buffer_mutex, NULL);//
+    frame_bus_init(&cam_bus);
     sem_init(&data_x_ready_sem, 0, 0);
     sem_init(&data_y_ready_sem, 0, 0);
     sem_init(&data_x_done_sem, 0, 0);
@@ -62,7 +58,7 @@ void ipc_init(void)
 
 void ipc_release(void)
 {
-    while (thread_ready_num < THREAD_NUMBER) {
+    while (thread_ready_num < thread_number) {
         sem_post(&data_x_ready_sem);
         sem_post(&data_y_ready_sem);
         sem_post(&data_x_done_sem);
@@ -72,8 +68,7 @@ void ipc_release(void)
 
 void ipc_close(void)
 {
-	pthread_mutex_destroy(&cam_buffer_mutex);
-    //pthread_mutex_destroy(&disp_buffer_mutex);//
+    frame_bus_destroy(&cam_bus);
     sem_destroy(&data_x_ready_sem);
     sem_destroy(&data_y_ready_sem);
     sem_destroy(&data_x_done_sem);
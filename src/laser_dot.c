@@ -0,0 +1,164 @@
+/**
+ * @file laser_dot.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c laser_dot.h .
+ *
+ * @see laser_dot.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "laser_dot.h"
+
+#include <string.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Number of blocks of a camera frame.
+#define MAX_BLOCKS_X (FRAME_WIDTH / LASER_DOT_BLOCK)
+#define MAX_BLOCKS_Y (FRAME_HEIGHT / LASER_DOT_BLOCK)
+
+/**
+ * @brief Checks if a BGR pixel is bright red.
+ */
+static inline bool is_dot_pixel(const uint8_t* px)
+{
+    int b = px[0], g = px[1], r = px[2];
+    return r >= LASER_DOT_MIN_RED && r - g >= LASER_DOT_MIN_EXCESS && r - b >= LASER_DOT_MIN_EXCESS;
+}
+
+/**
+ * @brief Counts the bright red pixels of a row, and sums their X-offsets.
+ *
+ * @param[in] row The first pixel of the row (BGR).
+ * @param[in] n Number of pixels.
+ * @param[out] sum_x Sum of the offsets of the bright red pixels from @p row [px].
+ * @return The number of bright red pixels.
+ */
+static uint32_t scan_row(const uint8_t* row, int n, uint32_t* sum_x)
+{
+    uint32_t count = 0;
+    uint32_t sx = 0;
+    int i = 0;
+
+#if defined(__ARM_NEON)
+    // 16 pixels at once: threshold mask, then masked lane counts and offsets.
+    static const uint8_t lanes[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+    const uint8x16_t min_red = vdupq_n_u8(LASER_DOT_MIN_RED);
+    const uint8x16_t min_excess = vdupq_n_u8(LASER_DOT_MIN_EXCESS);
+    const uint16x8_t step = vdupq_n_u16(16);
+    uint16x8_t idx_lo = vmovl_u8(vld1_u8(lanes));
+    uint16x8_t idx_hi = vmovl_u8(vld1_u8(lanes + 8));
+    uint16x8_t cnt = vdupq_n_u16(0);
+    uint32x4_t sum = vdupq_n_u32(0);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x3_t px = vld3q_u8(row + (size_t)i * 3);
+        uint8x16_t m = vandq_u8(vcgeq_u8(px.val[2], min_red),
+                                vandq_u8(vcgeq_u8(vqsubq_u8(px.val[2], px.val[1]), min_excess),
+                                         vcgeq_u8(vqsubq_u8(px.val[2], px.val[0]), min_excess)));
+        cnt = vpadalq_u8(cnt, vshrq_n_u8(m, 7));
+        // Widen the 0xFF mask lanes to 0xFFFF by sign extension.
+        uint16x8_t m_lo = vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(vget_low_u8(m))));
+        uint16x8_t m_hi = vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(vget_high_u8(m))));
+        sum = vpadalq_u16(sum, vandq_u16(idx_lo, m_lo));
+        sum = vpadalq_u16(sum, vandq_u16(idx_hi, m_hi));
+        idx_lo = vaddq_u16(idx_lo, step);
+        idx_hi = vaddq_u16(idx_hi, step);
+    }
+    uint32x4_t cnt32 = vpaddlq_u16(cnt);
+    uint32x2_t c2 = vpadd_u32(vget_low_u32(cnt32), vget_high_u32(cnt32));
+    uint32x2_t s2 = vpadd_u32(vget_low_u32(sum), vget_high_u32(sum));
+    count = vget_lane_u32(c2, 0) + vget_lane_u32(c2, 1);
+    sx = vget_lane_u32(s2, 0) + vget_lane_u32(s2, 1);
+#endif
+
+    for (; i < n; i++) {
+        if (is_dot_pixel(row + (size_t)i * 3)) {
+            count++;
+            sx += (uint32_t)i;
+        }
+    }
+    *sum_x = sx;
+    return count;
+}
+
+bool laser_dot_find_roi(const frame_t* frame, int x, int y, int w, int h, laser_dot_t* dot)
+{
+    // Clip the region to the frame.
+    int x1 = x + w;
+    int y1 = y + h;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x1 > frame->width) x1 = frame->width;
+    if (y1 > frame->height) y1 = frame->height;
+    if (x >= x1 || y >= y1) return false;
+
+    // Sums of the coordinates of the bright red pixels.
+    const size_t stride = (size_t)frame->width * 3;
+    uint64_t count = 0, sum_x = 0, sum_y = 0;
+    for (int j = y; j < y1; j++) {
+        uint32_t row_x;
+        uint32_t n = scan_row(frame->data + (size_t)j * stride + (size_t)x * 3, x1 - x, &row_x);
+        count += n;
+        sum_x += row_x + (uint64_t)n * x;
+        sum_y += (uint64_t)n * j;
+    }
+
+    if (count < LASER_DOT_MIN_PIXELS) return false;
+    dot->x = (float)sum_x / count;
+    dot->y = (float)sum_y / count;
+    dot->pixels = (uint32_t)count;
+    return true;
+}
+
+bool laser_dot_find(const frame_t* frame, laser_dot_t* dot)
+{
+    const int bw = frame->width / LASER_DOT_BLOCK;
+    const int bh = frame->height / LASER_DOT_BLOCK;
+    if (bw <= 0 || bh <= 0 || bw > MAX_BLOCKS_X || bh > MAX_BLOCKS_Y) return false;
+
+    // Count the bright red pixels of each block.
+    uint32_t counts[MAX_BLOCKS_X * MAX_BLOCKS_Y];
+    memset(counts, 0, sizeof(uint32_t) * (size_t)bw * bh);
+    const size_t stride = (size_t)frame->width * 3;
+    for (int j = 0; j < bh * LASER_DOT_BLOCK; j++) {
+        const uint8_t* row = frame->data + (size_t)j * stride;
+        uint32_t* line = counts + (size_t)(j / LASER_DOT_BLOCK) * bw;
+        for (int b = 0; b < bw; b++) {
+            uint32_t unused;
+            line[b] += scan_row(row + (size_t)b * LASER_DOT_BLOCK * 3, LASER_DOT_BLOCK, &unused);
+        }
+    }
+
+    // Block holding the most bright red pixels.
+    size_t best = 0;
+    for (size_t k = 1; k < (size_t)bw * bh; k++) {
+        if (counts[k] > counts[best]) best = k;
+    }
+    if (counts[best] == 0) return false;
+
+    // Centroid over the block and its neighbors, the dot possibly lying across blocks.
+    int bx = (int)(best % bw);
+    int by = (int)(best / bw);
+    return laser_dot_find_roi(frame, (bx - 1) * LASER_DOT_BLOCK, (by - 1) * LASER_DOT_BLOCK,
+                              3 * LASER_DOT_BLOCK, 3 * LASER_DOT_BLOCK, dot);
+}
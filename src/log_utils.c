@@ -0,0 +1,489 @@
+/**
+ * @file log_utils.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c log_utils.h .
+ *
+ * Each thread gets its own single-producer/single-consumer ring on its first
+ * log call. The background thread is the only consumer of all the rings:
+ * it merges the pending records by timestamp, formats them in a local buffer
+ * and writes the buffer with a single call.
+ *
+ * @see log_utils.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "log_utils.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define LOG_FLUSH_PERIOD_NS 5000000L    ///< Sleep time of the background thread when idle [ns].
+#define LOG_OUT_BUFFER_SIZE 8192        ///< Size of the formatting buffer [bytes].
+
+/// Storage for one argument of a record.
+typedef union {
+    long long i;
+    unsigned long long u;
+    double f;
+    const void* p;
+} log_arg_t;
+
+/// Binary log record, written by the producer and formatted by the consumer.
+typedef struct {
+    uint64_t timestamp_ns;      ///< Time of the call (@c CLOCK_MONOTONIC ) [ns].
+    const char* fmt;            ///< Format string, used as format identifier.
+    uint8_t level;              ///< Level of the record.
+    uint8_t n_args;             ///< Number of valid arguments.
+    log_arg_t args[LOG_MAX_ARGS];
+    char strings[LOG_STRING_SIZE];  ///< Copies of the string arguments, pointed to by their arguments.
+} log_record_t;
+
+/// Single-producer/single-consumer ring owned by a thread.
+typedef struct {
+    _Alignas(64) atomic_size_t head;    ///< Next slot to write (producer).
+    _Alignas(64) atomic_size_t tail;    ///< Next slot to read (consumer).
+    _Alignas(64) atomic_uint_fast64_t dropped;
+    log_record_t records[LOG_RING_SIZE];
+} log_ring_t;
+
+/// Kind of argument expected by a conversion specification.
+typedef enum {
+    ARG_NONE,
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_SIZE,
+    ARG_UINT,
+    ARG_ULONG,
+    ARG_ULLONG,
+    ARG_DOUBLE,
+    ARG_STR,
+    ARG_PTR
+} log_arg_kind_t;
+
+static log_ring_t* rings[LOG_MAX_THREADS];
+static atomic_uint ring_count = 0;
+static atomic_uint_fast64_t unregistered_dropped = 0;
+static atomic_int log_level = LOG_INFO;
+static atomic_bool log_running = false;
+static pthread_t log_thread;
+static _Thread_local log_ring_t* tls_ring = NULL;
+
+static const char* level_prefix[] = { "[Debug] ", "[Info] ", "[Warning] ", "[Error] " };
+
+/*******************************************************************************
+ * Helper functions
+ ******************************************************************************/
+
+/**
+ * @brief Parses the next conversion specification of a format string.
+ *
+ * @param[in] fmt Pointer to the remaining part of the format string.
+ * @param[out] spec_start Start of the specification (on its @c % ), or
+ *             @c NULL if there is none left.
+ * @param[out] spec_end One past the conversion character.
+ * @return The kind of argument consumed by the specification.
+ */
+static log_arg_kind_t next_spec(const char* fmt, const char** spec_start, const char** spec_end)
+{
+    const char* c = fmt;
+    while (*c) {
+        if (*c != '%') {
+            c++;
+            continue;
+        }
+        if (c[1] == '%') {
+            c += 2;
+            continue;
+        }
+
+        *spec_start = c++;
+
+        // Skip flags, width and precision.
+        while (*c && strchr("-+ #0123456789.", *c)) c++;
+
+        // Length modifiers.
+        int longs = 0;
+        bool size = false;
+        while (*c && strchr("hlLqjzt", *c)) {
+            if (*c == 'l' || *c == 'q' || *c == 'j' || *c == 'L') longs++;
+            if (*c == 'z' || *c == 't') size = true;
+            c++;
+        }
+        if (*c == '\0') break;
+        *spec_end = c + 1;
+
+        switch (*c) {
+        case 'd': case 'i': case 'c':
+            if (size) return ARG_SIZE;
+            return longs == 0 ? ARG_INT : (longs == 1 ? ARG_LONG : ARG_LLONG);
+        case 'u': case 'x': case 'X': case 'o':
+            if (size) return ARG_SIZE;
+            return longs == 0 ? ARG_UINT : (longs == 1 ? ARG_ULONG : ARG_ULLONG);
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            return ARG_DOUBLE;
+        case 's':
+            return ARG_STR;
+        case 'p':
+            return ARG_PTR;
+        default:
+            return ARG_NONE;
+        }
+    }
+    *spec_start = NULL;
+    return ARG_NONE;
+}
+
+/**
+ * @brief Copies the literal text of a format string, with @c %% escapes.
+ *
+ * @param[in] text Start of the literal text.
+ * @param[in] end End of the literal text.
+ * @param[out] out The text buffer.
+ * @param[in] size The remaining size of the buffer.
+ * @return The number of characters copied.
+ */
+static size_t copy_literal(const char* text, const char* end, char* out, size_t size)
+{
+    size_t len = 0;
+    while (text < end && len + 1 < size) {
+        if (text[0] == '%' && text + 1 < end && text[1] == '%') text++;
+        out[len++] = *text++;
+    }
+    if (size > 0) out[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief Copies a string argument into the string area of a record.
+ *
+ * The copy is truncated to the space left, an empty string once full.
+ *
+ * @param[in] str The string, can be @c NULL .
+ * @param[out] strings The string area of the record, of @c LOG_STRING_SIZE bytes.
+ * @param[in,out] used The bytes of the area already used.
+ * @return The copy.
+ */
+static const char* copy_string(const char* str, char* strings, size_t* used)
+{
+    if (!str) str = "(null)";
+    if (*used >= LOG_STRING_SIZE) return "";
+    char* copy = strings + *used;
+    size_t len = strnlen(str, LOG_STRING_SIZE - *used - 1);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    *used += len + 1;
+    return copy;
+}
+
+/**
+ * @brief Gets the current time [ns].
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Formats a record and appends it to a text buffer.
+ *
+ * @param[in] rec The record to format.
+ * @param[in,out] out The text buffer.
+ * @param[in] size The remaining size of the buffer.
+ * @return The number of characters appended.
+ */
+static size_t format_record(const log_record_t* rec, char* out, size_t size)
+{
+    size_t len = 0;
+    int n = snprintf(out, size, "%s", level_prefix[rec->level]);
+    if (n > 0) len += (size_t)n;
+
+    const char* seg = rec->fmt;
+    const char* spec_start;
+    const char* spec_end;
+    uint8_t arg = 0;
+    char spec[32];
+
+    // Format the string one conversion specification at a time.
+    while (len < size) {
+        log_arg_kind_t kind = next_spec(seg, &spec_start, &spec_end);
+        if (!spec_start) {
+            n = snprintf(out + len, size - len, seg, 0);
+            if (n > 0) len += (size_t)n;
+            break;
+        }
+        if (arg >= rec->n_args) {
+            // Arguments beyond LOG_MAX_ARGS were not stored: print the rest as is.
+            n = snprintf(out + len, size - len, "%s", seg);
+            if (n > 0) len += (size_t)n;
+            break;
+        }
+
+        // Copy the literal text preceding the specification, then format the specification alone.
+        len += copy_literal(seg, spec_start, out + len, size - len);
+        size_t spec_len = (size_t)(spec_end - spec_start);
+        if (spec_len >= sizeof(spec)) spec_len = sizeof(spec) - 1;
+        memcpy(spec, spec_start, spec_len);
+        spec[spec_len] = '\0';
+
+        const log_arg_t* a = &rec->args[arg++];
+        switch (kind) {
+        case ARG_INT:    n = snprintf(out + len, size - len, spec, (int)a->i); break;
+        case ARG_LONG:   n = snprintf(out + len, size - len, spec, (long)a->i); break;
+        case ARG_LLONG:  n = snprintf(out + len, size - len, spec, a->i); break;
+        case ARG_SIZE:   n = snprintf(out + len, size - len, spec, (size_t)a->u); break;
+        case ARG_UINT:   n = snprintf(out + len, size - len, spec, (unsigned int)a->u); break;
+        case ARG_ULONG:  n = snprintf(out + len, size - len, spec, (unsigned long)a->u); break;
+        case ARG_ULLONG: n = snprintf(out + len, size - len, spec, a->u); break;
+        case ARG_DOUBLE: n = snprintf(out + len, size - len, spec, a->f); break;
+        case ARG_STR:    n = snprintf(out + len, size - len, spec, (const char*)a->p); break;
+        case ARG_PTR:    n = snprintf(out + len, size - len, spec, a->p); break;
+        default:         n = snprintf(out + len, size - len, "%s", spec); break;
+        }
+        if (n > 0) len += (size_t)n;
+        seg = spec_end;
+    }
+
+    if (len >= size) len = size - 1;
+    out[len++] = '\n';
+    return len;
+}
+
+/**
+ * @brief Gets the ring of the calling thread, creating it on first use.
+ *
+ * @return The ring, or @c NULL if too many threads already own one.
+ */
+static log_ring_t* get_ring(void)
+{
+    if (tls_ring) return tls_ring;
+
+    unsigned int idx = atomic_fetch_add(&ring_count, 1);
+    if (idx >= LOG_MAX_THREADS) {
+        atomic_fetch_sub(&ring_count, 1);
+        return NULL;
+    }
+
+    log_ring_t* ring = aligned_alloc(64, sizeof(log_ring_t));
+    if (!ring) return NULL;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->dropped, 0);
+
+    // Publish the ring only once initialized.
+    __atomic_store_n(&rings[idx], ring, __ATOMIC_RELEASE);
+    tls_ring = ring;
+    return ring;
+}
+
+/**
+ * @brief Writes all the pending records, ordered by timestamp.
+ *
+ * @return @c true if at least one record has been written.
+ */
+static bool flush_rings(void)
+{
+    static char out[LOG_OUT_BUFFER_SIZE];
+    size_t len = 0;
+    bool flushed = false;
+    unsigned int count = atomic_load(&ring_count);
+    if (count > LOG_MAX_THREADS) count = LOG_MAX_THREADS;
+
+    for (;;) {
+        // Pick the oldest pending record among all rings.
+        log_ring_t* oldest = NULL;
+        uint64_t oldest_ts = UINT64_MAX;
+        for (unsigned int i = 0; i < count; i++) {
+            log_ring_t* ring = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+            if (!ring) continue;
+            size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+            size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+            if (tail == head) continue;
+            uint64_t ts = ring->records[tail % LOG_RING_SIZE].timestamp_ns;
+            if (ts < oldest_ts) {
+                oldest_ts = ts;
+                oldest = ring;
+            }
+        }
+        if (!oldest) break;
+
+        // Write the buffer once it may not hold another record.
+        if (LOG_OUT_BUFFER_SIZE - len < 512) {
+            fwrite(out, 1, len, stdout);
+            len = 0;
+        }
+
+        size_t tail = atomic_load_explicit(&oldest->tail, memory_order_relaxed);
+        len += format_record(&oldest->records[tail % LOG_RING_SIZE], out + len, 512);
+        atomic_store_explicit(&oldest->tail, tail + 1, memory_order_release);
+        flushed = true;
+    }
+
+    if (len > 0) {
+        fwrite(out, 1, len, stdout);
+        fflush(stdout);
+    }
+    return flushed;
+}
+
+/**
+ * @brief Background thread body, formatting and writing records.
+ */
+static void* log_task(void* arg)
+{
+    (void)arg;
+    struct timespec idle = { 0, LOG_FLUSH_PERIOD_NS };
+    while (atomic_load(&log_running)) {
+        if (!flush_rings()) {
+            nanosleep(&idle, NULL);
+        }
+    }
+    flush_rings();
+    return NULL;
+}
+
+/*******************************************************************************
+ * API functions
+ ******************************************************************************/
+
+int log_init(void)
+{
+    if (atomic_load(&log_running)) return EXIT_SUCCESS;
+
+    atomic_store(&log_running, true);
+    if (pthread_create(&log_thread, NULL, log_task, NULL) != 0) {
+        atomic_store(&log_running, false);
+        fprintf(stderr, "[Error] Could not create task for logging\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+void log_close(void)
+{
+    if (!atomic_exchange(&log_running, false)) return;
+    pthread_join(log_thread, NULL);
+
+    uint64_t dropped = log_dropped();
+    if (dropped > 0) {
+        printf("[Warning] %llu log records dropped\n", (unsigned long long)dropped);
+    }
+}
+
+void log_set_level(log_level_t level)
+{
+    atomic_store_explicit(&log_level, level, memory_order_relaxed);
+}
+
+log_level_t log_get_level(void)
+{
+    return (log_level_t)atomic_load_explicit(&log_level, memory_order_relaxed);
+}
+
+uint64_t log_dropped(void)
+{
+    uint64_t dropped = atomic_load(&unregistered_dropped);
+    unsigned int count = atomic_load(&ring_count);
+    if (count > LOG_MAX_THREADS) count = LOG_MAX_THREADS;
+    for (unsigned int i = 0; i < count; i++) {
+        log_ring_t* ring = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+        if (ring) dropped += atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    }
+    return dropped;
+}
+
+void log_write(log_level_t level, const char* fmt, ...)
+{
+    // Runtime level filtering.
+    if ((int)level < atomic_load_explicit(&log_level, memory_order_relaxed)) return;
+
+    va_list ap;
+
+    // Without background thread, just print the message.
+    if (!atomic_load_explicit(&log_running, memory_order_relaxed)) {
+        va_start(ap, fmt);
+        fputs(level_prefix[level], stdout);
+        vprintf(fmt, ap);
+        putchar('\n');
+        va_end(ap);
+        return;
+    }
+
+    log_ring_t* ring = get_ring();
+    if (!ring) {
+        atomic_fetch_add_explicit(&unregistered_dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    // Reserve a slot, or drop the record if the ring is full.
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= LOG_RING_SIZE) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    log_record_t* rec = &ring->records[head % LOG_RING_SIZE];
+    rec->timestamp_ns = now_ns();
+    rec->fmt = fmt;
+    rec->level = (uint8_t)level;
+
+    // Copy raw arguments, reading them with the type given by the format,
+    // and the strings themselves, which may not outlive the call.
+    uint8_t n_args = 0;
+    size_t strings_len = 0;
+    const char* seg = fmt;
+    const char* spec_start;
+    const char* spec_end;
+    va_start(ap, fmt);
+    while (n_args < LOG_MAX_ARGS) {
+        log_arg_kind_t kind = next_spec(seg, &spec_start, &spec_end);
+        if (!spec_start) break;
+        log_arg_t* a = &rec->args[n_args++];
+        switch (kind) {
+        case ARG_INT:    a->i = va_arg(ap, int); break;
+        case ARG_LONG:   a->i = va_arg(ap, long); break;
+        case ARG_LLONG:  a->i = va_arg(ap, long long); break;
+        case ARG_SIZE:   a->u = va_arg(ap, size_t); break;
+        case ARG_UINT:   a->u = va_arg(ap, unsigned int); break;
+        case ARG_ULONG:  a->u = va_arg(ap, unsigned long); break;
+        case ARG_ULLONG: a->u = va_arg(ap, unsigned long long); break;
+        case ARG_DOUBLE: a->f = va_arg(ap, double); break;
+        case ARG_STR:    a->p = copy_string(va_arg(ap, const char*), rec->strings, &strings_len); break;
+        case ARG_PTR:    a->p = va_arg(ap, const void*); break;
+        default:         a->u = 0; break;
+        }
+        seg = spec_end;
+    }
+    va_end(ap);
+    rec->n_args = n_args;
+
+    // Publish the record.
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
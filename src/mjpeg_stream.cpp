@@ -0,0 +1,428 @@
+/**
+ * @file mjpeg_stream.cpp
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c mjpeg_stream.h .
+ *
+ * @see mjpeg_stream.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "mjpeg_stream.h"
+
+#include <cstring>
+#include <cerrno>
+#include <vector>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/// Boundary between the parts of the stream.
+#define STREAM_BOUNDARY "frame"
+
+/**
+ * @brief Connection of a client.
+ */
+typedef struct {
+    int fd;                             ///< Socket, -1 if the slot is free.
+    bool streaming;                     ///< @c true once the stream headers are queued.
+    bool closing;                       ///< @c true to close the connection once the output is sent.
+    bool overlay;                       ///< @c true to draw the detections over the frames.
+    uint64_t interval_ns;               ///< Time between two frames [ns].
+    uint64_t next_ns;                   ///< Time of the next frame [ns].
+    char request[STREAM_REQUEST_SIZE];  ///< Request received so far.
+    size_t request_len;                 ///< Size of the request received so far [bytes].
+    std::vector<uint8_t> out;           ///< Output not sent yet.
+    size_t sent;                        ///< Size of the output already sent [bytes].
+} client_t;
+
+// Statistics, updated with atomic built-ins.
+static uint64_t clients_served = 0;
+static uint64_t forwarded = 0;
+static uint64_t encoded = 0;
+static uint64_t sent = 0;
+static uint64_t skipped = 0;
+
+void stream_get_stats(stream_stats_t* stats)
+{
+    stats->clients = __atomic_load_n(&clients_served, __ATOMIC_RELAXED);
+    stats->forwarded = __atomic_load_n(&forwarded, __ATOMIC_RELAXED);
+    stats->encoded = __atomic_load_n(&encoded, __ATOMIC_RELAXED);
+    stats->sent = __atomic_load_n(&sent, __ATOMIC_RELAXED);
+    stats->skipped = __atomic_load_n(&skipped, __ATOMIC_RELAXED);
+}
+
+/****************************************************************************
+ * Connections
+ ****************************************************************************/
+
+/**
+ * @brief Opens the listening socket on the loopback interface.
+ */
+static int open_server(uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, STREAM_MAX_CLIENTS) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Closes the connection of a client, and frees its slot.
+ */
+static void close_client(client_t* client)
+{
+    close(client->fd);
+    client->fd = -1;
+    client->out.clear();
+}
+
+/**
+ * @brief Queues data to send to a client.
+ */
+static void queue(client_t* client, const void* data, size_t len)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    client->out.insert(client->out.end(), bytes, bytes + len);
+}
+
+/**
+ * @brief Accepts a new client, or turns it down if all the slots are taken.
+ */
+static void accept_client(int server, client_t* clients)
+{
+    int fd = accept4(server, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) return;
+
+    for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+        client_t* client = &clients[i];
+        if (client->fd != -1) continue;
+        client->fd = fd;
+        client->streaming = false;
+        client->closing = false;
+        client->request_len = 0;
+        client->out.clear();
+        client->sent = 0;
+        return;
+    }
+
+    static const char busy[] = "HTTP/1.0 503 Service Unavailable\r\nConnection: close\r\n\r\n";
+    send(fd, busy, sizeof(busy) - 1, MSG_NOSIGNAL);
+    close(fd);
+}
+
+/**
+ * @brief Reads an integer parameter of a query string.
+ */
+static long query_param(const char* query, const char* name, long fallback)
+{
+    size_t len = strlen(name);
+    for (const char* p = query; p && *p; p = strchr(p, '&'), p = p ? p + 1 : nullptr) {
+        if (strncmp(p, name, len) == 0 && p[len] == '=') return strtol(p + len + 1, nullptr, 10);
+    }
+    return fallback;
+}
+
+/**
+ * @brief Parses the request of a client, and queues the stream headers or an error.
+ */
+static void parse_request(client_t* client)
+{
+    // Request line: GET /stream?fps=30&overlay=1 HTTP/1.1
+    char path[256];
+    if (sscanf(client->request, "GET %255s HTTP/", path) != 1) {
+        static const char bad[] = "HTTP/1.0 400 Bad Request\r\nConnection: close\r\n\r\n";
+        queue(client, bad, sizeof(bad) - 1);
+        client->closing = true;
+        return;
+    }
+    char* query = strchr(path, '?');
+    if (query) *query++ = '\0';
+    if (strcmp(path, "/") != 0 && strcmp(path, "/stream") != 0) {
+        static const char missing[] = "HTTP/1.0 404 Not Found\r\nConnection: close\r\n\r\n";
+        queue(client, missing, sizeof(missing) - 1);
+        client->closing = true;
+        return;
+    }
+
+    long fps = query_param(query, "fps", STREAM_DEFAULT_FPS);
+    if (fps < 1) fps = 1;
+    if (fps > FRAME_FPS) fps = FRAME_FPS;
+    client->interval_ns = 1000000000ULL / (uint64_t)fps;
+    client->overlay = query_param(query, "overlay", 0) != 0;
+    client->next_ns = 0;
+
+    static const char headers[] =
+        "HTTP/1.0 200 OK\r\n"
+        "Connection: close\r\n"
+        "Cache-Control: no-cache, no-store, must-revalidate\r\n"
+        "Pragma: no-cache\r\n"
+        "Content-Type: multipart/x-mixed-replace; boundary=" STREAM_BOUNDARY "\r\n"
+        "\r\n";
+    queue(client, headers, sizeof(headers) - 1);
+    client->streaming = true;
+    __atomic_add_fetch(&clients_served, 1, __ATOMIC_RELAXED);
+    log_write(LOG_INFO, "Stream client connected: %ld FPS, %s", fps, client->overlay ? "overlay" : "camera frames");
+}
+
+/**
+ * @brief Reads from a client: its request, or the end of the connection.
+ */
+static void read_client(client_t* client)
+{
+    // Nothing more is expected once the request is parsed.
+    bool parsed = client->streaming || client->closing;
+    char discard[256];
+    char* buffer = parsed ? discard : client->request + client->request_len;
+    size_t room = parsed ? sizeof(discard) : sizeof(client->request) - 1 - client->request_len;
+    ssize_t len = recv(client->fd, buffer, room, 0);
+    if (len == 0 || (len < 0 && errno != EAGAIN && errno != EINTR)) {
+        if (client->streaming) log_write(LOG_INFO, "Stream client disconnected");
+        close_client(client);
+        return;
+    }
+    if (len < 0 || parsed) return;
+
+    client->request_len += (size_t)len;
+    client->request[client->request_len] = '\0';
+    if (strstr(client->request, "\r\n\r\n")) {
+        parse_request(client);
+    } else if (client->request_len == sizeof(client->request) - 1) {
+        close_client(client);
+    }
+}
+
+/**
+ * @brief Sends the pending output of a client, as much as the socket takes.
+ */
+static void write_client(client_t* client)
+{
+    ssize_t len = send(client->fd, client->out.data() + client->sent, client->out.size() - client->sent,
+                       MSG_NOSIGNAL);
+    if (len < 0) {
+        if (errno != EAGAIN && errno != EINTR) close_client(client);
+        return;
+    }
+    client->sent += (size_t)len;
+    if (client->sent < client->out.size()) return;
+
+    client->out.clear();
+    client->sent = 0;
+    if (client->closing) close_client(client);
+}
+
+/****************************************************************************
+ * Frames
+ ****************************************************************************/
+
+/**
+ * @brief Compressed frame, shared by the clients of the same kind.
+ */
+typedef struct {
+    const uint8_t* data;        ///< JPEG data, @c nullptr if not built yet.
+    size_t size;                ///< Size of the JPEG data [bytes].
+    std::vector<uint8_t> buffer;///< Encoded data, if not forwarded from the camera.
+} jpeg_t;
+
+/**
+ * @brief Encodes an image, timed as the streaming stage.
+ */
+static void encode(const cv::Mat& image, jpeg_t* jpeg)
+{
+    static const std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, STREAM_JPEG_QUALITY};
+    perf_stage_begin(PERF_STAGE_STREAM);
+    cv::imencode(".jpg", image, jpeg->buffer, params);
+    perf_stage_end(PERF_STAGE_STREAM);
+    jpeg->data = jpeg->buffer.data();
+    jpeg->size = jpeg->buffer.size();
+    __atomic_add_fetch(&encoded, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Gets the frame as compressed by the camera, or encodes it if the camera did not.
+ */
+static void camera_jpeg(const frame_t* frame, jpeg_t* jpeg)
+{
+    if (frame->jpeg_size > 0) {
+        jpeg->data = frame->jpeg;
+        jpeg->size = frame->jpeg_size;
+        __atomic_add_fetch(&forwarded, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    encode(cv::Mat(frame->height, frame->width, CV_8UC3, frame->data), jpeg);
+}
+
+/**
+ * @brief Draws the latest detection result over a copy of the frame, and encodes it.
+ */
+static void overlay_jpeg(const frame_t* frame, cv::Mat& canvas, overlay_t* overlay, jpeg_t* jpeg)
+{
+    // The frame itself is shared with the other subscribers.
+    cv::Mat(frame->height, frame->width, CV_8UC3, frame->data).copyTo(canvas);
+    overlay_wait(overlay, 0);
+    display_draw_overlay(canvas, frame, overlay);
+    encode(canvas, jpeg);
+}
+
+/**
+ * @brief Queues a frame as a part of the stream.
+ */
+static void queue_frame(client_t* client, const jpeg_t* jpeg)
+{
+    char header[128];
+    int len = snprintf(header, sizeof(header),
+                       "--" STREAM_BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\n\r\n",
+                       jpeg->size);
+    queue(client, header, (size_t)len);
+    queue(client, jpeg->data, jpeg->size);
+    queue(client, "\r\n", 2);
+    __atomic_add_fetch(&sent, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Sends a new camera frame to the clients due for one.
+ */
+static void serve_frame(client_t* clients, const frame_t* frame, cv::Mat& canvas, overlay_t* overlay)
+{
+    jpeg_t plain = {}, annotated = {};
+    for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+        client_t* client = &clients[i];
+        if (client->fd == -1 || !client->streaming || frame->timestamp_ns < client->next_ns) continue;
+
+        // Still sending the previous frame.
+        if (!client->out.empty()) {
+            __atomic_add_fetch(&skipped, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        jpeg_t* jpeg = client->overlay ? &annotated : &plain;
+        if (!jpeg->data) {
+            if (client->overlay) overlay_jpeg(frame, canvas, overlay, jpeg);
+            else camera_jpeg(frame, jpeg);
+        }
+        queue_frame(client, jpeg);
+
+        // Keep the rate without drifting, nor catching up after a pause.
+        client->next_ns += client->interval_ns;
+        if (client->next_ns <= frame->timestamp_ns) client->next_ns = frame->timestamp_ns + client->interval_ns;
+    }
+}
+
+/****************************************************************************
+ * Task
+ ****************************************************************************/
+
+void* stream_task(void* arg)
+{
+    uint16_t port = arg ? *(const uint16_t*)arg : STREAM_DEFAULT_PORT;
+    log_write(LOG_INFO, "Start MJPEG streaming task");
+
+    // Install signal handler for system signals.
+    psig_install_handler();
+
+    int server = open_server(port);
+    if (server < 0) {
+        log_write(LOG_ERROR, "Could not listen on port %u: %s", port, strerror(errno));
+        thread_ready_num++;
+        pthread_exit(nullptr);
+    }
+    log_write(LOG_INFO, "MJPEG stream on port %u", (unsigned)port);
+
+    static client_t clients[STREAM_MAX_CLIENTS];
+    for (int i = 0; i < STREAM_MAX_CLIENTS; i++) clients[i].fd = -1;
+
+    // Subscribed to the camera only while a client is streaming.
+    frame_sub_t* sub = nullptr;
+    static overlay_t overlay;
+    cv::Mat canvas;
+
+    // Serving loop that continues until a termination signal is received.
+    while (!psig_kill_requested()) {
+        struct pollfd fds[STREAM_MAX_CLIENTS + 1];
+        fds[0] = {server, POLLIN, 0};
+        bool streaming = false;
+        for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+            client_t* client = &clients[i];
+            short events = client->out.empty() ? POLLIN : POLLIN | POLLOUT;
+            fds[i + 1] = {client->fd, events, 0};
+            streaming |= client->fd != -1 && client->streaming;
+        }
+
+        if (poll(fds, STREAM_MAX_CLIENTS + 1, streaming ? STREAM_TICK_MS : STREAM_WAIT_MS) < 0 && errno != EINTR) {
+            log_write(LOG_ERROR, "Could not poll the stream clients: %s", strerror(errno));
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) accept_client(server, clients);
+        for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+            client_t* client = &clients[i];
+            short revents = fds[i + 1].revents;
+            if (client->fd == -1 || fds[i + 1].fd != client->fd) continue;
+            if (revents & (POLLIN | POLLHUP | POLLERR)) read_client(client);
+            if (client->fd != -1 && (revents & POLLOUT)) write_client(client);
+        }
+
+        // Follow the camera only while someone watches.
+        if (streaming && !sub) {
+            sub = frame_bus_subscribe(&cam_bus, "stream", FRAME_BUS_LATEST, 0);
+        } else if (!streaming && sub) {
+            frame_bus_unsubscribe(&cam_bus, sub);
+            sub = nullptr;
+        }
+        if (!sub) continue;
+
+        frame_t* frame = frame_sub_receive(&cam_bus, sub, 0);
+        if (!frame) continue;
+        serve_frame(clients, frame, canvas, &overlay);
+        frame_unref(frame);
+    }
+
+    for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+        if (clients[i].fd != -1) close_client(&clients[i]);
+    }
+    if (sub) frame_bus_unsubscribe(&cam_bus, sub);
+    close(server);
+
+    stream_stats_t stats;
+    stream_get_stats(&stats);
+    log_write(LOG_INFO, "Streaming: %llu clients, %llu frames sent, %llu forwarded, %llu encoded, %llu skipped",
+              (unsigned long long)stats.clients, (unsigned long long)stats.sent,
+              (unsigned long long)stats.forwarded, (unsigned long long)stats.encoded,
+              (unsigned long long)stats.skipped);
+
+    // Indicate the task is complete.
+    thread_ready_num++;
+    log_write(LOG_INFO, "Stopping MJPEG streaming task");
+    pthread_exit(EXIT_SUCCESS);
+}
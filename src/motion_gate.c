@@ -0,0 +1,251 @@
+/**
+ * @file motion_gate.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c motion_gate.h .
+ *
+ * @see motion_gate.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "motion_gate.h"
+
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "log_utils.h"
+#include "perf_counters.h"
+#include "frame_clock.h"
+#include "targeting.h"
+#include "gray_downscale.h"
+
+// Size of a downscaled frame [px].
+#define SMALL_PIXELS ((FRAME_WIDTH / MOTION_SCALE) * (FRAME_HEIGHT / MOTION_SCALE))
+
+// Gate enabled, read with atomic built-ins.
+static bool enabled = false;
+
+// Downscaled frames, only used by the camera thread.
+static uint8_t small[2][SMALL_PIXELS];
+static uint8_t* current = small[0];
+static uint8_t* reference = small[1];
+static int ref_width = 0;
+static int ref_height = 0;
+
+// Last frame changing the scene, written by the camera thread.
+static uint64_t change_id = 0;
+
+// Last frame admitted, only used by the consumer of the frames.
+static uint64_t admitted_id = 0;
+static uint64_t admitted_ns = 0;
+
+// Change map and last detections, shared with the other threads.
+static pthread_mutex_t gate_mutex;
+static motion_map_t last_map;
+static detection_t kept[TARGETING_MAX_DETECTIONS];
+static size_t kept_count = 0;
+
+// Statistics, updated with atomic built-ins.
+static uint64_t frames = 0;
+static uint64_t changes = 0;
+static uint64_t admitted = 0;
+static uint64_t keepalives = 0;
+static uint64_t skipped = 0;
+
+/*******************************************************************************
+ * Image processing
+ ******************************************************************************/
+
+/**
+ * @brief Computes the sum of absolute differences of a tile of two frames.
+ *
+ * @param[in] a Top-left pixel of the tile in the first frame.
+ * @param[in] b Top-left pixel of the tile in the second frame.
+ * @param[in] stride Width of the frames [px].
+ * @param[in] w Width of the tile [px], at most @c MOTION_TILE .
+ * @param[in] h Height of the tile [px], at most @c MOTION_TILE .
+ * @return The sum of absolute differences.
+ */
+static uint32_t tile_sad(const uint8_t* a, const uint8_t* b, int stride, int w, int h)
+{
+#if defined(__ARM_NEON) && MOTION_TILE == 16
+    if (w == MOTION_TILE) {
+        uint16x8_t acc = vdupq_n_u16(0);
+        for (int r = 0; r < h; r++) {
+            acc = vpadalq_u8(acc, vabdq_u8(vld1q_u8(a + (size_t)r * stride), vld1q_u8(b + (size_t)r * stride)));
+        }
+        uint32x4_t s4 = vpaddlq_u16(acc);
+        uint32x2_t s2 = vadd_u32(vget_low_u32(s4), vget_high_u32(s4));
+        return vget_lane_u32(vpadd_u32(s2, s2), 0);
+    }
+#endif
+
+    uint32_t sad = 0;
+    for (int r = 0; r < h; r++) {
+        const uint8_t* ra = a + (size_t)r * stride;
+        const uint8_t* rb = b + (size_t)r * stride;
+        for (int c = 0; c < w; c++) {
+            sad += ra[c] > rb[c] ? ra[c] - rb[c] : rb[c] - ra[c];
+        }
+    }
+    return sad;
+}
+
+/*******************************************************************************
+ * Gate
+ ******************************************************************************/
+
+void motion_gate_init(void)
+{
+    pthread_mutex_init(&gate_mutex, NULL);
+    memset(&last_map, 0, sizeof(last_map));
+    kept_count = 0;
+    admitted_id = 0;
+    admitted_ns = 0;
+    ref_width = 0;
+    ref_height = 0;
+}
+
+void motion_gate_close(void)
+{
+    if (__atomic_load_n(&frames, __ATOMIC_RELAXED) > 0) {
+        motion_stats_t stats;
+        motion_gate_get_stats(&stats);
+        log_write(LOG_INFO, "Motion gate: %llu frames, %llu changes, %llu admitted, %llu keep-alives, %llu skipped",
+                  (unsigned long long)stats.frames, (unsigned long long)stats.changes,
+                  (unsigned long long)stats.admitted, (unsigned long long)stats.keepalives,
+                  (unsigned long long)stats.skipped);
+    }
+    pthread_mutex_destroy(&gate_mutex);
+}
+
+void motion_gate_enable(bool enable)
+{
+    __atomic_store_n(&enabled, enable, __ATOMIC_RELEASE);
+}
+
+void motion_gate_update(const frame_t* frame)
+{
+    if (!__atomic_load_n(&enabled, __ATOMIC_ACQUIRE)) return;
+    if (frame->width > FRAME_WIDTH || frame->height > FRAME_HEIGHT) return;
+
+    perf_stage_begin(PERF_STAGE_MOTION);
+    const int dw = frame->width / MOTION_SCALE;
+    const int dh = frame->height / MOTION_SCALE;
+    const int cols = (dw + MOTION_TILE - 1) / MOTION_TILE;
+    const int rows = (dh + MOTION_TILE - 1) / MOTION_TILE;
+    gray_downscale(frame->data, frame->width, frame->height, MOTION_SCALE, current);
+
+    motion_map_t map;
+    memset(&map, 0, sizeof(map));
+    map.frame_id = frame->frame_id;
+
+    // Without reference, the scene is new.
+    bool changed = true;
+    if (ref_width == frame->width && ref_height == frame->height && cols * rows <= MOTION_MAX_TILES) {
+        map.cols = (uint32_t)cols;
+        map.rows = (uint32_t)rows;
+        for (int ty = 0; ty < rows; ty++) {
+            int h = dh - ty * MOTION_TILE < MOTION_TILE ? dh - ty * MOTION_TILE : MOTION_TILE;
+            for (int tx = 0; tx < cols; tx++) {
+                int w = dw - tx * MOTION_TILE < MOTION_TILE ? dw - tx * MOTION_TILE : MOTION_TILE;
+                size_t offset = (size_t)(ty * MOTION_TILE) * dw + (size_t)(tx * MOTION_TILE);
+                uint32_t diff = tile_sad(current + offset, reference + offset, dw, w, h) / (uint32_t)(w * h);
+                map.diff[ty * cols + tx] = (uint8_t)diff;
+                if (diff > MOTION_THRESHOLD) map.changed++;
+            }
+        }
+        changed = map.changed >= MOTION_MIN_TILES;
+    }
+
+    // The reference only follows the changes, so that slow moves add up.
+    if (changed) {
+        uint8_t* tmp = reference;
+        reference = current;
+        current = tmp;
+        ref_width = frame->width;
+        ref_height = frame->height;
+        __atomic_store_n(&change_id, frame->frame_id, __ATOMIC_RELEASE);
+        __atomic_add_fetch(&changes, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&frames, 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&gate_mutex);
+    last_map = map;
+    pthread_mutex_unlock(&gate_mutex);
+    perf_stage_end(PERF_STAGE_MOTION);
+}
+
+bool motion_gate_admit(const frame_t* frame)
+{
+    if (!__atomic_load_n(&enabled, __ATOMIC_ACQUIRE)) return true;
+
+    // A change after the last frame admitted, even on a frame the consumer
+    // did not receive, makes the scene worth a new inference.
+    uint64_t now = frame_clock_now();
+    bool change = __atomic_load_n(&change_id, __ATOMIC_ACQUIRE) > admitted_id;
+    bool keepalive = now - admitted_ns >= (uint64_t)MOTION_KEEPALIVE_MS * 1000000ULL;
+    if (change || keepalive) {
+        admitted_id = frame->frame_id;
+        admitted_ns = now;
+        __atomic_add_fetch(change ? &admitted : &keepalives, 1, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    // Nothing moved: the last detections still hold for this frame.
+    detection_t dets[TARGETING_MAX_DETECTIONS];
+    pthread_mutex_lock(&gate_mutex);
+    size_t n = kept_count;
+    memcpy(dets, kept, n * sizeof(detection_t));
+    pthread_mutex_unlock(&gate_mutex);
+    targeting_submit_reused(dets, n, frame->frame_id);
+
+    __atomic_add_fetch(&skipped, 1, __ATOMIC_RELAXED);
+    return false;
+}
+
+void motion_gate_keep(const detection_t* dets, size_t n)
+{
+    if (n > TARGETING_MAX_DETECTIONS) n = TARGETING_MAX_DETECTIONS;
+    pthread_mutex_lock(&gate_mutex);
+    memcpy(kept, dets, n * sizeof(detection_t));
+    kept_count = n;
+    pthread_mutex_unlock(&gate_mutex);
+}
+
+void motion_gate_get_map(motion_map_t* map)
+{
+    pthread_mutex_lock(&gate_mutex);
+    *map = last_map;
+    pthread_mutex_unlock(&gate_mutex);
+}
+
+void motion_gate_get_stats(motion_stats_t* stats)
+{
+    stats->frames = __atomic_load_n(&frames, __ATOMIC_RELAXED);
+    stats->changes = __atomic_load_n(&changes, __ATOMIC_RELAXED);
+    stats->admitted = __atomic_load_n(&admitted, __ATOMIC_RELAXED);
+    stats->keepalives = __atomic_load_n(&keepalives, __ATOMIC_RELAXED);
+    stats->skipped = __atomic_load_n(&skipped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file overlay.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c overlay.h .
+ *
+ * @see overlay.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "overlay.h"
+
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+// Latest result, its lock and its notification.
+static pthread_mutex_t overlay_mutex;
+static pthread_cond_t overlay_cond;
+static overlay_t latest;
+
+void overlay_init(void)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&overlay_mutex, NULL);
+    pthread_cond_init(&overlay_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    memset(&latest, 0, sizeof(latest));
+}
+
+void overlay_close(void)
+{
+    pthread_mutex_destroy(&overlay_mutex);
+    pthread_cond_destroy(&overlay_cond);
+}
+
+void overlay_publish(const detection_t* dets, size_t n, const track_t* tracks, size_t m,
+                     uint64_t frame_id, uint64_t timestamp_ns, bool reused)
+{
+    if (n > TARGETING_MAX_DETECTIONS) n = TARGETING_MAX_DETECTIONS;
+    if (m > TRACKER_MAX_TRACKS) m = TRACKER_MAX_TRACKS;
+
+    pthread_mutex_lock(&overlay_mutex);
+    latest.seq++;
+    latest.frame_id = frame_id;
+    latest.timestamp_ns = timestamp_ns;
+    memcpy(latest.dets, dets, n * sizeof(detection_t));
+    latest.det_count = n;
+    memcpy(latest.tracks, tracks, m * sizeof(track_t));
+    latest.track_count = m;
+    latest.reused = reused;
+    pthread_cond_broadcast(&overlay_cond);
+    pthread_mutex_unlock(&overlay_mutex);
+}
+
+bool overlay_wait(overlay_t* overlay, uint32_t timeout_ms)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&overlay_mutex);
+    while (latest.seq == overlay->seq) {
+        if (pthread_cond_timedwait(&overlay_cond, &overlay_mutex, &deadline) != 0) break;
+    }
+    bool updated = latest.seq != overlay->seq;
+    if (updated) *overlay = latest;
+    pthread_mutex_unlock(&overlay_mutex);
+    return updated;
+}
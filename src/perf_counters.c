@@ -0,0 +1,257 @@
+/**
+ * @file perf_counters.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c perf_counters.h .
+ *
+ * @see perf_counters.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include "perf_counters.h"
+#include "log_utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/// Values of the counters of a thread, with the times of its group.
+typedef struct {
+    uint64_t enabled;                           ///< Time the group has been enabled [ns].
+    uint64_t running;                           ///< Time the group has been on the PMU [ns].
+    uint64_t values[PERF_COUNTER_NUMBER];       ///< Counters values, 0 for unavailable ones.
+} perf_sample_t;
+
+/// Counters of a thread, opened as a single group.
+typedef struct {
+    bool opened;                                ///< Opening has been attempted.
+    int leader;                                 ///< File descriptor of the group leader.
+    int fds[PERF_COUNTER_NUMBER];               ///< File descriptors, -1 if unavailable.
+    int index[PERF_COUNTER_NUMBER];             ///< Position in the group read, -1 if unavailable.
+    int size;                                   ///< Number of counters in the group.
+    perf_sample_t start[PERF_STAGE_NUMBER];     ///< Values when entering each stage.
+} perf_thread_t;
+
+/// Accumulated deltas of a stage, only updated by the thread owning the stage.
+typedef struct {
+    uint64_t sums[PERF_COUNTER_NUMBER];
+    uint32_t frames;
+} perf_stats_t;
+
+static bool enabled = false;
+static _Thread_local perf_thread_t tls = { .opened = false };
+static perf_stats_t stats[PERF_STAGE_NUMBER];
+
+// Closes the counters of each thread when it exits.
+static pthread_key_t thread_key;
+
+static const char* stage_names[PERF_STAGE_NUMBER] = {
+    "capture", "publish", "inference", "motor-x", "motor-y", "correlation", "servo", "stream", "motion"
+};
+
+/*******************************************************************************
+ * Helper functions
+ ******************************************************************************/
+
+/**
+ * @brief Opens one counter for the calling thread.
+ *
+ * Kernel events are counted when allowed by @c perf_event_paranoid ,
+ * otherwise only user space events are.
+ *
+ * @param[in] type The event type ( @c PERF_TYPE_* ).
+ * @param[in] config The event configuration.
+ * @param[in] group_fd The group leader, or -1 to create a group.
+ * @return The file descriptor, or -1 on failure.
+ */
+static int open_counter(uint32_t type, uint64_t config, int group_fd)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group_fd == -1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+    if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+        attr.exclude_kernel = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+    }
+    return fd;
+}
+
+/**
+ * @brief Closes the counters group of an exiting thread.
+ *
+ * @param[in] arg The counters of the thread.
+ */
+static void close_thread_counters(void* arg)
+{
+    perf_thread_t* t = (perf_thread_t*)arg;
+    for (int i = 0; i < PERF_COUNTER_NUMBER; i++) {
+        if (t->fds[i] >= 0) close(t->fds[i]);
+        t->fds[i] = -1;
+    }
+    t->leader = -1;
+    t->size = 0;
+}
+
+/**
+ * @brief Opens the counters group of the calling thread.
+ */
+static void open_thread_counters(void)
+{
+    static const struct { uint32_t type; uint64_t config; } events[PERF_COUNTER_NUMBER] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                              | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                              | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL
+                              | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                              | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+    };
+
+    tls.opened = true;
+    tls.size = 0;
+    int leader = -1;
+    for (int i = 0; i < PERF_COUNTER_NUMBER; i++) {
+        tls.fds[i] = open_counter(events[i].type, events[i].config, leader);
+        tls.index[i] = -1;
+        if (tls.fds[i] < 0) {
+            log_write(LOG_WARNING, "perf_event_open failed for counter %d (errno %d)", i, errno);
+            continue;
+        }
+        // The first available counter leads the group.
+        if (leader == -1) leader = tls.fds[i];
+        tls.index[i] = tls.size++;
+    }
+    tls.leader = leader;
+    if (leader == -1) return;
+    pthread_setspecific(thread_key, &tls);
+
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+/**
+ * @brief Reads all the counters of the calling thread at once.
+ *
+ * @param[out] sample The counters values and the times of the group.
+ * @return @c true on success, @c false otherwise.
+ */
+static bool read_counters(perf_sample_t* sample)
+{
+    if (!tls.opened) open_thread_counters();
+    if (tls.size == 0) return false;
+
+    // Group read format: { nr, time_enabled, time_running, values[nr] }.
+    uint64_t buf[3 + PERF_COUNTER_NUMBER];
+    ssize_t size = (ssize_t)((3 + tls.size) * sizeof(uint64_t));
+    if (read(tls.leader, buf, sizeof(buf)) < size) return false;
+
+    sample->enabled = buf[1];
+    sample->running = buf[2];
+    for (int i = 0; i < PERF_COUNTER_NUMBER; i++) {
+        sample->values[i] = tls.index[i] >= 0 ? buf[3 + tls.index[i]] : 0;
+    }
+    return true;
+}
+
+/**
+ * @brief Logs the average per-frame deltas of a stage and resets them.
+ */
+static void report_stage(perf_stage_t stage)
+{
+    perf_stats_t* s = &stats[stage];
+    double n = (double)s->frames;
+    double cycles = s->sums[PERF_CYCLES] / n;
+    double instructions = s->sums[PERF_INSTRUCTIONS] / n;
+
+    // Two lines, a log record holding at most LOG_MAX_ARGS arguments.
+    log_write(LOG_INFO, "perf %s: %.0f cycles, %.0f instr (IPC %.2f) per frame",
+              stage_names[stage], cycles, instructions,
+              cycles > 0 ? instructions / cycles : 0.0);
+    log_write(LOG_INFO, "perf %s: L1D miss %.0f, LLC miss %.0f, ctx sw %.2f per frame",
+              stage_names[stage], s->sums[PERF_L1D_MISSES] / n,
+              s->sums[PERF_LLC_MISSES] / n, s->sums[PERF_CTX_SWITCHES] / n);
+
+    memset(s, 0, sizeof(*s));
+}
+
+/*******************************************************************************
+ * API functions
+ ******************************************************************************/
+
+void perf_init(void)
+{
+    const char* env = getenv("EDGEAI_PERF");
+    enabled = env && strcmp(env, "1") == 0;
+    if (enabled) {
+        pthread_key_create(&thread_key, close_thread_counters);
+        log_write(LOG_INFO, "Hardware counters sampling enabled");
+    }
+}
+
+bool perf_enabled(void)
+{
+    return enabled;
+}
+
+void perf_stage_begin(perf_stage_t stage)
+{
+    if (!enabled || stage >= PERF_STAGE_NUMBER) return;
+    read_counters(&tls.start[stage]);
+}
+
+void perf_stage_end(perf_stage_t stage)
+{
+    if (!enabled || stage >= PERF_STAGE_NUMBER) return;
+
+    perf_sample_t end;
+    if (!read_counters(&end)) return;
+
+    // With more counters than the PMU has, the kernel multiplexes the groups:
+    // the deltas are extrapolated to the whole time the group was enabled.
+    const perf_sample_t* start = &tls.start[stage];
+    uint64_t enabled_ns = end.enabled - start->enabled;
+    uint64_t running_ns = end.running - start->running;
+    if (running_ns == 0) return;
+    double scale = (double)enabled_ns / (double)running_ns;
+
+    perf_stats_t* s = &stats[stage];
+    for (int i = 0; i < PERF_COUNTER_NUMBER; i++) {
+        s->sums[i] += (uint64_t)((double)(end.values[i] - start->values[i]) * scale + 0.5);
+    }
+    if (++s->frames >= PERF_REPORT_FRAMES) {
+        report_stage(stage);
+    }
+}
@@ -28,6 +28,7 @@
 #include "psig_utils.h"
 
 static volatile sig_atomic_t sigint_received = 0;
+static volatile sig_atomic_t sigusr1_received = 0;
 
 /**
  * @brief Signal handler.
@@ -37,22 +38,32 @@ static volatile sig_atomic_t sigint_received = 0;
  * such as releasing IPC resources.
  * 
  * @param signal The signal number that triggered the handler. 
- *               Currently only handles SIGINT (Ctrl+C).
+ *               Handles SIGINT (Ctrl+C) and SIGUSR1 (dump request).
  */
 static void on_signal(int signal)
 {
     if (signal == SIGINT) {
         sigint_received = 1;
         ipc_release();
+    } else if (signal == SIGUSR1) {
+        sigusr1_received = 1;
     }
 }
 
 void psig_install_handler(void)
 {
     signal(SIGINT, on_signal);
+    signal(SIGUSR1, on_signal);
 }
 
 bool psig_kill_requested(void)
 {
     return sigint_received != 0;
 }
+
+bool psig_dump_requested(void)
+{
+    if (!sigusr1_received) return false;
+    sigusr1_received = 0;
+    return true;
+}
@@ -0,0 +1,178 @@
+/**
+ * @file rate_governor.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c rate_governor.h .
+ *
+ * @see rate_governor.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "rate_governor.h"
+
+#include <string.h>
+#include <pthread.h>
+
+#include "log_utils.h"
+#include "frame_clock.h"
+
+// Governed mode and state, read with atomic built-ins.
+static uint32_t mode = GOVERNOR_OFF;
+static uint32_t state = GOVERNOR_ACQUIRING;
+
+// Detection history and counters, under the mutex.
+static pthread_mutex_t governor_mutex;
+static uint64_t last_detection_ns = 0;
+static uint64_t state_since_ns = 0;
+static uint64_t transitions = 0;
+static uint64_t entered[GOVERNOR_STATE_NUMBER];
+static uint64_t time_ns[GOVERNOR_STATE_NUMBER];
+
+// Last frames let through, each only used by its thread.
+static uint64_t last_admit_ns = 0;
+static uint64_t last_camera_ns = 0;
+
+// Statistics, updated with atomic built-ins.
+static uint64_t skipped = 0;
+static uint64_t camera_skipped = 0;
+
+void governor_init(void)
+{
+    pthread_mutex_init(&governor_mutex, NULL);
+    uint64_t now = frame_clock_now();
+    __atomic_store_n(&mode, GOVERNOR_OFF, __ATOMIC_RELAXED);
+    __atomic_store_n(&state, GOVERNOR_ACQUIRING, __ATOMIC_RELAXED);
+    last_detection_ns = now;
+    state_since_ns = now;
+    transitions = 0;
+    memset(entered, 0, sizeof(entered));
+    memset(time_ns, 0, sizeof(time_ns));
+    entered[GOVERNOR_ACQUIRING] = 1;
+    last_admit_ns = 0;
+    last_camera_ns = 0;
+}
+
+void governor_close(void)
+{
+    if (__atomic_load_n(&mode, __ATOMIC_RELAXED) != GOVERNOR_OFF) {
+        governor_stats_t stats;
+        governor_get_stats(&stats);
+        log_write(LOG_INFO, "Governor: %llu transitions, %llu s idle, %llu s acquiring, %llu s tracking, %llu skipped",
+                  (unsigned long long)stats.transitions,
+                  (unsigned long long)(stats.time_ms[GOVERNOR_IDLE] / 1000),
+                  (unsigned long long)(stats.time_ms[GOVERNOR_ACQUIRING] / 1000),
+                  (unsigned long long)(stats.time_ms[GOVERNOR_TRACKING] / 1000),
+                  (unsigned long long)stats.skipped);
+    }
+    pthread_mutex_destroy(&governor_mutex);
+}
+
+void governor_set_mode(governor_mode_t new_mode)
+{
+    __atomic_store_n(&mode, (uint32_t)new_mode, __ATOMIC_RELEASE);
+}
+
+const char* governor_state_name(governor_state_t s)
+{
+    switch (s) {
+    case GOVERNOR_IDLE: return "idle";
+    case GOVERNOR_ACQUIRING: return "acquiring";
+    case GOVERNOR_TRACKING: return "tracking";
+    default: return "unknown";
+    }
+}
+
+void governor_observe(size_t detections, size_t aliens)
+{
+    uint64_t now = frame_clock_now();
+
+    pthread_mutex_lock(&governor_mutex);
+    if (detections > 0) last_detection_ns = now;
+
+    // A confirmed alien is tracked at full rate, a recent detection is
+    // being acquired at full rate, nothing for a while is idle.
+    governor_state_t next;
+    if (aliens > 0) {
+        next = GOVERNOR_TRACKING;
+    } else if (now - last_detection_ns < (uint64_t)GOVERNOR_IDLE_AFTER_MS * 1000000ULL) {
+        next = GOVERNOR_ACQUIRING;
+    } else {
+        next = GOVERNOR_IDLE;
+    }
+
+    governor_state_t prev = (governor_state_t)__atomic_load_n(&state, __ATOMIC_RELAXED);
+    if (next != prev) {
+        time_ns[prev] += now - state_since_ns;
+        state_since_ns = now;
+        entered[next]++;
+        transitions++;
+        __atomic_store_n(&state, (uint32_t)next, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&governor_mutex);
+
+    if (next != prev && __atomic_load_n(&mode, __ATOMIC_RELAXED) != GOVERNOR_OFF) {
+        log_write(LOG_INFO, "Governor: %s -> %s", governor_state_name(prev), governor_state_name(next));
+    }
+}
+
+bool governor_admit(void)
+{
+    uint64_t now = frame_clock_now();
+    bool idle = __atomic_load_n(&mode, __ATOMIC_ACQUIRE) != GOVERNOR_OFF &&
+                __atomic_load_n(&state, __ATOMIC_ACQUIRE) == GOVERNOR_IDLE;
+    if (idle && now - last_admit_ns < 1000000000ULL / GOVERNOR_IDLE_HZ) {
+        __atomic_add_fetch(&skipped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    last_admit_ns = now;
+    return true;
+}
+
+bool governor_camera_admit(void)
+{
+    uint64_t now = frame_clock_now();
+    bool idle = __atomic_load_n(&mode, __ATOMIC_ACQUIRE) == GOVERNOR_CAMERA &&
+                __atomic_load_n(&state, __ATOMIC_ACQUIRE) == GOVERNOR_IDLE;
+    if (idle && now - last_camera_ns < 1000000000ULL / GOVERNOR_IDLE_CAMERA_FPS) {
+        __atomic_add_fetch(&camera_skipped, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    last_camera_ns = now;
+    return true;
+}
+
+void governor_get_stats(governor_stats_t* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    uint64_t now = frame_clock_now();
+
+    pthread_mutex_lock(&governor_mutex);
+    stats->state = __atomic_load_n(&state, __ATOMIC_RELAXED);
+    stats->transitions = transitions;
+    for (int i = 0; i < GOVERNOR_STATE_NUMBER; i++) {
+        uint64_t ns = time_ns[i] + (i == (int)stats->state ? now - state_since_ns : 0);
+        stats->entered[i] = entered[i];
+        stats->time_ms[i] = ns / 1000000ULL;
+    }
+    pthread_mutex_unlock(&governor_mutex);
+
+    stats->skipped = __atomic_load_n(&skipped, __ATOMIC_RELAXED);
+    stats->camera_skipped = __atomic_load_n(&camera_skipped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,452 @@
+/**
+ * @file scanout.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c scanout.h .
+ *
+ * @see scanout.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "scanout.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/fb.h>
+#include <linux/kd.h>
+#include <drm/drm.h>
+
+#include "log_utils.h"
+
+/// Connection status of a connected screen (@c drm_mode_get_connector ).
+#define DRM_CONNECTED 1
+
+/**
+ * @brief Issues an ioctl, restarted if interrupted by a signal.
+ */
+static int xioctl(int fd, unsigned long request, void* arg)
+{
+    int ret;
+    do {
+        ret = ioctl(fd, request, arg);
+    } while (ret == -1 && (errno == EINTR || errno == EAGAIN));
+    return ret;
+}
+
+/**
+ * @brief Clears a screen output, without device opened.
+ */
+static void scanout_reset(scanout_t* scanout)
+{
+    memset(scanout, 0, sizeof(*scanout));
+    scanout->fd = -1;
+    scanout->tty_fd = -1;
+}
+
+/****************************************************************************
+ * DRM/KMS dumb buffers
+ ****************************************************************************/
+
+/**
+ * @brief Finds a connected screen, its preferred mode, and a CRTC to drive it.
+ */
+static int drm_find_output(scanout_t* scanout, struct drm_mode_modeinfo* mode)
+{
+    uint32_t crtcs[SCANOUT_MAX_OBJECTS];
+    uint32_t connectors[SCANOUT_MAX_OBJECTS];
+    struct drm_mode_card_res res;
+    memset(&res, 0, sizeof(res));
+    res.crtc_id_ptr = (uintptr_t)crtcs;
+    res.connector_id_ptr = (uintptr_t)connectors;
+    res.count_crtcs = SCANOUT_MAX_OBJECTS;
+    res.count_connectors = SCANOUT_MAX_OBJECTS;
+    if (xioctl(scanout->fd, DRM_IOCTL_MODE_GETRESOURCES, &res) == -1) {
+        log_write(LOG_WARNING, "Could not get the DRM resources: %s", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    if (res.count_crtcs > SCANOUT_MAX_OBJECTS) res.count_crtcs = SCANOUT_MAX_OBJECTS;
+    if (res.count_connectors > SCANOUT_MAX_OBJECTS) res.count_connectors = SCANOUT_MAX_OBJECTS;
+
+    for (uint32_t i = 0; i < res.count_connectors; i++) {
+        // Probe the connector for its modes and encoders.
+        struct drm_mode_get_connector conn;
+        memset(&conn, 0, sizeof(conn));
+        conn.connector_id = connectors[i];
+        if (xioctl(scanout->fd, DRM_IOCTL_MODE_GETCONNECTOR, &conn) == -1) continue;
+        if (conn.connection != DRM_CONNECTED || conn.count_modes == 0) continue;
+
+        uint32_t count_modes = conn.count_modes;
+        uint32_t count_encoders = conn.count_encoders;
+        struct drm_mode_modeinfo* modes = calloc(count_modes, sizeof(*modes));
+        uint32_t* encoders = calloc(count_encoders ? count_encoders : 1, sizeof(*encoders));
+        if (!modes || !encoders) {
+            free(modes);
+            free(encoders);
+            return EXIT_FAILURE;
+        }
+        memset(&conn, 0, sizeof(conn));
+        conn.connector_id = connectors[i];
+        conn.modes_ptr = (uintptr_t)modes;
+        conn.count_modes = count_modes;
+        conn.encoders_ptr = (uintptr_t)encoders;
+        conn.count_encoders = count_encoders;
+        if (xioctl(scanout->fd, DRM_IOCTL_MODE_GETCONNECTOR, &conn) == -1 ||
+            conn.count_modes > count_modes || conn.count_encoders > count_encoders) {
+            free(modes);
+            free(encoders);
+            continue;
+        }
+
+        // Preferred mode, otherwise the first one.
+        *mode = modes[0];
+        for (uint32_t m = 0; m < conn.count_modes; m++) {
+            if (modes[m].type & DRM_MODE_TYPE_PREFERRED) {
+                *mode = modes[m];
+                break;
+            }
+        }
+
+        // CRTC of the current encoder, otherwise the first one usable by an encoder.
+        uint32_t crtc_id = 0;
+        struct drm_mode_get_encoder enc;
+        memset(&enc, 0, sizeof(enc));
+        enc.encoder_id = conn.encoder_id;
+        if (conn.encoder_id != 0 && xioctl(scanout->fd, DRM_IOCTL_MODE_GETENCODER, &enc) == 0) {
+            crtc_id = enc.crtc_id;
+        }
+        for (uint32_t e = 0; e < conn.count_encoders && crtc_id == 0; e++) {
+            memset(&enc, 0, sizeof(enc));
+            enc.encoder_id = encoders[e];
+            if (xioctl(scanout->fd, DRM_IOCTL_MODE_GETENCODER, &enc) == -1) continue;
+            for (uint32_t c = 0; c < res.count_crtcs && crtc_id == 0; c++) {
+                if (enc.possible_crtcs & (1u << c)) crtc_id = crtcs[c];
+            }
+        }
+        free(modes);
+        free(encoders);
+
+        if (crtc_id != 0) {
+            scanout->connector_id = connectors[i];
+            scanout->crtc_id = crtc_id;
+            return EXIT_SUCCESS;
+        }
+    }
+
+    log_write(LOG_WARNING, "No screen connected to the DRM device");
+    return EXIT_FAILURE;
+}
+
+/**
+ * @brief Creates a dumb buffer, its framebuffer, and maps it.
+ */
+static int drm_create_buffer(scanout_t* scanout, uint8_t i)
+{
+    struct drm_mode_create_dumb create;
+    memset(&create, 0, sizeof(create));
+    create.width = scanout->width;
+    create.height = scanout->height;
+    create.bpp = 32;
+    if (xioctl(scanout->fd, DRM_IOCTL_MODE_CREATE_DUMB, &create) == -1) {
+        log_write(LOG_ERROR, "Could not create a DRM dumb buffer: %s", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    scanout->handle[i] = create.handle;
+    scanout->pitch = create.pitch;
+    scanout->size = create.size;
+
+    struct drm_mode_fb_cmd fb;
+    memset(&fb, 0, sizeof(fb));
+    fb.width = scanout->width;
+    fb.height = scanout->height;
+    fb.pitch = create.pitch;
+    fb.bpp = 32;
+    fb.depth = 24;
+    fb.handle = create.handle;
+    if (xioctl(scanout->fd, DRM_IOCTL_MODE_ADDFB, &fb) == -1) {
+        log_write(LOG_ERROR, "Could not add a DRM framebuffer: %s", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    scanout->fb_id[i] = fb.fb_id;
+
+    struct drm_mode_map_dumb map;
+    memset(&map, 0, sizeof(map));
+    map.handle = create.handle;
+    if (xioctl(scanout->fd, DRM_IOCTL_MODE_MAP_DUMB, &map) == -1) {
+        log_write(LOG_ERROR, "Could not map a DRM dumb buffer: %s", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    void* data = mmap(NULL, create.size, PROT_READ | PROT_WRITE, MAP_SHARED, scanout->fd, (off_t)map.offset);
+    if (data == MAP_FAILED) {
+        log_write(LOG_ERROR, "Could not map a DRM dumb buffer: %s", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    scanout->map[i] = data;
+    memset(data, 0, create.size);
+    return EXIT_SUCCESS;
+}
+
+int scanout_open_drm(scanout_t* scanout, const char* device)
+{
+    scanout_reset(scanout);
+    scanout->fd = open(device, O_RDWR | O_CLOEXEC);
+    if (scanout->fd == -1) {
+        log_write(LOG_WARNING, "Could not open %s: %s", device, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    scanout->kind = SCANOUT_DRM;
+
+    // Mode setting is reserved to the master, which a display server would be.
+    xioctl(scanout->fd, DRM_IOCTL_SET_MASTER, NULL);
+
+    struct drm_mode_modeinfo mode;
+    if (drm_find_output(scanout, &mode) == EXIT_FAILURE) {
+        scanout_close(scanout);
+        return EXIT_FAILURE;
+    }
+    scanout->width = mode.hdisplay;
+    scanout->height = mode.vdisplay;
+
+    scanout->saved_crtc.crtc_id = scanout->crtc_id;
+    xioctl(scanout->fd, DRM_IOCTL_MODE_GETCRTC, &scanout->saved_crtc);
+
+    for (uint8_t i = 0; i < SCANOUT_BUFFERS; i++) {
+        if (drm_create_buffer(scanout, i) == EXIT_FAILURE) {
+            scanout_close(scanout);
+            return EXIT_FAILURE;
+        }
+        scanout->buffers++;
+    }
+
+    // Display the first buffer, and write in the other one.
+    struct drm_mode_crtc crtc;
+    memset(&crtc, 0, sizeof(crtc));
+    crtc.crtc_id = scanout->crtc_id;
+    crtc.fb_id = scanout->fb_id[0];
+    crtc.set_connectors_ptr = (uintptr_t)&scanout->connector_id;
+    crtc.count_connectors = 1;
+    crtc.mode = mode;
+    crtc.mode_valid = 1;
+    if (xioctl(scanout->fd, DRM_IOCTL_MODE_SETCRTC, &crtc) == -1) {
+        log_write(LOG_WARNING, "Could not set the DRM mode, is a display server running? %s", strerror(errno));
+        scanout_close(scanout);
+        return EXIT_FAILURE;
+    }
+    scanout->back = 1;
+
+    log_write(LOG_INFO, "DRM output %ux%u@%u on %s", scanout->width, scanout->height, mode.vrefresh, device);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Waits for the completion of the pending page flip.
+ */
+static void drm_wait_flip(scanout_t* scanout)
+{
+    struct pollfd pfd = { .fd = scanout->fd, .events = POLLIN };
+    while (scanout->pending) {
+        int ret = poll(&pfd, 1, SCANOUT_FLIP_TIMEOUT_MS);
+        if (ret == -1 && errno == EINTR) continue;
+        if (ret <= 0) {
+            log_write(LOG_WARNING, "DRM page flip timed out");
+            scanout->pending = false;
+            return;
+        }
+
+        // Events are packed one after the other.
+        uint8_t events[1024];
+        ssize_t len = read(scanout->fd, events, sizeof(events));
+        for (ssize_t off = 0; off + (ssize_t)sizeof(struct drm_event) <= len;) {
+            const struct drm_event* event = (const struct drm_event*)&events[off];
+            if (event->type == DRM_EVENT_FLIP_COMPLETE) scanout->pending = false;
+            if (event->length == 0) break;
+            off += event->length;
+        }
+    }
+}
+
+/****************************************************************************
+ * Framebuffer device
+ ****************************************************************************/
+
+int scanout_open_fbdev(scanout_t* scanout, const char* device)
+{
+    scanout_reset(scanout);
+    scanout->fd = open(device, O_RDWR | O_CLOEXEC);
+    if (scanout->fd == -1) {
+        log_write(LOG_WARNING, "Could not open %s: %s", device, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    scanout->kind = SCANOUT_FBDEV;
+
+    struct fb_var_screeninfo var;
+    struct fb_fix_screeninfo fix;
+    if (xioctl(scanout->fd, FBIOGET_VSCREENINFO, &var) == -1) {
+        log_write(LOG_ERROR, "Could not get the screen information of %s: %s", device, strerror(errno));
+        scanout_close(scanout);
+        return EXIT_FAILURE;
+    }
+    if (var.bits_per_pixel != 32 || var.red.offset != 16 || var.green.offset != 8 || var.blue.offset != 0) {
+        log_write(LOG_ERROR, "Unsupported pixel format of %s: %u bits per pixel", device, var.bits_per_pixel);
+        scanout_close(scanout);
+        return EXIT_FAILURE;
+    }
+
+    // A virtual screen twice as high holds two buffers, swapped by panning.
+    if (var.yres_virtual < 2 * var.yres) {
+        struct fb_var_screeninfo twice = var;
+        twice.yres_virtual = 2 * var.yres;
+        twice.yoffset = 0;
+        if (xioctl(scanout->fd, FBIOPUT_VSCREENINFO, &twice) == 0) var = twice;
+    }
+    if (xioctl(scanout->fd, FBIOGET_FSCREENINFO, &fix) == -1) {
+        log_write(LOG_ERROR, "Could not get the screen information of %s: %s", device, strerror(errno));
+        scanout_close(scanout);
+        return EXIT_FAILURE;
+    }
+    scanout->width = var.xres;
+    scanout->height = var.yres;
+    scanout->pitch = fix.line_length;
+    scanout->size = (size_t)fix.line_length * var.yres;
+    scanout->buffers = (var.yres_virtual >= 2 * var.yres && fix.smem_len >= 2 * scanout->size) ? 2 : 1;
+
+    scanout->fb_len = fix.smem_len;
+    void* data = mmap(NULL, scanout->fb_len, PROT_READ | PROT_WRITE, MAP_SHARED, scanout->fd, 0);
+    if (data == MAP_FAILED) {
+        log_write(LOG_ERROR, "Could not map %s: %s", device, strerror(errno));
+        scanout_close(scanout);
+        return EXIT_FAILURE;
+    }
+    scanout->fb_base = data;
+    for (uint8_t i = 0; i < scanout->buffers; i++) {
+        scanout->map[i] = scanout->fb_base + i * scanout->size;
+    }
+    memset(scanout->fb_base, 0, scanout->buffers * scanout->size);
+
+    // Keep the console from drawing its cursor over the images.
+    scanout->tty_fd = open("/dev/tty0", O_RDWR | O_CLOEXEC);
+    if (scanout->tty_fd != -1 && ioctl(scanout->tty_fd, KDSETMODE, KD_GRAPHICS) == -1) {
+        close(scanout->tty_fd);
+        scanout->tty_fd = -1;
+    }
+
+    // Display the first buffer, and write in the other one if any.
+    if (scanout->buffers == 2) {
+        var.yoffset = 0;
+        xioctl(scanout->fd, FBIOPAN_DISPLAY, &var);
+        scanout->back = 1;
+    }
+
+    log_write(LOG_INFO, "Framebuffer output %ux%u on %s, %u buffer(s)",
+              scanout->width, scanout->height, device, scanout->buffers);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Pans the framebuffer onto the back buffer, and waits for it to be displayed.
+ */
+static int fbdev_flip(scanout_t* scanout)
+{
+    struct fb_var_screeninfo var;
+    if (xioctl(scanout->fd, FBIOGET_VSCREENINFO, &var) == -1) return EXIT_FAILURE;
+    var.yoffset = scanout->back * scanout->height;
+    if (xioctl(scanout->fd, FBIOPAN_DISPLAY, &var) == -1) return EXIT_FAILURE;
+
+    // The previous buffer is free once the panned one is scanned out.
+    uint32_t crtc = 0;
+    xioctl(scanout->fd, FBIO_WAITFORVSYNC, &crtc);
+    return EXIT_SUCCESS;
+}
+
+/****************************************************************************
+ * Common operations
+ ****************************************************************************/
+
+uint8_t* scanout_begin(scanout_t* scanout)
+{
+    if (scanout->kind == SCANOUT_DRM) drm_wait_flip(scanout);
+    return scanout->map[scanout->back];
+}
+
+int scanout_flip(scanout_t* scanout)
+{
+    // A single buffer is written while displayed.
+    if (scanout->buffers < 2) return EXIT_SUCCESS;
+
+    if (scanout->kind == SCANOUT_DRM) {
+        struct drm_mode_crtc_page_flip flip;
+        memset(&flip, 0, sizeof(flip));
+        flip.crtc_id = scanout->crtc_id;
+        flip.fb_id = scanout->fb_id[scanout->back];
+        flip.flags = DRM_MODE_PAGE_FLIP_EVENT;
+        if (xioctl(scanout->fd, DRM_IOCTL_MODE_PAGE_FLIP, &flip) == -1) {
+            log_write(LOG_DEBUG, "DRM page flip failed: %s", strerror(errno));
+            return EXIT_FAILURE;
+        }
+        scanout->pending = true;
+    } else if (fbdev_flip(scanout) == EXIT_FAILURE) {
+        log_write(LOG_DEBUG, "Framebuffer panning failed: %s", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    scanout->back ^= 1;
+    return EXIT_SUCCESS;
+}
+
+void scanout_close(scanout_t* scanout)
+{
+    if (scanout->kind == SCANOUT_DRM) {
+        drm_wait_flip(scanout);
+
+        // Give the screen back to the console, or whoever had it.
+        if (scanout->saved_crtc.fb_id != 0) {
+            scanout->saved_crtc.set_connectors_ptr = (uintptr_t)&scanout->connector_id;
+            scanout->saved_crtc.count_connectors = 1;
+            xioctl(scanout->fd, DRM_IOCTL_MODE_SETCRTC, &scanout->saved_crtc);
+        }
+        for (uint8_t i = 0; i < SCANOUT_BUFFERS; i++) {
+            if (scanout->map[i]) munmap(scanout->map[i], scanout->size);
+            if (scanout->fb_id[i]) xioctl(scanout->fd, DRM_IOCTL_MODE_RMFB, &scanout->fb_id[i]);
+            if (scanout->handle[i]) {
+                struct drm_mode_destroy_dumb destroy = { .handle = scanout->handle[i] };
+                xioctl(scanout->fd, DRM_IOCTL_MODE_DESTROY_DUMB, &destroy);
+            }
+        }
+        xioctl(scanout->fd, DRM_IOCTL_DROP_MASTER, NULL);
+    } else if (scanout->kind == SCANOUT_FBDEV) {
+        struct fb_var_screeninfo var;
+        if (scanout->buffers == 2 && xioctl(scanout->fd, FBIOGET_VSCREENINFO, &var) == 0) {
+            var.yoffset = 0;
+            xioctl(scanout->fd, FBIOPAN_DISPLAY, &var);
+        }
+        if (scanout->fb_base) munmap(scanout->fb_base, scanout->fb_len);
+        if (scanout->tty_fd != -1) {
+            ioctl(scanout->tty_fd, KDSETMODE, KD_TEXT);
+            close(scanout->tty_fd);
+        }
+    }
+
+    if (scanout->fd != -1) close(scanout->fd);
+    scanout_reset(scanout);
+}
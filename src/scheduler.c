@@ -0,0 +1,176 @@
+/**
+ * @file scheduler.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c scheduler.h .
+ *
+ * @see scheduler.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "scheduler.h"
+
+#include <string.h>
+
+/**
+ * @brief Checks if an identifier is in a list.
+ */
+static bool contains(const uint32_t* ids, size_t n, uint32_t id)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (ids[i] == id) return true;
+    }
+    return false;
+}
+
+time_us_t scheduler_travel_us(d_px_t x0, d_px_t y0, d_px_t x1, d_px_t y1)
+{
+    return move_time_us(PWM_FREQ, x0, y0, x1, y1);
+}
+
+/**
+ * @brief Orders the targets to visit with the nearest neighbor heuristic, then 2-opt.
+ *
+ * @param[in,out] plan The targets, ordered in place.
+ * @param[in] n Number of targets.
+ * @param[in] x The X-position of the mirrors [px].
+ * @param[in] y The Y-position of the mirrors [px].
+ */
+static void plan_order(sched_target_t* plan, size_t n, d_px_t x, d_px_t y)
+{
+    // Path starting at the mirrors: node 0 is the mirrors, node i+1 the target i.
+    time_us_t cost[SCHEDULER_MAX_TARGETS + 1][SCHEDULER_MAX_TARGETS + 1];
+    d_px_t px[SCHEDULER_MAX_TARGETS + 1] = {x};
+    d_px_t py[SCHEDULER_MAX_TARGETS + 1] = {y};
+    for (size_t i = 0; i < n; i++) {
+        px[i + 1] = plan[i].x;
+        py[i + 1] = plan[i].y;
+    }
+    for (size_t i = 0; i <= n; i++) {
+        for (size_t j = i; j <= n; j++) {
+            cost[i][j] = scheduler_travel_us(px[i], py[i], px[j], py[j]);
+            cost[j][i] = cost[i][j];
+        }
+    }
+
+    // Nearest neighbor path.
+    size_t path[SCHEDULER_MAX_TARGETS + 1] = {0};
+    bool used[SCHEDULER_MAX_TARGETS + 1] = {true};
+    for (size_t k = 1; k <= n; k++) {
+        size_t best = 0;
+        for (size_t j = 1; j <= n; j++) {
+            if (!used[j] && (best == 0 || cost[path[k - 1]][j] < cost[path[k - 1]][best])) best = j;
+        }
+        path[k] = best;
+        used[best] = true;
+    }
+
+    // Reverse the segments of the path shortening it, until none does.
+    // The travel time being symmetric, a reversed segment keeps its length.
+    bool improved = n >= 2 && n <= SCHEDULER_2OPT_MAX;
+    while (improved) {
+        improved = false;
+        for (size_t i = 1; i < n; i++) {
+            for (size_t j = i + 1; j <= n; j++) {
+                int64_t before = cost[path[i - 1]][path[i]];
+                int64_t after = cost[path[i - 1]][path[j]];
+                if (j < n) {
+                    before += cost[path[j]][path[j + 1]];
+                    after += cost[path[i]][path[j + 1]];
+                }
+                if (after < before) {
+                    for (size_t a = i, b = j; a < b; a++, b--) {
+                        size_t tmp = path[a];
+                        path[a] = path[b];
+                        path[b] = tmp;
+                    }
+                    improved = true;
+                }
+            }
+        }
+    }
+
+    sched_target_t ordered[SCHEDULER_MAX_TARGETS];
+    for (size_t k = 1; k <= n; k++) ordered[k - 1] = plan[path[k] - 1];
+    memcpy(plan, ordered, n * sizeof(sched_target_t));
+}
+
+void scheduler_init(scheduler_t* sched)
+{
+    memset(sched, 0, sizeof(scheduler_t));
+}
+
+size_t scheduler_update(scheduler_t* sched, const sched_target_t* targets, size_t n, d_px_t x, d_px_t y)
+{
+    if (n > SCHEDULER_MAX_TARGETS) n = SCHEDULER_MAX_TARGETS;
+
+    uint32_t ids[SCHEDULER_MAX_TARGETS];
+    for (size_t i = 0; i < n; i++) ids[i] = targets[i].id;
+
+    // Count the planned targets which disappeared.
+    size_t removed = 0;
+    for (size_t i = 0; i < sched->count; i++) {
+        if (!contains(ids, n, sched->plan[i].id)) removed++;
+    }
+
+    // Forget the visited targets which disappeared.
+    size_t kept = 0;
+    for (size_t i = 0; i < sched->visited_count; i++) {
+        if (contains(ids, n, sched->visited[i])) sched->visited[kept++] = sched->visited[i];
+    }
+    sched->visited_count = kept;
+
+    // Start a new round once all the targets have been visited, the last
+    // visited one being deferred to the end of the round.
+    if (sched->visited_count >= n) {
+        sched->visited_count = 0;
+        sched->deferred_id = n > 1 ? sched->last_id : 0;
+    }
+
+    // Plan the targets not visited yet, at their current positions.
+    const sched_target_t* deferred = NULL;
+    sched->count = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (contains(sched->visited, sched->visited_count, ids[i])) continue;
+        if (ids[i] == sched->deferred_id) {
+            deferred = &targets[i];
+        } else {
+            sched->plan[sched->count++] = targets[i];
+        }
+    }
+    plan_order(sched->plan, sched->count, x, y);
+    if (deferred) sched->plan[sched->count++] = *deferred;
+
+    return removed;
+}
+
+bool scheduler_next(scheduler_t* sched, sched_target_t* target)
+{
+    if (sched->count == 0) return false;
+
+    *target = sched->plan[0];
+    sched->count--;
+    memmove(sched->plan, sched->plan + 1, sched->count * sizeof(sched_target_t));
+
+    if (sched->visited_count < SCHEDULER_MAX_TARGETS) sched->visited[sched->visited_count++] = target->id;
+    sched->last_id = target->id;
+    if (target->id == sched->deferred_id) sched->deferred_id = 0;
+    return true;
+}
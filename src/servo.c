@@ -0,0 +1,156 @@
+/**
+ * @file servo.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c servo.h .
+ *
+ * @see servo.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "servo.h"
+
+#include <math.h>
+
+#include "psig_utils.h"
+#include "log_utils.h"
+#include "ipc_elements.h"
+#include "perf_counters.h"
+#include "stepper_demo.h"
+#include "laser_dot.h"
+#include "calib.h"
+#include "flight_recorder.h"
+
+// Statistics, updated with atomic built-ins.
+static uint64_t frames = 0;
+static uint64_t found = 0;
+static uint64_t corrections = 0;
+static uint64_t steps = 0;
+
+void servo_get_stats(servo_stats_t* stats)
+{
+    stats->frames = __atomic_load_n(&frames, __ATOMIC_RELAXED);
+    stats->found = __atomic_load_n(&found, __ATOMIC_RELAXED);
+    stats->corrections = __atomic_load_n(&corrections, __ATOMIC_RELAXED);
+    stats->steps = __atomic_load_n(&steps, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Computes the steps missed by a motor.
+ *
+ * @param[in] dot The step position aiming at the dot [steps].
+ * @param[in] target The step position aiming at the target, or counted by the motor [steps].
+ * @return The steps the motor is ahead of the position, 0 within the deadband.
+ */
+static int32_t missed_steps(float dot, float target)
+{
+    // The motor aims at the rounded step position of its target.
+    float error = dot - (float)lroundf(target);
+    return fabsf(error) < SERVO_DEADBAND_STEPS ? 0 : (int32_t)lroundf(error);
+}
+
+/**
+ * @brief Compares the laser dot of a frame with the target of the motors.
+ */
+static void process_frame(const frame_t* frame)
+{
+    // Only frames exposed with the mirrors at rest on their target.
+    d_px_t x, y;
+    uint64_t arrival_ns;
+    if (motor_get_mode() != MOTOR_MODE_POINT || !read_abs_pos(&x, &y, &arrival_ns)) return;
+    if (frame->timestamp_ns < arrival_ns + SERVO_SETTLE_MS * 1000000ULL) return;
+    __atomic_add_fetch(&frames, 1, __ATOMIC_RELAXED);
+
+    laser_dot_t dot;
+    if (!laser_dot_find_roi(frame, x - SERVO_SEARCH, y - SERVO_SEARCH,
+                            2 * SERVO_SEARCH + 1, 2 * SERVO_SEARCH + 1, &dot)) {
+        return;
+    }
+    __atomic_add_fetch(&found, 1, __ATOMIC_RELAXED);
+
+    // Steps off the target on each axis, according to the calibration model.
+    float tx, ty, dx, dy;
+    calib_px_to_steps(x, y, &tx, &ty);
+    calib_px_to_steps(dot.x, dot.y, &dx, &dy);
+    int32_t ex = missed_steps(dx, tx);
+    int32_t ey = missed_steps(dy, ty);
+    if (ex == 0 && ey == 0) return;
+    if (abs(ex) > SERVO_MAX_STEPS || abs(ey) > SERVO_MAX_STEPS) {
+        log_write(LOG_DEBUG, "Laser dot at (%.1f, %.1f) px too far from (%d, %d), ignored", dot.x, dot.y, x, y);
+        return;
+    }
+
+    // Steps missed with respect to the step positions counted by the motors,
+    // which already include the steps emitted beyond a move.
+    int32_t cx, cy;
+    motor_get_steps(&cx, &cy);
+    int32_t mx = missed_steps(dx, (float)cx);
+    int32_t my = missed_steps(dy, (float)cy);
+
+    // Resynchronize the step positions and move back onto the target, only
+    // moving back for the steps already counted.
+    if (resync_abs_pos(x, y, mx, my) && (mx != 0 || my != 0)) {
+        __atomic_add_fetch(&corrections, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&steps, (uint64_t)(abs(mx) + abs(my)), __ATOMIC_RELAXED);
+        log_write(LOG_INFO, "Laser dot at (%.1f, %.1f) px for (%d, %d), corrected by (%d, %d) steps",
+                  dot.x, dot.y, x, y, -mx, -my);
+        flight_trigger(FLIGHT_TRIGGER_MISSED_STEPS);
+    }
+}
+
+void* servo_task(void* arg)
+{
+    log_write(LOG_INFO, "Start visual servoing task");
+
+    // Install signal handler for system signals.
+    psig_install_handler();
+
+    // Only the latest frame tells where the dot is.
+    frame_sub_t* sub = frame_bus_subscribe(&cam_bus, "servo", FRAME_BUS_LATEST, 0);
+    if (!sub) {
+        log_write(LOG_ERROR, "Could not subscribe to the camera bus");
+        thread_ready_num++;
+        pthread_exit(NULL);
+    }
+
+    // Servoing loop that continues until a termination signal is received.
+    while (!psig_kill_requested()) {
+        frame_t* frame = frame_sub_receive(&cam_bus, sub, SERVO_WAIT_MS);
+        if (!frame) continue;
+
+        perf_stage_begin(PERF_STAGE_SERVO);
+        process_frame(frame);
+        perf_stage_end(PERF_STAGE_SERVO);
+        frame_unref(frame);
+    }
+
+    frame_bus_unsubscribe(&cam_bus, sub);
+
+    servo_stats_t stats;
+    servo_get_stats(&stats);
+    log_write(LOG_INFO, "Servoing: %llu frames at rest, %llu dots found, %llu corrections, %llu steps",
+              (unsigned long long)stats.frames, (unsigned long long)stats.found,
+              (unsigned long long)stats.corrections, (unsigned long long)stats.steps);
+
+    // Indicate the task is complete.
+    thread_ready_num++;
+    log_write(LOG_INFO, "Stopping visual servoing task");
+    pthread_exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,428 @@
+/**
+ * @file shm_ipc.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c shm_ipc.h .
+ *
+ * Leases rely on the frame ring writer and the lease writer each storing
+ * their own word before reading the other one, with full fences in between:
+ * either the producer sees the lease before recycling a frame, or the
+ * client sees the ring entry change and retries with a newer frame.
+ *
+ * @see shm_ipc.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "shm_ipc.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "psig_utils.h"
+#include "log_utils.h"
+#include "ipc_elements.h"
+#include "frame_pool.h"
+#include "stepper_demo.h"
+#include "targeting.h"
+#include "motion_gate.h"
+#include "rate_governor.h"
+#include "frame_bus.h"
+
+// Producer side mappings.
+static shm_frame_ring_t* frames_ring = NULL;
+static shm_detection_ring_t* dets_ring = NULL;
+
+// Client side mappings.
+static const shm_frame_ring_t* client_frames = NULL;
+static shm_detection_ring_t* client_dets = NULL;
+static const uint8_t* client_pool = NULL;
+static size_t client_pool_bytes = 0;
+static uint32_t client_seq = 0;
+
+/*******************************************************************************
+ * Helper functions
+ ******************************************************************************/
+
+/**
+ * @brief Sleeps while a shared futex word holds the given value.
+ */
+static void futex_wait(uint32_t* word, uint32_t value, uint32_t timeout_ms)
+{
+    struct timespec timeout = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_nsec = (long)(timeout_ms % 1000) * 1000000L
+    };
+    syscall(SYS_futex, word, FUTEX_WAIT, value, &timeout, NULL, 0);
+}
+
+/**
+ * @brief Wakes up all the processes sleeping on a shared futex word.
+ */
+static void futex_wake(uint32_t* word)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+/**
+ * @brief Maps a shared memory object, creating it if requested.
+ *
+ * @return The mapping, or @c NULL on failure.
+ */
+static void* shm_map(const char* name, size_t size, bool create, bool writable)
+{
+    int fd = shm_open(name, create ? (O_CREAT | O_RDWR) : (writable ? O_RDWR : O_RDONLY), 0644);
+    if (fd < 0) return NULL;
+
+    if (create && ftruncate(fd, (off_t)size) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void* memory = mmap(NULL, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return memory == MAP_FAILED ? NULL : memory;
+}
+
+/*******************************************************************************
+ * Producer side
+ ******************************************************************************/
+
+int shm_ipc_init(void)
+{
+    frames_ring = shm_map(SHM_FRAMES_NAME, sizeof(shm_frame_ring_t), true, true);
+    dets_ring = shm_map(SHM_DETECTIONS_NAME, sizeof(shm_detection_ring_t), true, true);
+    if (!frames_ring || !dets_ring) {
+        perror("[Error] Could not create the shared memory rings");
+        shm_ipc_close();
+        return EXIT_FAILURE;
+    }
+
+    memset(frames_ring, 0, sizeof(shm_frame_ring_t));
+    frames_ring->version = SHM_VERSION;
+    frames_ring->pool_bytes = frame_pool_bytes();
+    frames_ring->alive = 1;
+
+    memset(dets_ring, 0, sizeof(shm_detection_ring_t));
+    dets_ring->version = SHM_VERSION;
+
+    // Clients check the magic numbers last.
+    __atomic_store_n(&dets_ring->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+    __atomic_store_n(&frames_ring->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+    return EXIT_SUCCESS;
+}
+
+void shm_ipc_close(void)
+{
+    if (frames_ring) {
+        munmap(frames_ring, sizeof(shm_frame_ring_t));
+        frames_ring = NULL;
+    }
+    if (dets_ring) {
+        munmap(dets_ring, sizeof(shm_detection_ring_t));
+        dets_ring = NULL;
+    }
+    shm_unlink(SHM_FRAMES_NAME);
+    shm_unlink(SHM_DETECTIONS_NAME);
+}
+
+void shm_ipc_set_calibrated(bool calibrated)
+{
+    if (dets_ring) __atomic_store_n(&dets_ring->calibrated, calibrated ? 1 : 0, __ATOMIC_RELEASE);
+}
+
+void* shm_publish_task(void* arg)
+{
+    log_write(LOG_INFO, "Start shared memory publish task");
+
+    // Install signal handler for system signals.
+    psig_install_handler();
+
+    // Frames referenced by the ring entries, and by the client lease.
+    frame_t* held[SHM_FRAME_RING_SIZE] = { NULL };
+    frame_t* leased = NULL;
+
+    frame_sub_t* sub = frame_bus_subscribe(&cam_bus, "shm", FRAME_BUS_LATEST, 0);
+    if (!sub) {
+        log_write(LOG_ERROR, "Could not subscribe to the camera bus");
+        thread_ready_num++;
+        pthread_exit(NULL);
+    }
+
+    // The ring and the lease keep the frames received but the one being published.
+    if (!frame_sub_hold(&cam_bus, sub, SHM_FRAME_RING_SIZE)) {
+        log_write(LOG_ERROR, "Not enough frames in the pool for the shared memory ring");
+        frame_bus_unsubscribe(&cam_bus, sub);
+        thread_ready_num++;
+        pthread_exit(NULL);
+    }
+
+    // Publishing loop that continues until a termination signal is received.
+    while (!psig_kill_requested()) {
+        frame_t* frame = frame_sub_receive(&cam_bus, sub, SHM_WAIT_MS);
+        if (!frame) continue;
+
+        // In idle, or on a static scene keeping its last detections, no inference.
+        if (!governor_admit() || !motion_gate_admit(frame)) {
+            frame_unref(frame);
+            continue;
+        }
+
+        uint32_t seq = frames_ring->seq;
+        uint32_t idx = seq % SHM_FRAME_RING_SIZE;
+        shm_frame_entry_t* entry = &frames_ring->entries[idx];
+
+        // Mark the entry as being written, then look for a lease on the evicted frame.
+        uint32_t gen = entry->gen;
+        __atomic_store_n(&entry->gen, gen + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        uint64_t lease = __atomic_load_n(&dets_ring->lease, __ATOMIC_RELAXED);
+
+        frame_t* evicted = held[idx];
+        if (evicted && evicted->frame_id == lease) {
+            frame_unref(leased);
+            leased = evicted;
+        } else {
+            frame_unref(evicted);
+        }
+        if (leased && leased->frame_id != lease) {
+            frame_unref(leased);
+            leased = NULL;
+        }
+
+        entry->offset = frame_pool_offset(frame);
+        entry->info.frame_id = frame->frame_id;
+        entry->info.timestamp_ns = frame->timestamp_ns;
+        entry->info.size = frame->size;
+        entry->info.width = frame->width;
+        entry->info.height = frame->height;
+        __atomic_store_n(&entry->gen, gen + 2, __ATOMIC_RELEASE);
+
+        // The ring keeps the reference received from the bus.
+        held[idx] = frame;
+        __atomic_store_n(&frames_ring->seq, seq + 1, __ATOMIC_RELEASE);
+        futex_wake(&frames_ring->seq);
+    }
+
+    // Tell the client to stop waiting for frames.
+    __atomic_store_n(&frames_ring->alive, 0, __ATOMIC_RELEASE);
+    futex_wake(&frames_ring->seq);
+
+    for (int i = 0; i < SHM_FRAME_RING_SIZE; i++) {
+        frame_unref(held[i]);
+    }
+    frame_unref(leased);
+    frame_bus_unsubscribe(&cam_bus, sub);
+
+    // Indicate the task is complete.
+    thread_ready_num++;
+    log_write(LOG_INFO, "Stopping shared memory publish task");
+    pthread_exit(EXIT_SUCCESS);
+}
+
+void* shm_detections_task(void* arg)
+{
+    log_write(LOG_INFO, "Start shared memory detections task");
+
+    // Install signal handler for system signals.
+    psig_install_handler();
+
+    uint32_t last = __atomic_load_n(&dets_ring->seq, __ATOMIC_ACQUIRE);
+    shm_detection_entry_t batch;
+
+    // Reading loop that continues until a termination signal is received.
+    while (!psig_kill_requested()) {
+        uint32_t seq = __atomic_load_n(&dets_ring->seq, __ATOMIC_ACQUIRE);
+        if (seq == last) {
+            futex_wait(&dets_ring->seq, seq, SHM_WAIT_MS);
+            continue;
+        }
+
+        // Skip the batches already overwritten.
+        if (seq - last > SHM_DETECTION_RING_SIZE) {
+            log_write(LOG_WARNING, "Dropped %u detection batches", seq - last - SHM_DETECTION_RING_SIZE);
+            last = seq - SHM_DETECTION_RING_SIZE;
+        }
+
+        for (; last != seq; last++) {
+            const shm_detection_entry_t* entry = &dets_ring->entries[last % SHM_DETECTION_RING_SIZE];
+
+            // Copy the batch, then check it was not overwritten meanwhile.
+            uint32_t gen = __atomic_load_n(&entry->gen, __ATOMIC_ACQUIRE);
+            memcpy(&batch, entry, sizeof(batch));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if ((gen & 1) || gen != __atomic_load_n(&entry->gen, __ATOMIC_RELAXED)) {
+                log_write(LOG_WARNING, "Dropped a detection batch being overwritten");
+                continue;
+            }
+
+            uint32_t count = batch.count > SHM_MAX_DETECTIONS ? SHM_MAX_DETECTIONS : batch.count;
+            if (!(batch.flags & SHM_DETECTIONS_CALIBRATION)) {
+                targeting_submit(batch.dets, count, batch.frame_id);
+                continue;
+            }
+
+            // Send the calibration reference, once.
+            if (count == 0) continue;
+            if (__atomic_load_n(&dets_ring->calibrated, __ATOMIC_ACQUIRE)) {
+                log_write(LOG_WARNING, "Motors already calibrated, ignoring reference");
+                continue;
+            }
+            const detection_t* det = &batch.dets[0];
+            write_abs_pos((d_px_t)((det->x1 + det->x2) / 2), (d_px_t)((det->y1 + det->y2) / 2));
+            __atomic_store_n(&dets_ring->calibrated, 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    // Indicate the task is complete.
+    thread_ready_num++;
+    log_write(LOG_INFO, "Stopping shared memory detections task");
+    pthread_exit(EXIT_SUCCESS);
+}
+
+/*******************************************************************************
+ * Client side (inference process)
+ ******************************************************************************/
+
+int shm_client_connect(void)
+{
+    if (client_frames) return EXIT_SUCCESS;
+
+    const shm_frame_ring_t* frames = shm_map(SHM_FRAMES_NAME, sizeof(shm_frame_ring_t), false, false);
+    shm_detection_ring_t* dets = shm_map(SHM_DETECTIONS_NAME, sizeof(shm_detection_ring_t), false, true);
+    if (!frames || !dets ||
+        __atomic_load_n(&frames->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC || frames->version != SHM_VERSION ||
+        __atomic_load_n(&dets->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC || dets->version != SHM_VERSION) {
+        if (frames) munmap((void*)frames, sizeof(shm_frame_ring_t));
+        if (dets) munmap(dets, sizeof(shm_detection_ring_t));
+        return EXIT_FAILURE;
+    }
+
+    size_t pool_bytes = frames->pool_bytes;
+    const uint8_t* pool = shm_map(SHM_POOL_NAME, pool_bytes, false, false);
+    if (!pool) {
+        munmap((void*)frames, sizeof(shm_frame_ring_t));
+        munmap(dets, sizeof(shm_detection_ring_t));
+        return EXIT_FAILURE;
+    }
+
+    client_frames = frames;
+    client_dets = dets;
+    client_pool = pool;
+    client_pool_bytes = pool_bytes;
+    client_seq = __atomic_load_n(&frames->seq, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&client_dets->lease, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&client_dets->client_pid, (int32_t)getpid(), __ATOMIC_RELAXED);
+    return EXIT_SUCCESS;
+}
+
+void shm_client_disconnect(void)
+{
+    if (!client_frames) return;
+    __atomic_store_n(&client_dets->lease, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&client_dets->client_pid, 0, __ATOMIC_RELAXED);
+    munmap((void*)client_frames, sizeof(shm_frame_ring_t));
+    munmap(client_dets, sizeof(shm_detection_ring_t));
+    munmap((void*)client_pool, client_pool_bytes);
+    client_frames = NULL;
+    client_dets = NULL;
+    client_pool = NULL;
+}
+
+bool shm_client_alive(void)
+{
+    return client_frames && __atomic_load_n(&client_frames->alive, __ATOMIC_ACQUIRE);
+}
+
+bool shm_client_calibrated(void)
+{
+    return client_dets && __atomic_load_n(&client_dets->calibrated, __ATOMIC_ACQUIRE);
+}
+
+const uint8_t* shm_client_wait_frame(shm_frame_info_t* info)
+{
+    if (!client_frames) return NULL;
+
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (shm_client_alive()) {
+        uint32_t seq = __atomic_load_n(&client_frames->seq, __ATOMIC_ACQUIRE);
+        if (seq == client_seq) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            int64_t elapsed_ms = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+            if (elapsed_ms >= SHM_WAIT_MS) return NULL;
+            futex_wait((uint32_t*)&client_frames->seq, seq, SHM_WAIT_MS - (uint32_t)elapsed_ms);
+            continue;
+        }
+
+        // Read the latest entry, then lease its frame before checking it is still there.
+        const shm_frame_entry_t* entry = &client_frames->entries[(seq - 1) % SHM_FRAME_RING_SIZE];
+        uint32_t gen = __atomic_load_n(&entry->gen, __ATOMIC_ACQUIRE);
+        if (gen & 1) continue;
+        uint64_t offset = entry->offset;
+        shm_frame_info_t frame_info = entry->info;
+
+        __atomic_store_n(&client_dets->lease, frame_info.frame_id, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&entry->gen, __ATOMIC_RELAXED) != gen) continue;
+        if (offset + frame_info.size > client_pool_bytes) continue;
+
+        client_seq = seq;
+        *info = frame_info;
+        return client_pool + offset;
+    }
+    return NULL;
+}
+
+void shm_client_release_frame(void)
+{
+    if (client_dets) {
+        __atomic_store_n(&client_dets->lease, 0, __ATOMIC_SEQ_CST);
+    }
+}
+
+int shm_client_submit(const detection_t* dets, size_t n, uint64_t frame_id, uint32_t flags)
+{
+    if (!client_dets) return EXIT_FAILURE;
+    if (n > SHM_MAX_DETECTIONS) n = SHM_MAX_DETECTIONS;
+
+    uint32_t seq = client_dets->seq;
+    shm_detection_entry_t* entry = &client_dets->entries[seq % SHM_DETECTION_RING_SIZE];
+
+    uint32_t gen = entry->gen;
+    __atomic_store_n(&entry->gen, gen + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    entry->flags = flags;
+    entry->frame_id = frame_id;
+    entry->count = (uint32_t)n;
+    memcpy(entry->dets, dets, n * sizeof(detection_t));
+    __atomic_store_n(&entry->gen, gen + 2, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&client_dets->seq, seq + 1, __ATOMIC_RELEASE);
+    futex_wake(&client_dets->seq);
+    return EXIT_SUCCESS;
+}
@@ -27,20 +27,128 @@
 
 #include "stepper_demo.h"
 
-void write_abs_pos(d_px_t x, d_px_t y)
+#include "flight_recorder.h"
+
+// Serializes the writers of the coordinates buffers.
+static pthread_mutex_t pos_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Last target position sent to the motors, and its lock.
+static pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
+static d_px_t last_x_px = 0;
+static d_px_t last_y_px = 0;
+static uint64_t last_arrival_ns = 0;
+static bool pos_calibrated = false;
+
+/**
+ * @brief Sends the coordinates to the buffers, and waits for both motors to read them.
+ *
+ * @note Must be called with @c pos_mutex held.
+ */
+static void post_pos(d_px_t x, d_px_t y)
 {
-    // Send X and Y coordinates to the buffers.
+    // Send X and Y coordinates to the buffers, both motors reading both.
     x_px_buff = x;
-    sem_post(&data_x_ready_sem);
     y_px_buff = y;
+    flight_record_command(x, y, 0.0f, 0.0f, false);
+    sem_post(&data_x_ready_sem);
     sem_post(&data_y_ready_sem);
-    printf("[Info] sent x=%d, y=%d\n", x_px_buff, y_px_buff);
 
     // Wait for the motors to read the coordinates.
     sem_wait(&data_x_done_sem);
     sem_wait(&data_y_done_sem);
 }
 
+void write_abs_pos(d_px_t x, d_px_t y)
+{
+    pthread_mutex_lock(&pos_mutex);
+
+    // Once calibrated, the motors in velocity mode follow the position at rest.
+    if (motor_get_mode() == MOTOR_MODE_VELOCITY && read_abs_pos(NULL, NULL, NULL)) {
+        uint64_t now_ns = frame_clock_now();
+        axis_target_t tx = { x, 0.0f, now_ns };
+        axis_target_t ty = { y, 0.0f, now_ns };
+        motor_follow(&tx, &ty);
+        log_write(LOG_INFO, "following x=%d, y=%d", x, y);
+
+        pthread_mutex_lock(&state_mutex);
+        last_x_px = x;
+        last_y_px = y;
+        last_arrival_ns = now_ns;
+        pthread_mutex_unlock(&state_mutex);
+        pthread_mutex_unlock(&pos_mutex);
+        return;
+    }
+
+    post_pos(x, y);
+    log_write(LOG_INFO, "sent x=%d, y=%d", x, y);
+
+    // Both motors start moving now.
+    uint64_t now_ns = frame_clock_now();
+
+    // Record the position, the first one being the calibration reference.
+    pthread_mutex_lock(&state_mutex);
+    if (pos_calibrated) {
+        last_arrival_ns = now_ns + (uint64_t)move_time_us(PWM_FREQ, last_x_px, last_y_px, x, y) * 1000ULL;
+    } else {
+        last_arrival_ns = now_ns;
+    }
+    last_x_px = x;
+    last_y_px = y;
+    pos_calibrated = true;
+    pthread_mutex_unlock(&state_mutex);
+
+    pthread_mutex_unlock(&pos_mutex);
+}
+
+bool resync_abs_pos(d_px_t x, d_px_t y, int32_t dx, int32_t dy)
+{
+    pthread_mutex_lock(&pos_mutex);
+
+    // Only while the motors still aim at the measured target, in point mode.
+    pthread_mutex_lock(&state_mutex);
+    bool current = pos_calibrated && last_x_px == x && last_y_px == y;
+    pthread_mutex_unlock(&state_mutex);
+    if (!current || motor_get_mode() != MOTOR_MODE_POINT) {
+        pthread_mutex_unlock(&pos_mutex);
+        return false;
+    }
+
+    // The same position moves the motors by the missed steps only.
+    motor_resync(dx, dy);
+    post_pos(x, y);
+    log_write(LOG_DEBUG, "resync x=%d, y=%d by (%d, %d) steps", x, y, dx, dy);
+
+    uint32_t steps = (uint32_t)(abs(dx) > abs(dy) ? abs(dx) : abs(dy));
+    pthread_mutex_lock(&state_mutex);
+    last_arrival_ns = frame_clock_now() + (uint64_t)steps * 1000000000ULL / PWM_FREQ;
+    pthread_mutex_unlock(&state_mutex);
+
+    pthread_mutex_unlock(&pos_mutex);
+    return true;
+}
+
+bool read_abs_pos(d_px_t* x, d_px_t* y, uint64_t* arrival_ns)
+{
+    pthread_mutex_lock(&state_mutex);
+    bool calibrated = pos_calibrated;
+    if (calibrated && x && y) {
+        *x = last_x_px;
+        *y = last_y_px;
+        if (arrival_ns) *arrival_ns = last_arrival_ns;
+    }
+    pthread_mutex_unlock(&state_mutex);
+
+    // In velocity mode, the motors are where their steps brought them.
+    if (calibrated && x && y && motor_get_mode() == MOTOR_MODE_VELOCITY) {
+        float ex, ey;
+        motor_estimate(&ex, &ey);
+        *x = (d_px_t)lroundf(ex);
+        *y = (d_px_t)lroundf(ey);
+        if (arrival_ns) *arrival_ns = frame_clock_now();
+    }
+    return calibrated;
+}
+
 void circle(d_px_t r, uint8_t n_pts, time_us_t delay)
 {
     // Angular step.
@@ -55,7 +163,7 @@ void circle(d_px_t r, uint8_t n_pts, time_us_t delay)
         // Compute and write coordinates to the buffers.
         d_px_t x = (d_px_t)(r * cos(a));
         d_px_t y = (d_px_t)(r * sin(a));
-        printf("[Info] Point %d: ", i);
+        log_write(LOG_INFO, "Point %d", i);
         write_abs_pos(x, y);
 
         wait_interruptible_us(delay, 1000, psig_kill_requested);
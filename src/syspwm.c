@@ -31,6 +31,9 @@
 const syspwm_t SYSPWM_3 = { 0, 3 };
 const syspwm_t SYSPWM_4 = { 0, 4 };
 
+// Directory holding the PWM chips.
+static const char* syspwm_root = SYSPWM_DEFAULT_ROOT;
+
 
 /*******************************************************************************
  * Helper functions
@@ -83,7 +86,7 @@ int write_sysfs(const char* path, const char* value)
 bool syspwm_is_exported(const syspwm_t* pwm)
 {
     char path[128];
-    snprintf(path, sizeof(path), "/sys/class/pwm/pwmchip%u/pwm%u", pwm->chip_no, pwm->channel_no);
+    snprintf(path, sizeof(path), "%s/pwmchip%u/pwm%u", syspwm_root, pwm->chip_no, pwm->channel_no);
     struct stat st;
     return stat(path, &st) == 0;
 }
@@ -93,6 +96,12 @@ bool syspwm_is_exported(const syspwm_t* pwm)
  * API functions
  ******************************************************************************/
 
+void syspwm_set_root(const char* root)
+{
+    syspwm_root = root ? root : SYSPWM_DEFAULT_ROOT;
+}
+
+
 int syspwm_init(const syspwm_t* pwm, period_ns_t period, duty_percent_t duty_c)
 {
     // Error on wrong parameter values.
@@ -103,12 +112,12 @@ int syspwm_init(const syspwm_t* pwm, period_ns_t period, duty_percent_t duty_c)
 
     // Write period.
     char path[128], buf[32];
-    snprintf(path, sizeof(path), "/sys/class/pwm/pwmchip%u/pwm%u/period", pwm->chip_no, pwm->channel_no);
+    snprintf(path, sizeof(path), "%s/pwmchip%u/pwm%u/period", syspwm_root, pwm->chip_no, pwm->channel_no);
     snprintf(buf, sizeof(buf), "%u", period);
     if (write_sysfs(path, buf) != EXIT_SUCCESS) return EXIT_FAILURE;
 
     // Write duty cycle.
-    snprintf(path, sizeof(path), "/sys/class/pwm/pwmchip%u/pwm%u/duty_cycle", pwm->chip_no, pwm->channel_no);
+    snprintf(path, sizeof(path), "%s/pwmchip%u/pwm%u/duty_cycle", syspwm_root, pwm->chip_no, pwm->channel_no);
     snprintf(buf, sizeof(buf), "%u", (uint32_t)(duty_c * period / 100));
     if (write_sysfs(path, buf) != EXIT_SUCCESS) return EXIT_FAILURE;
 
@@ -127,7 +136,7 @@ int syspwm_check(const syspwm_t* pwm)
 
     // Print PWM current period [ns].
     char path[128], val[32];
-    snprintf(path, sizeof(path), "/sys/class/pwm/pwmchip%u/pwm%u/period", pwm->chip_no, pwm->channel_no);
+    snprintf(path, sizeof(path), "%s/pwmchip%u/pwm%u/period", syspwm_root, pwm->chip_no, pwm->channel_no);
     FILE* f = fopen(path, "r");
     if (f) {
         if (fgets(val, sizeof(val), f)) {
@@ -137,7 +146,7 @@ int syspwm_check(const syspwm_t* pwm)
     }
 
     // Print PWM current duty cycle [ns].
-    snprintf(path, sizeof(path), "/sys/class/pwm/pwmchip%u/pwm%u/duty_cycle", pwm->chip_no, pwm->channel_no);
+    snprintf(path, sizeof(path), "%s/pwmchip%u/pwm%u/duty_cycle", syspwm_root, pwm->chip_no, pwm->channel_no);
     f = fopen(path, "r");
     if (f) {
         if (fgets(val, sizeof(val), f)) {
@@ -153,17 +162,17 @@ int syspwm_check(const syspwm_t* pwm)
 int syspwm_enable(const syspwm_t* pwm, syspwm_state_t enable)
 {
     char path[128];
-    snprintf(path, sizeof(path), "/sys/class/pwm/pwmchip%u/pwm%u/enable", pwm->chip_no, pwm->channel_no);
+    snprintf(path, sizeof(path), "%s/pwmchip%u/pwm%u/enable", syspwm_root, pwm->chip_no, pwm->channel_no);
     return write_sysfs(path, enable ? "1" : "0"); 
 }
 
 
-void syspwm_stepper_sig(const syspwm_t* pwm, frequency_hz_t freq, step_t steps)
+step_t syspwm_stepper_sig(const syspwm_t* pwm, frequency_hz_t freq, step_t steps)
 {
     // Avoid division by zero.
     if (freq == 0) {
         fprintf(stderr, "[Error] Frequency cannot be zero\n");
-        return;
+        return 0;
     }
 
     // Compute period and set fixed PWM duty cycle.
@@ -176,6 +185,8 @@ void syspwm_stepper_sig(const syspwm_t* pwm, frequency_hz_t freq, step_t steps)
 
     // Power-on the PWM pin.
     syspwm_enable(pwm, SYSPWM_ENABLE);
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
     // Compute signal duration.
     time_us_t duration = period / 1000;
@@ -188,5 +199,42 @@ void syspwm_stepper_sig(const syspwm_t* pwm, frequency_hz_t freq, step_t steps)
     }
 
     // Power-off the PWM pin.
+    clock_gettime(CLOCK_MONOTONIC, &stop);
     syspwm_enable(pwm, SYSPWM_DISABLE);
+
+    // Steps emitted while the signal ran.
+    uint64_t elapsed_ns = (uint64_t)(stop.tv_sec - start.tv_sec) * 1000000000ULL
+                        + (uint64_t)(stop.tv_nsec - start.tv_nsec);
+    uint64_t emitted = elapsed_ns * freq / 1000000000ULL;
+    return emitted > UINT16_MAX ? UINT16_MAX : (step_t)emitted;
+}
+
+
+int syspwm_set_freq(const syspwm_t* pwm, frequency_hz_t old_freq, frequency_hz_t freq)
+{
+    // Stop the signal.
+    if (freq == 0) {
+        return old_freq == 0 ? EXIT_SUCCESS : syspwm_enable(pwm, SYSPWM_DISABLE);
+    }
+
+    // Start the signal.
+    period_ns_t period = 1000000000UL / freq;
+    if (old_freq == 0) {
+        if (syspwm_init(pwm, period, 50) != EXIT_SUCCESS) return EXIT_FAILURE;
+        return syspwm_enable(pwm, SYSPWM_ENABLE);
+    }
+
+    // Keep the duty cycle within the period at all times.
+    period_ns_t old_period = 1000000000UL / old_freq;
+    char period_path[128], duty_path[128], period_buf[32], duty_buf[32];
+    snprintf(period_path, sizeof(period_path), "%s/pwmchip%u/pwm%u/period", syspwm_root, pwm->chip_no, pwm->channel_no);
+    snprintf(duty_path, sizeof(duty_path), "%s/pwmchip%u/pwm%u/duty_cycle", syspwm_root, pwm->chip_no, pwm->channel_no);
+    snprintf(period_buf, sizeof(period_buf), "%u", period);
+    snprintf(duty_buf, sizeof(duty_buf), "%u", period / 2);
+    if (period < old_period) {
+        if (write_sysfs(duty_path, duty_buf) != EXIT_SUCCESS) return EXIT_FAILURE;
+        return write_sysfs(period_path, period_buf);
+    }
+    if (write_sysfs(period_path, period_buf) != EXIT_SUCCESS) return EXIT_FAILURE;
+    return write_sysfs(duty_path, duty_buf);
 }
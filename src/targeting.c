@@ -0,0 +1,422 @@
+/**
+ * @file targeting.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c targeting.h .
+ *
+ * @see targeting.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "targeting.h"
+
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <math.h>
+
+#include "psig_utils.h"
+#include "log_utils.h"
+#include "ipc_elements.h"
+#include "stepper_demo.h"
+#include "frame_clock.h"
+#include "tracker.h"
+#include "scheduler.h"
+#include "corr_tracker.h"
+#include "overlay.h"
+#include "flight_recorder.h"
+#include "motion_gate.h"
+#include "rate_governor.h"
+
+// Mailbox: tracks updated with the latest detections not handled yet.
+static pthread_mutex_t mailbox_mutex;
+static pthread_cond_t mailbox_cond;
+static tracker_t tracker;
+static uint64_t last_frame_id = 0;
+static bool pending = false;
+static bool refreshed = false;
+
+// Visit order of the targets, only used by the targeting thread.
+static scheduler_t sched;
+
+// Time spent on each target [ms].
+static uint32_t dwell_ms = TARGETING_DEFAULT_DWELL_MS;
+
+// Fixed-point iterations predicting the position of a target at beam arrival.
+#define LEAD_ITERATIONS 3
+
+// Statistics, updated with atomic built-ins.
+static uint64_t submitted = 0;
+static uint64_t replaced = 0;
+static uint64_t targets = 0;
+static uint64_t abandoned = 0;
+
+void targeting_init(void)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&mailbox_mutex, NULL);
+    pthread_cond_init(&mailbox_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    tracker_init(&tracker);
+    scheduler_init(&sched);
+}
+
+void targeting_close(void)
+{
+    pthread_mutex_destroy(&mailbox_mutex);
+    pthread_cond_destroy(&mailbox_cond);
+}
+
+/**
+ * @brief Updates the tracks with the detections of a frame, and wakes up the
+ *        targeting thread and the viewers.
+ *
+ * @param[in] dets The detections.
+ * @param[in] n Number of detections, at most @c TARGETING_MAX_DETECTIONS .
+ * @param[in] frame_id Frame the detections come from, 0 if unknown.
+ * @param[in] reused @c true if the detections come from a previous frame.
+ * @return The number of confirmed aliens.
+ */
+static size_t update_tracks(const detection_t* dets, size_t n, uint64_t frame_id, bool reused)
+{
+    // Look the capture time up before the frame gets out of the ring,
+    // assuming a frame just captured if it is unknown.
+    uint64_t timestamp_ns = frame_clock_lookup(frame_id);
+    if (timestamp_ns == 0) timestamp_ns = frame_clock_now();
+
+    // Every frame updates the tracks, even if the targeting thread is busy.
+    track_t aliens[TRACKER_MAX_TRACKS];
+    track_t tracks[TRACKER_MAX_TRACKS];
+    size_t count = 0, track_count;
+    pthread_mutex_lock(&mailbox_mutex);
+    if (pending) __atomic_add_fetch(&replaced, 1, __ATOMIC_RELAXED);
+    tracker_update(&tracker, dets, n, timestamp_ns);
+    for (size_t i = 0; i < tracker.count; i++) {
+        const track_t* track = &tracker.tracks[i];
+        if (track->confirmed && track->cls == DETECTION_CLASS_ALIEN) aliens[count++] = *track;
+        tracks[i] = *track;
+    }
+    track_count = tracker.count;
+    last_frame_id = frame_id;
+    __atomic_store_n(&pending, true, __ATOMIC_RELAXED);
+    pthread_cond_signal(&mailbox_cond);
+    pthread_mutex_unlock(&mailbox_mutex);
+
+    // Follow the aliens on the frames captured until the next detections.
+    corr_tracker_seed(aliens, count, frame_id, timestamp_ns);
+
+    // Wake up the viewers drawing the results.
+    overlay_publish(dets, n, tracks, track_count, frame_id, timestamp_ns, reused);
+    return count;
+}
+
+void targeting_submit(const detection_t* dets, size_t n, uint64_t frame_id)
+{
+    if (n > TARGETING_MAX_DETECTIONS) n = TARGETING_MAX_DETECTIONS;
+    motion_gate_keep(dets, n);
+
+    size_t aliens = update_tracks(dets, n, frame_id, false);
+    governor_observe(n, aliens);
+    flight_record_detections(dets, n, frame_id);
+
+    __atomic_add_fetch(&submitted, 1, __ATOMIC_RELAXED);
+}
+
+void targeting_submit_reused(const detection_t* dets, size_t n, uint64_t frame_id)
+{
+    if (n > TARGETING_MAX_DETECTIONS) n = TARGETING_MAX_DETECTIONS;
+    update_tracks(dets, n, frame_id, true);
+}
+
+void targeting_refresh(void)
+{
+    pthread_mutex_lock(&mailbox_mutex);
+    refreshed = true;
+    pthread_cond_signal(&mailbox_cond);
+    pthread_mutex_unlock(&mailbox_mutex);
+}
+
+void targeting_set_dwell_ms(uint32_t ms)
+{
+    __atomic_store_n(&dwell_ms, ms, __ATOMIC_RELAXED);
+}
+
+void targeting_get_stats(targeting_stats_t* stats)
+{
+    stats->submitted = __atomic_load_n(&submitted, __ATOMIC_RELAXED);
+    stats->replaced = __atomic_load_n(&replaced, __ATOMIC_RELAXED);
+    stats->targets = __atomic_load_n(&targets, __ATOMIC_RELAXED);
+    stats->abandoned = __atomic_load_n(&abandoned, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Targets of the latest update of the tracks.
+ */
+typedef struct {
+    uint64_t frame_id;
+    uint64_t timestamp_ns;
+    size_t count;
+    track_t tracks[TRACKER_MAX_TRACKS];
+} target_set_t;
+
+/**
+ * @brief Waits for an update of the tracks and copies the confirmed ones.
+ *
+ * A refresh of the positions followed by correlation also wakes the thread
+ * up, keeping the tracks of the previous update.
+ *
+ * @return @c true if the tracks or their positions were updated,
+ *         @c false after @c TARGETING_WAIT_MS .
+ */
+static bool mailbox_take(target_set_t* set)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_nsec += (long)TARGETING_WAIT_MS * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&mailbox_mutex);
+    while (!pending && !refreshed) {
+        if (pthread_cond_timedwait(&mailbox_cond, &mailbox_mutex, &deadline) != 0) break;
+    }
+    bool taken = pending || refreshed;
+    if (pending) {
+        set->frame_id = last_frame_id;
+        set->timestamp_ns = tracker.last_ns;
+        set->count = tracker_confirmed(&tracker, set->tracks, TRACKER_MAX_TRACKS);
+        __atomic_store_n(&pending, false, __ATOMIC_RELAXED);
+    }
+    refreshed = false;
+    pthread_mutex_unlock(&mailbox_mutex);
+    return taken;
+}
+
+/**
+ * @brief Predicts where a track will be when the beam reaches it.
+ *
+ * The move to the target only starts once the current move is over, and
+ * lasts according to the motor model, so that the beam arrives well after
+ * the capture of the frame. The predicted position depends on the duration
+ * of the move, which depends on the position: a few fixed-point iterations
+ * converge as long as the target is slower than the motors.
+ *
+ * @param[in] track The track, whose state is at @p state_ns .
+ * @param[in] state_ns Capture time of the frame of the track state [ns].
+ * @param[in] x The X-position of the motors at @p start_ns [px].
+ * @param[in] y The Y-position of the motors at @p start_ns [px].
+ * @param[in] start_ns Time the move to the target starts [ns].
+ * @param[out] lx The X-position to send to the motors [px].
+ * @param[out] ly The Y-position to send to the motors [px].
+ */
+static void lead_point(const track_t* track, uint64_t state_ns, d_px_t x, d_px_t y, uint64_t start_ns,
+                       d_px_t* lx, d_px_t* ly)
+{
+    float px = track->x.pos;
+    float py = track->y.pos;
+
+    for (int i = 0; i < LEAD_ITERATIONS; i++) {
+        time_us_t move_us = move_time_us(PWM_FREQ, x, y, (d_px_t)px, (d_px_t)py);
+        uint64_t arrival_ns = start_ns + (uint64_t)move_us * 1000ULL;
+
+        // Extrapolate the track, within a bounded horizon.
+        float lead_s = arrival_ns > state_ns ? (float)((arrival_ns - state_ns) / 1e9) : 0.0f;
+        if (lead_s > TARGETING_MAX_LEAD_MS / 1000.0f) lead_s = TARGETING_MAX_LEAD_MS / 1000.0f;
+        px = track->x.pos + track->x.vel * lead_s;
+        py = track->y.pos + track->y.vel * lead_s;
+    }
+
+    *lx = (d_px_t)lroundf(px);
+    *ly = (d_px_t)lroundf(py);
+}
+
+/**
+ * @brief Gets the latest state of a track, moved to its position followed by correlation.
+ *
+ * @param[in] track The track, whose state is at @p set_ns .
+ * @param[in] set_ns Capture time of the frame of the track state [ns].
+ * @param[out] fresh The track, at its latest known position.
+ * @param[out] state_ns Capture time of the frame of the latest position [ns].
+ */
+static void fresh_state(const track_t* track, uint64_t set_ns, track_t* fresh, uint64_t* state_ns)
+{
+    corr_pos_t pos;
+    *fresh = *track;
+    *state_ns = set_ns;
+    if (corr_tracker_lookup(track->id, &pos) && pos.timestamp_ns > set_ns) {
+        fresh->x.pos = pos.x;
+        fresh->y.pos = pos.y;
+        *state_ns = pos.timestamp_ns;
+    }
+}
+
+/**
+ * @brief Finds a track by its identifier.
+ *
+ * @return The track, or @c NULL if it is not in the set.
+ */
+static const track_t* find_track(const target_set_t* set, uint32_t id)
+{
+    for (size_t i = 0; i < set->count; i++) {
+        if (set->tracks[i].id == id) return &set->tracks[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Makes the motors in velocity mode follow a track.
+ *
+ * @param[in] track The track, whose state is at @p state_ns .
+ * @param[in] state_ns Capture time of the frame of the track state [ns].
+ * @param[in] wait @c true to wait for the beam to reach the target, within
+ *            @c TARGETING_MAX_LEAD_MS or until the tracks are updated.
+ * @return The time the beam reached the target, or now if not waiting [ns].
+ */
+static uint64_t follow_track(const track_t* track, uint64_t state_ns, bool wait)
+{
+    axis_target_t tx = { track->x.pos, track->x.vel, state_ns };
+    axis_target_t ty = { track->y.pos, track->y.vel, state_ns };
+    motor_follow(&tx, &ty);
+
+    uint64_t start_ns = frame_clock_now();
+    uint64_t now_ns = start_ns;
+    while (wait && now_ns - start_ns < TARGETING_MAX_LEAD_MS * 1000000ULL &&
+           !__atomic_load_n(&pending, __ATOMIC_RELAXED) && !psig_kill_requested()) {
+        float ex, ey;
+        motor_estimate(&ex, &ey);
+        float lead_s = (float)((now_ns - state_ns) / 1e9);
+        if (fabsf(tx.pos + tx.vel * lead_s - ex) <= STEP_SIZE && fabsf(ty.pos + ty.vel * lead_s - ey) <= STEP_SIZE) break;
+        wait_interruptible_us(1000, 1000, psig_kill_requested);
+        now_ns = frame_clock_now();
+    }
+    return now_ns;
+}
+
+/**
+ * @brief Sends the tracked aliens to the motors, in the order planned by the scheduler.
+ */
+static void aim_set(const target_set_t* set)
+{
+    static bool warned = false;
+    static uint64_t logged_frame_id = 0;
+
+    // The motors only move relative to their calibration reference.
+    d_px_t x, y;
+    uint64_t arrival_ns;
+    if (!read_abs_pos(&x, &y, &arrival_ns)) {
+        if (!warned) log_write(LOG_WARNING, "Motors not calibrated, ignoring detections");
+        warned = true;
+        return;
+    }
+
+    // The motors read the next position once the current move is over.
+    uint64_t now_ns = frame_clock_now();
+    uint64_t start_ns = arrival_ns > now_ns ? arrival_ns : now_ns;
+
+    // Plan the visit of the tracked aliens, at their led positions.
+    sched_target_t aliens[TRACKER_MAX_TRACKS];
+    size_t n = 0;
+    for (size_t i = 0; i < set->count; i++) {
+        if (set->tracks[i].cls != DETECTION_CLASS_ALIEN) continue;
+        track_t track;
+        uint64_t state_ns;
+        fresh_state(&set->tracks[i], set->timestamp_ns, &track, &state_ns);
+        aliens[n].id = track.id;
+        lead_point(&track, state_ns, x, y, start_ns, &aliens[n].x, &aliens[n].y);
+        n++;
+    }
+    size_t lost = scheduler_update(&sched, aliens, n, x, y);
+    __atomic_add_fetch(&abandoned, lost, __ATOMIC_RELAXED);
+    if (n == 0) return;
+
+    // Positions refreshed by correlation come at camera rate, log the detections only.
+    if (set->frame_id != logged_frame_id) {
+        log_write(LOG_INFO, "Targeting %zu aliens of frame %llu, %.1f ms old", n,
+                  (unsigned long long)set->frame_id, (frame_clock_now() - set->timestamp_ns) / 1e6);
+        logged_frame_id = set->frame_id;
+    }
+
+    // Visit the targets until the tracks are updated, which plans the remaining ones again.
+    sched_target_t next;
+    while (!__atomic_load_n(&pending, __ATOMIC_RELAXED) && !psig_kill_requested() &&
+           scheduler_next(&sched, &next)) {
+        track_t track;
+        uint64_t state_ns;
+        fresh_state(find_track(set, next.id), set->timestamp_ns, &track, &state_ns);
+        uint64_t dwell_ns = (uint64_t)__atomic_load_n(&dwell_ms, __ATOMIC_RELAXED) * 1000000ULL;
+
+        if (motor_get_mode() == MOTOR_MODE_VELOCITY) {
+            // The motors follow the target continuously: a single one needs no waiting.
+            log_write(LOG_DEBUG, "Track %u at (%.0f,%.0f), followed at (%.0f,%.0f) px/s", track.id,
+                      track.x.pos, track.y.pos, track.x.vel, track.y.vel);
+            arrival_ns = follow_track(&track, state_ns, n > 1 || dwell_ns > 0);
+        } else {
+            // Lead the target from the actual start of the move.
+            now_ns = frame_clock_now();
+            start_ns = arrival_ns > now_ns ? arrival_ns : now_ns;
+            d_px_t lx, ly;
+            lead_point(&track, state_ns, x, y, start_ns, &lx, &ly);
+
+            log_write(LOG_DEBUG, "Track %u at (%.0f,%.0f), led to (%d,%d)", track.id,
+                      track.x.pos, track.y.pos, lx, ly);
+            write_abs_pos(lx, ly);
+            read_abs_pos(&x, &y, &arrival_ns);
+        }
+        __atomic_add_fetch(&targets, 1, __ATOMIC_RELAXED);
+
+        // Keep the beam on the target for the dwell time.
+        if (dwell_ns > 0) {
+            now_ns = frame_clock_now();
+            if (arrival_ns + dwell_ns > now_ns) {
+                wait_interruptible_us((time_us_t)((arrival_ns + dwell_ns - now_ns) / 1000), 1000, psig_kill_requested);
+            }
+        }
+    }
+}
+
+void* targeting_task(void* arg)
+{
+    log_write(LOG_INFO, "Start targeting task");
+
+    // Install signal handler for system signals.
+    psig_install_handler();
+
+    target_set_t set = {0};
+
+    // Targeting loop that continues until a termination signal is received.
+    while (!psig_kill_requested()) {
+        if (mailbox_take(&set)) aim_set(&set);
+    }
+
+    targeting_stats_t stats;
+    targeting_get_stats(&stats);
+    log_write(LOG_INFO, "Targeting: %llu sets, %llu replaced, %llu targets, %llu abandoned",
+              (unsigned long long)stats.submitted, (unsigned long long)stats.replaced,
+              (unsigned long long)stats.targets, (unsigned long long)stats.abandoned);
+
+    // Indicate the task is complete.
+    thread_ready_num++;
+    log_write(LOG_INFO, "Stopping targeting task");
+    pthread_exit(EXIT_SUCCESS);
+}
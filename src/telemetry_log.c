@@ -0,0 +1,309 @@
+/**
+ * @file telemetry_log.c
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c telemetry_log.h .
+ *
+ * @see telemetry_log.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "telemetry_log.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "psig_utils.h"
+#include "log_utils.h"
+#include "ipc_elements.h"
+#include "wait_utils.h"
+#include "frame_clock.h"
+
+_Static_assert(sizeof(telemetry_header_t) == sizeof(flight_event_t), "the records must stay aligned on cache lines");
+
+// Number of records mapped in a file.
+#define CAPACITY ((uint64_t)TELEMETRY_FILE_SIZE / sizeof(flight_event_t) + TELEMETRY_HEADROOM)
+
+/**
+ * @brief Log file being written.
+ */
+typedef struct {
+    int fd;                     ///< File descriptor.
+    uint8_t* map;               ///< Mapping of the whole file.
+    size_t map_size;            ///< Size of the mapping [bytes].
+    uint64_t next;              ///< Index of the next record.
+    uint32_t writers;           ///< Number of threads writing a record.
+    uint64_t name_ms;           ///< Wall-clock time in the file name [ms].
+} segment_t;
+
+// Directory of the log files.
+static char log_dir[PATH_MAX];
+
+// Two files, the one written and the one closed or opened by the rotation.
+static segment_t segments[2];
+
+// File written, NULL while the log is closed; read with atomic built-ins.
+static segment_t* current = NULL;
+
+// Number of files opened in the session.
+static uint64_t file_index = 0;
+
+// Names of the files kept, oldest first from kept_head.
+static uint64_t kept[TELEMETRY_MAX_FILES];
+static size_t kept_head = 0;
+static size_t kept_count = 0;
+
+// Statistics, updated with atomic built-ins.
+static uint64_t records = 0;
+static uint64_t dropped = 0;
+static uint64_t files = 0;
+static uint64_t failed = 0;
+
+/**
+ * @brief Builds the path of a log file from its name.
+ */
+static void file_path(char* path, size_t size, uint64_t name_ms)
+{
+    snprintf(path, size, "%s/telemetry-%llu.bin", log_dir, (unsigned long long)name_ms);
+}
+
+/**
+ * @brief Creates a log file, allocated and mapped to its full size.
+ *
+ * @param[out] seg The file.
+ * @return @c EXIT_SUCCESS on success, @c EXIT_FAILURE otherwise.
+ */
+static int segment_open(segment_t* seg)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t realtime_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+    uint64_t start_ns = frame_clock_now();
+
+    // A rotation within the same millisecond gets the next name.
+    seg->name_ms = realtime_ns / 1000000ULL;
+    if (kept_count > 0) {
+        uint64_t last = kept[(kept_head + kept_count - 1) % TELEMETRY_MAX_FILES];
+        if (seg->name_ms <= last) seg->name_ms = last + 1;
+    }
+
+    char path[PATH_MAX + 64];
+    file_path(path, sizeof(path), seg->name_ms);
+    seg->map_size = sizeof(telemetry_header_t) + CAPACITY * sizeof(flight_event_t);
+
+    seg->fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (seg->fd < 0) {
+        log_write(LOG_ERROR, "Could not create a telemetry log file: %s", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    // Allocate the blocks now, so that the write-back never runs out of space.
+    if (posix_fallocate(seg->fd, 0, (off_t)seg->map_size) != 0 && ftruncate(seg->fd, (off_t)seg->map_size) < 0) {
+        log_write(LOG_ERROR, "Could not allocate a telemetry log file: %s", strerror(errno));
+        close(seg->fd);
+        unlink(path);
+        return EXIT_FAILURE;
+    }
+    void* map = mmap(NULL, seg->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, seg->fd, 0);
+    if (map == MAP_FAILED) {
+        log_write(LOG_ERROR, "Could not map a telemetry log file: %s", strerror(errno));
+        close(seg->fd);
+        unlink(path);
+        return EXIT_FAILURE;
+    }
+    seg->map = map;
+    seg->next = 0;
+    seg->writers = 0;
+
+    telemetry_header_t* header = (telemetry_header_t*)seg->map;
+    memcpy(header->magic, TELEMETRY_MAGIC, sizeof(header->magic));
+    header->version = TELEMETRY_VERSION;
+    header->record_size = sizeof(flight_event_t);
+    header->file_index = file_index++;
+    header->start_ns = start_ns;
+    header->realtime_ns = realtime_ns;
+
+    // Delete the oldest file, beyond the files kept.
+    if (kept_count == TELEMETRY_MAX_FILES) {
+        char oldest[PATH_MAX + 64];
+        file_path(oldest, sizeof(oldest), kept[kept_head]);
+        unlink(oldest);
+        kept_head = (kept_head + 1) % TELEMETRY_MAX_FILES;
+        kept_count--;
+    }
+    kept[(kept_head + kept_count) % TELEMETRY_MAX_FILES] = seg->name_ms;
+    kept_count++;
+
+    __atomic_add_fetch(&files, 1, __ATOMIC_RELAXED);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Waits for the last threads writing in a file no longer current.
+ */
+static void segment_drain(segment_t* seg)
+{
+    while (__atomic_load_n(&seg->writers, __ATOMIC_SEQ_CST) != 0) sched_yield();
+}
+
+/**
+ * @brief Closes a log file, cut to its records.
+ */
+static void segment_close(segment_t* seg)
+{
+    uint64_t count = __atomic_load_n(&seg->next, __ATOMIC_ACQUIRE);
+    if (count > CAPACITY) count = CAPACITY;
+
+    telemetry_header_t* header = (telemetry_header_t*)seg->map;
+    header->record_count = count;
+
+    bool ok = munmap(seg->map, seg->map_size) == 0;
+    ok = ftruncate(seg->fd, (off_t)(sizeof(telemetry_header_t) + count * sizeof(flight_event_t))) == 0 && ok;
+    ok = close(seg->fd) == 0 && ok;
+    if (!ok) {
+        __atomic_add_fetch(&failed, 1, __ATOMIC_RELAXED);
+        log_write(LOG_ERROR, "Could not close a telemetry log file: %s", strerror(errno));
+    }
+    seg->map = NULL;
+    seg->fd = -1;
+}
+
+int telemetry_open(const char* dir)
+{
+    snprintf(log_dir, sizeof(log_dir), "%s", dir);
+    if (mkdir(log_dir, 0755) < 0 && errno != EEXIST) {
+        log_write(LOG_ERROR, "Could not create %s: %s", log_dir, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    file_index = 0;
+    kept_head = 0;
+    kept_count = 0;
+    if (segment_open(&segments[0]) == EXIT_FAILURE) {
+        __atomic_add_fetch(&failed, 1, __ATOMIC_RELAXED);
+        return EXIT_FAILURE;
+    }
+    __atomic_store_n(&current, &segments[0], __ATOMIC_SEQ_CST);
+    return EXIT_SUCCESS;
+}
+
+void telemetry_close(void)
+{
+    segment_t* seg = __atomic_exchange_n(&current, NULL, __ATOMIC_SEQ_CST);
+    if (!seg) return;
+    segment_drain(seg);
+    segment_close(seg);
+}
+
+bool telemetry_is_open(void)
+{
+    return __atomic_load_n(&current, __ATOMIC_ACQUIRE) != NULL;
+}
+
+void telemetry_get_stats(telemetry_stats_t* stats)
+{
+    stats->records = __atomic_load_n(&records, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+    stats->files = __atomic_load_n(&files, __ATOMIC_RELAXED);
+    stats->failed = __atomic_load_n(&failed, __ATOMIC_RELAXED);
+}
+
+void telemetry_append(const flight_event_t* event)
+{
+    // Register as a writer of the current file, so that it is not closed meanwhile.
+    segment_t* seg;
+    for (;;) {
+        seg = __atomic_load_n(&current, __ATOMIC_SEQ_CST);
+        if (!seg) return;
+        __atomic_add_fetch(&seg->writers, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&current, __ATOMIC_SEQ_CST) == seg) break;
+        __atomic_sub_fetch(&seg->writers, 1, __ATOMIC_RELEASE);
+    }
+
+    // The sequence number is written last, a record being valid once it is set.
+    uint64_t idx = __atomic_fetch_add(&seg->next, 1, __ATOMIC_RELAXED);
+    if (idx < CAPACITY) {
+        flight_event_t* slot = (flight_event_t*)(seg->map + sizeof(telemetry_header_t)) + idx;
+        slot->timestamp_ns = event->timestamp_ns;
+        slot->type = event->type;
+        slot->reserved = 0;
+        memcpy(&slot->u, &event->u, sizeof(slot->u));
+        __atomic_store_n(&slot->seq, event->seq, __ATOMIC_RELEASE);
+        __atomic_add_fetch(&records, 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_add_fetch(&dropped, 1, __ATOMIC_RELAXED);
+    }
+
+    __atomic_sub_fetch(&seg->writers, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Switches the writers to a new file, and closes the full one.
+ */
+static void rotate(void)
+{
+    segment_t* seg = __atomic_load_n(&current, __ATOMIC_ACQUIRE);
+    segment_t* next = seg == &segments[0] ? &segments[1] : &segments[0];
+
+    // Keep writing in the headroom of the full file if the next one fails.
+    if (segment_open(next) == EXIT_FAILURE) {
+        __atomic_add_fetch(&failed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    __atomic_store_n(&current, next, __ATOMIC_SEQ_CST);
+    segment_drain(seg);
+    segment_close(seg);
+    log_write(LOG_INFO, "Telemetry log rotated to file %llu", (unsigned long long)(file_index - 1));
+}
+
+void* telemetry_task(void* arg)
+{
+    log_write(LOG_INFO, "Start telemetry log task");
+
+    // Install signal handler for system signals.
+    psig_install_handler();
+
+    // Rotation loop that continues until a termination signal is received.
+    // A failed rotation is retried after the next wait.
+    uint64_t full = (uint64_t)TELEMETRY_FILE_SIZE / sizeof(flight_event_t);
+    while (!psig_kill_requested()) {
+        wait_interruptible_us(TELEMETRY_WAIT_MS * 1000, 10000, psig_kill_requested);
+        segment_t* seg = __atomic_load_n(&current, __ATOMIC_ACQUIRE);
+        if (seg && __atomic_load_n(&seg->next, __ATOMIC_RELAXED) >= full) rotate();
+    }
+
+    telemetry_stats_t stats;
+    telemetry_get_stats(&stats);
+    log_write(LOG_INFO, "Telemetry log: %llu records, %llu dropped, %llu files, %llu failed",
+              (unsigned long long)stats.records, (unsigned long long)stats.dropped,
+              (unsigned long long)stats.files, (unsigned long long)stats.failed);
+
+    // Indicate the task is complete.
+    thread_ready_num++;
+    log_write(LOG_INFO, "Stopping telemetry log task");
+    pthread_exit(EXIT_SUCCESS);
+}
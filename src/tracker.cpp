@@ -0,0 +1,300 @@
+/**
+ * @file tracker.cpp
+ * @author Adrien Chevrier
+ *
+ * @brief Implementation file for the header @c tracker.h .
+ *
+ * @see tracker.h
+ *
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2025 Adrien Chevrier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "tracker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+// Standard deviation of the velocity of a new track [px/s].
+static constexpr float INIT_VEL_STD = 200.0f;
+
+// Longest prediction between two frames [s].
+static constexpr float MAX_DT = 1.0f;
+
+/*******************************************************************************
+ * Kalman filter
+ ******************************************************************************/
+
+/**
+ * @brief Starts the filter of an axis at a detected position, without velocity.
+ */
+static void axis_init(tracker_axis_t* a, float z)
+{
+    a->pos = z;
+    a->vel = 0.0f;
+    a->p00 = TRACKER_MEAS_NOISE * TRACKER_MEAS_NOISE;
+    a->p01 = 0.0f;
+    a->p11 = INIT_VEL_STD * INIT_VEL_STD;
+}
+
+/**
+ * @brief Predicts the filter of an axis after @p dt , at constant velocity.
+ */
+static void axis_predict(tracker_axis_t* a, float dt)
+{
+    // Process noise of a random acceleration, constant between the frames.
+    const float q = TRACKER_ACCEL_NOISE * TRACKER_ACCEL_NOISE;
+    const float dt2 = dt * dt;
+
+    a->pos += a->vel * dt;
+    a->p00 += 2.0f * dt * a->p01 + dt2 * a->p11 + q * dt2 * dt2 / 4.0f;
+    a->p01 += dt * a->p11 + q * dt2 * dt / 2.0f;
+    a->p11 += q * dt2;
+}
+
+/**
+ * @brief Corrects the filter of an axis with a detected position.
+ */
+static void axis_correct(tracker_axis_t* a, float z)
+{
+    const float s = a->p00 + TRACKER_MEAS_NOISE * TRACKER_MEAS_NOISE;
+    const float k0 = a->p00 / s;
+    const float k1 = a->p01 / s;
+    const float innovation = z - a->pos;
+
+    a->pos += k0 * innovation;
+    a->vel += k1 * innovation;
+    a->p11 -= k1 * a->p01;
+    a->p01 *= 1.0f - k0;
+    a->p00 *= 1.0f - k0;
+}
+
+/*******************************************************************************
+ * Assignment
+ ******************************************************************************/
+
+/**
+ * @brief Computes the overlap of a predicted track and a detection.
+ *
+ * @return The intersection over union of their boxes, between 0 and 1.
+ */
+static float track_iou(const track_t* t, const detection_t* d)
+{
+    float x1 = std::max(t->x.pos - t->w / 2.0f, d->x1);
+    float y1 = std::max(t->y.pos - t->h / 2.0f, d->y1);
+    float x2 = std::min(t->x.pos + t->w / 2.0f, d->x2);
+    float y2 = std::min(t->y.pos + t->h / 2.0f, d->y2);
+    if (x2 <= x1 || y2 <= y1) return 0.0f;
+
+    float inter = (x2 - x1) * (y2 - y1);
+    float area = t->w * t->h + (d->x2 - d->x1) * (d->y2 - d->y1) - inter;
+    return area > 0.0f ? inter / area : 0.0f;
+}
+
+/**
+ * @brief Solves the assignment problem with the Hungarian algorithm, in O(rows^2 cols).
+ *
+ * @param[in] cost Cost of assigning each row to each column.
+ * @param[in] rows Number of rows, not more than @p cols .
+ * @param[in] cols Number of columns.
+ * @param[out] row_to_col Column assigned to each row.
+ */
+static void hungarian(const float cost[TRACKER_MAX_TRACKS][TRACKER_MAX_TRACKS], int rows, int cols, int* row_to_col)
+{
+    const float inf = std::numeric_limits<float>::infinity();
+
+    // Potentials of the rows and columns, row matched to each column (1-based, 0 if none).
+    float u[TRACKER_MAX_TRACKS + 1] = {0};
+    float v[TRACKER_MAX_TRACKS + 1] = {0};
+    int match[TRACKER_MAX_TRACKS + 1] = {0};
+    int way[TRACKER_MAX_TRACKS + 1] = {0};
+
+    for (int i = 1; i <= rows; i++) {
+        // Find an augmenting path from row i, column 0 being a virtual start.
+        float minv[TRACKER_MAX_TRACKS + 1];
+        bool used[TRACKER_MAX_TRACKS + 1];
+        std::fill(minv, minv + cols + 1, inf);
+        std::fill(used, used + cols + 1, false);
+        match[0] = i;
+        int j0 = 0;
+        do {
+            used[j0] = true;
+            int i0 = match[j0];
+            int j1 = 0;
+            float delta = inf;
+            for (int j = 1; j <= cols; j++) {
+                if (used[j]) continue;
+                float cur = cost[i0 - 1][j - 1] - u[i0] - v[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= cols; j++) {
+                if (used[j]) {
+                    u[match[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (match[j0] != 0);
+
+        // Flip the matches along the path.
+        do {
+            int j1 = way[j0];
+            match[j0] = match[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    for (int j = 1; j <= cols; j++) {
+        if (match[j] != 0) row_to_col[match[j] - 1] = j - 1;
+    }
+}
+
+/*******************************************************************************
+ * Tracker
+ ******************************************************************************/
+
+void tracker_init(tracker_t* tracker)
+{
+    memset(tracker, 0, sizeof(tracker_t));
+    tracker->next_id = 1;
+}
+
+void tracker_update(tracker_t* tracker, const detection_t* dets, size_t n, uint64_t timestamp_ns)
+{
+    if (n > TRACKER_MAX_TRACKS) n = TRACKER_MAX_TRACKS;
+    const int nt = (int)tracker->count;
+    const int nd = (int)n;
+
+    // Time elapsed since the previous frame.
+    float dt = TRACKER_DEFAULT_DT;
+    if (timestamp_ns && tracker->last_ns) {
+        dt = timestamp_ns > tracker->last_ns ? (float)((timestamp_ns - tracker->last_ns) / 1e9) : 0.0f;
+        dt = std::min(dt, MAX_DT);
+    }
+    if (timestamp_ns) tracker->last_ns = timestamp_ns;
+
+    // Predict the tracks at the time of the frame.
+    for (int i = 0; i < nt; i++) {
+        axis_predict(&tracker->tracks[i].x, dt);
+        axis_predict(&tracker->tracks[i].y, dt);
+    }
+
+    // Match the tracks and the detections, on the smaller dimension.
+    int track_to_det[TRACKER_MAX_TRACKS];
+    int det_to_track[TRACKER_MAX_TRACKS];
+    std::fill(track_to_det, track_to_det + TRACKER_MAX_TRACKS, -1);
+    std::fill(det_to_track, det_to_track + TRACKER_MAX_TRACKS, -1);
+    if (nt > 0 && nd > 0) {
+        float cost[TRACKER_MAX_TRACKS][TRACKER_MAX_TRACKS];
+        float iou[TRACKER_MAX_TRACKS][TRACKER_MAX_TRACKS];
+        bool by_track = nt <= nd;
+        for (int i = 0; i < nt; i++) {
+            for (int j = 0; j < nd; j++) {
+                const track_t* t = &tracker->tracks[i];
+                iou[i][j] = t->cls == dets[j].cls ? track_iou(t, &dets[j]) : 0.0f;
+                if (by_track) {
+                    cost[i][j] = 1.0f - iou[i][j];
+                } else {
+                    cost[j][i] = 1.0f - iou[i][j];
+                }
+            }
+        }
+        if (by_track) {
+            hungarian(cost, nt, nd, track_to_det);
+        } else {
+            hungarian(cost, nd, nt, det_to_track);
+            for (int j = 0; j < nd; j++) {
+                if (det_to_track[j] >= 0) track_to_det[det_to_track[j]] = j;
+            }
+        }
+
+        // Reject the assignments of boxes barely overlapping.
+        std::fill(det_to_track, det_to_track + TRACKER_MAX_TRACKS, -1);
+        for (int i = 0; i < nt; i++) {
+            int j = track_to_det[i];
+            if (j < 0) continue;
+            if (iou[i][j] < TRACKER_MIN_IOU) {
+                track_to_det[i] = -1;
+            } else {
+                det_to_track[j] = i;
+            }
+        }
+    }
+
+    // Correct the matched tracks, and age the others.
+    size_t kept = 0;
+    for (int i = 0; i < nt; i++) {
+        track_t* t = &tracker->tracks[i];
+        int j = track_to_det[i];
+        if (j >= 0) {
+            const detection_t* d = &dets[j];
+            axis_correct(&t->x, (d->x1 + d->x2) / 2.0f);
+            axis_correct(&t->y, (d->y1 + d->y2) / 2.0f);
+            t->w = d->x2 - d->x1;
+            t->h = d->y2 - d->y1;
+            t->conf = d->conf;
+            t->hits++;
+            t->misses = 0;
+            if (t->hits >= TRACKER_MIN_HITS) t->confirmed = 1;
+        } else {
+            t->hits = 0;
+            t->misses++;
+        }
+
+        // Tentative tracks do not survive a miss, confirmed ones coast for a while.
+        bool alive = t->misses == 0 || (t->confirmed && t->misses <= TRACKER_MAX_MISSES);
+        if (alive) tracker->tracks[kept++] = *t;
+    }
+    tracker->count = kept;
+
+    // Start a track for each unmatched detection.
+    for (int j = 0; j < nd && tracker->count < TRACKER_MAX_TRACKS; j++) {
+        if (det_to_track[j] >= 0) continue;
+        const detection_t* d = &dets[j];
+        track_t* t = &tracker->tracks[tracker->count++];
+        memset(t, 0, sizeof(track_t));
+        t->id = tracker->next_id++;
+        t->cls = d->cls;
+        t->conf = d->conf;
+        t->w = d->x2 - d->x1;
+        t->h = d->y2 - d->y1;
+        t->hits = 1;
+        t->confirmed = TRACKER_MIN_HITS <= 1;
+        axis_init(&t->x, (d->x1 + d->x2) / 2.0f);
+        axis_init(&t->y, (d->y1 + d->y2) / 2.0f);
+    }
+}
+
+size_t tracker_confirmed(const tracker_t* tracker, track_t* tracks, size_t max)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < tracker->count && n < max; i++) {
+        if (tracker->tracks[i].confirmed) tracks[n++] = tracker->tracks[i];
+    }
+    return n;
+}
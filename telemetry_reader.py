@@ -0,0 +1,252 @@
+"""
+telemetry_reader.py
+Converts the binary telemetry logs to CSV or columnar files.
+
+This script reads the telemetry log files written with ``python3 main.py
+--telemetry DIR`` (``telemetry-TIME.bin``), and the flight recorder dumps
+(``flight-TIME-REASON.bin``), whose events share the same fixed-size records.
+The records are decoded at once with numpy, and split by event type in tables
+with one column per field:
+
+- ``detections``: every detection submitted to the targeting, with its frame;
+- ``commands``: every position sent to the motors;
+- ``steps``: every motor move, with its planned and emitted steps;
+- ``rates``: every step rate change of a motor in velocity mode;
+- ``triggers``: every trigger of the flight recorder.
+
+Each table is written to ``OUT/TABLE.csv``, to a compressed numpy archive
+``OUT/TABLE.npz`` of one array per column, or to ``OUT/TABLE.parquet`` if
+pyarrow is installed. Without output directory, a summary is printed.
+
+Usage:
+    python3 telemetry_reader.py logs/telemetry-*.bin -o out --format csv
+
+References:
+    - include/telemetry_log.h
+    - include/flight_recorder.h
+
+Author:
+    Adrien Chevrier
+
+Version:
+    0.1 (2026-10-18)
+
+Copyright:
+    Copyright (c) 2025 Adrien Chevrier
+
+License:
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+"""
+
+import argparse
+import os
+import sys
+import numpy as np
+
+# Signatures of the files, see telemetry_log.h and flight_recorder.h.
+TELEMETRY_MAGIC = b"EATELEMT"
+FLIGHT_MAGIC = b"EAFLIGHT"
+
+# Size of a record, flight_event_t [bytes].
+RECORD_SIZE = 64
+
+# Header of a log file, telemetry_header_t.
+TELEMETRY_HEADER = np.dtype([
+    ("magic", "S8"), ("version", "<u4"), ("record_size", "<u4"), ("file_index", "<u8"),
+    ("start_ns", "<u8"), ("realtime_ns", "<u8"), ("record_count", "<u8"), ("reserved", "V16"),
+])
+
+# Header of a dump file, flight_dump_header_t.
+FLIGHT_HEADER = np.dtype([
+    ("magic", "S8"), ("version", "<u4"), ("reason", "<u4"), ("trigger_ns", "<u8"),
+    ("realtime_ns", "<u8"), ("event_count", "<u8"), ("frame_count", "<u8"), ("frame_bytes", "<u8"),
+])
+
+
+def _record(fields):
+    """Builds the dtype of a record type, from its fields after the common ones."""
+    names = ["seq", "timestamp_ns", "type"]
+    formats = ["<u8", "<u8", "<u4"]
+    offsets = [0, 8, 16]
+    offset = 24
+    for name, fmt in fields:
+        names.append(name)
+        formats.append(fmt)
+        offsets.append(offset)
+        offset += np.dtype(fmt).itemsize
+    return np.dtype({"names": names, "formats": formats, "offsets": offsets, "itemsize": RECORD_SIZE})
+
+
+# Tables by flight_event_type_t.
+TABLES = {
+    1: ("detections", _record([
+        ("frame_id", "<u8"), ("index", "<u4"), ("count", "<u4"),
+        ("x1", "<f4"), ("y1", "<f4"), ("x2", "<f4"), ("y2", "<f4"), ("conf", "<f4"), ("cls", "<i4"),
+    ])),
+    2: ("commands", _record([
+        ("velocity", "<u4"), ("x", "<f4"), ("y", "<f4"), ("vx", "<f4"), ("vy", "<f4"),
+    ])),
+    3: ("steps", _record([
+        ("axis", "<u4"), ("position", "<i4"), ("planned", "<i4"), ("slip", "<i4"), ("emitted", "<i4"),
+    ])),
+    4: ("rates", _record([
+        ("axis", "<u4"), ("rate", "<f4"), ("estimate", "<f4"),
+    ])),
+    5: ("triggers", _record([
+        ("reason", "<u4"),
+    ])),
+}
+
+
+def read_records(path):
+    """Reads the records of a log or dump file.
+
+    Args:
+        path (str): The file.
+
+    Returns:
+        tuple: The valid records as a raw ``(N, 64)`` byte array, and the offset
+        to add to their monotonic timestamps to get wall-clock times [ns].
+
+    Raises:
+        ValueError: If the file is neither a telemetry log nor a flight dump.
+    """
+    data = np.fromfile(path, dtype=np.uint8)
+    magic = data[:8].tobytes()
+    if magic == TELEMETRY_MAGIC:
+        header = data[:TELEMETRY_HEADER.itemsize].view(TELEMETRY_HEADER)[0]
+        if header["record_size"] != RECORD_SIZE:
+            raise ValueError(f"{path}: unsupported record size {header['record_size']}")
+        body = data[TELEMETRY_HEADER.itemsize:]
+        count = len(body) // RECORD_SIZE
+        if header["record_count"]:
+            count = min(count, int(header["record_count"]))
+        clock = int(header["realtime_ns"]) - int(header["start_ns"])
+    elif magic == FLIGHT_MAGIC:
+        header = data[:FLIGHT_HEADER.itemsize].view(FLIGHT_HEADER)[0]
+        body = data[FLIGHT_HEADER.itemsize:]
+        count = min(len(body) // RECORD_SIZE, int(header["event_count"]))
+        clock = int(header["realtime_ns"]) - int(header["trigger_ns"])
+    else:
+        raise ValueError(f"{path}: not a telemetry log nor a flight recorder dump")
+
+    # A file not closed ends with unwritten records, and may hold records
+    # still being written: both have a zero sequence number.
+    records = body[:count * RECORD_SIZE].reshape(count, RECORD_SIZE)
+    seq = records[:, :8].copy().view("<u8").ravel()
+    return records[seq != 0], clock
+
+
+def read_tables(paths):
+    """Reads log or dump files into tables of columns.
+
+    Args:
+        paths (list): The files, in any order.
+
+    Returns:
+        dict: The columns (``dict`` of numpy arrays) by table name, the
+        records being sorted by sequence number, with a ``realtime_ns`` column.
+    """
+    parts, clocks = [], []
+    for path in paths:
+        records, clock = read_records(path)
+        parts.append(records)
+        clocks.append(np.full(len(records), clock, dtype=np.int64))
+    records = np.concatenate(parts) if parts else np.empty((0, RECORD_SIZE), np.uint8)
+    clock = np.concatenate(clocks) if clocks else np.empty(0, np.int64)
+
+    # Sort by sequence number, dropping the events found in several files.
+    seq = records[:, :8].copy().view("<u8").ravel()
+    seq, first = np.unique(seq, return_index=True)
+    records, clock = records[first], clock[first]
+
+    tables = {}
+    kinds = records[:, 16:20].copy().view("<u4").ravel()
+    for kind, (name, dtype) in TABLES.items():
+        selected = records[kinds == kind]
+        rows = np.ascontiguousarray(selected).view(dtype).ravel()
+        columns = {field: rows[field] for field in dtype.names if field != "type"}
+        columns["realtime_ns"] = rows["timestamp_ns"].astype(np.int64) + clock[kinds == kind]
+        tables[name] = columns
+    return tables
+
+
+def write_csv(path, columns):
+    """Writes a table to a CSV file, with a header line."""
+    names = list(columns)
+    fmt = ["%.6g" if columns[n].dtype.kind == "f" else "%d" for n in names]
+    matrix = np.empty((len(columns[names[0]]), len(names)), dtype=object)
+    for i, name in enumerate(names):
+        matrix[:, i] = columns[name]
+    np.savetxt(path, matrix, fmt=fmt, delimiter=",", header=",".join(names), comments="")
+
+
+def write_parquet(path, columns):
+    """Writes a table to a Parquet file, with pyarrow."""
+    import pyarrow as pa
+    import pyarrow.parquet as pq
+    pq.write_table(pa.table(columns), path)
+
+
+def summary(tables):
+    """Prints the number of events by table, and the steps planned and emitted by axis."""
+    for name, columns in tables.items():
+        print(f"{name}: {len(columns['seq'])} events")
+    steps = tables["steps"]
+    for axis in (0, 1):
+        moves = steps["axis"] == axis
+        planned = np.abs(steps["planned"][moves]).sum()
+        emitted = np.abs(steps["emitted"][moves]).sum()
+        print(f"axis {'XY'[axis]}: {moves.sum()} moves, {planned} steps planned, {emitted} steps emitted")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Converts the binary telemetry logs to CSV or columnar files.")
+    parser.add_argument("files", nargs="+", metavar="FILE",
+                        help="telemetry log files (telemetry-*.bin) or flight recorder dumps (flight-*.bin)")
+    parser.add_argument("-o", "--output", metavar="DIR",
+                        help="directory of the tables, one file per event type (default: print a summary)")
+    parser.add_argument("--format", choices=("csv", "npz", "parquet"), default="csv",
+                        help="format of the tables (default: %(default)s)")
+    args = parser.parse_args()
+
+    try:
+        tables = read_tables(args.files)
+    except (OSError, ValueError) as e:
+        print(f"[Error] {e}")
+        return 1
+
+    if args.output is None:
+        summary(tables)
+        return 0
+
+    os.makedirs(args.output, exist_ok=True)
+    for name, columns in tables.items():
+        path = os.path.join(args.output, f"{name}.{args.format}")
+        if args.format == "csv":
+            write_csv(path, columns)
+        elif args.format == "npz":
+            np.savez_compressed(path, **columns)
+        else:
+            try:
+                write_parquet(path, columns)
+            except ImportError:
+                print("[Error] Parquet output needs pyarrow (pip install pyarrow)")
+                return 1
+        print(f"[Info] {len(columns['seq'])} {name} written to {path}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
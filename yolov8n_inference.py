@@ -3,9 +3,12 @@ yolov8n_inference.py
 YOLOv8n inference task for Orange Pi hardware integration.
 
 This script runs the YOLOv8n object detection model on frames provided by the
-C++ camera thread. It processes detections, optionally sends annotated frames
-back to the C++ display thread, and communicates object positions to the motor
-control system (C threads).
+C++ camera thread. It processes detections, and communicates object positions
+to the motor control system (C threads), which also draw them on the display.
+
+It runs either as a thread of main.py, or as a separate process linked to
+``main.py --shm`` by shared memory (``python3 yolov8n_inference.py``). The
+separate process can be stopped and restarted while the motors keep running.
 
 References:
     - libloader.py
@@ -37,14 +40,12 @@ License:
 """
 
 from ultralytics import YOLO
-import ctypes
+import time
 import numpy as np
 
-from libloader import clib
+from libloader import edgeai
 
-# Camera image buffer size.
-FRAME_WIDTH = 320
-FRAME_HEIGHT = 240
+EXIT_SUCCESS = 0
 
 # Confidence threshold for inferences.
 CONF = 0.65
@@ -54,13 +55,14 @@ def task():
     Task body t run the YOLOv8n object detection loop.
 
     Loads the YOLOv8n model and processes camera frames obtained via the
-    C interface. Sends detected object positions to the motor control system
-    and optionally sends annotated frames to the display.
+    C interface. Submits the detections of each frame to the C targeting
+    thread, which drives the motors and feeds the display.
 
     Notes:
         - The task terminates when `kill_requested()` returns True.
         - Uses the Ultralytics YOLOv8 API for inference.
-        - User is prompted for manual reference calibration on first detection.
+        - User is prompted for manual reference calibration on first detection,
+          unless the motors have been calibrated automatically.
 
     Raises:
         Exception: If model loading or inference fails.
@@ -76,7 +78,7 @@ def task():
         print("[Info] Model loaded successfully.")
     except Exception as e:
         print(f"[Error] Failed to load model: {e}")
-        clib.thread_exit_ready()
+        edgeai.thread_exit_ready()
         return
     
     # Calibration coordinates to send to the motors.
@@ -84,92 +86,170 @@ def task():
     y0_px = None
     
     # Inference loop that continues until a termination signal is received.
-    while not clib.kill_requested():
-        
-        # Get latest frame from the C++ camera thread.
-        size = ctypes.c_size_t()
-        ptr_in = clib.get_latest_frame(ctypes.byref(size))
-        buf_in = ctypes.string_at(ptr_in, size.value)
-        frame = np.frombuffer(buf_in, dtype=np.uint8).reshape((FRAME_HEIGHT, FRAME_WIDTH, 3))
+    while not edgeai.kill_requested():
         
-        # Free created C pointer.
-        clib.free_frame(ptr_in)
+        # Wait for the next frame from the C++ camera thread, viewed without copy.
+        frame_in = edgeai.get_latest_frame()
+        if frame_in is None:
+            continue
+        frame = np.asarray(frame_in)
         
         try:
             # Run inference on the captured frame at defined confidence threshold.
+            edgeai.perf_begin(edgeai.PERF_STAGE_INFERENCE)
             results = model.predict(frame, imgsz=224, conf=CONF, verbose=False)
+            edgeai.perf_end(edgeai.PERF_STAGE_INFERENCE)
             result = results[0]
         except Exception as e:
             print(f"[Error] Inference failed: {e}")
+            del frame
+            frame_in.release()
             break
 
-        # Uncomment the following to display result on OrangePi screen
-        # Also modify ipc_elements.h, ipc_elements.c, c_interface.cpp
-        # and yolov8n_inference.py accordingly.
-        # =======================================================================
-        ##try:
-        ##    img = result.plot()
-        ##    img_contig = np.ascontiguousarray(img)
-        ##    ptr_out = img_contig.ctypes.data_as(ctypes.POINTER(ctypes.c_uint8))
-        ##    clib.send_frame(ptr_out, img.shape[1], img.shape[0])
-        ##except Exception as e:
-        ##    print(f"[Error] Failed to send result: {e}")
-        # =======================================================================
+        # Give the frame back to the C++ frame pool (the result no longer needs it).
+        frame_id = frame_in.frame_id
+        del frame
+        frame_in.release()
 
         try:
-            # Get inference result attributes.
-            boxes = result.boxes                            # Bounding boxes.
-            boxes_xyxy = boxes.xyxy.cpu().numpy()           # Bounding boxes coordinates.
-            confidences = boxes.conf.cpu().numpy()          # Bounding boxes confidence scores.
-            class_ids = boxes.cls.cpu().numpy().astype(int) # Identified class-indexes.
+            # All the detections in a single array: x1, y1, x2, y2, confidence, class.
+            boxes = result.boxes
+            dets = np.column_stack((boxes.xyxy.cpu().numpy(), boxes.conf.cpu().numpy(),
+                                    boxes.cls.cpu().numpy())).astype(np.float32)
             class_names = result.names                      # Identified class-names.
 
-            # For each identified objects:
-            for i in range(len(boxes_xyxy)):
-                # Compute inference speed [FPS]
-                inference_time_ms = result.speed.get('inference')
-                fps = 1000.0 / inference_time_ms
-
-                # Get object's center coordinates.
-                x1, y1, x2, y2 = boxes_xyxy[i]
-                cx = int((x1 + x2)) // 2
-                cy = int((y1 + y2)) // 2
-
-                # Get object's attributes.
-                conf = confidences[i]           # Confidence score.
-                cls_id = class_ids[i]           # Class index.
-                cls_name = class_names[cls_id]  # Class name.
+            # Compute inference speed [FPS]
+            inference_time_ms = result.speed.get('inference')
+            fps = 1000.0 / inference_time_ms
 
+            for x1, y1, x2, y2, conf, cls_id in dets:
                 print(f"[Info] Detections at {inference_time_ms:.2f} ms ({fps:.2f} FPS)"
-                    f" Class: {cls_name} ({cls_id}), Conf: {conf:.2f}, Center: ({cx},{cy})")
+                    f" Class: {class_names[int(cls_id)]} ({int(cls_id)}), Conf: {conf:.2f},"
+                    f" Center: ({int(x1 + x2) // 2},{int(y1 + y2) // 2})")
+
+            # If the motors have not been calibrated yet, pause inference loop.
+            if (x0_px is None or y0_px is None) and not edgeai.motors_calibrated():
+                if len(dets) == 0:
+                    continue
+
+                # Prepare first detected object's position as reference for calibration.
+                cx = int(dets[0, 0] + dets[0, 2]) // 2
+                cy = int(dets[0, 1] + dets[0, 3]) // 2
+                print(f"[Info] About to set ref to x0={cx} y0={cy}")
+                print("[Info] Press 'y' then Enter to validate, or just Enter to retry")
+                user_input = input().strip().lower()
+
+                # Save and send calibration position to motors when pressing `y`.
+                if user_input == "y":
+                    x0_px = cx
+                    y0_px = cy
+                    edgeai.send_abs_pos(x0_px, y0_px)
+                    print(f"[Info] YOLOv8n reference position set to x0={x0_px}, y0={y0_px}")
+                # Abort calibration: make another inference and ask for calibration again.
+                else:
+                    print("[Info] Retry calibration, moving to next detection.")
+
+            # Otherwise, hand all the detections to the C targeting thread, without waiting for the motors.
+            # Frames without detection are also sent, so that lost aliens stop being tracked.
+            else:
+                edgeai.submit_detections(dets, frame_id)
 
-                # If the motors have not been calibrated yet, pause inference loop.
-                if x0_px is None or y0_px is None:
-                    
-                    # Prepare current detected object's position as reference for calibration.
-                    print(f"[Info] About to set ref to x0={cx} y0={cy}")
-                    print("[Info] Press 'y' then Enter to validate, or just Enter to retry")
-                    user_input = input().strip().lower()
-                    
-                    # Save and send calibration position to motors when pressing `y`.
-                    if user_input == "y":
-                        x0_px = cx
-                        y0_px = cy
-                        clib.send_abs_pos(x0_px, y0_px)
-                        print(f"[Info] YOLOv8n reference position set to x0={x0_px}, y0={y0_px}")
-                    # Abort calibration: make another inference and ask for calibration again.
-                    else:
-                        print("[Info] Retry calibration, moving to next detection.")
-                
-                # Otherwise, if the detected class corresponds to an alien, send object's position to motors.
-                elif cls_id == 0:
-                    clib.send_abs_pos(cx, cy)
-        
         except Exception as e:
             print(f"[Error] Detection processing failed: {e}")
             continue
-    
+
     # Indicate the task is complete and release resources.
-    clib.thread_exit_ready()
+    edgeai.thread_exit_ready()
     print("[Info] Stopping YOLOv8n inference task")
     return
+
+def shm_task():
+    """
+    Task body to run the YOLOv8n object detection loop in a separate process.
+
+    Connects to the application started with ``main.py --shm``, reads the
+    camera frames in place in shared memory, and sends the detections back
+    to the application, which forwards the aliens positions to the motors.
+
+    Notes:
+        - The task terminates on Ctrl+C, and reconnects if the application restarts.
+        - User is prompted for manual reference calibration on first detection,
+          unless the motors have already been calibrated.
+
+    Returns:
+        None
+    """
+
+    print("[Info] Start YOLOv8n inference process")
+    try:
+        model = YOLO("models/best_full_integer_quant_edgetpu.tflite", task="detect", verbose=False)
+        print("[Info] Model loaded successfully.")
+    except Exception as e:
+        print(f"[Error] Failed to load model: {e}")
+        return
+
+    try:
+        while True:
+            # Wait for the application to run.
+            if edgeai.inference_connect() != EXIT_SUCCESS:
+                print("[Info] Waiting for main.py --shm ...")
+                time.sleep(1.0)
+                continue
+            print("[Info] Connected to the application")
+
+            # Inference loop that continues while the application runs.
+            while edgeai.inference_link_alive():
+
+                # Lease the latest frame, read in place in shared memory.
+                frame_in = edgeai.inference_wait_frame()
+                if frame_in is None:
+                    continue
+                frame = np.asarray(frame_in)
+
+                try:
+                    edgeai.perf_begin(edgeai.PERF_STAGE_INFERENCE)
+                    result = model.predict(frame, imgsz=224, conf=CONF, verbose=False)[0]
+                    edgeai.perf_end(edgeai.PERF_STAGE_INFERENCE)
+                except Exception as e:
+                    print(f"[Error] Inference failed: {e}")
+                    del frame
+                    frame_in.release()
+                    continue
+
+                # The result no longer needs the frame.
+                del frame
+                frame_in.release()
+
+                # All the detections in a single array: x1, y1, x2, y2, confidence, class.
+                boxes = result.boxes
+                dets = np.column_stack((boxes.xyxy.cpu().numpy(), boxes.conf.cpu().numpy(),
+                                        boxes.cls.cpu().numpy())).astype(np.float32)
+                # If the motors have not been calibrated yet, ask for the reference.
+                # Otherwise, frames without detection are also sent to stop tracking lost aliens.
+                flags = 0
+                if not edgeai.inference_calibrated():
+                    if len(dets) == 0:
+                        continue
+                    cx = int(dets[0, 0] + dets[0, 2]) // 2
+                    cy = int(dets[0, 1] + dets[0, 3]) // 2
+                    print(f"[Info] About to set ref to x0={cx} y0={cy}")
+                    print("[Info] Press 'y' then Enter to validate, or just Enter to retry")
+                    if input().strip().lower() != "y":
+                        print("[Info] Retry calibration, moving to next detection.")
+                        continue
+                    flags = edgeai.SHM_DETECTIONS_CALIBRATION
+                    print(f"[Info] YOLOv8n reference position set to x0={cx}, y0={cy}")
+
+                edgeai.inference_submit(dets, frame_in.frame_id, flags)
+
+            print("[Info] Application stopped")
+            edgeai.inference_disconnect()
+
+    except KeyboardInterrupt:
+        pass
+
+    edgeai.inference_disconnect()
+    print("[Info] Stopping YOLOv8n inference process")
+
+if __name__ == "__main__":
+    shm_task()